@@ -0,0 +1,1178 @@
+#define FIREWATCH_IMPLEMENTATION
+#include "firewatch.h"
+
+#include "alloc_track.h"
+#include "ase_compose.h"
+#include "ase_probe.h"
+#include "asset_gen.h"
+#include "blend.h"
+#include "capture.h"
+#include "cute_aseprite.h"
+#include "discovery.h"
+#include "disk_cache.h"
+#include "draw_list.h"
+#include "gpu_timer.h"
+#include "layer_cache.h"
+#include "lights.h"
+#include "metrics.h"
+#include "model_vector.h"
+#include "path.h"
+#include "point_cloud.h"
+#include "raylib.h"
+#include "raymath.h"
+#include "string_vector.h"
+#include "tiled_texture.h"
+#include "version_history.h"
+#include "voxel_mesh.h"
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Microbenchmarks for the decoders, parsers and containers on the reload path.
+//
+// Each benchmark is calibrated to run for at least `min_time` seconds, and the
+// fastest of BENCH_SAMPLES runs is reported. Allocations are counted with
+// alloc_track, so they include everything allocated by bricklayer, libebb and
+// the header-only libraries, but not allocations made inside shared libraries
+// such as raylib.
+//
+// Results are compared against a JSON baseline and any benchmark allocating
+// more than the baseline, or missing from it, is reported as a regression.
+// Timings only mean something on the machine that recorded them, so
+// bench/baseline.json holds allocation counts alone, written with
+// -save-allocations. A baseline written with -save has the timings too, and
+// benchmarks slower than it by more than the tolerance are regressions as
+// well. Saving keeps the entries of the benchmarks that were not run.
+
+#define BENCH_SAMPLES 5
+#define BENCH_MAX_RESULTS 64
+#define BENCH_OBJ_FILEPATH "/tmp/bricklayer_bench.obj"
+#define BENCH_SCAN_FILEPATH "/tmp/bricklayer_bench_scan.obj"
+#define BENCH_CACHE_DIRECTORY "/tmp/bricklayer_bench_disk_cache"
+#define BENCH_DISCOVERY_DIRECTORY "/tmp/bricklayer_bench_discovery"
+
+// --- Harness ---
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(size_t iterations);
+    void (*teardown)(void);
+    // Bytes processed by a single iteration, for throughput. 0 if not
+    // applicable.
+    double bytes_per_op;
+    // Needs a window and an OpenGL context
+    int needs_gl;
+} Benchmark;
+
+typedef struct {
+    char name[64];
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_allocated_per_op;
+    double megabytes_per_second;
+} BenchResult;
+
+static inline double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static BenchResult run_benchmark(Benchmark *benchmark, double min_time) {
+    BenchResult result = {0};
+    snprintf(result.name, sizeof(result.name), "%s", benchmark->name);
+
+    if (benchmark->setup)
+        benchmark->setup();
+
+    // Calibrate the iteration count
+    size_t iterations = 1;
+    double elapsed = 0;
+    while (1) {
+        double start = now_seconds();
+        benchmark->run(iterations);
+        elapsed = now_seconds() - start;
+        if (elapsed >= min_time / 4 || iterations >= ((size_t)1 << 40))
+            break;
+        iterations *= 2;
+    }
+    if (elapsed > 0 && elapsed < min_time)
+        iterations = (size_t)((double)iterations * min_time / elapsed) + 1;
+
+    double best = -1;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        AllocCount allocations_start = alloc_track_total();
+
+        double start = now_seconds();
+        benchmark->run(iterations);
+        double sample = (now_seconds() - start) / (double)iterations;
+
+        AllocCount allocations = alloc_track_since(allocations_start);
+        result.allocs_per_op =
+            (double)allocations.count / (double)iterations;
+        result.bytes_allocated_per_op =
+            (double)allocations.bytes / (double)iterations;
+        if (best < 0 || sample < best)
+            best = sample;
+    }
+
+    if (benchmark->teardown)
+        benchmark->teardown();
+
+    result.ns_per_op = best * 1e9;
+    if (benchmark->bytes_per_op > 0 && best > 0)
+        result.megabytes_per_second = benchmark->bytes_per_op / best / 1e6;
+    return result;
+}
+
+// --- Baseline ---
+
+// Reads a baseline in the format written by write_results(): a single JSON
+// object mapping benchmark names to objects with numeric fields. ns_per_op is
+// 0 for baselines without timings.
+static size_t read_baseline(const char *filepath, BenchResult *entries,
+                            size_t max_entries) {
+    FILE *file = fopen(filepath, "r");
+    if (!file)
+        return 0;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *json = malloc((size_t)length + 1);
+    assert(json);
+    json[fread(json, 1, (size_t)length, file)] = 0;
+    fclose(file);
+
+    size_t count = 0;
+    char *cursor = strchr(json, '{');
+    while (cursor && count < max_entries) {
+        char *key_start = strchr(cursor + 1, '"');
+        if (!key_start)
+            break;
+        char *key_end = strchr(key_start + 1, '"');
+        char *object_start = key_end ? strchr(key_end, '{') : 0;
+        char *object_end = object_start ? strchr(object_start, '}') : 0;
+        if (!object_end)
+            break;
+
+        BenchResult *entry = entries + count++;
+        memset(entry, 0, sizeof(BenchResult));
+        size_t key_length = (size_t)(key_end - key_start - 1);
+        if (key_length >= sizeof(entry->name))
+            key_length = sizeof(entry->name) - 1;
+        memcpy(entry->name, key_start + 1, key_length);
+
+        *object_end = 0;
+        char *field = strstr(object_start, "\"ns_per_op\"");
+        if (field)
+            entry->ns_per_op = strtod(strchr(field, ':') + 1, 0);
+        field = strstr(object_start, "\"allocs_per_op\"");
+        if (field)
+            entry->allocs_per_op = strtod(strchr(field, ':') + 1, 0);
+        field = strstr(object_start, "\"bytes_allocated_per_op\"");
+        if (field)
+            entry->bytes_allocated_per_op = strtod(strchr(field, ':') + 1, 0);
+        field = strstr(object_start, "\"mb_per_s\"");
+        if (field)
+            entry->megabytes_per_second = strtod(strchr(field, ':') + 1, 0);
+
+        cursor = object_end + 1;
+    }
+
+    free(json);
+    return count;
+}
+
+// Writes the results as a baseline, leaving out the timings unless `timed`.
+static int write_results(const char *filepath, BenchResult *results,
+                         size_t count, int timed) {
+    FILE *file = fopen(filepath, "w");
+    if (!file)
+        return 1;
+
+    fprintf(file, "{\n");
+    for (size_t i = 0; i < count; i++) {
+        if (!timed) {
+            fprintf(file,
+                    "    \"%s\": {\"allocs_per_op\": %.2f, "
+                    "\"bytes_allocated_per_op\": %.0f}%s\n",
+                    results[i].name, results[i].allocs_per_op,
+                    results[i].bytes_allocated_per_op,
+                    i + 1 < count ? "," : "");
+            continue;
+        }
+        fprintf(file,
+                "    \"%s\": {\"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, "
+                "\"bytes_allocated_per_op\": %.0f, \"mb_per_s\": %.1f}%s\n",
+                results[i].name, results[i].ns_per_op,
+                results[i].allocs_per_op, results[i].bytes_allocated_per_op,
+                results[i].megabytes_per_second, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "}\n");
+    return fclose(file);
+}
+
+// --- Benchmarks ---
+
+static uint8_t *ase_data = 0;
+static size_t ase_size = 0;
+
+static void generate_aseprite(int size, int depth, int layers, int frames,
+                              int hold, AseGenCompression compression) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = options.height = size;
+    options.depth = depth;
+    options.layer_count = layers;
+    options.frame_count = frames;
+    options.hold = hold;
+    options.compression = compression;
+    ase_size = asset_gen_aseprite(&options, &ase_data);
+    assert(ase_size);
+}
+
+static void setup_aseprite_inflate(void) {
+    generate_aseprite(512, 32, 1, 1, 1, ASSET_GEN_COMPRESSION_ZLIB);
+}
+
+static void setup_aseprite_indexed(void) {
+    generate_aseprite(512, 8, 1, 1, 1, ASSET_GEN_COMPRESSION_ZLIB);
+}
+
+static void setup_aseprite_composite(void) {
+    generate_aseprite(256, 32, 8, 1, 1, ASSET_GEN_COMPRESSION_NONE);
+}
+
+static void setup_aseprite_animation(void) {
+    generate_aseprite(64, 32, 2, 64, 4, ASSET_GEN_COMPRESSION_ZLIB);
+}
+
+static void run_aseprite(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        ase_t *ase = cute_aseprite_load_from_memory(ase_data, (int)ase_size, 0);
+        assert(ase);
+        cute_aseprite_free(ase);
+    }
+}
+
+// Header and chunk table only, what setup_models does for every texture.
+static void run_aseprite_probe(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        AseProbe probe;
+        if (ase_probe_memory(ase_data, ase_size, &probe))
+            abort();
+    }
+}
+
+// Same work as run_aseprite, composited into a reused buffer the way texture
+// loading composites into the staging ring.
+static uint8_t *compose_buffer = 0;
+
+static void setup_aseprite_compose(void) {
+    setup_aseprite_composite();
+    compose_buffer = malloc(256 * 256 * 4);
+    assert(compose_buffer);
+}
+
+static void run_aseprite_compose(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        ase_t *ase = cute_aseprite_load_from_memory_ex(
+            ase_data, (int)ase_size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+        assert(ase);
+        AseComposeTarget target = {
+            .pixels = compose_buffer,
+            .stride = (size_t)ase->w * 4,
+            .format = ASE_COMPOSE_RGBA8,
+        };
+        for (int j = 0; j < ase->frame_count; j++)
+            ase_compose_frame(ase, j, &target);
+        cute_aseprite_free(ase);
+    }
+}
+
+static void teardown_aseprite_compose(void) {
+    free(compose_buffer);
+    compose_buffer = 0;
+    free(ase_data);
+    ase_data = 0;
+}
+
+// A canvas over a 256 pixel texture limit, composited and hashed in tiles on
+// every processor. Nothing is uploaded, so the tile memory is reused, and the
+// tiles are forgotten each time so that all of them are composited again.
+static TiledTexture tiled_texture = {0};
+static ase_t *tiled_ase = 0;
+
+static void setup_tiled_compose(void) {
+    generate_aseprite(1024, 32, 8, 1, 1, ASSET_GEN_COMPRESSION_NONE);
+    tiled_ase = cute_aseprite_load_from_memory_ex(
+        ase_data, (int)ase_size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    assert(tiled_ase);
+    tiled_texture_init(&tiled_texture);
+}
+
+static void run_tiled_compose(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        if (tiled_texture.sources)
+            memset(tiled_texture.sources, 0,
+                   (size_t)tiled_texture.composed.columns *
+                       (size_t)tiled_texture.composed.rows * sizeof(uint64_t));
+        tiled_texture_compose(&tiled_texture, tiled_ase, 256, 0);
+    }
+}
+
+static void teardown_tiled_compose(void) {
+    tiled_texture_free(&tiled_texture);
+    cute_aseprite_free(tiled_ase);
+    tiled_ase = 0;
+    free(ase_data);
+    ase_data = 0;
+}
+
+// Maps a cached 256x256 texture, as a load does on a cache hit.
+static DiskCache disk_cache = {0};
+static const DiskCacheKey disk_cache_key_bench = {.source = 1, .version = 1};
+
+static void setup_disk_cache(void) {
+    int result = disk_cache_open(&disk_cache, BENCH_CACHE_DIRECTORY,
+                                 DISK_CACHE_CAPACITY);
+    assert(result == 0);
+    uint8_t *pixels = calloc(256 * 256, 4);
+    result = disk_cache_put_pixels(&disk_cache, disk_cache_key_bench, pixels,
+                                   256, 256);
+    assert(result == 0);
+    (void)result;
+    free(pixels);
+}
+
+static void run_disk_cache_get(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        DiskCacheBlob blob;
+        const uint8_t *pixels;
+        int width, height;
+        int result = disk_cache_get_pixels(&disk_cache, disk_cache_key_bench,
+                                           &blob, &pixels, &width, &height);
+        assert(result == 0);
+        (void)result;
+        disk_cache_release(&blob);
+    }
+}
+
+static void teardown_disk_cache(void) {
+    disk_cache_close(&disk_cache);
+    remove(BENCH_CACHE_DIRECTORY "/0000000000000001-0000000000000001.cache");
+    remove(BENCH_CACHE_DIRECTORY);
+}
+
+// Culls the bounds of 10k models scattered around the view, as every frame
+// does before drawing.
+#define BENCH_DRAW_LIST_COUNT 10000
+static DrawList draw_list = {0};
+static PointCloudView draw_list_view = {0};
+
+static void setup_draw_list(void) {
+    draw_list_init(&draw_list, BENCH_DRAW_LIST_COUNT);
+    uint32_t state = 1;
+    for (size_t i = 0; i < BENCH_DRAW_LIST_COUNT; i++) {
+        float center[3];
+        for (int axis = 0; axis < 3; axis++) {
+            state = state * 1664525u + 1013904223u;
+            center[axis] = (float)(state >> 8) / (float)(1 << 24) * 200.0f -
+                           100.0f;
+        }
+        BoundingBox bounds = {{center[0] - 1, center[1] - 1, center[2] - 1},
+                              {center[0] + 1, center[1] + 1, center[2] + 1}};
+        // Never drawn, only needs to look loaded
+        Mesh mesh = {.vertexCount = 36, .vaoId = (unsigned int)i + 1};
+        draw_list_set(&draw_list, i, &mesh, 0, bounds, 0);
+    }
+    Camera camera = {
+        .position = {0.0f, 20.0f, 60.0f},
+        .target = {0.0f, 0.0f, 0.0f},
+        .up = {0.0f, 1.0f, 0.0f},
+        .fovy = 45.0f,
+    };
+    draw_list_view = point_cloud_view(camera, 1280, 720);
+}
+
+static void run_draw_list_cull(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++)
+        draw_list_cull(&draw_list, &draw_list_view);
+}
+
+static void teardown_draw_list(void) {
+    draw_list_free(&draw_list);
+}
+
+// Finds the textures of 1000 models, half of them PNGs found with the last
+// pattern tried.
+#define BENCH_DISCOVERY_COUNT 1000
+static DiscoveryPatterns discovery_patterns = {0};
+static char discovery_filepaths[BENCH_DISCOVERY_COUNT][64];
+static const char *discovery_pointers[BENCH_DISCOVERY_COUNT];
+static int discovery_found[BENCH_DISCOVERY_COUNT];
+
+static void setup_discovery(void) {
+    discovery_parse_patterns(&discovery_patterns, DISCOVERY_DEFAULT_PATTERNS);
+    mkdir(BENCH_DISCOVERY_DIRECTORY, 0755);
+    char filepath[80];
+    for (int i = 0; i < BENCH_DISCOVERY_COUNT; i++) {
+        snprintf(discovery_filepaths[i], sizeof(discovery_filepaths[i]),
+                 BENCH_DISCOVERY_DIRECTORY "/model%d.obj", i);
+        discovery_pointers[i] = discovery_filepaths[i];
+        snprintf(filepath, sizeof(filepath),
+                 BENCH_DISCOVERY_DIRECTORY "/model%d%s", i,
+                 i % 2 ? ".png" : ".aseprite");
+        FILE *file = fopen(filepath, "w");
+        assert(file);
+        fclose(file);
+    }
+}
+
+static void run_discovery(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++)
+        discovery_find_textures(discovery_found, discovery_pointers,
+                                BENCH_DISCOVERY_COUNT, &discovery_patterns,
+                                0);
+}
+
+static void teardown_discovery(void) {
+    char filepath[80];
+    for (int i = 0; i < BENCH_DISCOVERY_COUNT; i++) {
+        snprintf(filepath, sizeof(filepath),
+                 BENCH_DISCOVERY_DIRECTORY "/model%d%s", i,
+                 i % 2 ? ".png" : ".aseprite");
+        remove(filepath);
+    }
+    remove(BENCH_DISCOVERY_DIRECTORY);
+}
+
+// Toggles a layer near the top of a 64 layer file, recompositing from its
+// cached prefix.
+static LayerCache layer_cache = {0};
+
+static void setup_layer_toggle(void) {
+    generate_aseprite(256, 32, 64, 1, 1, ASSET_GEN_COMPRESSION_NONE);
+    ase_t *ase = cute_aseprite_load_from_memory_ex(
+        ase_data, (int)ase_size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    assert(ase);
+    int error = layer_cache_init(&layer_cache, ase, 0);
+    assert(!error);
+    (void)error;
+    layer_cache_pixels(&layer_cache);
+}
+
+static void run_layer_toggle(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        layer_cache_set_visible(&layer_cache, 60,
+                                !layer_cache_visible(&layer_cache, 60));
+        const ase_color_t *pixels = layer_cache_pixels(&layer_cache);
+        assert(pixels);
+        (void)pixels;
+    }
+}
+
+static void teardown_layer_toggle(void) {
+    layer_cache_free(&layer_cache);
+    free(ase_data);
+    ase_data = 0;
+}
+
+static void teardown_aseprite(void) {
+    free(ase_data);
+    ase_data = 0;
+}
+
+// Blends a 256x256 layer over another with one of the blend kernels.
+#define BLEND_PIXEL_COUNT (256 * 256)
+static ase_color_t *blend_src = 0;
+static ase_color_t *blend_dst = 0;
+static ase_blend_mode_t blend_mode = ASE_BLEND_MODE_NORMAL;
+static BlendKernel blend_kernel = BLEND_KERNEL_SCALAR;
+
+static void setup_blend(ase_blend_mode_t mode, BlendKernel kernel) {
+    blend_mode = mode;
+    blend_kernel = kernel;
+    blend_src = malloc(BLEND_PIXEL_COUNT * sizeof(ase_color_t));
+    blend_dst = malloc(BLEND_PIXEL_COUNT * sizeof(ase_color_t));
+    assert(blend_src && blend_dst);
+    uint32_t state = 1;
+    for (size_t i = 0; i < BLEND_PIXEL_COUNT; i++) {
+        state = state * 1664525u + 1013904223u;
+        memcpy(blend_src + i, &state, sizeof(state));
+        state = state * 1664525u + 1013904223u;
+        memcpy(blend_dst + i, &state, sizeof(state));
+    }
+}
+
+static void setup_blend_normal_scalar(void) {
+    setup_blend(ASE_BLEND_MODE_NORMAL, BLEND_KERNEL_SCALAR);
+}
+
+static void setup_blend_normal(void) {
+    setup_blend(ASE_BLEND_MODE_NORMAL, blend_best_kernel());
+}
+
+static void setup_blend_multiply(void) {
+    setup_blend(ASE_BLEND_MODE_MULTIPLY, blend_best_kernel());
+}
+
+static void setup_blend_overlay(void) {
+    setup_blend(ASE_BLEND_MODE_OVERLAY, blend_best_kernel());
+}
+
+static void setup_blend_hue(void) {
+    setup_blend(ASE_BLEND_MODE_HUE, blend_best_kernel());
+}
+
+static void run_blend(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++)
+        blend_row_kernel(blend_kernel, blend_mode, blend_src, blend_dst,
+                         BLEND_PIXEL_COUNT, 200);
+}
+
+static void teardown_blend(void) {
+    free(blend_src);
+    free(blend_dst);
+    blend_src = blend_dst = 0;
+}
+
+#define CAPTURE_WIDTH 800
+#define CAPTURE_HEIGHT 450
+
+static uint8_t *capture_pixels = 0;
+static uint8_t *capture_encoded = 0;
+
+// A frame like the viewer draws: flat background around a noisy, textured
+// model in the middle.
+static void setup_capture_encode(void) {
+    capture_pixels = malloc(CAPTURE_WIDTH * CAPTURE_HEIGHT * 4);
+    capture_encoded =
+        malloc(capture_qoi_max_size(CAPTURE_WIDTH, CAPTURE_HEIGHT));
+    assert(capture_pixels && capture_encoded);
+
+    uint32_t state = 1;
+    for (int y = 0; y < CAPTURE_HEIGHT; y++) {
+        for (int x = 0; x < CAPTURE_WIDTH; x++) {
+            uint8_t *pixel = capture_pixels + (y * CAPTURE_WIDTH + x) * 4;
+            state = state * 1664525u + 1013904223u;
+            int inside = x > 250 && x < 550 && y > 75 && y < 375;
+            pixel[0] = inside ? (uint8_t)(x + (state >> 29)) : 0x48;
+            pixel[1] = inside ? (uint8_t)(y + (state >> 29)) : 0x48;
+            pixel[2] = inside ? (uint8_t)((x ^ y) & 0xf0) : 0x48;
+            pixel[3] = 0xff;
+        }
+    }
+}
+
+static void run_capture_encode(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++)
+        capture_encode_qoi(capture_pixels, CAPTURE_WIDTH, CAPTURE_HEIGHT,
+                           capture_encoded);
+}
+
+static void teardown_capture_encode(void) {
+    free(capture_pixels);
+    free(capture_encoded);
+    capture_pixels = capture_encoded = 0;
+}
+
+#define LIGHT_CULL_MODELS 1000
+
+static LightSet light_set = {0};
+static BoundingBox *light_cull_boxes = 0;
+
+// Models in a 10 x 10 x 10 grid, lights spread over it
+static void setup_light_cull(void) {
+    light_cull_boxes = malloc(LIGHT_CULL_MODELS * sizeof(BoundingBox));
+    assert(light_cull_boxes);
+    for (int i = 0; i < LIGHT_CULL_MODELS; i++) {
+        Vector3 center = {(float)(i % 10), (float)(i / 10 % 10),
+                          (float)(i / 100)};
+        light_cull_boxes[i] = (BoundingBox){
+            Vector3Subtract(center, (Vector3){0.4f, 0.4f, 0.4f}),
+            Vector3Add(center, (Vector3){0.4f, 0.4f, 0.4f}),
+        };
+    }
+    BoundingBox bounds = {{0, 0, 0}, {9, 9, 9}};
+    light_set_scatter(&light_set, bounds, 256, 1);
+}
+
+static void run_light_cull(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++)
+        light_set_cull(&light_set, light_cull_boxes, LIGHT_CULL_MODELS,
+                       MatrixRotateY((float)i * 0.01f));
+}
+
+static void teardown_light_cull(void) {
+    light_set_free(&light_set);
+    free(light_cull_boxes);
+    light_cull_boxes = 0;
+}
+
+#define VOXEL_SPRITE_SIZE 256
+
+static uint8_t *voxel_pixels = 0;
+static VoxelMesher voxel_mesher = {0};
+
+// A round sprite with scattered holes, like pixel art with some detail
+static void setup_voxel_mesh(void) {
+    voxel_pixels = malloc(VOXEL_SPRITE_SIZE * VOXEL_SPRITE_SIZE * 4);
+    assert(voxel_pixels);
+    int half = VOXEL_SPRITE_SIZE / 2;
+    for (int y = 0; y < VOXEL_SPRITE_SIZE; y++) {
+        for (int x = 0; x < VOXEL_SPRITE_SIZE; x++) {
+            uint8_t *pixel = voxel_pixels + (y * VOXEL_SPRITE_SIZE + x) * 4;
+            int inside = (x - half) * (x - half) + (y - half) * (y - half) <
+                         half * half;
+            pixel[0] = (uint8_t)x;
+            pixel[1] = (uint8_t)y;
+            pixel[2] = 0x80;
+            pixel[3] = inside && (x * 13 + y * 7) % 23 ? 0xff : 0;
+        }
+    }
+    voxel_mesher_update(&voxel_mesher, voxel_pixels, VOXEL_SPRITE_SIZE,
+                        VOXEL_SPRITE_SIZE);
+}
+
+static void run_voxel_mesh(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        voxel_mesher_free(&voxel_mesher);
+        voxel_mesher_update(&voxel_mesher, voxel_pixels, VOXEL_SPRITE_SIZE,
+                            VOXEL_SPRITE_SIZE);
+    }
+}
+
+// An edit of one pixel in the middle of the sprite
+static void run_voxel_remesh_row(size_t iterations) {
+    uint8_t *alpha = voxel_pixels +
+                     (VOXEL_SPRITE_SIZE / 2 * VOXEL_SPRITE_SIZE + 100) * 4 + 3;
+    for (size_t i = 0; i < iterations; i++) {
+        *alpha = ~*alpha;
+        voxel_mesher_update(&voxel_mesher, voxel_pixels, VOXEL_SPRITE_SIZE,
+                            VOXEL_SPRITE_SIZE);
+    }
+}
+
+static void teardown_voxel_mesh(void) {
+    voxel_mesher_free(&voxel_mesher);
+    free(voxel_pixels);
+    voxel_pixels = 0;
+}
+
+#define VERSION_SPRITE_SIZE 256
+
+static uint8_t *version_pixels = 0;
+static uint8_t *version_compressed = 0;
+static size_t version_compressed_size = 0;
+
+// Pixel art: flat colors in blocks, with a gradient
+static void setup_version_compress(void) {
+    size_t size = VERSION_SPRITE_SIZE * VERSION_SPRITE_SIZE * 4;
+    version_pixels = malloc(size);
+    version_compressed = malloc(version_compress_bound(size));
+    assert(version_pixels && version_compressed);
+    for (int y = 0; y < VERSION_SPRITE_SIZE; y++) {
+        for (int x = 0; x < VERSION_SPRITE_SIZE; x++) {
+            uint8_t *pixel = version_pixels + (y * VERSION_SPRITE_SIZE + x) * 4;
+            int block = (x / 8 * 7 + y / 8 * 3) % 6;
+            pixel[0] = (uint8_t)(block * 40);
+            pixel[1] = (uint8_t)(y / 4 * 4);
+            pixel[2] = 0x80;
+            pixel[3] = block ? 0xff : 0;
+        }
+    }
+    version_compressed_size =
+        version_compress(version_pixels, size, version_compressed);
+}
+
+static void run_version_compress(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++)
+        version_compress(version_pixels,
+                         VERSION_SPRITE_SIZE * VERSION_SPRITE_SIZE * 4,
+                         version_compressed);
+}
+
+static void run_version_decompress(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        int result = version_decompress(
+            version_compressed, version_compressed_size, version_pixels,
+            VERSION_SPRITE_SIZE * VERSION_SPRITE_SIZE * 4);
+        assert(!result);
+        (void)result;
+    }
+}
+
+static void teardown_version_compress(void) {
+    free(version_pixels);
+    free(version_compressed);
+    version_pixels = version_compressed = 0;
+}
+
+#define SCAN_POINTS (1000 * 1000)
+
+static PointCloud point_cloud = {0};
+
+// Points on a rippled sphere, like a scan of a rough surface
+static void write_scan(void) {
+    FILE *file = fopen(BENCH_SCAN_FILEPATH, "w");
+    assert(file);
+    srand(1);
+    for (size_t i = 0; i < SCAN_POINTS; i++) {
+        float z = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+        float angle = (float)rand() / RAND_MAX * 2.0f * PI;
+        float radius = sqrtf(1.0f - z * z) * (1.0f + 0.05f * sinf(angle * 20));
+        fprintf(file, "v %f %f %f\n", radius * cosf(angle) * 10.0f,
+                radius * sinf(angle) * 10.0f, z * 10.0f);
+    }
+    fclose(file);
+    remove(BENCH_SCAN_FILEPATH ".octree");
+}
+
+// Scopes of a scene with as many models
+#define GPU_TIMER_SCOPES 258
+
+static GpuTimer gpu_timer = {0};
+static uint64_t gpu_timer_clock = 0;
+static uint64_t gpu_timer_times[GPU_TIMER_LATENCY * GPU_TIMER_SCOPES * 2 + 1];
+
+static void create_fake_queries(unsigned int *ids, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        ids[i] = (unsigned int)i + 1;
+}
+
+static void destroy_fake_queries(unsigned int *ids, size_t count) {
+    (void)ids;
+    (void)count;
+}
+
+static void write_fake_timestamp(unsigned int id) {
+    gpu_timer_times[id] = gpu_timer_clock += 1000 + id % 7 * 100;
+}
+
+static int read_fake_timestamp(unsigned int id, uint64_t *nanoseconds) {
+    *nanoseconds = gpu_timer_times[id];
+    return 1;
+}
+
+// The timer itself, without a GPU to wait for
+static void setup_gpu_timer(void) {
+    GpuTimerQueries queries = {
+        .create = &create_fake_queries,
+        .destroy = &destroy_fake_queries,
+        .timestamp = &write_fake_timestamp,
+        .result = &read_fake_timestamp,
+    };
+    gpu_timer_init(&gpu_timer, GPU_TIMER_SCOPES, &queries);
+}
+
+static void run_gpu_timer_frame(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        gpu_timer_begin_frame(&gpu_timer);
+        for (size_t scope = 0; scope < GPU_TIMER_SCOPES; scope++) {
+            gpu_timer_begin(&gpu_timer, scope);
+            gpu_timer_end(&gpu_timer, scope);
+        }
+        gpu_timer_rank(&gpu_timer);
+    }
+}
+
+static void teardown_gpu_timer(void) {
+    gpu_timer_free(&gpu_timer);
+}
+
+// What the frame loop records: the frame time and the file watcher state
+static void run_metrics_frame(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        metrics_set(METRIC_FIREWATCH_QUEUE_DEPTH, i & 3);
+        metrics_store(METRIC_FIREWATCH_EVENTS, i);
+        metrics_observe(METRIC_FRAME_SECONDS, 0.001 * (double)(i % 40));
+    }
+}
+
+static char metrics_output[16384];
+
+static void run_metrics_write(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        FILE *file = fmemopen(metrics_output, sizeof(metrics_output), "w");
+        assert(file);
+        metrics_write(file);
+        fclose(file);
+    }
+}
+
+static void run_point_cloud_build(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        remove(BENCH_SCAN_FILEPATH ".octree");
+        int result = point_cloud_load(&point_cloud, BENCH_SCAN_FILEPATH, 0);
+        assert(!result);
+        (void)result;
+        point_cloud_free(&point_cloud);
+    }
+}
+
+static void setup_point_cloud_select(void) {
+    write_scan();
+    int result = point_cloud_load(&point_cloud, BENCH_SCAN_FILEPATH, 0);
+    assert(!result);
+    (void)result;
+}
+
+// The camera circles the scan up close
+static void run_point_cloud_select(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        float angle = (float)i * 0.01f;
+        Camera camera = {
+            .position = {sinf(angle) * 15.0f, 3.0f, cosf(angle) * 15.0f},
+            .up = {0.0f, 1.0f, 0.0f},
+            .fovy = 45.0f,
+        };
+        PointCloudView view = point_cloud_view(camera, 1920, 1080);
+        point_cloud_select(&point_cloud, &view, POINT_CLOUD_BUDGET);
+    }
+}
+
+static void teardown_point_cloud(void) {
+    point_cloud_free(&point_cloud);
+    remove(BENCH_SCAN_FILEPATH);
+    remove(BENCH_SCAN_FILEPATH ".octree");
+}
+
+static void write_obj(size_t triangles, AssetGenTopology topology) {
+    ObjGenOptions options = asset_gen_obj_defaults();
+    options.triangle_count = triangles;
+    options.topology = topology;
+    int result = asset_gen_write_obj_file(BENCH_OBJ_FILEPATH, &options);
+    assert(!result);
+    (void)result;
+}
+
+static void setup_obj_grid(void) {
+    write_obj(100000, ASSET_GEN_TOPOLOGY_GRID);
+}
+
+static void setup_obj_soup(void) {
+    write_obj(20000, ASSET_GEN_TOPOLOGY_SOUP);
+}
+
+static void run_obj_load(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        Model model = LoadModel(BENCH_OBJ_FILEPATH);
+        assert(model.meshCount);
+        UnloadModel(model);
+    }
+}
+
+static void teardown_obj(void) {
+    remove(BENCH_OBJ_FILEPATH);
+}
+
+static void run_path(size_t iterations) {
+    for (size_t i = 0; i < iterations; i++) {
+        char *texture_filepath = path_get_corresponding_texture_file(
+            "/home/user/projects/game/assets/models/bricks/wall_corner.obj");
+        assert(texture_filepath);
+        free(texture_filepath);
+    }
+}
+
+static void run_path_write(size_t iterations) {
+    char texture_filepath[PATH_MAX];
+    for (size_t i = 0; i < iterations; i++) {
+        int error = path_write_corresponding_texture_file(
+            texture_filepath, sizeof(texture_filepath),
+            "/home/user/projects/game/assets/models/bricks/wall_corner.obj");
+        assert(!error);
+        (void)error;
+    }
+}
+
+static void run_stringvec(size_t iterations) {
+    const char *string = "/home/user/projects/game/assets/models/wall.obj";
+    size_t length = strlen(string);
+    for (size_t i = 0; i < iterations; i++) {
+        StringVector vec = stringvec_init();
+        for (size_t j = 0; j < 1000; j++)
+            stringvec_append(&vec, string, length);
+        for (size_t j = 0; j < 1000; j++) {
+            char *returned = stringvec_get(&vec, j);
+            assert(returned);
+            (void)returned;
+        }
+        stringvec_free(&vec);
+    }
+}
+
+static void run_modelvec(size_t iterations) {
+    Model model = {.meshCount = 1};
+    for (size_t i = 0; i < iterations; i++) {
+        ModelVector vec = modelvec_init();
+        for (size_t j = 0; j < 1000; j++)
+            modelvec_append(&vec, model);
+        for (size_t j = 0; j < 1000; j++) {
+            Model *returned = modelvec_get(&vec, j);
+            assert(returned);
+            (void)returned;
+        }
+        modelvec_free(&vec);
+    }
+}
+
+static size_t dispatched = 0;
+
+static void count_dispatch(const char *filepath, uint64_t cookie) {
+    (void)filepath;
+    dispatched += cookie;
+}
+
+static void setup_firewatch(void) {
+    if (!fw_needs_refresh_queue.data)
+        fw_needs_refresh_queue = fileinfovec_init();
+}
+
+// Queues a burst of 1000 file events and dispatches them the way the main
+// loop does with firewatch_check().
+static void run_firewatch(size_t iterations) {
+    FileInfo file_info = {
+        .using_stack = 1,
+        .cookie = 1,
+        .on_change_callback = &count_dispatch,
+    };
+    strcpy(file_info.filepath, "/home/user/projects/game/assets/wall.aseprite");
+
+    for (size_t i = 0; i < iterations; i++) {
+        pthread_mutex_lock(&fw_lock);
+        for (size_t j = 0; j < 1000; j++)
+            fileinfovec_append(&fw_needs_refresh_queue, file_info);
+        pthread_mutex_unlock(&fw_lock);
+        firewatch_check();
+    }
+}
+
+static Benchmark benchmarks[] = {
+    {"aseprite_inflate_512x512_rgba", &setup_aseprite_inflate, &run_aseprite,
+     &teardown_aseprite, 512.0 * 512 * 4, 0},
+    {"aseprite_inflate_512x512_indexed", &setup_aseprite_indexed,
+     &run_aseprite, &teardown_aseprite, 512.0 * 512 * 4, 0},
+    {"aseprite_composite_256x256_8_layers", &setup_aseprite_composite,
+     &run_aseprite, &teardown_aseprite, 256.0 * 256 * 4 * 8, 0},
+    {"aseprite_compose_256x256_8_layers", &setup_aseprite_compose,
+     &run_aseprite_compose, &teardown_aseprite_compose, 256.0 * 256 * 4 * 8, 0},
+    {"tiled_compose_1024x1024_8_layers", &setup_tiled_compose,
+     &run_tiled_compose, &teardown_tiled_compose, 1024.0 * 1024 * 4 * 8, 0},
+    {"disk_cache_get_pixels_256x256", &setup_disk_cache, &run_disk_cache_get,
+     &teardown_disk_cache, 256.0 * 256 * 4, 0},
+    {"draw_list_cull_10000_models", &setup_draw_list, &run_draw_list_cull,
+     &teardown_draw_list, BENCH_DRAW_LIST_COUNT * 6.0 * sizeof(float), 0},
+    {"discovery_1000_models", &setup_discovery, &run_discovery,
+     &teardown_discovery, 0, 0},
+    {"layer_toggle_256x256_64_layers", &setup_layer_toggle, &run_layer_toggle,
+     &teardown_layer_toggle, 256.0 * 256 * 4 * 4, 0},
+    {"aseprite_probe_64x64_64_frames", &setup_aseprite_animation,
+     &run_aseprite_probe, &teardown_aseprite, 64.0 * 64 * 4 * 64, 0},
+    {"aseprite_animation_64x64_64_frames", &setup_aseprite_animation,
+     &run_aseprite, &teardown_aseprite, 64.0 * 64 * 4 * 64, 0},
+    {"blend_normal_scalar_256x256", &setup_blend_normal_scalar, &run_blend,
+     &teardown_blend, 256.0 * 256 * 4, 0},
+    {"blend_normal_256x256", &setup_blend_normal, &run_blend, &teardown_blend,
+     256.0 * 256 * 4, 0},
+    {"blend_multiply_256x256", &setup_blend_multiply, &run_blend,
+     &teardown_blend, 256.0 * 256 * 4, 0},
+    {"blend_overlay_256x256", &setup_blend_overlay, &run_blend,
+     &teardown_blend, 256.0 * 256 * 4, 0},
+    {"blend_hue_256x256", &setup_blend_hue, &run_blend, &teardown_blend,
+     256.0 * 256 * 4, 0},
+    {"capture_encode_qoi_800x450", &setup_capture_encode, &run_capture_encode,
+     &teardown_capture_encode, 800.0 * 450 * 4, 0},
+    {"light_cull_256_lights_1000_models", &setup_light_cull, &run_light_cull,
+     &teardown_light_cull, 0, 0},
+    {"voxel_mesh_256x256", &setup_voxel_mesh, &run_voxel_mesh,
+     &teardown_voxel_mesh, 256.0 * 256 * 4, 0},
+    {"voxel_remesh_row_256x256", &setup_voxel_mesh, &run_voxel_remesh_row,
+     &teardown_voxel_mesh, 0, 0},
+    {"version_compress_256x256", &setup_version_compress,
+     &run_version_compress, &teardown_version_compress, 256.0 * 256 * 4, 0},
+    {"version_decompress_256x256", &setup_version_compress,
+     &run_version_decompress, &teardown_version_compress, 256.0 * 256 * 4, 0},
+    {"point_cloud_build_1m_points", &write_scan, &run_point_cloud_build,
+     &teardown_point_cloud, SCAN_POINTS * (double)sizeof(CloudPoint), 0},
+    {"point_cloud_select_1m_points", &setup_point_cloud_select,
+     &run_point_cloud_select, &teardown_point_cloud, 0, 0},
+    {"gpu_timer_frame_256_models", &setup_gpu_timer, &run_gpu_timer_frame,
+     &teardown_gpu_timer, 0, 0},
+    {"metrics_frame", 0, &run_metrics_frame, 0, 0, 0},
+    {"metrics_write", 0, &run_metrics_write, 0, 0, 0},
+    {"obj_load_grid_100k_triangles", &setup_obj_grid, &run_obj_load,
+     &teardown_obj, 0, 1},
+    {"obj_load_soup_20k_triangles", &setup_obj_soup, &run_obj_load,
+     &teardown_obj, 0, 1},
+    {"path_get_corresponding_texture_file", 0, &run_path, 0, 0, 0},
+    {"path_write_corresponding_texture_file", 0, &run_path_write, 0, 0, 0},
+    {"stringvec_append_get_1000", 0, &run_stringvec, 0, 0, 0},
+    {"modelvec_append_get_1000", 0, &run_modelvec, 0, 0, 0},
+    {"firewatch_dispatch_1000_events", &setup_firewatch, &run_firewatch, 0,
+     0, 0},
+};
+
+// Finds the entry of the benchmark `name` among `count` results, 0 if none.
+static const BenchResult *find_result(const BenchResult *results,
+                                      size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++)
+        if (!strcmp(results[i].name, name))
+            return results + i;
+    return 0;
+}
+
+// Writes the results to the baseline at `filepath`, in the order of
+// benchmarks[]. Benchmarks that were not run, filtered out or without an
+// OpenGL context, keep the entry they had in it so that a partial run never
+// drops them.
+static int save_results(const char *filepath, const BenchResult *results,
+                        size_t count, int timed) {
+    BenchResult previous[BENCH_MAX_RESULTS] = {0};
+    size_t previous_count =
+        read_baseline(filepath, previous, BENCH_MAX_RESULTS);
+
+    BenchResult merged[BENCH_MAX_RESULTS] = {0};
+    size_t merged_count = 0;
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(Benchmark); i++) {
+        const BenchResult *result =
+            find_result(results, count, benchmarks[i].name);
+        if (!result)
+            result =
+                find_result(previous, previous_count, benchmarks[i].name);
+        if (result)
+            merged[merged_count++] = *result;
+    }
+    return write_results(filepath, merged, merged_count, timed);
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: bench [-baseline file.json] [-save file.json] "
+            "[-save-allocations file.json]\n"
+            "             [-tolerance 0.10] [-time seconds] "
+            "[-filter substring] [-no-gl]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_filepath = 0;
+    const char *save_filepath = 0;
+    int save_timed = 1;
+    const char *filter = 0;
+    double tolerance = 0.10;
+    double min_time = 0.5;
+    int use_gl = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-baseline") && i + 1 < argc)
+            baseline_filepath = argv[++i];
+        else if (!strcmp(argv[i], "-save") && i + 1 < argc) {
+            save_filepath = argv[++i];
+            save_timed = 1;
+        } else if (!strcmp(argv[i], "-save-allocations") && i + 1 < argc) {
+            save_filepath = argv[++i];
+            save_timed = 0;
+        } else if (!strcmp(argv[i], "-tolerance") && i + 1 < argc)
+            tolerance = strtod(argv[++i], 0);
+        else if (!strcmp(argv[i], "-time") && i + 1 < argc)
+            min_time = strtod(argv[++i], 0);
+        else if (!strcmp(argv[i], "-filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "-no-gl"))
+            use_gl = 0;
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    BenchResult baseline[BENCH_MAX_RESULTS] = {0};
+    size_t baseline_count = 0;
+    if (baseline_filepath) {
+        baseline_count =
+            read_baseline(baseline_filepath, baseline, BENCH_MAX_RESULTS);
+        if (!baseline_count)
+            fprintf(stderr, "WARNING: no baseline entries read from %s\n",
+                    baseline_filepath);
+    }
+
+    if (use_gl) {
+        SetTraceLogLevel(LOG_WARNING);
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(64, 64, "bricklayer bench");
+    }
+
+    BenchResult results[BENCH_MAX_RESULTS] = {0};
+    size_t result_count = 0;
+    int regressions = 0;
+    int missing = 0;
+
+    printf("%-40s %12s %10s %12s %10s  %s\n", "benchmark", "ns/op", "allocs/op",
+           "bytes/op", "MB/s", "vs baseline");
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(Benchmark); i++) {
+        Benchmark *benchmark = benchmarks + i;
+        if (filter && !strstr(benchmark->name, filter))
+            continue;
+        if (benchmark->needs_gl && !use_gl)
+            continue;
+
+        BenchResult result = run_benchmark(benchmark, min_time);
+        results[result_count++] = result;
+
+        char comparison[64] = "no baseline";
+        const BenchResult *entry =
+            find_result(baseline, baseline_count, result.name);
+        if (baseline_count && !entry) {
+            snprintf(comparison, sizeof(comparison), "MISSING");
+            missing++;
+        } else if (entry) {
+            int more_allocations =
+                result.allocs_per_op > entry->allocs_per_op + 0.5;
+            if (!entry->ns_per_op) {
+                snprintf(comparison, sizeof(comparison), "%s",
+                         more_allocations ? "MORE ALLOCATIONS" : "ok");
+                regressions += more_allocations;
+            } else {
+                double change = result.ns_per_op / entry->ns_per_op - 1.0;
+                int slower = change > tolerance;
+                snprintf(comparison, sizeof(comparison), "%+.1f%%%s%s",
+                         change * 100.0, slower ? " REGRESSION" : "",
+                         more_allocations ? " MORE ALLOCATIONS" : "");
+                regressions += slower || more_allocations;
+            }
+        }
+
+        printf("%-40s %12.1f %10.2f %12.0f %10.1f  %s\n", result.name,
+               result.ns_per_op, result.allocs_per_op,
+               result.bytes_allocated_per_op, result.megabytes_per_second,
+               comparison);
+    }
+
+    if (use_gl)
+        CloseWindow();
+
+    if (save_filepath &&
+        save_results(save_filepath, results, result_count, save_timed)) {
+        fprintf(stderr, "ERROR: could not write %s\n", save_filepath);
+        return 1;
+    }
+
+    // A benchmark without an entry could never be flagged
+    if (missing)
+        printf("\n%d benchmark(s) missing from the baseline, record them "
+               "with \"make bench_baseline\".\n",
+               missing);
+    if (regressions)
+        printf("\n%d benchmark(s) regressed, allocating more or slower "
+               "beyond the %.0f%% tolerance.\n",
+               regressions, tolerance * 100.0);
+    return regressions || missing;
+}
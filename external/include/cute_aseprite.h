@@ -113,6 +113,15 @@ ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
                                       void *mem_ctx);
 void cute_aseprite_free(ase_t *aseprite);
 
+// Flags for cute_aseprite_load_from_memory_ex.
+//
+// CUTE_ASEPRITE_NO_COMPOSITE: Do not blend the cels into frame->pixels, which
+// is left NULL. For callers compositing the cels into their own buffers.
+#define CUTE_ASEPRITE_NO_COMPOSITE (1 << 0)
+
+ase_t *cute_aseprite_load_from_memory_ex(const void *memory, int size,
+                                         int flags, void *mem_ctx);
+
 #define CUTE_ASEPRITE_MAX_LAYERS (64)
 #define CUTE_ASEPRITE_MAX_SLICES (128)
 #define CUTE_ASEPRITE_MAX_PALETTE_ENTRIES (1024)
@@ -164,9 +173,34 @@ typedef enum ase_layer_type_t {
     ASE_LAYER_TYPE_GROUP,
 } ase_layer_type_t;
 
+// Layer blend modes, in the order of the file format.
+typedef enum ase_blend_mode_t {
+    ASE_BLEND_MODE_NORMAL,
+    ASE_BLEND_MODE_MULTIPLY,
+    ASE_BLEND_MODE_SCREEN,
+    ASE_BLEND_MODE_OVERLAY,
+    ASE_BLEND_MODE_DARKEN,
+    ASE_BLEND_MODE_LIGHTEN,
+    ASE_BLEND_MODE_COLOR_DODGE,
+    ASE_BLEND_MODE_COLOR_BURN,
+    ASE_BLEND_MODE_HARD_LIGHT,
+    ASE_BLEND_MODE_SOFT_LIGHT,
+    ASE_BLEND_MODE_DIFFERENCE,
+    ASE_BLEND_MODE_EXCLUSION,
+    ASE_BLEND_MODE_HUE,
+    ASE_BLEND_MODE_SATURATION,
+    ASE_BLEND_MODE_COLOR,
+    ASE_BLEND_MODE_LUMINOSITY,
+    ASE_BLEND_MODE_ADDITION,
+    ASE_BLEND_MODE_SUBTRACT,
+    ASE_BLEND_MODE_DIVIDE,
+    ASE_BLEND_MODE_COUNT,
+} ase_blend_mode_t;
+
 struct ase_layer_t {
     ase_layer_flags_t flags;
     ase_layer_type_t type;
+    ase_blend_mode_t blend_mode;
     const char *name;
     ase_layer_t *parent;
     float opacity;
@@ -188,6 +222,9 @@ struct ase_cel_t {
     float opacity;
     int is_linked;
     uint16_t linked_frame_index;
+    // For linked cels, the cel holding the pixels with all links resolved.
+    // NULL if the link is broken.
+    ase_cel_t *linked_cel;
     int has_extra;
     ase_cel_extra_chunk_t extra;
     ase_udata_t udata;
@@ -197,6 +234,9 @@ struct ase_frame_t {
     ase_t *ase;
     int duration_milliseconds;
     ase_color_t *pixels;
+    // Index of an earlier frame with the same cels after link resolution, or
+    // of this frame itself. Such frames share one `pixels` buffer.
+    int shared_frame_index;
     int cel_count;
     ase_cel_t cels[CUTE_ASEPRITE_MAX_LAYERS];
 };
@@ -297,6 +337,20 @@ struct ase_t {
     void *mem_ctx;
 };
 
+// The color `mode` gives for `src` over `backdrop`, before compositing.
+// Alphas are ignored, the result has the alpha of `src`.
+ase_color_t cute_aseprite_blend_color(ase_color_t backdrop, ase_color_t src,
+                                      ase_blend_mode_t mode);
+
+// Blends `src` over `dst` with `mode` and the cel and layer `opacity`, the way
+// the cels of a frame are composited. This is the reference for any faster
+// implementation.
+//
+// Blended colors are mixed with `src` by the alpha of `dst` before the normal
+// blend, so that blending over transparent pixels shows the source as is.
+ase_color_t cute_aseprite_blend(ase_color_t src, ase_color_t dst,
+                                uint8_t opacity, ase_blend_mode_t mode);
+
 #endif // CUTE_ASEPRITE_H
 
 #ifdef CUTE_ASEPRITE_IMPLEMENTATION
@@ -340,6 +394,11 @@ struct ase_t {
 #define CUTE_ASEPRITE_ASSERT assert
 #endif
 
+#if !defined(CUTE_ASEPRITE_SQRT)
+#include <math.h> // sqrt
+#define CUTE_ASEPRITE_SQRT sqrt
+#endif
+
 #if !defined(CUTE_ASEPRITE_SEEK_SET)
 #include <stdio.h> // SEEK_SET
 #define CUTE_ASEPRITE_SEEK_SET SEEK_SET
@@ -921,6 +980,208 @@ static int s_max(int a, int b) {
     return a < b ? b : a;
 }
 
+// round(x / 255) for 0 <= x <= 255 * 255.
+static int s_div_255(int x) {
+    int t = x + 0x80;
+    return (((t >> 8) + t) >> 8);
+}
+
+// a / b in 8-bit fixed point, for 0 <= a < b.
+static int s_div_un8(int a, int b) {
+    return (a * 0xff + (b / 2)) / b;
+}
+
+static int s_blend_screen(int b, int s) {
+    return b + s - s_mul_un8(b, s);
+}
+
+static int s_blend_hard_light(int b, int s) {
+    if (s < 128) {
+        return s_mul_un8(b, s << 1);
+    }
+    return s_blend_screen(b, (s << 1) - 255);
+}
+
+static int s_blend_soft_light(int b_int, int s_int) {
+    double b = b_int / 255.0;
+    double s = s_int / 255.0;
+    double d = b <= 0.25 ? ((16 * b - 12) * b + 4) * b : CUTE_ASEPRITE_SQRT(b);
+    double r;
+    if (s <= 0.5) {
+        r = b - (1.0 - 2.0 * s) * b * (1.0 - b);
+    } else {
+        r = b + (2.0 * s - 1.0) * (d - b);
+    }
+    return (int)(r * 255 + 0.5);
+}
+
+// Separable blend modes, per color channel of backdrop `b` and source `s`.
+static int s_blend_channel(ase_blend_mode_t mode, int b, int s) {
+    switch (mode) {
+    case ASE_BLEND_MODE_MULTIPLY:
+        return s_mul_un8(b, s);
+    case ASE_BLEND_MODE_SCREEN:
+        return s_blend_screen(b, s);
+    case ASE_BLEND_MODE_OVERLAY:
+        return s_blend_hard_light(s, b);
+    case ASE_BLEND_MODE_DARKEN:
+        return s_min(b, s);
+    case ASE_BLEND_MODE_LIGHTEN:
+        return s_max(b, s);
+    case ASE_BLEND_MODE_COLOR_DODGE:
+        if (b == 0) {
+            return 0;
+        }
+        s = 255 - s;
+        return b >= s ? 255 : s_div_un8(b, s);
+    case ASE_BLEND_MODE_COLOR_BURN:
+        if (b == 255) {
+            return 255;
+        }
+        b = 255 - b;
+        return b >= s ? 0 : 255 - s_div_un8(b, s);
+    case ASE_BLEND_MODE_HARD_LIGHT:
+        return s_blend_hard_light(b, s);
+    case ASE_BLEND_MODE_SOFT_LIGHT:
+        return s_blend_soft_light(b, s);
+    case ASE_BLEND_MODE_DIFFERENCE:
+        return b > s ? b - s : s - b;
+    case ASE_BLEND_MODE_EXCLUSION:
+        return b + s - 2 * s_mul_un8(b, s);
+    case ASE_BLEND_MODE_ADDITION:
+        return s_min(b + s, 255);
+    case ASE_BLEND_MODE_SUBTRACT:
+        return s_max(b - s, 0);
+    case ASE_BLEND_MODE_DIVIDE:
+        if (b == 0) {
+            return 0;
+        }
+        return b >= s ? 255 : s_div_un8(b, s);
+    default:
+        return s;
+    }
+}
+
+// Helpers of the non-separable blend modes, on colors in [0, 1].
+
+static double s_lum(double r, double g, double b) {
+    return 0.3 * r + 0.59 * g + 0.11 * b;
+}
+
+static double s_sat(double r, double g, double b) {
+    double max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    double min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    return max - min;
+}
+
+static void s_clip_color(double *r, double *g, double *b) {
+    double l = s_lum(*r, *g, *b);
+    double n = *r < *g ? (*r < *b ? *r : *b) : (*g < *b ? *g : *b);
+    double x = *r > *g ? (*r > *b ? *r : *b) : (*g > *b ? *g : *b);
+    if (n < 0) {
+        *r = l + (((*r - l) * l) / (l - n));
+        *g = l + (((*g - l) * l) / (l - n));
+        *b = l + (((*b - l) * l) / (l - n));
+    }
+    if (x > 1) {
+        *r = l + (((*r - l) * (1 - l)) / (x - l));
+        *g = l + (((*g - l) * (1 - l)) / (x - l));
+        *b = l + (((*b - l) * (1 - l)) / (x - l));
+    }
+}
+
+static void s_set_lum(double *r, double *g, double *b, double l) {
+    double d = l - s_lum(*r, *g, *b);
+    *r += d;
+    *g += d;
+    *b += d;
+    s_clip_color(r, g, b);
+}
+
+static void s_set_sat(double *r, double *g, double *b, double s) {
+    double *min = r;
+    double *mid = g;
+    double *max = b;
+    double *swap;
+    if (*min > *mid) {
+        swap = min;
+        min = mid;
+        mid = swap;
+    }
+    if (*mid > *max) {
+        swap = mid;
+        mid = max;
+        max = swap;
+    }
+    if (*min > *mid) {
+        swap = min;
+        min = mid;
+        mid = swap;
+    }
+    if (*max > *min) {
+        *mid = ((*mid - *min) * s) / (*max - *min);
+        *max = s;
+    } else {
+        *mid = *max = 0;
+    }
+    *min = 0;
+}
+
+ase_color_t cute_aseprite_blend_color(ase_color_t backdrop, ase_color_t src,
+                                      ase_blend_mode_t mode) {
+    ase_color_t result = src;
+    if (mode < ASE_BLEND_MODE_HUE || mode > ASE_BLEND_MODE_LUMINOSITY) {
+        result.r = (uint8_t)s_blend_channel(mode, backdrop.r, src.r);
+        result.g = (uint8_t)s_blend_channel(mode, backdrop.g, src.g);
+        result.b = (uint8_t)s_blend_channel(mode, backdrop.b, src.b);
+        return result;
+    }
+
+    double br = backdrop.r / 255.0, bg = backdrop.g / 255.0,
+           bb = backdrop.b / 255.0;
+    double sr = src.r / 255.0, sg = src.g / 255.0, sb = src.b / 255.0;
+    double r, g, b;
+    switch (mode) {
+    case ASE_BLEND_MODE_HUE:
+        r = sr, g = sg, b = sb;
+        s_set_sat(&r, &g, &b, s_sat(br, bg, bb));
+        s_set_lum(&r, &g, &b, s_lum(br, bg, bb));
+        break;
+    case ASE_BLEND_MODE_SATURATION:
+        r = br, g = bg, b = bb;
+        s_set_sat(&r, &g, &b, s_sat(sr, sg, sb));
+        s_set_lum(&r, &g, &b, s_lum(br, bg, bb));
+        break;
+    case ASE_BLEND_MODE_COLOR:
+        r = sr, g = sg, b = sb;
+        s_set_lum(&r, &g, &b, s_lum(br, bg, bb));
+        break;
+    default: // Luminosity
+        r = br, g = bg, b = bb;
+        s_set_lum(&r, &g, &b, s_lum(sr, sg, sb));
+        break;
+    }
+    result.r = (uint8_t)(255.0 * r);
+    result.g = (uint8_t)(255.0 * g);
+    result.b = (uint8_t)(255.0 * b);
+    return result;
+}
+
+ase_color_t cute_aseprite_blend(ase_color_t src, ase_color_t dst,
+                                uint8_t opacity, ase_blend_mode_t mode) {
+    if (mode != ASE_BLEND_MODE_NORMAL) {
+        ase_color_t blended = cute_aseprite_blend_color(dst, src, mode);
+        int backdrop_a = dst.a;
+        src.r = (uint8_t)s_div_255(src.r * (255 - backdrop_a) +
+                                   blended.r * backdrop_a);
+        src.g = (uint8_t)s_div_255(src.g * (255 - backdrop_a) +
+                                   blended.g * backdrop_a);
+        src.b = (uint8_t)s_div_255(src.b * (255 - backdrop_a) +
+                                   blended.b * backdrop_a);
+    }
+    return s_blend(src, dst, opacity);
+}
+
 static ase_color_t s_color(ase_t *ase, void *src, int index) {
     ase_color_t result;
     if (ase->mode == ASE_MODE_RGBA) {
@@ -947,6 +1208,128 @@ static ase_color_t s_color(ase_t *ase, void *src, int index) {
 
 ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
                                       void *mem_ctx) {
+    return cute_aseprite_load_from_memory_ex(memory, size, 0, mem_ctx);
+}
+
+// Points every linked cel at the cel holding its pixels. Uses a table of the
+// cel of each layer in each frame, so that following a link is a lookup
+// rather than a search through the cels of the linked frame.
+static void s_resolve_links(ase_t *ase, void *mem_ctx) {
+    // Only passed on to the allocator, which may ignore it
+    CUTE_ASEPRITE_UNUSED(mem_ctx);
+    int layer_count = ase->layer_count;
+    int has_links = 0;
+    for (int i = 0; i < ase->frame_count && !has_links; ++i) {
+        for (int j = 0; j < ase->frames[i].cel_count; ++j) {
+            has_links |= ase->frames[i].cels[j].is_linked;
+        }
+    }
+    if (!has_links || !layer_count) {
+        return;
+    }
+    size_t table_size = (size_t)ase->frame_count * (size_t)layer_count;
+    ase_cel_t **layer_cels = (ase_cel_t **)CUTE_ASEPRITE_ALLOC(
+        (int)(sizeof(ase_cel_t *) * table_size), mem_ctx);
+    CUTE_ASEPRITE_MEMSET(layer_cels, 0, sizeof(ase_cel_t *) * table_size);
+    for (int i = 0; i < ase->frame_count; ++i) {
+        ase_frame_t *frame = ase->frames + i;
+        for (int j = 0; j < frame->cel_count; ++j) {
+            int layer = (int)(frame->cels[j].layer - ase->layers);
+            if (layer >= 0 && layer < layer_count) {
+                layer_cels[(size_t)i * (size_t)layer_count + (size_t)layer] =
+                    frame->cels + j;
+            }
+        }
+    }
+
+    for (int i = 0; i < ase->frame_count; ++i) {
+        ase_frame_t *frame = ase->frames + i;
+        for (int j = 0; j < frame->cel_count; ++j) {
+            ase_cel_t *cel = frame->cels + j;
+            if (!cel->is_linked) {
+                continue;
+            }
+            int layer = (int)(cel->layer - ase->layers);
+            ase_cel_t *target = cel;
+            // Links point to earlier frames, which are already resolved, the
+            // hop limit only guards against malformed files.
+            for (int hops = 0; target && target->is_linked; ++hops) {
+                if (target->linked_cel || hops > ase->frame_count) {
+                    target = target->linked_cel;
+                    break;
+                }
+                if (target->linked_frame_index >= ase->frame_count ||
+                    layer < 0 || layer >= layer_count) {
+                    target = NULL;
+                    break;
+                }
+                target = layer_cels[(size_t)target->linked_frame_index *
+                                        (size_t)layer_count +
+                                    (size_t)layer];
+            }
+            cel->linked_cel = target;
+        }
+    }
+    CUTE_ASEPRITE_FREE(layer_cels, mem_ctx);
+}
+
+static ase_cel_t *s_pixel_cel(ase_cel_t *cel) {
+    return cel->is_linked ? cel->linked_cel : cel;
+}
+
+static int s_same_cels(ase_frame_t *a, ase_frame_t *b) {
+    if (a->cel_count != b->cel_count) {
+        return 0;
+    }
+    for (int i = 0; i < a->cel_count; ++i) {
+        if (a->cels[i].layer != b->cels[i].layer) {
+            return 0;
+        }
+        ase_cel_t *pixel_cel = s_pixel_cel(a->cels + i);
+        if (!pixel_cel || pixel_cel != s_pixel_cel(b->cels + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Sets the shared_frame_index of every frame. A frame is compared with the
+// previous frame, which catches held frames, and with the frame its newest
+// cel comes from, which catches returning to an earlier pose.
+static void s_find_shared_frames(ase_t *ase) {
+    for (int i = 0; i < ase->frame_count; ++i) {
+        ase_frame_t *frame = ase->frames + i;
+        frame->shared_frame_index = i;
+        if (!i) {
+            continue;
+        }
+
+        int newest = 0;
+        for (int j = 0; j < frame->cel_count; ++j) {
+            ase_cel_t *pixel_cel = s_pixel_cel(frame->cels + j);
+            if (!pixel_cel) {
+                continue;
+            }
+            int source =
+                (int)((size_t)((char *)pixel_cel - (char *)ase->frames) /
+                      sizeof(ase_frame_t));
+            newest = s_max(newest, source);
+        }
+
+        int candidates[2] = {ase->frames[i - 1].shared_frame_index,
+                             ase->frames[newest].shared_frame_index};
+        for (int j = 0; j < 2; ++j) {
+            if (candidates[j] < i &&
+                s_same_cels(ase->frames + candidates[j], frame)) {
+                frame->shared_frame_index = candidates[j];
+                break;
+            }
+        }
+    }
+}
+
+ase_t *cute_aseprite_load_from_memory_ex(const void *memory, int size,
+                                         int flags, void *mem_ctx) {
     ase_t *ase = (ase_t *)CUTE_ASEPRITE_ALLOC(sizeof(ase_t), mem_ctx);
     CUTE_ASEPRITE_MEMSET(ase, 0, sizeof(*ase));
 
@@ -1070,8 +1453,11 @@ ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
                     sizeof(
                         uint16_t)); // Default layer height in pixels (ignored).
                 int blend_mode = (int)s_read_uint16(s);
-                if (blend_mode)
+                if (blend_mode >= ASE_BLEND_MODE_COUNT) {
                     CUTE_ASEPRITE_WARNING("Unknown blend mode encountered.");
+                    blend_mode = ASE_BLEND_MODE_NORMAL;
+                }
+                layer->blend_mode = (ase_blend_mode_t)blend_mode;
                 layer->opacity = s_read_uint8(s) / 255.0f;
                 if (!valid_layer_opacity)
                     layer->opacity = 1.0f;
@@ -1288,10 +1674,18 @@ ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
         }
     }
 
+    s_resolve_links(ase, mem_ctx);
+    s_find_shared_frames(ase);
+
     // Blend all cel pixels into each of their respective frames, for
-    // convenience.
-    for (int i = 0; i < ase->frame_count; ++i) {
+    // convenience. Frames identical to an earlier one share its pixels.
+    int composite = !(flags & CUTE_ASEPRITE_NO_COMPOSITE);
+    for (int i = 0; composite && i < ase->frame_count; ++i) {
         ase_frame_t *frame = ase->frames + i;
+        if (frame->shared_frame_index != i) {
+            frame->pixels = ase->frames[frame->shared_frame_index].pixels;
+            continue;
+        }
         frame->pixels = (ase_color_t *)CUTE_ASEPRITE_ALLOC(
             (int)(sizeof(ase_color_t)) * ase->w * ase->h, mem_ctx);
         CUTE_ASEPRITE_MEMSET(frame->pixels, 0,
@@ -1307,17 +1701,12 @@ ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
                 !(cel->layer->parent->flags & ASE_LAYER_FLAGS_VISIBLE)) {
                 continue;
             }
-            while (cel->is_linked) {
-                ase_frame_t *frame = ase->frames + cel->linked_frame_index;
-                int found = 0;
-                for (int k = 0; k < frame->cel_count; ++k) {
-                    if (frame->cels[k].layer == cel->layer) {
-                        cel = frame->cels + k;
-                        found = 1;
-                        break;
-                    }
+            if (cel->is_linked) {
+                cel = cel->linked_cel;
+                CUTE_ASEPRITE_ASSERT(cel);
+                if (!cel) {
+                    continue;
                 }
-                CUTE_ASEPRITE_ASSERT(found);
             }
             void *src = cel->pixels;
             uint8_t opacity =
@@ -1338,7 +1727,9 @@ ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
                     int dst_index = aw * dy + dx;
                     ase_color_t src_color = s_color(ase, src, cw * sy + sx);
                     ase_color_t dst_color = dst[dst_index];
-                    ase_color_t result = s_blend(src_color, dst_color, opacity);
+                    ase_color_t result =
+                        cute_aseprite_blend(src_color, dst_color, opacity,
+                                            cel->layer->blend_mode);
                     dst[dst_index] = result;
                 }
             }
@@ -1352,7 +1743,9 @@ ase_t *cute_aseprite_load_from_memory(const void *memory, int size,
 void cute_aseprite_free(ase_t *ase) {
     for (int i = 0; i < ase->frame_count; ++i) {
         ase_frame_t *frame = ase->frames + i;
-        CUTE_ASEPRITE_FREE(frame->pixels, ase->mem_ctx);
+        if (frame->shared_frame_index == i) {
+            CUTE_ASEPRITE_FREE(frame->pixels, ase->mem_ctx);
+        }
         for (int j = 0; j < frame->cel_count; ++j) {
             ase_cel_t *cel = frame->cels + j;
             CUTE_ASEPRITE_FREE(cel->pixels, ase->mem_ctx);
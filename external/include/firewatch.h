@@ -55,6 +55,15 @@ typedef struct {
     size_t data_used;
 } FileInfoVector;
 
+typedef struct {
+    // Changes to watched files seen so far
+    size_t events;
+    // Changes lost because the kernel's event queue overflowed
+    size_t dropped;
+    // Changes waiting for firewatch_check
+    size_t queued;
+} FirewatchStats;
+
 // Registers a new file at `filepath` to be watched by firewatch.
 //
 // `filepath`: The file to watch. Must be a file, not a directory. The parent
@@ -72,7 +81,11 @@ typedef struct {
 // needs to be loaded from the current thread, put 0 here. In that case,
 // `on_change_callback` will be called from the current thread when the
 // firewatch_check function is called.
-void firewatch_new_file(const char *filepath, uint64_t cookie,
+//
+// The `on_change_callback` is called once right away for the initial load.
+// Returns 0 on success, 1 if the watch could not be created, in which case
+// the callback is not called.
+int firewatch_new_file(const char *filepath, uint64_t cookie,
                         FileRefreshFunction on_change_callback,
                         int load_instantly);
 
@@ -80,6 +93,9 @@ void firewatch_new_file(const char *filepath, uint64_t cookie,
 // when `load_instantly` of firewatch_new_file is set to 0).
 void firewatch_check(void);
 
+// Counts of the file changes seen, safe to call from any thread.
+FirewatchStats firewatch_stats(void);
+
 #endif // _FIREWATCH
 #ifdef FIREWATCH_IMPLEMENTATION
 
@@ -105,6 +121,16 @@ size_t fileinfovec_append(FileInfoVector *vec, FileInfo data) {
     return vec->data_used - 1;
 }
 
+// Grows the capacity of `vec` to at least `count` elements.
+void fileinfovec_reserve(FileInfoVector *vec, size_t count) {
+    if (vec->data_allocated >= count)
+        return;
+    vec->data_allocated = count;
+    vec->data = realloc(vec->data, vec->data_allocated * sizeof(FileInfo));
+    if (!vec->data)
+        abort();
+}
+
 FileInfo *fileinfovec_get(FileInfoVector *vec, size_t index) {
     if (index >= vec->data_used)
         return 0;
@@ -128,6 +154,9 @@ static int fw_inotify_fp = -1;
 static pthread_t fw_thread_id = 0;
 static pthread_mutex_t fw_lock;
 static FileInfoVector fw_needs_refresh_queue = {0};
+static size_t fw_watched_file_count = 0;
+static size_t fw_event_count = 0;
+static size_t fw_dropped_count = 0;
 
 // Last occurrence of character '/' in `string` plus one.
 // Returns 0 if no slashes in `string`.
@@ -154,8 +183,14 @@ static void *fw_watch_for_changes(void *_a) {
         size = read(fw_inotify_fp, buf, _BUF_SIZE);
         i = 0;
         while (i < size) {
-            struct inotify_event *event = (struct inotify_event *)buf + i;
+            struct inotify_event *event = (struct inotify_event *)(buf + i);
             i += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                pthread_mutex_lock(&fw_lock);
+                fw_dropped_count++;
+                pthread_mutex_unlock(&fw_lock);
+                continue;
+            }
             if (!event->mask || !event->len || event->wd <= 0)
                 continue;
             if (!fw_file_info_lists[event->wd].data)
@@ -171,6 +206,7 @@ static void *fw_watch_for_changes(void *_a) {
                 if (strcmp(file_info->filepath + file_info->filename_offset,
                            event->name))
                     continue;
+                fw_event_count++;
 
                 // Two methods, stack and callback
                 if (file_info->using_stack) {
@@ -208,11 +244,12 @@ static inline void _fw_ensure_init(void) {
 #endif // FIREWATCH_NO_RELOAD
 
 //  TODO: Return handle, removable watch
-void firewatch_new_file(const char *filepath, uint64_t cookie,
+int firewatch_new_file(const char *filepath, uint64_t cookie,
                         FileRefreshFunction on_change_callback,
                         int load_instantly) {
 #ifdef FIREWATCH_NO_RELOAD
     (*on_change_callback)(filepath, cookie);
+    return 0;
 #else
     _fw_ensure_init();
 
@@ -239,7 +276,7 @@ void firewatch_new_file(const char *filepath, uint64_t cookie,
                 "ERROR: could not begin watching changes on file %s, maybe "
                 "the parent directory of the file does not exist?\n",
                 filepath);
-        return;
+        return 1;
     }
 
     pthread_mutex_lock(&fw_lock);
@@ -248,9 +285,15 @@ void firewatch_new_file(const char *filepath, uint64_t cookie,
         fw_file_info_lists[wd] = fileinfovec_init();
     fileinfovec_append(fw_file_info_lists + wd, file_info);
 
+    // Room for a close and a move event per file so that queueing changes
+    // does not allocate in the common case
+    fw_watched_file_count++;
+    fileinfovec_reserve(&fw_needs_refresh_queue, fw_watched_file_count * 2);
+
     pthread_mutex_unlock(&fw_lock);
 
     (*on_change_callback)(filepath, cookie);
+    return 0;
 #endif
 }
 
@@ -274,4 +317,16 @@ void firewatch_check(void) {
 #endif
 }
 
+FirewatchStats firewatch_stats(void) {
+    FirewatchStats stats = {0};
+#ifndef FIREWATCH_NO_RELOAD
+    pthread_mutex_lock(&fw_lock);
+    stats.events = fw_event_count;
+    stats.dropped = fw_dropped_count;
+    stats.queued = fw_needs_refresh_queue.data_used;
+    pthread_mutex_unlock(&fw_lock);
+#endif
+    return stats;
+}
+
 #endif // FIREWATCH_IMPLEMENTATION
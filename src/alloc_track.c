@@ -0,0 +1,65 @@
+#include "alloc_track.h"
+#include <stdatomic.h>
+
+#ifdef ALLOC_TRACK
+
+// Atomic as the file watcher thread allocates too
+static atomic_size_t allocation_count = 0;
+static atomic_size_t allocation_bytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+static inline void count_allocation(size_t size) {
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocation_bytes, size, memory_order_relaxed);
+}
+
+void *__wrap_malloc(size_t size) {
+    count_allocation(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    count_allocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    count_allocation(size);
+    return __real_realloc(pointer, size);
+}
+
+int alloc_track_enabled(void) {
+    return 1;
+}
+
+AllocCount alloc_track_total(void) {
+    return (AllocCount){
+        .count =
+            atomic_load_explicit(&allocation_count, memory_order_relaxed),
+        .bytes =
+            atomic_load_explicit(&allocation_bytes, memory_order_relaxed),
+    };
+}
+
+#else
+
+int alloc_track_enabled(void) {
+    return 0;
+}
+
+AllocCount alloc_track_total(void) {
+    return (AllocCount){0};
+}
+
+#endif
+
+AllocCount alloc_track_since(AllocCount start) {
+    AllocCount now = alloc_track_total();
+    return (AllocCount){
+        .count = now.count - start.count,
+        .bytes = now.bytes - start.bytes,
+    };
+}
@@ -0,0 +1,25 @@
+#ifndef _ALLOC_TRACK
+#define _ALLOC_TRACK
+
+// Heap allocation counting. When built with ALLOC_TRACK defined and linked
+// with the linker's --wrap option for malloc, calloc and realloc (see
+// CFLAGS_ALLOC_TRACK in the Makefile), every allocation made by bricklayer,
+// libebb and the header-only libraries is counted. Allocations made inside
+// shared libraries such as raylib are not seen. Without ALLOC_TRACK the
+// counters always stay at zero.
+
+#include <stddef.h>
+
+typedef struct {
+    size_t count;
+    size_t bytes;
+} AllocCount;
+
+// 1 if allocations are counted in this build.
+int alloc_track_enabled(void);
+// Allocations made since the start of the program, from all threads.
+AllocCount alloc_track_total(void);
+// Allocations made since `start`, a value returned by alloc_track_total.
+AllocCount alloc_track_since(AllocCount start);
+
+#endif
@@ -0,0 +1,254 @@
+#include "ase_compose.h"
+#include "blend.h"
+#include "metrics.h"
+#include "timings.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ase_t *ase_compose_load(const char *filepath) {
+    FILE *file = fopen(filepath, "rb");
+    if (!file)
+        return 0;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // Shorter than the header, not an aseprite file
+    if (size < 128) {
+        fclose(file);
+        return 0;
+    }
+
+    void *memory = malloc((size_t)size);
+    if (!memory)
+        abort();
+    size_t read = fread(memory, 1, (size_t)size, file);
+    fclose(file);
+
+    ase_t *ase = 0;
+    double start = timings_now();
+    if (read == (size_t)size)
+        ase = cute_aseprite_load_from_memory_ex(
+            memory, (int)size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    free(memory);
+    if (ase) {
+        metrics_count(METRIC_DECODE_NANOSECONDS,
+                      (uint64_t)((timings_now() - start) * 1e9));
+        metrics_count(METRIC_DECODE_FILE_BYTES, (uint64_t)size);
+        metrics_count(METRIC_DECODE_PIXEL_BYTES,
+                      (uint64_t)ase->w * (uint64_t)ase->h * 4 *
+                          (uint64_t)ase->frame_count);
+    }
+    return ase;
+}
+
+// Pixels of non-RGBA cels converted at a time before blending
+#define COMPOSE_CHUNK_SIZE 256
+// Bytes of rows composited at a time by ase_compose_upload
+#define COMPOSE_BAND_SIZE (256 * 1024)
+
+// The color conversion below matches cute_aseprite exactly, the blending is
+// done by blend_row.
+
+static inline ase_color_t cel_color(ase_t *ase, const void *src, int index) {
+    if (ase->mode == ASE_MODE_RGBA)
+        return ((const ase_color_t *)src)[index];
+
+    if (ase->mode == ASE_MODE_GRAYSCALE) {
+        uint8_t value = ((const uint8_t *)src)[index * 2];
+        uint8_t alpha = ((const uint8_t *)src)[index * 2 + 1];
+        return (ase_color_t){value, value, value, alpha};
+    }
+
+    uint8_t palette_index = ((const uint8_t *)src)[index];
+    if (palette_index == ase->transparent_palette_entry_index)
+        return (ase_color_t){0};
+    return ase->palette.entries[palette_index].color;
+}
+
+ase_cel_t *ase_compose_resolve_cel(ase_cel_t *cel) {
+    if (!cel->is_linked)
+        return cel;
+    // Resolved by cute_aseprite while loading
+    return cel->linked_cel;
+}
+
+int ase_compose_cel_visible(const ase_cel_t *cel) {
+    if (!(cel->layer->flags & ASE_LAYER_FLAGS_VISIBLE))
+        return 0;
+    if (cel->layer->parent &&
+        !(cel->layer->parent->flags & ASE_LAYER_FLAGS_VISIBLE))
+        return 0;
+    return 1;
+}
+
+uint8_t ase_compose_cel_opacity(const ase_cel_t *cel) {
+    return (uint8_t)(cel->opacity * cel->layer->opacity * 255.0f);
+}
+
+void ase_compose_decode_cel(ase_t *ase, const ase_cel_t *cel,
+                            ase_color_t *out) {
+    int count = cel->w * cel->h;
+    if (ase->mode == ASE_MODE_RGBA) {
+        memcpy(out, cel->pixels, (size_t)count * sizeof(ase_color_t));
+        return;
+    }
+    for (int i = 0; i < count; i++)
+        out[i] = cel_color(ase, cel->pixels, i);
+}
+
+// Part of `cel` inside the rectangle at `x`, `y` of `w` x `h` canvas pixels,
+// in cel coordinates.
+static inline void clip_cel(const ase_cel_t *cel, int x, int y, int w,
+                            int h, int *left, int *top, int *right,
+                            int *bottom) {
+    *left = cel->x < x ? x - cel->x : 0;
+    *top = cel->y < y ? y - cel->y : 0;
+    *right = cel->w;
+    if (cel->x + *right > x + w)
+        *right = x + w - cel->x;
+    *bottom = cel->h;
+    if (cel->y + *bottom > y + h)
+        *bottom = y + h - cel->y;
+}
+
+// Blends `pixels` of `cel` into `target` holding the rectangle at `x`, `y` of
+// `w` x `h` canvas pixels.
+static void blend_cel_rect(const ase_cel_t *cel, const ase_color_t *pixels,
+                           uint8_t opacity, const AseComposeTarget *target,
+                           int x, int y, int w, int h) {
+    int left, top, right, bottom;
+    clip_cel(cel, x, y, w, h, &left, &top, &right, &bottom);
+    if (right <= left)
+        return;
+
+    for (int sy = top; sy < bottom; sy++) {
+        ase_color_t *row = (ase_color_t *)(target->pixels +
+                                           (size_t)(cel->y + sy - y) *
+                                               target->stride);
+        blend_row(cel->layer->blend_mode, pixels + cel->w * sy + left,
+                  row + cel->x + left - x, right - left, opacity);
+    }
+}
+
+void ase_compose_blend_cel(ase_t *ase, const ase_cel_t *cel,
+                           const ase_color_t *pixels, uint8_t opacity,
+                           const AseComposeTarget *target) {
+    blend_cel_rect(cel, pixels, opacity, target, 0, 0, ase->w, ase->h);
+}
+
+void ase_compose_region(ase_t *ase, int frame_index, int x, int y, int w,
+                        int h, const AseComposeTarget *target) {
+    assert(frame_index >= 0 && frame_index < ase->frame_count);
+    assert(x >= 0 && y >= 0 && x + w <= ase->w && y + h <= ase->h);
+    assert(target->stride >= (size_t)w * sizeof(ase_color_t));
+
+    for (int row = 0; row < h; row++)
+        memset(target->pixels + (size_t)row * target->stride, 0,
+               (size_t)w * sizeof(ase_color_t));
+
+    ase_frame_t *frame = ase->frames + frame_index;
+    for (int i = 0; i < frame->cel_count; i++) {
+        ase_cel_t *cel = frame->cels + i;
+        if (!ase_compose_cel_visible(cel))
+            continue;
+
+        cel = ase_compose_resolve_cel(cel);
+        if (!cel)
+            continue;
+
+        uint8_t opacity = ase_compose_cel_opacity(cel);
+        if (ase->mode == ASE_MODE_RGBA) {
+            blend_cel_rect(cel, cel->pixels, opacity, target, x, y, w, h);
+            continue;
+        }
+
+        int left, top, right, bottom;
+        clip_cel(cel, x, y, w, h, &left, &top, &right, &bottom);
+        ase_color_t converted[COMPOSE_CHUNK_SIZE];
+        for (int sy = top; sy < bottom; sy++) {
+            ase_color_t *row =
+                (ase_color_t *)(target->pixels +
+                                (size_t)(cel->y + sy - y) * target->stride);
+            for (int sx = left; sx < right; sx += COMPOSE_CHUNK_SIZE) {
+                int count = right - sx;
+                if (count > COMPOSE_CHUNK_SIZE)
+                    count = COMPOSE_CHUNK_SIZE;
+                for (int j = 0; j < count; j++)
+                    converted[j] =
+                        cel_color(ase, cel->pixels, cel->w * sy + sx + j);
+                blend_row(cel->layer->blend_mode, converted,
+                          row + cel->x + sx - x, count, opacity);
+            }
+        }
+    }
+
+    if (target->format == ASE_COMPOSE_BGRA8) {
+        for (int row_index = 0; row_index < h; row_index++) {
+            ase_color_t *row =
+                (ase_color_t *)(target->pixels +
+                                (size_t)row_index * target->stride);
+            for (int column = 0; column < w; column++) {
+                uint8_t red = row[column].r;
+                row[column].r = row[column].b;
+                row[column].b = red;
+            }
+        }
+    }
+}
+
+void ase_compose_frame(ase_t *ase, int frame_index,
+                       const AseComposeTarget *target) {
+    ase_compose_region(ase, frame_index, 0, 0, ase->w, ase->h, target);
+}
+
+Texture ase_compose_upload(StagingRing *ring, ase_t *ase, Texture reuse) {
+    size_t stride = (size_t)ase->w * sizeof(ase_color_t);
+    uint8_t *staging = staging_ring_reserve(ring, stride * (size_t)ase->h);
+    if (staging) {
+        // The ring may be write only, so the blending happens in a band of
+        // rows small enough to stay in cache and is copied over from there
+        int band_rows = (int)(COMPOSE_BAND_SIZE / stride);
+        if (band_rows < 1)
+            band_rows = 1;
+        if (band_rows > ase->h)
+            band_rows = ase->h;
+        AseComposeTarget band = {
+            .pixels = malloc(stride * (size_t)band_rows),
+            .stride = stride,
+            .format = ASE_COMPOSE_RGBA8,
+        };
+        if (!band.pixels)
+            abort();
+        for (int y = 0; y < ase->h; y += band_rows) {
+            int rows = ase->h - y < band_rows ? ase->h - y : band_rows;
+            ase_compose_region(ase, 0, 0, y, ase->w, rows, &band);
+            memcpy(staging + (size_t)y * stride, band.pixels,
+                   (size_t)rows * stride);
+        }
+        free(band.pixels);
+        return staging_ring_upload_texture(ring, ase->w, ase->h, reuse);
+    }
+
+    Image image = {
+        .data = malloc(stride * (size_t)ase->h),
+        .width = ase->w,
+        .height = ase->h,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    if (!image.data)
+        abort();
+    AseComposeTarget target = {
+        .pixels = image.data,
+        .stride = stride,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+    ase_compose_frame(ase, 0, &target);
+    Texture texture = LoadTextureFromImage(image);
+    free(image.data);
+    return texture;
+}
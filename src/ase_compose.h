@@ -0,0 +1,70 @@
+#ifndef _ASE_COMPOSE
+#define _ASE_COMPOSE
+
+// Composites the cels of an aseprite file loaded with
+// CUTE_ASEPRITE_NO_COMPOSITE straight into caller memory, such as the staging
+// ring, a mapped cache file or a sub-rectangle of an atlas. The result is the
+// same as the frame->pixels cute_aseprite would have produced.
+
+#include "cute_aseprite.h"
+#include "raylib.h"
+#include "staging_ring.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    ASE_COMPOSE_RGBA8,
+    ASE_COMPOSE_BGRA8,
+} AseComposeFormat;
+
+typedef struct {
+    // First pixel of the destination, ase->w x ase->h pixels are written
+    uint8_t *pixels;
+    // Bytes from the start of one row to the next
+    size_t stride;
+    AseComposeFormat format;
+} AseComposeTarget;
+
+// Reads and parses an .aseprite file without compositing its frames. Free the
+// result with cute_aseprite_free. Returns 0 on failure.
+ase_t *ase_compose_load(const char *filepath);
+
+// The cel holding the pixels of `cel`, following links to earlier frames.
+// Returns 0 if the link is broken.
+ase_cel_t *ase_compose_resolve_cel(ase_cel_t *cel);
+
+// Whether `cel` is drawn with the visibility flags of its layers.
+int ase_compose_cel_visible(const ase_cel_t *cel);
+
+// Opacity `cel` is blended with, from the cel and layer opacity.
+uint8_t ase_compose_cel_opacity(const ase_cel_t *cel);
+
+// Converts the pixels of the resolved `cel` to RGBA, cel->w * cel->h pixels
+// are written to `out`.
+void ase_compose_decode_cel(ase_t *ase, const ase_cel_t *cel,
+                            ase_color_t *out);
+
+// Blends RGBA `pixels` of a cel at `cel` position and size into the RGBA8
+// `target`, clipped to the canvas of `ase`.
+void ase_compose_blend_cel(ase_t *ase, const ase_cel_t *cel,
+                           const ase_color_t *pixels, uint8_t opacity,
+                           const AseComposeTarget *target);
+
+// Composites frame `frame_index` of `ase` into `target`.
+void ase_compose_frame(ase_t *ase, int frame_index,
+                       const AseComposeTarget *target);
+
+// Composites the rectangle at `x`, `y` of `w` x `h` pixels of frame
+// `frame_index` into `target`, whose first pixel is the one at `x`, `y`. Only
+// the cels overlapping the rectangle are read, so disjoint regions can be
+// composited on separate threads.
+void ase_compose_region(ase_t *ase, int frame_index, int x, int y, int w,
+                        int h, const AseComposeTarget *target);
+
+// Composites the first frame a band of rows at a time, copies it into the
+// staging ring and uploads it, see staging_ring_upload_texture. The ring is
+// only written to. Goes through a temporary image if the ring cannot hold the
+// frame.
+Texture ase_compose_upload(StagingRing *ring, ase_t *ase, Texture reuse);
+
+#endif
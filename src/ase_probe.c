@@ -0,0 +1,157 @@
+#include "ase_probe.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HEADER_SIZE 128
+#define FRAME_HEADER_SIZE 16
+#define CHUNK_HEADER_SIZE 6
+// Cel chunk fields before the width and height, after the chunk header
+#define CEL_FIELDS_SIZE 16
+
+static inline uint16_t read_u16(const uint8_t *data) {
+    return (uint16_t)(data[0] | data[1] << 8);
+}
+
+static inline uint32_t read_u32(const uint8_t *data) {
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 |
+           (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+// Reads the tags chunk at `data`, `size` bytes without the chunk header.
+static inline int probe_tags(const uint8_t *data, size_t size, AseProbe *out) {
+    if (size < 10)
+        return 1;
+    int count = read_u16(data);
+    size_t offset = 10;
+    for (int i = 0; i < count; i++) {
+        // Frame range, direction, repeat, reserved and color, then the name
+        if (offset + 19 > size)
+            return 1;
+        const uint8_t *tag = data + offset;
+        size_t name_length = read_u16(tag + 17);
+        if (offset + 19 + name_length > size)
+            return 1;
+
+        if (out->tag_count < ASE_PROBE_MAX_TAGS) {
+            AseProbeTag *stored = out->tags + out->tag_count;
+            stored->from_frame = read_u16(tag);
+            stored->to_frame = read_u16(tag + 2);
+            size_t copied = name_length < ASE_PROBE_TAG_NAME_SIZE - 1
+                                ? name_length
+                                : ASE_PROBE_TAG_NAME_SIZE - 1;
+            memcpy(stored->name, tag + 19, copied);
+            stored->name[copied] = 0;
+        }
+        out->tag_count++;
+        offset += 19 + name_length;
+    }
+    return 0;
+}
+
+int ase_probe_memory(const void *memory, size_t size, AseProbe *out) {
+    const uint8_t *data = memory;
+    *out = (AseProbe){0};
+    if (size < HEADER_SIZE || read_u16(data + 4) != 0xA5E0)
+        return 1;
+
+    out->frame_count = read_u16(data + 6);
+    out->width = read_u16(data + 8);
+    out->height = read_u16(data + 10);
+    out->depth = read_u16(data + 12);
+    if (out->depth != 32 && out->depth != 16 && out->depth != 8)
+        return 1;
+
+    size_t offset = HEADER_SIZE;
+    for (int i = 0; i < out->frame_count; i++) {
+        if (offset + FRAME_HEADER_SIZE > size)
+            return 1;
+        const uint8_t *frame = data + offset;
+        size_t frame_size = read_u32(frame);
+        if (read_u16(frame + 4) != 0xF1FA || frame_size < FRAME_HEADER_SIZE ||
+            frame_size > size - offset)
+            return 1;
+        uint32_t chunk_count = read_u16(frame + 6);
+        if (read_u32(frame + 12))
+            chunk_count = read_u32(frame + 12);
+
+        size_t chunk_offset = offset + FRAME_HEADER_SIZE;
+        size_t frame_end = offset + frame_size;
+        for (uint32_t j = 0; j < chunk_count; j++) {
+            if (chunk_offset + CHUNK_HEADER_SIZE > frame_end)
+                return 1;
+            const uint8_t *chunk = data + chunk_offset;
+            size_t chunk_size = read_u32(chunk);
+            if (chunk_size < CHUNK_HEADER_SIZE ||
+                chunk_size > frame_end - chunk_offset)
+                return 1;
+            const uint8_t *body = chunk + CHUNK_HEADER_SIZE;
+            size_t body_size = chunk_size - CHUNK_HEADER_SIZE;
+
+            switch (read_u16(chunk + 4)) {
+            case 0x2004: // Layer
+                out->layer_count++;
+                break;
+
+            case 0x2005: { // Cel
+                if (body_size < CEL_FIELDS_SIZE)
+                    return 1;
+                out->cel_count++;
+                int cel_type = read_u16(body + 7);
+                if (cel_type == 1) {
+                    out->linked_cel_count++;
+                } else if (cel_type == 0 || cel_type == 2) {
+                    if (body_size < CEL_FIELDS_SIZE + 4)
+                        return 1;
+                    size_t width = read_u16(body + CEL_FIELDS_SIZE);
+                    size_t height = read_u16(body + CEL_FIELDS_SIZE + 2);
+                    out->cel_bytes +=
+                        width * height * (size_t)(out->depth / 8);
+                }
+            } break;
+
+            case 0x2018: // Tags
+                if (probe_tags(body, body_size, out))
+                    return 1;
+                break;
+            }
+            chunk_offset += chunk_size;
+        }
+        offset = frame_end;
+    }
+    return 0;
+}
+
+int ase_probe_file(const char *filepath, AseProbe *out) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) || file_stat.st_size < HEADER_SIZE) {
+        close(fd);
+        return 1;
+    }
+
+    size_t size = (size_t)file_stat.st_size;
+    void *memory = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return 1;
+
+    int error = ase_probe_memory(memory, size, out);
+    munmap(memory, size);
+    return error;
+}
+
+size_t ase_probe_frame_size(const AseProbe *probe) {
+    return (size_t)probe->width * (size_t)probe->height * 4;
+}
+
+size_t ase_probe_decoded_size(const AseProbe *probe) {
+    return probe->cel_bytes +
+           (size_t)probe->frame_count * ase_probe_frame_size(probe);
+}
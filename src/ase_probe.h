@@ -0,0 +1,52 @@
+#ifndef _ASE_PROBE
+#define _ASE_PROBE
+
+// Reads the metadata of an .aseprite file from its header and chunk headers
+// alone, without inflating or allocating anything. For planning atlases,
+// residency and memory budgets before decoding.
+
+#include <stddef.h>
+
+#define ASE_PROBE_MAX_TAGS 32
+#define ASE_PROBE_TAG_NAME_SIZE 32
+
+typedef struct {
+    int from_frame;
+    int to_frame;
+    // Truncated to fit
+    char name[ASE_PROBE_TAG_NAME_SIZE];
+} AseProbeTag;
+
+typedef struct {
+    int width;
+    int height;
+    // Bits per pixel: 32 (RGBA), 16 (grayscale) or 8 (indexed)
+    int depth;
+    int frame_count;
+    int layer_count;
+    // Cels of all frames, linked cels included
+    int cel_count;
+    int linked_cel_count;
+    // Bytes of the cel pixels once inflated
+    size_t cel_bytes;
+    // Every tag is counted, only the first ASE_PROBE_MAX_TAGS are stored
+    int tag_count;
+    AseProbeTag tags[ASE_PROBE_MAX_TAGS];
+} AseProbe;
+
+// Probes an .aseprite file in memory. Returns 0 on success, 1 if the file is
+// truncated or not an aseprite file.
+int ase_probe_memory(const void *memory, size_t size, AseProbe *out);
+
+// Probes an .aseprite file through a read-only mapping, so that only the
+// pages holding headers are read. Returns 0 on success.
+int ase_probe_file(const char *filepath, AseProbe *out);
+
+// Upper bound of the memory a full decode with cute_aseprite needs: the
+// inflated cels and a composited RGBA buffer per frame.
+size_t ase_probe_decoded_size(const AseProbe *probe);
+
+// Bytes of one composited RGBA frame.
+size_t ase_probe_frame_size(const AseProbe *probe);
+
+#endif
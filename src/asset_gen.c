@@ -0,0 +1,697 @@
+#define _DEFAULT_SOURCE
+#include "asset_gen.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ASE_HEADER_SIZE 128
+#define ASE_FRAME_HEADER_SIZE 16
+#define ASE_CHUNK_HEADER_SIZE 6
+#define ASE_BLOCK_SIZE 4
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_MAX_DISTANCE 32768
+
+ObjGenOptions asset_gen_obj_defaults(void) {
+    ObjGenOptions options = {
+        .triangle_count = 1000,
+        .topology = ASSET_GEN_TOPOLOGY_GRID,
+        .with_texcoords = 1,
+        .with_normals = 1,
+        .seed = 1,
+    };
+    return options;
+}
+
+AseGenOptions asset_gen_aseprite_defaults(void) {
+    AseGenOptions options = {
+        .width = 64,
+        .height = 64,
+        .depth = 32,
+        .layer_count = 1,
+        .frame_count = 1,
+        .hold = 1,
+        .compression = ASSET_GEN_COMPRESSION_ZLIB,
+        .seed = 1,
+    };
+    return options;
+}
+
+static inline uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static inline float random_float(uint32_t *state) {
+    return (float)(xorshift32(state) & 0xffffff) / (float)0xffffff;
+}
+
+static inline uint32_t hash_u32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+// --- OBJ ---
+
+static inline void write_face(FILE *file, const ObjGenOptions *options,
+                              size_t a, size_t b, size_t c) {
+    size_t indices[3] = {a + 1, b + 1, c + 1};
+    fputc('f', file);
+    for (int i = 0; i < 3; i++) {
+        size_t index = indices[i];
+        if (options->with_texcoords && options->with_normals)
+            fprintf(file, " %zu/%zu/%zu", index, index, index);
+        else if (options->with_texcoords)
+            fprintf(file, " %zu/%zu", index, index);
+        else if (options->with_normals)
+            fprintf(file, " %zu//%zu", index, index);
+        else
+            fprintf(file, " %zu", index);
+    }
+    fputc('\n', file);
+}
+
+static inline void write_vertex(FILE *file, const ObjGenOptions *options,
+                                float x, float y, float z, float u, float v,
+                                float nx, float ny, float nz) {
+    fprintf(file, "v %f %f %f\n", x, y, z);
+    if (options->with_texcoords)
+        fprintf(file, "vt %f %f\n", u, v);
+    if (options->with_normals)
+        fprintf(file, "vn %f %f %f\n", nx, ny, nz);
+}
+
+static void write_obj_grid(FILE *file, const ObjGenOptions *options) {
+    size_t quads = (options->triangle_count + 1) / 2;
+    size_t cells_x = (size_t)ceil(sqrt((double)quads));
+    if (!cells_x)
+        cells_x = 1;
+    size_t cells_y = (quads + cells_x - 1) / cells_x;
+
+    for (size_t y = 0; y <= cells_y; y++) {
+        for (size_t x = 0; x <= cells_x; x++) {
+            float u = (float)x / (float)cells_x;
+            float v = (float)y / (float)cells_y;
+            write_vertex(file, options, u * 2.0f - 1.0f, 0.0f, v * 2.0f - 1.0f,
+                         u, v, 0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    size_t written = 0;
+    for (size_t y = 0; y < cells_y; y++) {
+        for (size_t x = 0; x < cells_x; x++) {
+            size_t a = y * (cells_x + 1) + x;
+            size_t b = a + 1;
+            size_t c = a + cells_x + 1;
+            size_t d = c + 1;
+            if (written++ < options->triangle_count)
+                write_face(file, options, a, c, b);
+            if (written++ < options->triangle_count)
+                write_face(file, options, b, c, d);
+        }
+    }
+}
+
+static void write_obj_sphere(FILE *file, const ObjGenOptions *options) {
+    size_t segments = (size_t)ceil(sqrt((double)options->triangle_count));
+    if (segments < 3)
+        segments = 3;
+    size_t rings = (options->triangle_count + 2 * segments - 1) / (2 * segments);
+    if (rings < 2)
+        rings = 2;
+
+    for (size_t ring = 0; ring <= rings; ring++) {
+        float v = (float)ring / (float)rings;
+        float theta = v * (float)M_PI;
+        for (size_t segment = 0; segment <= segments; segment++) {
+            float u = (float)segment / (float)segments;
+            float phi = u * 2.0f * (float)M_PI;
+            float x = sinf(theta) * cosf(phi);
+            float y = cosf(theta);
+            float z = sinf(theta) * sinf(phi);
+            write_vertex(file, options, x, y, z, u, v, x, y, z);
+        }
+    }
+
+    size_t written = 0;
+    for (size_t ring = 0; ring < rings; ring++) {
+        for (size_t segment = 0; segment < segments; segment++) {
+            size_t a = ring * (segments + 1) + segment;
+            size_t b = a + 1;
+            size_t c = a + segments + 1;
+            size_t d = c + 1;
+            if (written++ < options->triangle_count)
+                write_face(file, options, a, b, c);
+            if (written++ < options->triangle_count)
+                write_face(file, options, b, d, c);
+        }
+    }
+}
+
+static void write_obj_soup(FILE *file, const ObjGenOptions *options) {
+    uint32_t state = options->seed ? options->seed : 1;
+
+    for (size_t i = 0; i < options->triangle_count; i++) {
+        float cx = random_float(&state) * 2.0f - 1.0f;
+        float cy = random_float(&state) * 2.0f - 1.0f;
+        float cz = random_float(&state) * 2.0f - 1.0f;
+        for (int j = 0; j < 3; j++) {
+            float x = cx + (random_float(&state) - 0.5f) * 0.1f;
+            float y = cy + (random_float(&state) - 0.5f) * 0.1f;
+            float z = cz + (random_float(&state) - 0.5f) * 0.1f;
+            write_vertex(file, options, x, y, z, random_float(&state),
+                         random_float(&state), 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    for (size_t i = 0; i < options->triangle_count; i++)
+        write_face(file, options, i * 3, i * 3 + 1, i * 3 + 2);
+}
+
+int asset_gen_write_obj(FILE *file, const ObjGenOptions *options) {
+    fprintf(file, "# Generated by assetgen, %zu triangles\no generated\n",
+            options->triangle_count);
+
+    switch (options->topology) {
+    case ASSET_GEN_TOPOLOGY_GRID:
+        write_obj_grid(file, options);
+        break;
+    case ASSET_GEN_TOPOLOGY_SPHERE:
+        write_obj_sphere(file, options);
+        break;
+    case ASSET_GEN_TOPOLOGY_SOUP:
+        write_obj_soup(file, options);
+        break;
+    default:
+        return 1;
+    }
+
+    return ferror(file);
+}
+
+int asset_gen_write_obj_file(const char *filepath,
+                             const ObjGenOptions *options) {
+    FILE *file = fopen(filepath, "w");
+    if (!file)
+        return 1;
+    int result = asset_gen_write_obj(file, options);
+    if (fclose(file))
+        return 1;
+    return result;
+}
+
+// --- Byte buffer ---
+
+typedef struct {
+    uint8_t *data;
+    size_t data_allocated;
+    size_t data_used;
+} ByteBuffer;
+
+static inline void bytes_reserve(ByteBuffer *buffer, size_t additional) {
+    if (buffer->data_used + additional <= buffer->data_allocated)
+        return;
+    while (buffer->data_used + additional > buffer->data_allocated)
+        buffer->data_allocated =
+            buffer->data_allocated ? buffer->data_allocated * 2 : 4096;
+    buffer->data = realloc(buffer->data, buffer->data_allocated);
+    if (!buffer->data)
+        abort();
+}
+
+static inline void bytes_u8(ByteBuffer *buffer, uint8_t value) {
+    bytes_reserve(buffer, 1);
+    buffer->data[buffer->data_used++] = value;
+}
+
+static inline void bytes_u16(ByteBuffer *buffer, uint16_t value) {
+    bytes_u8(buffer, value & 0xff);
+    bytes_u8(buffer, value >> 8);
+}
+
+static inline void bytes_u32(ByteBuffer *buffer, uint32_t value) {
+    bytes_u16(buffer, value & 0xffff);
+    bytes_u16(buffer, value >> 16);
+}
+
+static inline void bytes_zero(ByteBuffer *buffer, size_t count) {
+    bytes_reserve(buffer, count);
+    memset(buffer->data + buffer->data_used, 0, count);
+    buffer->data_used += count;
+}
+
+static inline void bytes_append(ByteBuffer *buffer, const void *data,
+                                size_t size) {
+    bytes_reserve(buffer, size);
+    memcpy(buffer->data + buffer->data_used, data, size);
+    buffer->data_used += size;
+}
+
+static inline void bytes_patch_u32(ByteBuffer *buffer, size_t offset,
+                                   uint32_t value) {
+    buffer->data[offset] = value & 0xff;
+    buffer->data[offset + 1] = (value >> 8) & 0xff;
+    buffer->data[offset + 2] = (value >> 16) & 0xff;
+    buffer->data[offset + 3] = value >> 24;
+}
+
+static inline void bytes_patch_u16(ByteBuffer *buffer, size_t offset,
+                                   uint16_t value) {
+    buffer->data[offset] = value & 0xff;
+    buffer->data[offset + 1] = value >> 8;
+}
+
+// --- Zlib (fixed Huffman codes, RFC 1950 and 1951) ---
+
+static const uint16_t len_base[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t len_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t dist_base[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t dist_extra[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                       4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                       9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+typedef struct {
+    ByteBuffer *out;
+    uint64_t bits;
+    int count;
+} BitWriter;
+
+static inline void bits_put(BitWriter *writer, uint32_t value, int length) {
+    writer->bits |= (uint64_t)value << writer->count;
+    writer->count += length;
+    while (writer->count >= 8) {
+        bytes_u8(writer->out, writer->bits & 0xff);
+        writer->bits >>= 8;
+        writer->count -= 8;
+    }
+}
+
+static inline void bits_flush(BitWriter *writer) {
+    if (writer->count > 0)
+        bytes_u8(writer->out, writer->bits & 0xff);
+    writer->bits = 0;
+    writer->count = 0;
+}
+
+// Huffman codes are packed starting from their most significant bit.
+static inline void bits_put_code(BitWriter *writer, uint32_t code,
+                                 int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    bits_put(writer, reversed, length);
+}
+
+static inline void put_symbol(BitWriter *writer, int symbol) {
+    if (symbol <= 143)
+        bits_put_code(writer, 0x30 + symbol, 8);
+    else if (symbol <= 255)
+        bits_put_code(writer, 0x190 + symbol - 144, 9);
+    else if (symbol <= 279)
+        bits_put_code(writer, symbol - 256, 7);
+    else
+        bits_put_code(writer, 0xc0 + symbol - 280, 8);
+}
+
+static inline void put_match(BitWriter *writer, int length, int distance) {
+    int i = 28;
+    while (len_base[i] > length)
+        i--;
+    put_symbol(writer, 257 + i);
+    bits_put(writer, length - len_base[i], len_extra[i]);
+
+    int d = 29;
+    while (dist_base[d] > distance)
+        d--;
+    bits_put_code(writer, d, 5);
+    bits_put(writer, distance - dist_base[d], dist_extra[d]);
+}
+
+static inline int match_length(const uint8_t *data, size_t size, size_t i,
+                               size_t distance) {
+    if (!distance || distance > i || distance > DEFLATE_MAX_DISTANCE)
+        return 0;
+    int length = 0;
+    while (length < DEFLATE_MAX_MATCH && i + length < size &&
+           data[i + length] == data[i + length - distance])
+        length++;
+    return length;
+}
+
+// Compresses `data` into a zlib stream. Matches are only searched for at the
+// distance of the previous pixel and the previous row, which is what most of
+// the redundancy in pixel art consists of.
+static void zlib_compress(ByteBuffer *out, const uint8_t *data, size_t size,
+                          size_t pixel_stride, size_t row_stride) {
+    bytes_u8(out, 0x78);
+    bytes_u8(out, 0x01);
+
+    BitWriter writer = {.out = out};
+    bits_put(&writer, 1, 1); // BFINAL
+    bits_put(&writer, 1, 2); // BTYPE = fixed Huffman codes
+
+    size_t i = 0;
+    while (i < size) {
+        int length = match_length(data, size, i, pixel_stride);
+        size_t distance = pixel_stride;
+        int row_length = match_length(data, size, i, row_stride);
+        if (row_length > length) {
+            length = row_length;
+            distance = row_stride;
+        }
+
+        if (length >= 3) {
+            put_match(&writer, length, (int)distance);
+            i += length;
+        } else {
+            put_symbol(&writer, data[i]);
+            i++;
+        }
+    }
+    put_symbol(&writer, 256);
+    bits_flush(&writer);
+
+    uint32_t a = 1, b = 0;
+    for (size_t j = 0; j < size; j++) {
+        a = (a + data[j]) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    bytes_u8(out, adler >> 24);
+    bytes_u8(out, (adler >> 16) & 0xff);
+    bytes_u8(out, (adler >> 8) & 0xff);
+    bytes_u8(out, adler & 0xff);
+}
+
+// --- Aseprite ---
+
+// Pixel art-like content: blocks of solid color, with the layers above the
+// first one mostly transparent.
+static inline void generate_cel_pixels(const AseGenOptions *options,
+                                       int layer, int frame, uint8_t *pixels) {
+    int bytes_per_pixel = options->depth / 8;
+    for (int y = 0; y < options->height; y++) {
+        for (int x = 0; x < options->width; x++) {
+            uint32_t h = hash_u32(options->seed ^ hash_u32(
+                                      (uint32_t)(x / ASE_BLOCK_SIZE) * 73856093u ^
+                                      (uint32_t)(y / ASE_BLOCK_SIZE) * 19349663u ^
+                                      (uint32_t)layer * 83492791u ^
+                                      (uint32_t)frame * 2654435761u));
+            int transparent = layer && (h & 3);
+            uint8_t *pixel = pixels + ((size_t)y * options->width + x) *
+                                          bytes_per_pixel;
+
+            switch (options->depth) {
+            case 32:
+                pixel[0] = h >> 8;
+                pixel[1] = h >> 16;
+                pixel[2] = h >> 24;
+                pixel[3] = transparent ? 0 : 255;
+                break;
+            case 16:
+                pixel[0] = h >> 8;
+                pixel[1] = transparent ? 0 : 255;
+                break;
+            default:
+                pixel[0] = transparent ? 0 : 1 + (h >> 8) % 255;
+                break;
+            }
+        }
+    }
+}
+
+static inline size_t begin_chunk(ByteBuffer *buffer, uint16_t type) {
+    size_t start = buffer->data_used;
+    bytes_u32(buffer, 0);
+    bytes_u16(buffer, type);
+    return start;
+}
+
+static inline void end_chunk(ByteBuffer *buffer, size_t start) {
+    bytes_patch_u32(buffer, start, (uint32_t)(buffer->data_used - start));
+}
+
+static inline void write_palette_chunk(ByteBuffer *buffer, uint32_t seed) {
+    size_t chunk = begin_chunk(buffer, 0x2019);
+    bytes_u32(buffer, 256);
+    bytes_u32(buffer, 0);
+    bytes_u32(buffer, 255);
+    bytes_zero(buffer, 8);
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t h = hash_u32(seed ^ (i * 2654435761u));
+        bytes_u16(buffer, 0);
+        bytes_u8(buffer, h & 0xff);
+        bytes_u8(buffer, (h >> 8) & 0xff);
+        bytes_u8(buffer, (h >> 16) & 0xff);
+        bytes_u8(buffer, i ? 255 : 0);
+    }
+    end_chunk(buffer, chunk);
+}
+
+static inline void write_layer_chunk(ByteBuffer *buffer,
+                                     const AseGenOptions *options, int layer) {
+    char name[32] = {0};
+    snprintf(name, sizeof(name), "Layer %d", layer + 1);
+
+    size_t chunk = begin_chunk(buffer, 0x2004);
+    bytes_u16(buffer, 0x01 | 0x02); // Visible, editable
+    bytes_u16(buffer, 0);           // Normal layer
+    bytes_u16(buffer, 0);           // Child level
+    bytes_u16(buffer, (uint16_t)options->width);
+    bytes_u16(buffer, (uint16_t)options->height);
+    bytes_u16(buffer, (uint16_t)(layer ? options->blend_mode : 0));
+    bytes_u8(buffer, 255);
+    bytes_zero(buffer, 3);
+    bytes_u16(buffer, (uint16_t)strlen(name));
+    bytes_append(buffer, name, strlen(name));
+    end_chunk(buffer, chunk);
+}
+
+static inline void write_cel_chunk(ByteBuffer *buffer,
+                                   const AseGenOptions *options, int layer,
+                                   int frame, int keyframe, uint8_t *pixels) {
+    size_t chunk = begin_chunk(buffer, 0x2005);
+    bytes_u16(buffer, (uint16_t)layer);
+    bytes_u16(buffer, 0); // x
+    bytes_u16(buffer, 0); // y
+    bytes_u8(buffer, 255);
+
+    if (keyframe != frame) {
+        bytes_u16(buffer, 1); // Linked cel
+        bytes_zero(buffer, 7);
+        bytes_u16(buffer, (uint16_t)keyframe);
+        end_chunk(buffer, chunk);
+        return;
+    }
+
+    size_t bytes_per_pixel = options->depth / 8;
+    size_t size = (size_t)options->width * options->height * bytes_per_pixel;
+    generate_cel_pixels(options, layer, frame, pixels);
+
+    if (options->compression == ASSET_GEN_COMPRESSION_NONE) {
+        bytes_u16(buffer, 0);
+        bytes_zero(buffer, 7);
+        bytes_u16(buffer, (uint16_t)options->width);
+        bytes_u16(buffer, (uint16_t)options->height);
+        bytes_append(buffer, pixels, size);
+    } else {
+        bytes_u16(buffer, 2);
+        bytes_zero(buffer, 7);
+        bytes_u16(buffer, (uint16_t)options->width);
+        bytes_u16(buffer, (uint16_t)options->height);
+        zlib_compress(buffer, pixels, size, bytes_per_pixel,
+                      bytes_per_pixel * options->width);
+    }
+    end_chunk(buffer, chunk);
+}
+
+size_t asset_gen_aseprite(const AseGenOptions *options, uint8_t **out) {
+    if (options->width <= 0 || options->height <= 0 ||
+        options->width > 0xffff || options->height > 0xffff ||
+        options->layer_count <= 0 || options->layer_count > 64 ||
+        options->frame_count <= 0 || options->frame_count > 0xffff)
+        return 0;
+    if (options->depth != 32 && options->depth != 16 && options->depth != 8)
+        return 0;
+    // Normal to divide
+    if (options->blend_mode < 0 || options->blend_mode > 18)
+        return 0;
+
+    int hold = options->hold > 1 ? options->hold : 1;
+    uint8_t *pixels = malloc((size_t)options->width * options->height *
+                             (options->depth / 8));
+    if (!pixels)
+        abort();
+
+    ByteBuffer buffer = {0};
+
+    // File header
+    bytes_u32(&buffer, 0); // File size, patched at the end
+    bytes_u16(&buffer, 0xa5e0);
+    bytes_u16(&buffer, (uint16_t)options->frame_count);
+    bytes_u16(&buffer, (uint16_t)options->width);
+    bytes_u16(&buffer, (uint16_t)options->height);
+    bytes_u16(&buffer, (uint16_t)options->depth);
+    bytes_u32(&buffer, 1); // Layer opacity is valid
+    bytes_u16(&buffer, 100);
+    bytes_zero(&buffer, 8);
+    bytes_u8(&buffer, 0); // Transparent palette index
+    bytes_zero(&buffer, 3);
+    bytes_u16(&buffer, options->depth == 8 ? 256 : 0);
+    bytes_u8(&buffer, 1); // Pixel ratio
+    bytes_u8(&buffer, 1);
+    bytes_u16(&buffer, 0); // Grid
+    bytes_u16(&buffer, 0);
+    bytes_u16(&buffer, 16);
+    bytes_u16(&buffer, 16);
+    bytes_zero(&buffer, 84);
+
+    for (int frame = 0; frame < options->frame_count; frame++) {
+        size_t frame_start = buffer.data_used;
+        bytes_u32(&buffer, 0);
+        bytes_u16(&buffer, 0xf1fa);
+        bytes_u16(&buffer, 0);
+        bytes_u16(&buffer, 100); // Duration in milliseconds
+        bytes_zero(&buffer, 2);
+        bytes_u32(&buffer, 0);
+
+        uint32_t chunk_count = 0;
+        if (frame == 0) {
+            if (options->depth == 8) {
+                write_palette_chunk(&buffer, options->seed);
+                chunk_count++;
+            }
+            for (int layer = 0; layer < options->layer_count; layer++) {
+                write_layer_chunk(&buffer, options, layer);
+                chunk_count++;
+            }
+        }
+
+        int keyframe = frame - frame % hold;
+        for (int layer = 0; layer < options->layer_count; layer++) {
+            write_cel_chunk(&buffer, options, layer, frame, keyframe, pixels);
+            chunk_count++;
+        }
+
+        bytes_patch_u32(&buffer, frame_start,
+                        (uint32_t)(buffer.data_used - frame_start));
+        bytes_patch_u16(&buffer, frame_start + 6,
+                        chunk_count < 0xffff ? (uint16_t)chunk_count : 0xffff);
+        bytes_patch_u32(&buffer, frame_start + 12, chunk_count);
+    }
+
+    bytes_patch_u32(&buffer, 0, (uint32_t)buffer.data_used);
+
+    free(pixels);
+    *out = buffer.data;
+    return buffer.data_used;
+}
+
+static inline int write_whole_file(const char *filepath, const uint8_t *data,
+                                   size_t size) {
+    FILE *file = fopen(filepath, "wb");
+    if (!file)
+        return 1;
+    size_t written = fwrite(data, 1, size, file);
+    if (fclose(file) || written != size)
+        return 1;
+    return 0;
+}
+
+int asset_gen_write_aseprite_file(const char *filepath,
+                                  const AseGenOptions *options) {
+    uint8_t *data = 0;
+    size_t size = asset_gen_aseprite(options, &data);
+    if (!size)
+        return 1;
+    int result = write_whole_file(filepath, data, size);
+    free(data);
+    return result;
+}
+
+// --- Rewrite storms ---
+
+static inline uint8_t *read_whole_file(const char *filepath, size_t *size) {
+    FILE *file = fopen(filepath, "rb");
+    if (!file)
+        return 0;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length < 0) {
+        fclose(file);
+        return 0;
+    }
+
+    uint8_t *data = malloc((size_t)length + 1);
+    if (!data)
+        abort();
+    *size = fread(data, 1, (size_t)length, file);
+    fclose(file);
+    return data;
+}
+
+int asset_gen_rewrite_storm(const char **filepaths, size_t filepath_count,
+                            const StormOptions *options) {
+    uint8_t **contents = calloc(filepath_count, sizeof(uint8_t *));
+    size_t *sizes = calloc(filepath_count, sizeof(size_t));
+    if (!contents || !sizes)
+        abort();
+
+    int result = 0;
+    for (size_t i = 0; i < filepath_count; i++) {
+        contents[i] = read_whole_file(filepaths[i], sizes + i);
+        if (!contents[i]) {
+            fprintf(stderr, "ERROR: could not read %s\n", filepaths[i]);
+            result = 1;
+            goto cleanup;
+        }
+    }
+
+    char temporary_path[4096] = {0};
+    struct timespec interval = {
+        .tv_sec = options->interval_milliseconds / 1000,
+        .tv_nsec = (long)(options->interval_milliseconds % 1000) * 1000000L,
+    };
+
+    for (int round = 0; round < options->count; round++) {
+        for (size_t i = 0; i < filepath_count; i++) {
+            if (!options->use_rename) {
+                result |= write_whole_file(filepaths[i], contents[i], sizes[i]);
+                continue;
+            }
+
+            snprintf(temporary_path, sizeof(temporary_path), "%s.assetgen~",
+                     filepaths[i]);
+            result |= write_whole_file(temporary_path, contents[i], sizes[i]);
+            if (rename(temporary_path, filepaths[i]))
+                result = 1;
+        }
+
+        if (options->interval_milliseconds > 0)
+            nanosleep(&interval, 0);
+    }
+
+cleanup:
+    for (size_t i = 0; i < filepath_count; i++)
+        free(contents[i]);
+    free(contents);
+    free(sizes);
+    return result;
+}
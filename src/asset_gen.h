@@ -0,0 +1,82 @@
+#ifndef _ASSET_GEN
+#define _ASSET_GEN
+
+// Generators for synthetic model and texture files, used by tests, benchmarks
+// and the assetgen tool.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    // A flat, indexed grid of quads. Vertices are shared between triangles.
+    ASSET_GEN_TOPOLOGY_GRID,
+    // A closed UV sphere. Vertices are shared between triangles.
+    ASSET_GEN_TOPOLOGY_SPHERE,
+    // Unconnected triangles at random positions, no shared vertices.
+    ASSET_GEN_TOPOLOGY_SOUP,
+} AssetGenTopology;
+
+typedef struct {
+    size_t triangle_count;
+    AssetGenTopology topology;
+    int with_texcoords;
+    int with_normals;
+    uint32_t seed;
+} ObjGenOptions;
+
+typedef enum {
+    // Raw cels (cel type 0)
+    ASSET_GEN_COMPRESSION_NONE,
+    // Zlib compressed cels (cel type 2), as written by Aseprite itself
+    ASSET_GEN_COMPRESSION_ZLIB,
+} AseGenCompression;
+
+typedef struct {
+    int width;
+    int height;
+    // Bits per pixel: 32 (RGBA), 16 (grayscale) or 8 (indexed)
+    int depth;
+    int layer_count;
+    int frame_count;
+    // Every `hold`th frame has its own pixels, the frames in between link to
+    // it with linked cels. 0 or 1 means no linked cels.
+    int hold;
+    // Blend mode of every layer above the first, in the numbering of the file
+    // format. 0 is normal.
+    int blend_mode;
+    AseGenCompression compression;
+    uint32_t seed;
+} AseGenOptions;
+
+typedef struct {
+    int count;
+    int interval_milliseconds;
+    // If 1, files are written to a temporary file which is then moved in
+    // place (IN_MOVED_TO), otherwise they are rewritten in place
+    // (IN_CLOSE_WRITE).
+    int use_rename;
+} StormOptions;
+
+ObjGenOptions asset_gen_obj_defaults(void);
+AseGenOptions asset_gen_aseprite_defaults(void);
+
+// Writes an OBJ model with exactly `options->triangle_count` triangles.
+// Returns 0 on success.
+int asset_gen_write_obj(FILE *file, const ObjGenOptions *options);
+int asset_gen_write_obj_file(const char *filepath,
+                             const ObjGenOptions *options);
+
+// Encodes an .aseprite file into a newly allocated buffer, stored to `out`.
+// Free `*out` after use. Returns the size of the file, or 0 on invalid options.
+size_t asset_gen_aseprite(const AseGenOptions *options, uint8_t **out);
+int asset_gen_write_aseprite_file(const char *filepath,
+                                  const AseGenOptions *options);
+
+// Rewrites each of `filepaths` with its current contents `options->count`
+// times, sleeping `options->interval_milliseconds` between rounds. Returns 0
+// on success.
+int asset_gen_rewrite_storm(const char **filepaths, size_t filepath_count,
+                            const StormOptions *options);
+
+#endif
@@ -0,0 +1,88 @@
+#include "blend.h"
+#include <assert.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLEND_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#define BLEND_LANES 4
+#define BLEND_SUFFIX sse41
+#include "blend_kernel.h"
+#undef BLEND_LANES
+#undef BLEND_SUFFIX
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define BLEND_LANES 8
+#define BLEND_SUFFIX avx2
+#include "blend_kernel.h"
+#undef BLEND_LANES
+#undef BLEND_SUFFIX
+#pragma GCC pop_options
+#endif
+
+static void blend_row_scalar(ase_blend_mode_t mode, const ase_color_t *src,
+                             ase_color_t *dst, int count, uint8_t opacity) {
+    for (int i = 0; i < count; i++)
+        dst[i] = cute_aseprite_blend(src[i], dst[i], opacity, mode);
+}
+
+int blend_kernel_supported(BlendKernel kernel) {
+    switch (kernel) {
+    case BLEND_KERNEL_SCALAR:
+        return 1;
+#ifdef BLEND_X86
+    case BLEND_KERNEL_SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case BLEND_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+BlendKernel blend_best_kernel(void) {
+    static BlendKernel best = BLEND_KERNEL_COUNT;
+    if (best == BLEND_KERNEL_COUNT) {
+        BlendKernel kernel = BLEND_KERNEL_COUNT - 1;
+        while (!blend_kernel_supported(kernel))
+            kernel--;
+        best = kernel;
+    }
+    return best;
+}
+
+const char *blend_kernel_name(BlendKernel kernel) {
+    static const char *names[BLEND_KERNEL_COUNT] = {"scalar", "sse4.1",
+                                                    "avx2"};
+    assert(kernel < BLEND_KERNEL_COUNT);
+    return names[kernel];
+}
+
+void blend_row(ase_blend_mode_t mode, const ase_color_t *src,
+               ase_color_t *dst, int count, uint8_t opacity) {
+    blend_row_kernel(blend_best_kernel(), mode, src, dst, count, opacity);
+}
+
+void blend_row_kernel(BlendKernel kernel, ase_blend_mode_t mode,
+                      const ase_color_t *src, ase_color_t *dst, int count,
+                      uint8_t opacity) {
+    assert(blend_kernel_supported(kernel));
+    switch (kernel) {
+#ifdef BLEND_X86
+    case BLEND_KERNEL_AVX2:
+        blend_row_avx2(mode, src, dst, count, opacity);
+        break;
+    case BLEND_KERNEL_SSE41:
+        blend_row_sse41(mode, src, dst, count, opacity);
+        break;
+#endif
+    default:
+        blend_row_scalar(mode, src, dst, count, opacity);
+        break;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef _BLEND
+#define _BLEND
+
+// Row kernels for the aseprite layer blend modes. Every kernel gives exactly
+// the result of cute_aseprite_blend, which is the scalar reference.
+
+#include "cute_aseprite.h"
+#include <stdint.h>
+
+typedef enum {
+    BLEND_KERNEL_SCALAR,
+    BLEND_KERNEL_SSE41,
+    BLEND_KERNEL_AVX2,
+    BLEND_KERNEL_COUNT,
+} BlendKernel;
+
+// Whether the CPU can run `kernel`.
+int blend_kernel_supported(BlendKernel kernel);
+// The fastest kernel the CPU can run.
+BlendKernel blend_best_kernel(void);
+const char *blend_kernel_name(BlendKernel kernel);
+
+// Blends `count` pixels of `src` over `dst` in place with `mode` and
+// `opacity`, using the fastest kernel.
+void blend_row(ase_blend_mode_t mode, const ase_color_t *src,
+               ase_color_t *dst, int count, uint8_t opacity);
+// Same as blend_row with a specific, supported `kernel`.
+void blend_row_kernel(BlendKernel kernel, ase_blend_mode_t mode,
+                      const ase_color_t *src, ase_color_t *dst, int count,
+                      uint8_t opacity);
+
+#endif
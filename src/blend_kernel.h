@@ -0,0 +1,226 @@
+// Vector implementation of cute_aseprite_blend, included by blend.c once per
+// instruction set with BLEND_LANES and BLEND_SUFFIX defined. Channels are
+// unpacked to 32-bit lanes. Integer divisions are estimated in single
+// precision and corrected from the remainder, so they stay exact even when
+// the division is turned into a reciprocal multiplication by -Ofast.
+
+#define BLEND_CONCAT_(name, suffix) name##_##suffix
+#define BLEND_CONCAT(name, suffix) BLEND_CONCAT_(name, suffix)
+#define K(name) BLEND_CONCAT(name, BLEND_SUFFIX)
+
+typedef int32_t K(vi) __attribute__((vector_size(BLEND_LANES * 4)));
+typedef uint32_t K(vu) __attribute__((vector_size(BLEND_LANES * 4)));
+typedef float K(vf) __attribute__((vector_size(BLEND_LANES * 4)));
+#define vi K(vi)
+#define vu K(vu)
+#define vf K(vf)
+
+static inline vi K(splat)(int32_t x) {
+    return (vi){0} + x;
+}
+
+static inline vi K(select)(vi mask, vi a, vi b) {
+    return (mask & a) | (~mask & b);
+}
+
+static inline vi K(min)(vi a, vi b) {
+    return K(select)(a < b, a, b);
+}
+
+static inline vi K(max)(vi a, vi b) {
+    return K(select)(a < b, b, a);
+}
+
+static inline vi K(mul_un8)(vi a, vi b) {
+    vi t = a * b + 0x80;
+    return ((t >> 8) + t) >> 8;
+}
+
+static inline vi K(div_255)(vi x) {
+    vi t = x + 0x80;
+    return ((t >> 8) + t) >> 8;
+}
+
+// a / b rounded toward zero like C division, for b > 0 and small a.
+static inline vi K(div)(vi a, vi b) {
+    vi q = __builtin_convertvector(__builtin_convertvector(a, vf) /
+                                       __builtin_convertvector(b, vf),
+                                   vi);
+    // The estimate is off by at most one
+    vi r = a - q * b;
+    vi non_negative = a >= 0;
+    vi too_small = K(select)(non_negative, r >= b, r > 0);
+    vi too_large = K(select)(non_negative, r < 0, r <= -b);
+    return q - too_small + too_large;
+}
+
+// s_div_un8 with a guard for the lanes where `b` is 0, which the callers
+// discard.
+static inline vi K(div_un8)(vi a, vi b) {
+    vi safe = K(select)(b == 0, K(splat)(1), b);
+    return K(div)(a * 255 + (safe >> 1), safe);
+}
+
+static inline vi K(screen)(vi b, vi s) {
+    return b + s - K(mul_un8)(b, s);
+}
+
+static inline vi K(hard_light)(vi b, vi s) {
+    return K(select)(s < 128, K(mul_un8)(b, s << 1),
+                     K(screen)(b, (s << 1) - 255));
+}
+
+// s_blend_channel of the separable modes other than soft light.
+static inline __attribute__((always_inline)) vi
+K(channel)(ase_blend_mode_t mode, vi b, vi s) {
+    switch (mode) {
+    case ASE_BLEND_MODE_MULTIPLY:
+        return K(mul_un8)(b, s);
+    case ASE_BLEND_MODE_SCREEN:
+        return K(screen)(b, s);
+    case ASE_BLEND_MODE_OVERLAY:
+        return K(hard_light)(s, b);
+    case ASE_BLEND_MODE_DARKEN:
+        return K(min)(b, s);
+    case ASE_BLEND_MODE_LIGHTEN:
+        return K(max)(b, s);
+    case ASE_BLEND_MODE_COLOR_DODGE: {
+        vi inverse = 255 - s;
+        vi result = K(select)(b >= inverse, K(splat)(255),
+                              K(div_un8)(b, inverse));
+        return K(select)(b == 0, K(splat)(0), result);
+    }
+    case ASE_BLEND_MODE_COLOR_BURN: {
+        vi inverse = 255 - b;
+        vi result = K(select)(inverse >= s, K(splat)(0),
+                              255 - K(div_un8)(inverse, s));
+        return K(select)(b == 255, K(splat)(255), result);
+    }
+    case ASE_BLEND_MODE_HARD_LIGHT:
+        return K(hard_light)(b, s);
+    case ASE_BLEND_MODE_DIFFERENCE:
+        return K(max)(b, s) - K(min)(b, s);
+    case ASE_BLEND_MODE_EXCLUSION:
+        return b + s - 2 * K(mul_un8)(b, s);
+    case ASE_BLEND_MODE_ADDITION:
+        return K(min)(b + s, K(splat)(255));
+    case ASE_BLEND_MODE_SUBTRACT:
+        return K(max)(b - s, K(splat)(0));
+    case ASE_BLEND_MODE_DIVIDE: {
+        vi result = K(select)(b >= s, K(splat)(255), K(div_un8)(b, s));
+        return K(select)(b == 0, K(splat)(0), result);
+    }
+    default:
+        return s;
+    }
+}
+
+// The normal blend of s_blend for one channel.
+static inline vi K(normal)(vi dst, vi src, vi src_a, vi zero_a, vi a) {
+    vi result = dst + K(div)((src - dst) * src_a, a);
+    return K(select)(zero_a, K(splat)(0), result);
+}
+
+static inline __attribute__((always_inline)) void
+K(blend_pixels)(ase_blend_mode_t mode, const ase_color_t *src,
+                ase_color_t *dst, uint8_t opacity) {
+    vu src_pixels, dst_pixels;
+    memcpy(&src_pixels, src, sizeof(src_pixels));
+    memcpy(&dst_pixels, dst, sizeof(dst_pixels));
+
+    vi sr = (vi)(src_pixels & 0xff);
+    vi sg = (vi)((src_pixels >> 8) & 0xff);
+    vi sb = (vi)((src_pixels >> 16) & 0xff);
+    vi sa = (vi)(src_pixels >> 24);
+    vi dr = (vi)(dst_pixels & 0xff);
+    vi dg = (vi)((dst_pixels >> 8) & 0xff);
+    vi db = (vi)((dst_pixels >> 16) & 0xff);
+    vi da = (vi)(dst_pixels >> 24);
+
+    if (mode != ASE_BLEND_MODE_NORMAL) {
+        vi br, bg, bb;
+        if (mode == ASE_BLEND_MODE_SOFT_LIGHT ||
+            (mode >= ASE_BLEND_MODE_HUE && mode <= ASE_BLEND_MODE_LUMINOSITY)) {
+            // Defined in double precision by the reference, only the
+            // compositing below is vectorized
+            ase_color_t blended[BLEND_LANES];
+            for (int i = 0; i < BLEND_LANES; i++)
+                blended[i] = cute_aseprite_blend_color(dst[i], src[i], mode);
+            vu blended_pixels;
+            memcpy(&blended_pixels, blended, sizeof(blended_pixels));
+            br = (vi)(blended_pixels & 0xff);
+            bg = (vi)((blended_pixels >> 8) & 0xff);
+            bb = (vi)((blended_pixels >> 16) & 0xff);
+        } else {
+            br = K(channel)(mode, dr, sr);
+            bg = K(channel)(mode, dg, sg);
+            bb = K(channel)(mode, db, sb);
+        }
+        vi backdrop_inverse = 255 - da;
+        sr = K(div_255)(sr * backdrop_inverse + br * da);
+        sg = K(div_255)(sg * backdrop_inverse + bg * da);
+        sb = K(div_255)(sb * backdrop_inverse + bb * da);
+    }
+
+    sa = K(mul_un8)(sa, K(splat)(opacity));
+    vi a = sa + da - K(mul_un8)(sa, da);
+    vi zero_a = a == 0;
+    vi safe_a = K(select)(zero_a, K(splat)(1), a);
+    vi r = K(normal)(dr, sr, sa, zero_a, safe_a);
+    vi g = K(normal)(dg, sg, sa, zero_a, safe_a);
+    vi b = K(normal)(db, sb, sa, zero_a, safe_a);
+
+    vu result = (vu)r | (vu)g << 8 | (vu)b << 16 | (vu)a << 24;
+    memcpy(dst, &result, sizeof(result));
+}
+
+static inline __attribute__((always_inline)) void
+K(blend_row_mode)(ase_blend_mode_t mode, const ase_color_t *src,
+                  ase_color_t *dst, int count, uint8_t opacity) {
+    int i = 0;
+    for (; i + BLEND_LANES <= count; i += BLEND_LANES)
+        K(blend_pixels)(mode, src + i, dst + i, opacity);
+    for (; i < count; i++)
+        dst[i] = cute_aseprite_blend(src[i], dst[i], opacity, mode);
+}
+
+// Dispatches to a copy of the row loop specialized for each mode.
+static void K(blend_row)(ase_blend_mode_t mode, const ase_color_t *src,
+                         ase_color_t *dst, int count, uint8_t opacity) {
+    switch (mode) {
+#define BLEND_ROW_CASE(mode_name)                                              \
+    case mode_name:                                                            \
+        K(blend_row_mode)(mode_name, src, dst, count, opacity);                \
+        break;
+        BLEND_ROW_CASE(ASE_BLEND_MODE_NORMAL)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_MULTIPLY)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_SCREEN)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_OVERLAY)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_DARKEN)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_LIGHTEN)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_COLOR_DODGE)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_COLOR_BURN)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_HARD_LIGHT)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_SOFT_LIGHT)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_DIFFERENCE)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_EXCLUSION)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_HUE)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_SATURATION)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_COLOR)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_LUMINOSITY)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_ADDITION)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_SUBTRACT)
+        BLEND_ROW_CASE(ASE_BLEND_MODE_DIVIDE)
+#undef BLEND_ROW_CASE
+    default:
+        K(blend_row_mode)(ASE_BLEND_MODE_NORMAL, src, dst, count, opacity);
+        break;
+    }
+}
+
+#undef vi
+#undef vu
+#undef vf
+#undef K
+#undef BLEND_CONCAT
+#undef BLEND_CONCAT_
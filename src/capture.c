@@ -0,0 +1,443 @@
+#define _DEFAULT_SOURCE
+#define GL_GLEXT_PROTOTYPES
+#include "capture.h"
+#include "raylib.h"
+#include "timings.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define QOI_HEADER_SIZE 14
+#define QOI_END_SIZE 8
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MAX_RUN 62
+
+static int gl_fence_signaled(void *fence, int wait) {
+    GLenum status =
+        glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         wait ? (GLuint64)1000 * 1000 * 1000 : 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return 0;
+    glDeleteSync((GLsync)fence);
+    return 1;
+}
+
+static inline size_t frame_size(Capture *capture) {
+    return (size_t)capture->width * (size_t)capture->height * 4;
+}
+
+static inline void write_u32_big_endian(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+size_t capture_qoi_max_size(int width, int height) {
+    return (size_t)width * (size_t)height * 5 + QOI_HEADER_SIZE + QOI_END_SIZE;
+}
+
+size_t capture_encode_qoi(const uint8_t *pixels, int width, int height,
+                          uint8_t *out) {
+    uint8_t *start = out;
+    memcpy(out, "qoif", 4);
+    write_u32_big_endian(out + 4, (uint32_t)width);
+    write_u32_big_endian(out + 8, (uint32_t)height);
+    out[12] = 4;
+    // sRGB with linear alpha
+    out[13] = 0;
+    out += QOI_HEADER_SIZE;
+
+    uint8_t index[64][4] = {0};
+    uint8_t previous[4] = {0, 0, 0, 255};
+    size_t pixel_count = (size_t)width * (size_t)height;
+    int run = 0;
+
+    for (size_t i = 0; i < pixel_count; i++) {
+        const uint8_t *pixel = pixels + i * 4;
+        if (!memcmp(pixel, previous, 4)) {
+            run++;
+            if (run == QOI_MAX_RUN || i + 1 == pixel_count) {
+                *out++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run) {
+            *out++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 +
+                    pixel[3] * 11) %
+                   64;
+        if (!memcmp(index[hash], pixel, 4)) {
+            *out++ = (uint8_t)(QOI_OP_INDEX | hash);
+        } else {
+            memcpy(index[hash], pixel, 4);
+
+            if (pixel[3] == previous[3]) {
+                int8_t red = (int8_t)(pixel[0] - previous[0]);
+                int8_t green = (int8_t)(pixel[1] - previous[1]);
+                int8_t blue = (int8_t)(pixel[2] - previous[2]);
+                int8_t red_green = (int8_t)(red - green);
+                int8_t blue_green = (int8_t)(blue - green);
+
+                if (red > -3 && red < 2 && green > -3 && green < 2 &&
+                    blue > -3 && blue < 2) {
+                    *out++ = (uint8_t)(QOI_OP_DIFF | (red + 2) << 4 |
+                                       (green + 2) << 2 | (blue + 2));
+                } else if (red_green > -9 && red_green < 8 && green > -33 &&
+                           green < 32 && blue_green > -9 && blue_green < 8) {
+                    *out++ = (uint8_t)(QOI_OP_LUMA | (green + 32));
+                    *out++ = (uint8_t)((red_green + 8) << 4 | (blue_green + 8));
+                } else {
+                    *out++ = QOI_OP_RGB;
+                    memcpy(out, pixel, 3);
+                    out += 3;
+                }
+            } else {
+                *out++ = QOI_OP_RGBA;
+                memcpy(out, pixel, 4);
+                out += 4;
+            }
+        }
+        memcpy(previous, pixel, 4);
+    }
+
+    memset(out, 0, QOI_END_SIZE - 1);
+    out[QOI_END_SIZE - 1] = 1;
+    out += QOI_END_SIZE;
+    return (size_t)(out - start);
+}
+
+// Writes `size` bytes to a new file at `filepath`. Returns 0 on success.
+static int write_file(const char *filepath, const uint8_t *data, size_t size) {
+    int fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return 1;
+    while (size) {
+        ssize_t written = write(fd, data, size);
+        if (written <= 0) {
+            close(fd);
+            return 1;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return close(fd) != 0;
+}
+
+// Encodes and writes `image`. Returns the size of the file, 0 on failure.
+static size_t write_image(CaptureWorker *worker, CaptureImage *image) {
+    Capture *capture = worker->capture;
+    char filepath[PATH_MAX + 32] = {0};
+    snprintf(filepath, sizeof(filepath), "%s/frame_%06zu.%s",
+             capture->directory, image->frame_index,
+             capture->format == CAPTURE_FORMAT_PNG ? "png" : "qoi");
+
+    if (capture->format == CAPTURE_FORMAT_PNG) {
+        Image png = {
+            .data = image->pixels,
+            .width = capture->width,
+            .height = capture->height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+        };
+        struct stat file_stat;
+        if (!ExportImage(png, filepath) || stat(filepath, &file_stat))
+            return 0;
+        return (size_t)file_stat.st_size;
+    }
+
+    size_t size = capture_encode_qoi(image->pixels, capture->width,
+                                     capture->height, worker->encode_buffer);
+    if (write_file(filepath, worker->encode_buffer, size))
+        return 0;
+    return size;
+}
+
+static void *worker_main(void *arg) {
+    CaptureWorker *worker = arg;
+    Capture *capture = worker->capture;
+
+    pthread_mutex_lock(&capture->lock);
+    while (1) {
+        while (!capture->queued_count && !capture->stopping)
+            pthread_cond_wait(&capture->queued, &capture->lock);
+        // The queue is drained before stopping
+        if (!capture->queued_count)
+            break;
+
+        size_t image_index = capture->queued_images[capture->queued_first];
+        capture->queued_first =
+            (capture->queued_first + 1) % CAPTURE_QUEUE_SIZE;
+        capture->queued_count--;
+        pthread_mutex_unlock(&capture->lock);
+
+        double start = timings_now();
+        size_t size = write_image(worker, capture->images + image_index);
+        double seconds = timings_now() - start;
+
+        pthread_mutex_lock(&capture->lock);
+        if (size) {
+            capture->written_count++;
+            capture->bytes_written += size;
+        } else {
+            fprintf(stderr, "ERROR: could not write captured frame %zu\n",
+                    capture->images[image_index].frame_index);
+            capture->failed_count++;
+        }
+        capture->encode_seconds += seconds;
+        capture->free_images[capture->free_count++] = image_index;
+        pthread_cond_signal(&capture->freed);
+    }
+    pthread_mutex_unlock(&capture->lock);
+    return 0;
+}
+
+int capture_init(Capture *capture, const char *directory, CaptureFormat format,
+                 int width, int height, int worker_count) {
+    assert(width > 0 && height > 0);
+    *capture = (Capture){
+        .format = format,
+        .width = width,
+        .height = height,
+        .fence_signaled = &gl_fence_signaled,
+    };
+    if (strlen(directory) >= sizeof(capture->directory)) {
+        fprintf(stderr, "ERROR: capture directory path is too long\n");
+        return 1;
+    }
+    strcpy(capture->directory, directory);
+
+    struct stat directory_stat;
+    if (stat(directory, &directory_stat) || !S_ISDIR(directory_stat.st_mode)) {
+        fprintf(stderr, "ERROR: capture directory %s does not exist\n",
+                directory);
+        return 1;
+    }
+
+    if (!worker_count) {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        // One processor is left for the render loop
+        worker_count = processor_count > 1 ? (int)processor_count - 1 : 1;
+    }
+    if (worker_count > CAPTURE_MAX_WORKERS)
+        worker_count = CAPTURE_MAX_WORKERS;
+
+    // Everything is allocated up front so that capturing does not allocate
+    for (size_t i = 0; i < CAPTURE_QUEUE_SIZE; i++) {
+        capture->images[i].pixels = malloc(frame_size(capture));
+        if (!capture->images[i].pixels)
+            abort();
+        capture->free_images[capture->free_count++] = i;
+    }
+
+    pthread_mutex_init(&capture->lock, 0);
+    pthread_cond_init(&capture->queued, 0);
+    pthread_cond_init(&capture->freed, 0);
+
+    for (int i = 0; i < worker_count; i++) {
+        CaptureWorker *worker = capture->workers + i;
+        worker->capture = capture;
+        if (format == CAPTURE_FORMAT_QOI) {
+            worker->encode_buffer = malloc(capture_qoi_max_size(width, height));
+            if (!worker->encode_buffer)
+                abort();
+        }
+        if (pthread_create(&worker->thread, 0, &worker_main, worker)) {
+            free(worker->encode_buffer);
+            worker->encode_buffer = 0;
+            break;
+        }
+        capture->worker_count++;
+    }
+
+    if (!capture->worker_count) {
+        fprintf(stderr, "ERROR: could not start any capture workers\n");
+        capture_free(capture);
+        return 1;
+    }
+    return 0;
+}
+
+// Takes a free image, waiting for the workers to free one if `wait` is 1.
+static CaptureImage *acquire_image(Capture *capture, int wait) {
+    pthread_mutex_lock(&capture->lock);
+    while (wait && !capture->free_count && capture->worker_count)
+        pthread_cond_wait(&capture->freed, &capture->lock);
+
+    CaptureImage *image = 0;
+    if (capture->free_count)
+        image = capture->images + capture->free_images[--capture->free_count];
+    pthread_mutex_unlock(&capture->lock);
+    return image;
+}
+
+CaptureImage *capture_acquire(Capture *capture) {
+    return acquire_image(capture, 0);
+}
+
+void capture_submit(Capture *capture, CaptureImage *image) {
+    if (!capture->start_time)
+        capture->start_time = timings_now();
+
+    pthread_mutex_lock(&capture->lock);
+    size_t last =
+        (capture->queued_first + capture->queued_count) % CAPTURE_QUEUE_SIZE;
+    capture->queued_images[last] = (size_t)(image - capture->images);
+    capture->queued_count++;
+    pthread_cond_signal(&capture->queued);
+    pthread_mutex_unlock(&capture->lock);
+}
+
+// Copies the finished readbacks to images and queues them, oldest first.
+// Waits for the GPU and for free images if `wait` is 1.
+static void collect_readbacks(Capture *capture, int wait) {
+    size_t row_size = (size_t)capture->width * 4;
+
+    while (capture->readback_count) {
+        CaptureReadback *readback =
+            capture->readbacks + capture->readback_first;
+        if (!(*capture->fence_signaled)(readback->fence, wait))
+            break;
+        readback->fence = 0;
+        capture->readback_first =
+            (capture->readback_first + 1) % CAPTURE_READBACK_COUNT;
+        capture->readback_count--;
+
+        CaptureImage *image = acquire_image(capture, wait);
+        if (!image) {
+            capture->dropped_count++;
+            continue;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer_id);
+        const uint8_t *pixels = glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)frame_size(capture),
+            GL_MAP_READ_BIT);
+        if (pixels) {
+            // OpenGL stores the bottom row first
+            for (int y = 0; y < capture->height; y++)
+                memcpy(image->pixels + (size_t)y * row_size,
+                       pixels + (size_t)(capture->height - 1 - y) * row_size,
+                       row_size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        if (!pixels) {
+            pthread_mutex_lock(&capture->lock);
+            capture->free_images[capture->free_count++] =
+                (size_t)(image - capture->images);
+            pthread_mutex_unlock(&capture->lock);
+            capture->dropped_count++;
+            continue;
+        }
+
+        image->frame_index = readback->frame_index;
+        capture_submit(capture, image);
+    }
+}
+
+void capture_read_frame(Capture *capture) {
+    collect_readbacks(capture, 0);
+
+    size_t frame_index = capture->frame_count++;
+    // The GPU or the copies are behind
+    if (capture->readback_count == CAPTURE_READBACK_COUNT) {
+        capture->dropped_count++;
+        return;
+    }
+
+    size_t slot = (capture->readback_first + capture->readback_count) %
+                  CAPTURE_READBACK_COUNT;
+    CaptureReadback *readback = capture->readbacks + slot;
+    if (!readback->buffer_id) {
+        glGenBuffers(1, &readback->buffer_id);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer_id);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)frame_size(capture), 0,
+                     GL_STREAM_READ);
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer_id);
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, capture->width, capture->height, GL_RGBA,
+                 GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback->frame_index = frame_index;
+    capture->readback_count++;
+}
+
+void capture_finish(Capture *capture, int gl_readbacks) {
+    if (gl_readbacks)
+        collect_readbacks(capture, 1);
+
+    pthread_mutex_lock(&capture->lock);
+    capture->stopping = 1;
+    pthread_cond_broadcast(&capture->queued);
+    pthread_mutex_unlock(&capture->lock);
+
+    for (int i = 0; i < capture->worker_count; i++)
+        pthread_join(capture->workers[i].thread, 0);
+    capture->worker_count = 0;
+    capture->end_time = timings_now();
+}
+
+void capture_free(Capture *capture) {
+    assert(!capture->worker_count);
+
+    for (size_t i = 0; i < CAPTURE_READBACK_COUNT; i++) {
+        if (capture->readbacks[i].buffer_id)
+            glDeleteBuffers(1, &capture->readbacks[i].buffer_id);
+        capture->readbacks[i].buffer_id = 0;
+    }
+
+    for (size_t i = 0; i < CAPTURE_QUEUE_SIZE; i++) {
+        free(capture->images[i].pixels);
+        capture->images[i].pixels = 0;
+    }
+    for (size_t i = 0; i < CAPTURE_MAX_WORKERS; i++) {
+        free(capture->workers[i].encode_buffer);
+        capture->workers[i].encode_buffer = 0;
+    }
+
+    pthread_mutex_destroy(&capture->lock);
+    pthread_cond_destroy(&capture->queued);
+    pthread_cond_destroy(&capture->freed);
+}
+
+void capture_print(Capture *capture, FILE *file) {
+    fprintf(file, "capture: %zu frames written to %s, %zu dropped",
+            capture->written_count, capture->directory,
+            capture->dropped_count);
+    if (capture->failed_count)
+        fprintf(file, ", %zu failed", capture->failed_count);
+    fprintf(file, "\n");
+
+    double seconds = capture->end_time - capture->start_time;
+    if (!capture->written_count || seconds <= 0.0)
+        return;
+    fprintf(file,
+            "capture throughput: %.1f frames/s, %.1f MB/s, %.2f ms encoding "
+            "per frame\n",
+            (double)capture->written_count / seconds,
+            (double)capture->bytes_written / (1024.0 * 1024.0) / seconds,
+            capture->encode_seconds * 1000.0 /
+                (double)capture->written_count);
+}
@@ -0,0 +1,128 @@
+#ifndef _CAPTURE
+#define _CAPTURE
+
+// Captures rendered frames to a directory of numbered images.
+//
+// Frames are read back into pixel pack buffers, and copied out once a fence
+// shows the GPU has finished writing them, a few frames later. The copies go
+// through a queue of preallocated images to a pool of worker threads which
+// encode and write them. Neither the readback nor the encoding ever blocks
+// the render loop: when every buffer or image is still busy the frame is
+// dropped and counted instead.
+//
+// Only plain OpenGL 3.3 is needed, so capturing also works on software
+// renderers such as Mesa's llvmpipe.
+
+#include "staging_ring.h"
+#include <linux/limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Frames in flight between the readback and the copy to an image
+#define CAPTURE_READBACK_COUNT 3
+// Images waiting for or being encoded
+#define CAPTURE_QUEUE_SIZE 16
+#define CAPTURE_MAX_WORKERS 8
+
+typedef enum {
+    // Quite OK Image Format, fast to encode
+    CAPTURE_FORMAT_QOI,
+    CAPTURE_FORMAT_PNG,
+} CaptureFormat;
+
+// A frame of RGBA8 pixels, top row first.
+typedef struct {
+    uint8_t *pixels;
+    size_t frame_index;
+} CaptureImage;
+
+typedef struct {
+    unsigned int buffer_id;
+    // 0 if the buffer is free
+    void *fence;
+    size_t frame_index;
+} CaptureReadback;
+
+typedef struct Capture Capture;
+
+typedef struct {
+    pthread_t thread;
+    Capture *capture;
+    // Encoded file, large enough for any frame. Only used for QOI.
+    uint8_t *encode_buffer;
+} CaptureWorker;
+
+struct Capture {
+    char directory[PATH_MAX];
+    CaptureFormat format;
+    int width;
+    int height;
+
+    CaptureReadback readbacks[CAPTURE_READBACK_COUNT];
+    // Oldest readback in flight and their number
+    size_t readback_first;
+    size_t readback_count;
+    // Returns 1 if `fence` has been signalled, waiting for it if `wait` is 1.
+    StagingFenceSignaled fence_signaled;
+
+    CaptureImage images[CAPTURE_QUEUE_SIZE];
+    // Indices of the images free to fill, and of those waiting for a worker
+    // in the order they were submitted
+    size_t free_images[CAPTURE_QUEUE_SIZE];
+    size_t free_count;
+    size_t queued_images[CAPTURE_QUEUE_SIZE];
+    size_t queued_first;
+    size_t queued_count;
+
+    CaptureWorker workers[CAPTURE_MAX_WORKERS];
+    int worker_count;
+    int stopping;
+    pthread_mutex_t lock;
+    // Signalled when an image is queued and when an image is freed
+    pthread_cond_t queued;
+    pthread_cond_t freed;
+
+    // Frames offered to capture_read_frame, including dropped ones
+    size_t frame_count;
+    size_t dropped_count;
+    // Written by the workers, under `lock`
+    size_t written_count;
+    size_t failed_count;
+    size_t bytes_written;
+    double encode_seconds;
+    double start_time;
+    double end_time;
+};
+
+// Starts the workers of a capture of `width` x `height` frames into
+// `directory`, which must exist. A `worker_count` of 0 uses one worker per
+// spare processor. Returns 0 on success.
+int capture_init(Capture *capture, const char *directory, CaptureFormat format,
+                 int width, int height, int worker_count);
+// Waits for the queued frames to be written and stops the workers. Reads back
+// the frames still in flight first if `gl_readbacks` is 1, which needs the GL
+// context.
+void capture_finish(Capture *capture, int gl_readbacks);
+// Frees the images and GL buffers, call after capture_finish.
+void capture_free(Capture *capture);
+
+// Starts the readback of the current framebuffer and queues the frames whose
+// readback has finished. Call after drawing and before swapping buffers.
+void capture_read_frame(Capture *capture);
+
+// Takes a free image to fill in, or returns 0 if every image is in use.
+CaptureImage *capture_acquire(Capture *capture);
+// Queues a filled image from capture_acquire for encoding.
+void capture_submit(Capture *capture, CaptureImage *image);
+
+// Encodes `width` x `height` RGBA8 pixels as QOI into `out`, which must hold
+// capture_qoi_max_size bytes. Returns the size of the encoded file.
+size_t capture_encode_qoi(const uint8_t *pixels, int width, int height,
+                          uint8_t *out);
+size_t capture_qoi_max_size(int width, int height);
+
+void capture_print(Capture *capture, FILE *file);
+
+#endif
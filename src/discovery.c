@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+#include "discovery.h"
+#include "path.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Fewer models than this per thread are not worth starting one for
+#define MODELS_PER_WORKER 32
+
+typedef struct {
+    int *found;
+    const char *const *model_filepaths;
+    size_t begin;
+    size_t end;
+    const DiscoveryPatterns *patterns;
+    size_t missing;
+} DiscoveryChunk;
+
+// Writes `model_filepath` with its extension replaced by `pattern`. Returns 0
+// on success.
+static int write_sidecar(char *destination, size_t size,
+                         const char *model_filepath, const char *pattern) {
+    size_t length = strlen(model_filepath);
+    const char *slash = strrchr(model_filepath, '/');
+    const char *dot = strrchr(model_filepath, '.');
+    if (dot && (!slash || dot > slash))
+        length = (size_t)(dot - model_filepath);
+
+    size_t pattern_length = strlen(pattern);
+    if (length + pattern_length + 1 > size)
+        return 1;
+    memcpy(destination, model_filepath, length);
+    memcpy(destination + length, pattern, pattern_length + 1);
+    return 0;
+}
+
+static void *find_chunk(void *arg) {
+    DiscoveryChunk *chunk = arg;
+    char filepath[PATH_MAX];
+    for (size_t i = chunk->begin; i < chunk->end; i++) {
+        const char *model_filepath = chunk->model_filepaths[i];
+        int *found = chunk->found + i;
+        if (path_is_aseprite(model_filepath)) {
+            *found = DISCOVERY_SELF;
+            continue;
+        }
+
+        *found = DISCOVERY_MISSING;
+        for (int p = 0; p < chunk->patterns->pattern_count; p++) {
+            const char *pattern = chunk->patterns->patterns[p];
+            if (write_sidecar(filepath, sizeof(filepath), model_filepath,
+                              pattern))
+                continue;
+            // Only the type is needed, cached attributes will do
+            struct statx attributes;
+            if (statx(AT_FDCWD, filepath, AT_STATX_DONT_SYNC, STATX_TYPE,
+                      &attributes) ||
+                !S_ISREG(attributes.stx_mode))
+                continue;
+            *found = p;
+            break;
+        }
+        chunk->missing += *found == DISCOVERY_MISSING;
+    }
+    return 0;
+}
+
+int discovery_parse_patterns(DiscoveryPatterns *patterns, const char *list) {
+    *patterns = (DiscoveryPatterns){0};
+    while (*list) {
+        const char *end = strchr(list, ',');
+        size_t length = end ? (size_t)(end - list) : strlen(list);
+        if (length) {
+            if (patterns->pattern_count == DISCOVERY_MAX_PATTERNS ||
+                length >= DISCOVERY_PATTERN_SIZE || memchr(list, '/', length))
+                return 1;
+            memcpy(patterns->patterns[patterns->pattern_count++], list,
+                   length);
+        }
+        list += length + (end != 0);
+    }
+    return patterns->pattern_count == 0;
+}
+
+size_t discovery_find_textures(int *found,
+                               const char *const *model_filepaths,
+                               size_t count,
+                               const DiscoveryPatterns *patterns,
+                               int worker_count) {
+    if (!worker_count) {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        worker_count = processor_count > 0 ? (int)processor_count : 1;
+    }
+    if (worker_count > DISCOVERY_MAX_WORKERS)
+        worker_count = DISCOVERY_MAX_WORKERS;
+    size_t useful = (count + MODELS_PER_WORKER - 1) / MODELS_PER_WORKER;
+    if ((size_t)worker_count > useful)
+        worker_count = useful ? (int)useful : 1;
+
+    DiscoveryChunk chunks[DISCOVERY_MAX_WORKERS];
+    for (int i = 0; i < worker_count; i++) {
+        chunks[i] = (DiscoveryChunk){
+            .found = found,
+            .model_filepaths = model_filepaths,
+            .begin = count * (size_t)i / (size_t)worker_count,
+            .end = count * (size_t)(i + 1) / (size_t)worker_count,
+            .patterns = patterns,
+        };
+    }
+
+    // On a thread each but the first
+    pthread_t threads[DISCOVERY_MAX_WORKERS];
+    int started[DISCOVERY_MAX_WORKERS] = {0};
+    for (int i = 1; i < worker_count; i++)
+        started[i] = !pthread_create(threads + i, 0, &find_chunk, chunks + i);
+    find_chunk(chunks);
+    size_t missing = chunks[0].missing;
+    for (int i = 1; i < worker_count; i++) {
+        if (started[i])
+            pthread_join(threads[i], 0);
+        else
+            find_chunk(chunks + i);
+        missing += chunks[i].missing;
+    }
+    return missing;
+}
+
+int discovery_write_texture_file(char *destination, size_t size,
+                                 const char *model_filepath,
+                                 const DiscoveryPatterns *patterns, int found) {
+    if (found == DISCOVERY_SELF)
+        return path_write_texture_file(destination, size, model_filepath);
+    if (found < 0)
+        return 1;
+    assert(found < patterns->pattern_count);
+    return write_sidecar(destination, size, model_filepath,
+                         patterns->patterns[found]);
+}
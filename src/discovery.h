@@ -0,0 +1,53 @@
+#ifndef _DISCOVERY
+#define _DISCOVERY
+
+// Finds the texture of each model at startup, before anything is loaded.
+//
+// The texture of a model is a sidecar file next to it: the model's path with
+// its extension replaced by one of the sidecar patterns, tried in order. Every
+// candidate is checked with statx alone, split between worker threads, so that
+// missing textures are known without opening or decoding anything. Sprites
+// extruded into voxels are their own texture.
+//
+// Aseprite textures are composited, any other image is loaded as is by raylib.
+
+#include <stddef.h>
+
+#define DISCOVERY_MAX_PATTERNS 8
+#define DISCOVERY_PATTERN_SIZE 32
+#define DISCOVERY_MAX_WORKERS 16
+// Tried in this order unless set otherwise with -sidecar
+#define DISCOVERY_DEFAULT_PATTERNS ".aseprite,.ase,.png"
+// Pattern index of a model that is its own texture
+#define DISCOVERY_SELF -1
+// Pattern index of a model without a texture
+#define DISCOVERY_MISSING -2
+
+typedef struct {
+    // Suffixes replacing the extension of the model, e.g. ".aseprite"
+    char patterns[DISCOVERY_MAX_PATTERNS][DISCOVERY_PATTERN_SIZE];
+    int pattern_count;
+} DiscoveryPatterns;
+
+// Parses a comma separated list of patterns such as ".ase,.png". Returns 0
+// on success.
+int discovery_parse_patterns(DiscoveryPatterns *patterns, const char *list);
+
+// Finds the textures of the `count` models at `model_filepaths`, storing the
+// index of the pattern matched by each in `found`, or DISCOVERY_SELF or
+// DISCOVERY_MISSING. Uses `worker_count` threads (0 for one per processor).
+// Returns the number of models without a texture.
+size_t discovery_find_textures(int *found,
+                               const char *const *model_filepaths,
+                               size_t count,
+                               const DiscoveryPatterns *patterns,
+                               int worker_count);
+
+// Writes the path of the texture of the model at `model_filepath` found with
+// the pattern `found`. Returns 0 on success, 1 if the model has no texture or
+// the path does not fit in `size` bytes.
+int discovery_write_texture_file(char *destination, size_t size,
+                                 const char *model_filepath,
+                                 const DiscoveryPatterns *patterns, int found);
+
+#endif
@@ -0,0 +1,702 @@
+#define _GNU_SOURCE
+#include "disk_cache.h"
+#include "metrics.h"
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ENTRY_MAGIC "BLDC"
+#define ENTRY_VERSION 1
+#define ENTRY_EXTENSION ".cache"
+// The payload starts after the header, aligned for any of its arrays
+#define ENTRY_PAYLOAD_OFFSET 64
+#define ENTRY_NAME_SIZE 64
+#define MAX_PARTS 16
+
+// Arrays present in a mesh entry
+#define MESH_TEXCOORDS 0x1
+#define MESH_NORMALS 0x2
+#define MESH_COLORS 0x4
+#define MESH_INDICES 0x8
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t source;
+    uint64_t key_version;
+    uint64_t payload_size;
+} EntryHeader;
+
+_Static_assert(sizeof(EntryHeader) <= ENTRY_PAYLOAD_OFFSET,
+               "the entry header overlaps the payload");
+
+typedef struct {
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+    uint32_t arrays;
+    uint32_t padding;
+} MeshHeader;
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+} PixelsHeader;
+
+// An entry to unlink or to write the access time of, once the lock is
+// released
+typedef struct {
+    DiskCacheKey key;
+    double last_access;
+} PendingFileOp;
+
+_Static_assert(offsetof(PendingFileOp, key) == 0 &&
+                   offsetof(DiskCacheEntry, key) == 0,
+               "entries and pending operations are compared by key");
+
+static inline uint64_t hash_bytes(uint64_t hash, const void *data,
+                                  size_t size) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+static inline double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static inline void write_entry_name(char *name, DiskCacheKey key) {
+    snprintf(name, ENTRY_NAME_SIZE,
+             "%016" PRIx64 "-%016" PRIx64 ENTRY_EXTENSION, key.source,
+             key.version);
+}
+
+// 1 if `name` is an entry, storing its key.
+static inline int parse_entry_name(const char *name, DiskCacheKey *key) {
+    char extension[16] = {0};
+    if (sscanf(name, "%16" SCNx64 "-%16" SCNx64 "%15s", &key->source,
+               &key->version, extension) != 3)
+        return 0;
+    return strlen(name) == 33 + strlen(ENTRY_EXTENSION) &&
+           !strcmp(extension, ENTRY_EXTENSION);
+}
+
+static inline int same_key(DiskCacheKey a, DiskCacheKey b) {
+    return a.source == b.source && a.version == b.version;
+}
+
+// Index of the entry of `key`, entry_count if there is none. Call locked.
+static size_t find_entry(DiskCache *cache, DiskCacheKey key) {
+    size_t i = 0;
+    while (i < cache->entry_count && !same_key(cache->entries[i].key, key))
+        i++;
+    return i;
+}
+
+static void remove_entry(DiskCache *cache, size_t index) {
+    cache->total_size -= cache->entries[index].size;
+    cache->entries[index] = cache->entries[--cache->entry_count];
+}
+
+static DiskCacheEntry *add_entry(DiskCache *cache, DiskCacheKey key) {
+    if (cache->entry_count >= cache->entries_allocated) {
+        cache->entries_allocated =
+            cache->entries_allocated ? cache->entries_allocated * 2 : 64;
+        cache->entries = realloc(cache->entries, cache->entries_allocated *
+                                                     sizeof(DiskCacheEntry));
+        if (!cache->entries)
+            abort();
+    }
+    DiskCacheEntry *entry = cache->entries + cache->entry_count++;
+    *entry = (DiskCacheEntry){.key = key};
+    return entry;
+}
+
+// Records an access to the entry of `key`, `size` bytes on disk.
+static void record_access(DiskCache *cache, DiskCacheKey key, uint64_t size) {
+    double now = now_seconds();
+    pthread_mutex_lock(&cache->lock);
+    size_t index = find_entry(cache, key);
+    DiskCacheEntry *entry = index < cache->entry_count
+                                ? cache->entries + index
+                                : add_entry(cache, key);
+    cache->total_size += size - entry->size;
+    entry->size = size;
+    entry->last_access = now;
+    entry->touched = 1;
+    uint64_t total_size = cache->total_size;
+    if (total_size > cache->capacity)
+        pthread_cond_signal(&cache->wake);
+    pthread_mutex_unlock(&cache->lock);
+    metrics_set(METRIC_DISK_CACHE_BYTES, total_size);
+}
+
+int disk_cache_open(DiskCache *cache, const char *directory,
+                    uint64_t capacity) {
+    *cache = (DiskCache){
+        .directory_fd = -1,
+        .capacity = capacity,
+        .interval = DISK_CACHE_COMPACT_INTERVAL,
+    };
+    if (strlen(directory) >= sizeof(cache->directory)) {
+        fprintf(stderr, "ERROR: cache directory path is too long\n");
+        return 1;
+    }
+    strcpy(cache->directory, directory);
+
+    if (mkdir(directory, 0755) && errno != EEXIST) {
+        fprintf(stderr, "ERROR: could not create cache directory %s\n",
+                directory);
+        return 1;
+    }
+    cache->directory_fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (cache->directory_fd < 0) {
+        fprintf(stderr, "ERROR: could not open cache directory %s\n",
+                directory);
+        return 1;
+    }
+    pthread_mutex_init(&cache->lock, 0);
+    pthread_cond_init(&cache->wake, 0);
+    return 0;
+}
+
+void disk_cache_close(DiskCache *cache) {
+    if (cache->directory_fd < 0)
+        return;
+    if (cache->thread_running) {
+        pthread_mutex_lock(&cache->lock);
+        cache->stopping = 1;
+        pthread_cond_signal(&cache->wake);
+        pthread_mutex_unlock(&cache->lock);
+        pthread_join(cache->thread, 0);
+    }
+    pthread_cond_destroy(&cache->wake);
+    pthread_mutex_destroy(&cache->lock);
+    close(cache->directory_fd);
+    free(cache->entries);
+    *cache = (DiskCache){.directory_fd = -1};
+}
+
+DiskCacheKey disk_cache_key(DiskCacheKind kind, const char *filepath) {
+    uint64_t source = 0xcbf29ce484222325ull;
+    uint32_t format = (uint32_t)kind << 16 | ENTRY_VERSION;
+    source = hash_bytes(source, &format, sizeof(format));
+    source = hash_bytes(source, filepath, strlen(filepath));
+
+    struct stat source_stat;
+    if (stat(filepath, &source_stat))
+        return (DiskCacheKey){.source = source};
+
+    uint64_t version = source;
+    int64_t stamp[4] = {(int64_t)source_stat.st_size,
+                        (int64_t)source_stat.st_mtim.tv_sec,
+                        (int64_t)source_stat.st_mtim.tv_nsec,
+                        (int64_t)source_stat.st_ino};
+    version = hash_bytes(version, stamp, sizeof(stamp));
+    // 0 is reserved for unreadable sources
+    return (DiskCacheKey){.source = source, .version = version ? version : 1};
+}
+
+int disk_cache_get(DiskCache *cache, DiskCacheKey key, DiskCacheBlob *blob) {
+    *blob = (DiskCacheBlob){0};
+    if (!key.version) {
+        metrics_count(METRIC_DISK_CACHE_MISSES, 1);
+        return 1;
+    }
+
+    char name[ENTRY_NAME_SIZE];
+    write_entry_name(name, key);
+    int fd = openat(cache->directory_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        metrics_count(METRIC_DISK_CACHE_MISSES, 1);
+        return 1;
+    }
+
+    struct stat entry_stat;
+    void *map = MAP_FAILED;
+    if (!fstat(fd, &entry_stat) &&
+        (size_t)entry_stat.st_size >= ENTRY_PAYLOAD_OFFSET)
+        map = mmap(0, (size_t)entry_stat.st_size, PROT_READ, MAP_SHARED, fd,
+                   0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        metrics_count(METRIC_DISK_CACHE_MISSES, 1);
+        return 1;
+    }
+
+    const EntryHeader *header = map;
+    if (memcmp(header->magic, ENTRY_MAGIC, 4) ||
+        header->version != ENTRY_VERSION || header->source != key.source ||
+        header->key_version != key.version ||
+        header->payload_size !=
+            (uint64_t)entry_stat.st_size - ENTRY_PAYLOAD_OFFSET) {
+        munmap(map, (size_t)entry_stat.st_size);
+        // Written by another version, or damaged outside of the cache
+        unlinkat(cache->directory_fd, name, 0);
+        metrics_count(METRIC_DISK_CACHE_MISSES, 1);
+        return 1;
+    }
+
+    *blob = (DiskCacheBlob){
+        .data = (const uint8_t *)map + ENTRY_PAYLOAD_OFFSET,
+        .size = (size_t)header->payload_size,
+        .map = map,
+        .map_size = (size_t)entry_stat.st_size,
+    };
+    record_access(cache, key, (uint64_t)entry_stat.st_size);
+    metrics_count(METRIC_DISK_CACHE_HITS, 1);
+    return 0;
+}
+
+void disk_cache_release(DiskCacheBlob *blob) {
+    if (blob->map)
+        munmap(blob->map, blob->map_size);
+    *blob = (DiskCacheBlob){0};
+}
+
+// Writes all of `parts`, continuing after short writes.
+static int write_parts(int fd, struct iovec *parts, int part_count) {
+    while (part_count) {
+        ssize_t written = writev(fd, parts, part_count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+        while (part_count && (size_t)written >= parts->iov_len) {
+            written -= (ssize_t)parts->iov_len;
+            parts++;
+            part_count--;
+        }
+        if (part_count) {
+            parts->iov_base = (uint8_t *)parts->iov_base + written;
+            parts->iov_len -= (size_t)written;
+        }
+    }
+    return 0;
+}
+
+int disk_cache_put(DiskCache *cache, DiskCacheKey key,
+                   const struct iovec *parts, int part_count) {
+    assert(part_count < MAX_PARTS);
+    if (!key.version)
+        return 1;
+
+    uint64_t header_bytes[ENTRY_PAYLOAD_OFFSET / 8] = {0};
+    EntryHeader *header = (EntryHeader *)header_bytes;
+    *header = (EntryHeader){
+        .magic = ENTRY_MAGIC,
+        .version = ENTRY_VERSION,
+        .source = key.source,
+        .key_version = key.version,
+    };
+    struct iovec all_parts[MAX_PARTS] = {
+        {.iov_base = header_bytes, .iov_len = sizeof(header_bytes)}};
+    for (int i = 0; i < part_count; i++) {
+        all_parts[i + 1] = parts[i];
+        header->payload_size += parts[i].iov_len;
+    }
+
+    char name[ENTRY_NAME_SIZE];
+    write_entry_name(name, key);
+    pthread_mutex_lock(&cache->lock);
+    uint64_t write_index = cache->writes++;
+    pthread_mutex_unlock(&cache->lock);
+    char temporary[ENTRY_NAME_SIZE * 2];
+    snprintf(temporary, sizeof(temporary), "%s.tmp.%ld.%" PRIu64, name,
+             (long)getpid(), write_index);
+
+    int fd = openat(cache->directory_fd, temporary,
+                    O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return 1;
+    // Synced before the rename so that the entry is complete whenever its
+    // name exists
+    int error = write_parts(fd, all_parts, part_count + 1) || fsync(fd);
+    error |= close(fd);
+    if (error ||
+        renameat(cache->directory_fd, temporary, cache->directory_fd, name)) {
+        unlinkat(cache->directory_fd, temporary, 0);
+        return 1;
+    }
+    fsync(cache->directory_fd);
+
+    record_access(cache, key, ENTRY_PAYLOAD_OFFSET + header->payload_size);
+    return 0;
+}
+
+static int compare_access(const void *a, const void *b) {
+    double difference = ((const DiskCacheEntry *)a)->last_access -
+                        ((const DiskCacheEntry *)b)->last_access;
+    return (difference > 0.0) - (difference < 0.0);
+}
+
+// Orders entries and pending operations, which both start with the key
+static int compare_key(const void *a, const void *b) {
+    const DiskCacheKey *key_a = a;
+    const DiskCacheKey *key_b = b;
+    if (key_a->source != key_b->source)
+        return (key_a->source > key_b->source) -
+               (key_a->source < key_b->source);
+    return (key_a->version > key_b->version) -
+           (key_a->version < key_b->version);
+}
+
+// By source, most recently used first within a source
+static int compare_source_access(const void *a, const void *b) {
+    const DiskCacheEntry *entry_a = a;
+    const DiskCacheEntry *entry_b = b;
+    if (entry_a->key.source != entry_b->key.source)
+        return (entry_a->key.source > entry_b->key.source) -
+               (entry_a->key.source < entry_b->key.source);
+    return compare_access(b, a);
+}
+
+// Merges the entries in the directory into the index and removes temporary
+// files left behind. Entries written while scanning are kept.
+static void scan_directory(DiskCache *cache, double scan_start) {
+    DIR *directory = opendir(cache->directory);
+    if (!directory)
+        return;
+
+    DiskCacheEntry *found = 0;
+    size_t found_count = 0;
+    size_t found_allocated = 0;
+    struct dirent *dirent;
+    while ((dirent = readdir(directory))) {
+        struct stat entry_stat;
+        if (dirent->d_name[0] == '.' ||
+            fstatat(cache->directory_fd, dirent->d_name, &entry_stat,
+                    AT_SYMLINK_NOFOLLOW) ||
+            !S_ISREG(entry_stat.st_mode))
+            continue;
+
+        DiskCacheKey key;
+        if (!parse_entry_name(dirent->d_name, &key)) {
+            if (strstr(dirent->d_name, ENTRY_EXTENSION ".tmp.") &&
+                scan_start - (double)entry_stat.st_mtim.tv_sec >
+                    DISK_CACHE_STALE_SECONDS)
+                unlinkat(cache->directory_fd, dirent->d_name, 0);
+            continue;
+        }
+
+        if (found_count >= found_allocated) {
+            found_allocated = found_allocated ? found_allocated * 2 : 64;
+            found = realloc(found, found_allocated * sizeof(DiskCacheEntry));
+            if (!found)
+                abort();
+        }
+        found[found_count++] = (DiskCacheEntry){
+            .key = key,
+            .size = (uint64_t)entry_stat.st_size,
+            .last_access = (double)entry_stat.st_mtim.tv_sec +
+                           (double)entry_stat.st_mtim.tv_nsec / 1e9,
+        };
+    }
+    closedir(directory);
+
+    // Sorted to look each indexed entry up while locked
+    qsort(found, found_count, sizeof(DiskCacheEntry), &compare_key);
+
+    pthread_mutex_lock(&cache->lock);
+    // Removed by someone else, unless written since the scan started
+    for (size_t i = 0; i < cache->entry_count;) {
+        DiskCacheEntry *entry = cache->entries + i;
+        DiskCacheEntry *match = bsearch(entry, found, found_count,
+                                        sizeof(DiskCacheEntry), &compare_key);
+        if (!match) {
+            if (entry->last_access < scan_start)
+                remove_entry(cache, i);
+            else
+                i++;
+            continue;
+        }
+        if (match->last_access > entry->last_access)
+            entry->last_access = match->last_access;
+        // Entries are never empty, so a size of 0 marks the merged
+        match->size = 0;
+        i++;
+    }
+    for (size_t i = 0; i < found_count; i++) {
+        if (!found[i].size)
+            continue;
+        *add_entry(cache, found[i].key) = found[i];
+        cache->total_size += found[i].size;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    free(found);
+}
+
+void disk_cache_compact(DiskCache *cache) {
+    scan_directory(cache, now_seconds());
+
+    // Evictions are chosen on a copy, so that lookups are only held up while
+    // the copy is taken and the chosen entries are dropped
+    pthread_mutex_lock(&cache->lock);
+    size_t count = cache->entry_count;
+    DiskCacheEntry *entries = malloc((count ? count : 1) * sizeof(*entries));
+    if (!entries)
+        abort();
+    memcpy(entries, cache->entries, count * sizeof(*entries));
+    pthread_mutex_unlock(&cache->lock);
+
+    PendingFileOp *removed = malloc((count ? count : 1) * sizeof(*removed));
+    PendingFileOp *touched = malloc((count ? count : 1) * sizeof(*touched));
+    if (!removed || !touched)
+        abort();
+    size_t removed_count = 0;
+    size_t touched_count = 0;
+
+    // Older versions of a source are never read again, unless the source is
+    // put back the way it was, so only the most recently used one is kept
+    qsort(entries, count, sizeof(DiskCacheEntry), &compare_source_access);
+    for (size_t i = 1; i < count; i++) {
+        if (entries[i].key.source != entries[i - 1].key.source)
+            continue;
+        removed[removed_count++] =
+            (PendingFileOp){entries[i].key, entries[i].last_access};
+        // Entries are never empty, so a size of 0 marks the removed
+        entries[i].size = 0;
+    }
+    // Most recently used first
+    qsort(entries, count, sizeof(DiskCacheEntry), &compare_access);
+    uint64_t kept_size = 0;
+    for (size_t i = count; i-- > 0;) {
+        DiskCacheEntry entry = entries[i];
+        if (!entry.size)
+            continue;
+        if (kept_size + entry.size > cache->capacity) {
+            removed[removed_count++] =
+                (PendingFileOp){entry.key, entry.last_access};
+            continue;
+        }
+        kept_size += entry.size;
+        if (entry.touched)
+            touched[touched_count++] =
+                (PendingFileOp){entry.key, entry.last_access};
+    }
+    qsort(removed, removed_count, sizeof(PendingFileOp), &compare_key);
+    qsort(touched, touched_count, sizeof(PendingFileOp), &compare_key);
+
+    // Entries accessed since the copy was taken are kept, and stay touched
+    // The copy is no longer needed and holds as many keys
+    DiskCacheKey *unlinked = (DiskCacheKey *)entries;
+    size_t unlinked_count = 0;
+    pthread_mutex_lock(&cache->lock);
+    for (size_t i = 0; i < cache->entry_count;) {
+        DiskCacheEntry *entry = cache->entries + i;
+        PendingFileOp *op = bsearch(entry, removed, removed_count,
+                                    sizeof(PendingFileOp), &compare_key);
+        if (op && op->last_access == entry->last_access) {
+            unlinked[unlinked_count++] = entry->key;
+            remove_entry(cache, i);
+            continue;
+        }
+        op = bsearch(entry, touched, touched_count, sizeof(PendingFileOp),
+                     &compare_key);
+        if (op && op->last_access == entry->last_access)
+            entry->touched = 0;
+        i++;
+    }
+    uint64_t total_size = cache->total_size;
+    pthread_mutex_unlock(&cache->lock);
+    metrics_set(METRIC_DISK_CACHE_BYTES, total_size);
+
+    // Readers still holding a mapping of a removed entry keep their pages
+    char name[ENTRY_NAME_SIZE];
+    for (size_t i = 0; i < unlinked_count; i++) {
+        write_entry_name(name, unlinked[i]);
+        unlinkat(cache->directory_fd, name, 0);
+    }
+    for (size_t i = 0; i < touched_count; i++) {
+        double seconds = touched[i].last_access;
+        struct timespec times[2];
+        times[0].tv_sec = (time_t)seconds;
+        times[0].tv_nsec = (long)((seconds - (double)times[0].tv_sec) * 1e9);
+        times[1] = times[0];
+        write_entry_name(name, touched[i].key);
+        utimensat(cache->directory_fd, name, times, 0);
+    }
+    metrics_count(METRIC_DISK_CACHE_EVICTIONS, unlinked_count);
+    free(entries);
+    free(removed);
+    free(touched);
+}
+
+static void *compaction_thread(void *arg) {
+    DiskCache *cache = arg;
+    // Out of the way of the viewer, for the disk too as the I/O priority
+    // follows the scheduling class
+    struct sched_param param = {0};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+    pthread_mutex_lock(&cache->lock);
+    while (!cache->stopping) {
+        pthread_mutex_unlock(&cache->lock);
+        disk_cache_compact(cache);
+
+        struct timespec wake_time;
+        clock_gettime(CLOCK_REALTIME, &wake_time);
+        double seconds = (double)wake_time.tv_sec +
+                         (double)wake_time.tv_nsec / 1e9 + cache->interval;
+        wake_time.tv_sec = (time_t)seconds;
+        wake_time.tv_nsec = (long)((seconds - (double)wake_time.tv_sec) * 1e9);
+
+        pthread_mutex_lock(&cache->lock);
+        while (!cache->stopping && cache->total_size <= cache->capacity &&
+               pthread_cond_timedwait(&cache->wake, &cache->lock,
+                                      &wake_time) != ETIMEDOUT)
+            ;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+int disk_cache_start(DiskCache *cache, double interval) {
+    assert(!cache->thread_running);
+    cache->interval = interval > 0.0 ? interval : DISK_CACHE_COMPACT_INTERVAL;
+    cache->stopping = 0;
+    if (pthread_create(&cache->thread, 0, &compaction_thread, cache))
+        return 1;
+    cache->thread_running = 1;
+    return 0;
+}
+
+int disk_cache_put_mesh(DiskCache *cache, DiskCacheKey key, const Mesh *mesh) {
+    size_t vertex_count = (size_t)mesh->vertexCount;
+    MeshHeader header = {
+        .vertex_count = (uint32_t)mesh->vertexCount,
+        .triangle_count = (uint32_t)mesh->triangleCount,
+        .arrays = (mesh->texcoords ? MESH_TEXCOORDS : 0) |
+                  (mesh->normals ? MESH_NORMALS : 0) |
+                  (mesh->colors ? MESH_COLORS : 0) |
+                  (mesh->indices ? MESH_INDICES : 0),
+    };
+    if (!mesh->vertices)
+        return 1;
+
+    struct iovec parts[6] = {
+        {&header, sizeof(header)},
+        {mesh->vertices, vertex_count * 3 * sizeof(float)},
+    };
+    int part_count = 2;
+    if (mesh->texcoords)
+        parts[part_count++] =
+            (struct iovec){mesh->texcoords, vertex_count * 2 * sizeof(float)};
+    if (mesh->normals)
+        parts[part_count++] =
+            (struct iovec){mesh->normals, vertex_count * 3 * sizeof(float)};
+    if (mesh->colors)
+        parts[part_count++] = (struct iovec){mesh->colors, vertex_count * 4};
+    if (mesh->indices)
+        parts[part_count++] = (struct iovec){
+            mesh->indices,
+            (size_t)mesh->triangleCount * 3 * sizeof(unsigned short)};
+    return disk_cache_put(cache, key, parts, part_count);
+}
+
+// Copies the next `size` bytes of `blob` at `*offset` into a new array.
+// Returns 0 if the blob is too short.
+static void *copy_array(const DiskCacheBlob *blob, size_t *offset,
+                        size_t size) {
+    if (blob->size - *offset < size)
+        return 0;
+    void *array = malloc(size ? size : 1);
+    if (!array)
+        abort();
+    memcpy(array, blob->data + *offset, size);
+    *offset += size;
+    return array;
+}
+
+int disk_cache_get_mesh(DiskCache *cache, DiskCacheKey key, Mesh *mesh) {
+    DiskCacheBlob blob;
+    if (disk_cache_get(cache, key, &blob))
+        return 1;
+
+    MeshHeader header;
+    if (blob.size < sizeof(header)) {
+        disk_cache_release(&blob);
+        return 1;
+    }
+    memcpy(&header, blob.data, sizeof(header));
+    size_t vertex_count = header.vertex_count;
+    size_t offset = sizeof(header);
+    *mesh = (Mesh){
+        .vertexCount = (int)header.vertex_count,
+        .triangleCount = (int)header.triangle_count,
+        .vertices = copy_array(&blob, &offset, vertex_count * 3 * 4),
+    };
+    int error = !mesh->vertices;
+    if (!error && header.arrays & MESH_TEXCOORDS)
+        error = !(mesh->texcoords =
+                      copy_array(&blob, &offset, vertex_count * 2 * 4));
+    if (!error && header.arrays & MESH_NORMALS)
+        error = !(mesh->normals =
+                      copy_array(&blob, &offset, vertex_count * 3 * 4));
+    if (!error && header.arrays & MESH_COLORS)
+        error =
+            !(mesh->colors = copy_array(&blob, &offset, vertex_count * 4));
+    if (!error && header.arrays & MESH_INDICES)
+        error = !(mesh->indices = copy_array(
+                      &blob, &offset,
+                      (size_t)header.triangle_count * 3 *
+                          sizeof(unsigned short)));
+    error |= offset != blob.size;
+    disk_cache_release(&blob);
+
+    if (error) {
+        free(mesh->vertices);
+        free(mesh->texcoords);
+        free(mesh->normals);
+        free(mesh->colors);
+        free(mesh->indices);
+        *mesh = (Mesh){0};
+        return 1;
+    }
+    return 0;
+}
+
+int disk_cache_put_pixels(DiskCache *cache, DiskCacheKey key,
+                          const uint8_t *pixels, int width, int height) {
+    PixelsHeader header = {(uint32_t)width, (uint32_t)height};
+    struct iovec parts[2] = {
+        {&header, sizeof(header)},
+        {(void *)pixels, (size_t)width * (size_t)height * 4},
+    };
+    return disk_cache_put(cache, key, parts, 2);
+}
+
+int disk_cache_get_pixels(DiskCache *cache, DiskCacheKey key,
+                          DiskCacheBlob *blob, const uint8_t **pixels,
+                          int *width, int *height) {
+    if (disk_cache_get(cache, key, blob))
+        return 1;
+    PixelsHeader header;
+    if (blob->size < sizeof(header)) {
+        disk_cache_release(blob);
+        return 1;
+    }
+    memcpy(&header, blob->data, sizeof(header));
+    if (blob->size - sizeof(header) !=
+        (size_t)header.width * (size_t)header.height * 4) {
+        disk_cache_release(blob);
+        return 1;
+    }
+    *pixels = blob->data + sizeof(header);
+    *width = (int)header.width;
+    *height = (int)header.height;
+    return 0;
+}
@@ -0,0 +1,117 @@
+#ifndef _DISK_CACHE
+#define _DISK_CACHE
+
+// Cache directory of processed assets, such as parsed meshes and decoded
+// textures, keyed by the source file and its size and modification time.
+//
+// A lookup is a single open and mmap of the entry. Entries are written to a
+// temporary file, synced and renamed into place, so a crash never leaves a
+// partial entry behind. Access times are kept in memory and written to the
+// entries' modification times by the compaction thread, which runs at idle
+// priority and evicts least recently used entries above the size cap, older
+// versions of the same source and temporary files left over from crashes.
+//
+// Lookups and writes may happen on any thread.
+
+#include "raylib.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#define DISK_CACHE_CAPACITY (512ull * 1024 * 1024)
+// Seconds between compactions unless set otherwise, they also happen as soon
+// as the cap is exceeded
+#define DISK_CACHE_COMPACT_INTERVAL 30.0
+// Temporary files older than this were left behind by a crash
+#define DISK_CACHE_STALE_SECONDS 600
+
+typedef enum {
+    DISK_CACHE_MESH,
+    DISK_CACHE_PIXELS,
+} DiskCacheKind;
+
+typedef struct {
+    // Of the kind and the source path, shared by every version
+    uint64_t source;
+    // Of the source's size and modification time as well, 0 if it could not
+    // be read
+    uint64_t version;
+} DiskCacheKey;
+
+typedef struct {
+    DiskCacheKey key;
+    uint64_t size;
+    // Seconds since the epoch
+    double last_access;
+    // Accessed since the time was written to the file
+    int touched;
+} DiskCacheEntry;
+
+typedef struct {
+    char directory[PATH_MAX];
+    int directory_fd;
+    uint64_t capacity;
+
+    pthread_mutex_t lock;
+    DiskCacheEntry *entries;
+    size_t entry_count;
+    size_t entries_allocated;
+    uint64_t total_size;
+    // Temporary files written, for unique names
+    uint64_t writes;
+
+    pthread_t thread;
+    pthread_cond_t wake;
+    int thread_running;
+    int stopping;
+    double interval;
+} DiskCache;
+
+// A mapped entry, valid until released
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    void *map;
+    size_t map_size;
+} DiskCacheBlob;
+
+// Opens the cache in `directory`, creating it if needed. Returns 0 on
+// success.
+int disk_cache_open(DiskCache *cache, const char *directory,
+                    uint64_t capacity);
+// Stops compaction and closes the cache, the entries stay on disk.
+void disk_cache_close(DiskCache *cache);
+// Starts compacting every `interval` seconds on a thread of idle priority.
+// Returns 0 on success.
+int disk_cache_start(DiskCache *cache, double interval);
+// Scans the directory and evicts what is over the cap or stale. Done by the
+// compaction thread, callable directly when it is not running.
+void disk_cache_compact(DiskCache *cache);
+
+DiskCacheKey disk_cache_key(DiskCacheKind kind, const char *filepath);
+
+// Maps the entry of `key`. Returns 0 on a hit.
+int disk_cache_get(DiskCache *cache, DiskCacheKey key, DiskCacheBlob *blob);
+void disk_cache_release(DiskCacheBlob *blob);
+// Writes the concatenated `parts` as the entry of `key`. Returns 0 on
+// success.
+int disk_cache_put(DiskCache *cache, DiskCacheKey key,
+                   const struct iovec *parts, int part_count);
+
+// The vertex arrays of `mesh`, indices included.
+int disk_cache_put_mesh(DiskCache *cache, DiskCacheKey key, const Mesh *mesh);
+// Reads a mesh stored with disk_cache_put_mesh into newly allocated arrays,
+// not uploaded. Returns 0 on a hit.
+int disk_cache_get_mesh(DiskCache *cache, DiskCacheKey key, Mesh *mesh);
+// RGBA8 pixels of a `width` x `height` image.
+int disk_cache_put_pixels(DiskCache *cache, DiskCacheKey key,
+                          const uint8_t *pixels, int width, int height);
+// Maps pixels stored with disk_cache_put_pixels, valid until `blob` is
+// released. Returns 0 on a hit.
+int disk_cache_get_pixels(DiskCache *cache, DiskCacheKey key,
+                          DiskCacheBlob *blob, const uint8_t **pixels,
+                          int *width, int *height);
+
+#endif
@@ -0,0 +1,222 @@
+#define GL_GLEXT_PROTOTYPES
+#include "draw_list.h"
+#include "raymath.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// For each side of the view, the corner of every box furthest inside it. A
+// box is outside the view if that corner is outside any side.
+typedef struct {
+    const float *x[5];
+    const float *y[5];
+    const float *z[5];
+} CullCorners;
+
+static inline CullCorners cull_corners(const DrawList *list,
+                                       const PointCloudView *view) {
+    CullCorners corners;
+    for (int side = 0; side < 5; side++) {
+        Vector3 normal = view->normals[side];
+        corners.x[side] = normal.x >= 0.0f ? list->max_x : list->min_x;
+        corners.y[side] = normal.y >= 0.0f ? list->max_y : list->min_y;
+        corners.z[side] = normal.z >= 0.0f ? list->max_z : list->min_z;
+    }
+    return corners;
+}
+
+static inline int cull_inside(const DrawList *list, const CullCorners *corners,
+                              const PointCloudView *view, size_t index) {
+    // Entries without a mesh yet are empty boxes at the origin
+    if (!list->vao_ids[index])
+        return 0;
+    for (int side = 0; side < 5; side++) {
+        Vector3 normal = view->normals[side];
+        float distance = corners->x[side][index] * normal.x +
+                         corners->y[side][index] * normal.y +
+                         corners->z[side][index] * normal.z;
+        if (!(distance >= view->offsets[side]))
+            return 0;
+    }
+    return 1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DRAW_LIST_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#define DRAW_LIST_LANES 4
+#define DRAW_LIST_SUFFIX sse41
+#include "draw_list_kernel.h"
+#undef DRAW_LIST_LANES
+#undef DRAW_LIST_SUFFIX
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define DRAW_LIST_LANES 8
+#define DRAW_LIST_SUFFIX avx2
+#include "draw_list_kernel.h"
+#undef DRAW_LIST_LANES
+#undef DRAW_LIST_SUFFIX
+#pragma GCC pop_options
+#endif
+
+static size_t cull_scalar(DrawList *list, const PointCloudView *view) {
+    CullCorners corners = cull_corners(list, view);
+    size_t visible_count = 0;
+    for (size_t i = 0; i < list->count; i++)
+        if (cull_inside(list, &corners, view, i))
+            list->visible[visible_count++] = (uint32_t)i;
+    return visible_count;
+}
+
+int draw_list_kernel_supported(DrawListKernel kernel) {
+    switch (kernel) {
+    case DRAW_LIST_KERNEL_SCALAR:
+        return 1;
+#ifdef DRAW_LIST_X86
+    case DRAW_LIST_KERNEL_SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case DRAW_LIST_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+DrawListKernel draw_list_best_kernel(void) {
+    static DrawListKernel best = DRAW_LIST_KERNEL_COUNT;
+    if (best == DRAW_LIST_KERNEL_COUNT) {
+        DrawListKernel kernel = DRAW_LIST_KERNEL_COUNT - 1;
+        while (!draw_list_kernel_supported(kernel))
+            kernel--;
+        best = kernel;
+    }
+    return best;
+}
+
+const char *draw_list_kernel_name(DrawListKernel kernel) {
+    static const char *names[DRAW_LIST_KERNEL_COUNT] = {"scalar", "sse4.1",
+                                                        "avx2"};
+    assert(kernel < DRAW_LIST_KERNEL_COUNT);
+    return names[kernel];
+}
+
+void draw_list_init(DrawList *list, size_t count) {
+    *list = (DrawList){.count = count};
+    list->vao_ids = calloc(count, sizeof(*list->vao_ids));
+    list->element_counts = calloc(count, sizeof(*list->element_counts));
+    list->texture_ids = calloc(count, sizeof(*list->texture_ids));
+    list->min_x = calloc(count, sizeof(float));
+    list->min_y = calloc(count, sizeof(float));
+    list->min_z = calloc(count, sizeof(float));
+    list->max_x = calloc(count, sizeof(float));
+    list->max_y = calloc(count, sizeof(float));
+    list->max_z = calloc(count, sizeof(float));
+    list->flags = calloc(count, sizeof(*list->flags));
+    list->visible = calloc(count, sizeof(*list->visible));
+    if (count &&
+        (!list->vao_ids || !list->element_counts || !list->texture_ids ||
+         !list->min_x || !list->min_y || !list->min_z || !list->max_x ||
+         !list->max_y || !list->max_z || !list->flags || !list->visible))
+        abort();
+}
+
+void draw_list_free(DrawList *list) {
+    free(list->vao_ids);
+    free(list->element_counts);
+    free(list->texture_ids);
+    free(list->min_x);
+    free(list->min_y);
+    free(list->min_z);
+    free(list->max_x);
+    free(list->max_y);
+    free(list->max_z);
+    free(list->flags);
+    free(list->visible);
+    *list = (DrawList){0};
+}
+
+void draw_list_set(DrawList *list, size_t index, const Mesh *mesh,
+                   unsigned int texture_id, BoundingBox bounds, int flags) {
+    assert(index < list->count);
+    flags &= ~DRAW_LIST_INDEXED;
+    if (mesh && mesh->indices)
+        flags |= DRAW_LIST_INDEXED;
+    list->vao_ids[index] = mesh ? mesh->vaoId : 0;
+    list->element_counts[index] =
+        !mesh ? 0 : mesh->indices ? mesh->triangleCount * 3 : mesh->vertexCount;
+    list->texture_ids[index] = texture_id;
+    list->min_x[index] = bounds.min.x;
+    list->min_y[index] = bounds.min.y;
+    list->min_z[index] = bounds.min.z;
+    list->max_x[index] = bounds.max.x;
+    list->max_y[index] = bounds.max.y;
+    list->max_z[index] = bounds.max.z;
+    list->flags[index] = (uint8_t)flags;
+}
+
+size_t draw_list_cull(DrawList *list, const PointCloudView *view) {
+    return draw_list_cull_kernel(draw_list_best_kernel(), list, view);
+}
+
+size_t draw_list_cull_kernel(DrawListKernel kernel, DrawList *list,
+                             const PointCloudView *view) {
+    assert(draw_list_kernel_supported(kernel));
+    switch (kernel) {
+#ifdef DRAW_LIST_X86
+    case DRAW_LIST_KERNEL_AVX2:
+        list->visible_count = cull_avx2(list, view);
+        break;
+    case DRAW_LIST_KERNEL_SSE41:
+        list->visible_count = cull_sse41(list, view);
+        break;
+#endif
+    default:
+        list->visible_count = cull_scalar(list, view);
+        break;
+    }
+    return list->visible_count;
+}
+
+void draw_list_begin(DrawList *list, Shader shader, Matrix mvp) {
+    // Same uniforms as DrawMesh sets for a white material
+    static const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glUseProgram(shader.id);
+    glUniformMatrix4fv(shader.locs[SHADER_LOC_MATRIX_MVP], 1, GL_FALSE,
+                       MatrixToFloat(mvp));
+    if (shader.locs[SHADER_LOC_COLOR_DIFFUSE] >= 0)
+        glUniform4fv(shader.locs[SHADER_LOC_COLOR_DIFFUSE], 1, white);
+    glActiveTexture(GL_TEXTURE0);
+    list->texture_bound = 0;
+}
+
+void draw_list_draw(DrawList *list, size_t index) {
+    assert(index < list->count);
+    if (!list->vao_ids[index])
+        return;
+    if (!list->texture_bound ||
+        list->bound_texture != list->texture_ids[index]) {
+        glBindTexture(GL_TEXTURE_2D, list->texture_ids[index]);
+        list->bound_texture = list->texture_ids[index];
+        list->texture_bound = 1;
+    }
+    glBindVertexArray(list->vao_ids[index]);
+    if (list->flags[index] & DRAW_LIST_INDEXED)
+        glDrawElements(GL_TRIANGLES, list->element_counts[index],
+                       GL_UNSIGNED_SHORT, 0);
+    else
+        glDrawArrays(GL_TRIANGLES, 0, list->element_counts[index]);
+}
+
+void draw_list_end(DrawList *list) {
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    list->texture_bound = 0;
+}
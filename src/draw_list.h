@@ -0,0 +1,80 @@
+#ifndef _DRAW_LIST
+#define _DRAW_LIST
+
+// What drawing a frame needs of each model, packed one array per field.
+//
+// Going through the Models means following the pointers to their meshes and
+// materials for every model every frame. Here the entry of a model is only
+// updated when a load commits a new mesh or texture, and the frame reads the
+// arrays in order: the bounds are culled against the view a few models at a
+// time with vector instructions, and the models inside are drawn with a
+// single shader bind, rebinding only the textures that change.
+
+#include "point_cloud.h"
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    DRAW_LIST_KERNEL_SCALAR,
+    DRAW_LIST_KERNEL_SSE41,
+    DRAW_LIST_KERNEL_AVX2,
+    DRAW_LIST_KERNEL_COUNT,
+} DrawListKernel;
+
+enum {
+    // Drawn with indices, otherwise as a plain vertex array
+    DRAW_LIST_INDEXED = 1 << 0,
+    // Textured from the tiles of a TiledTexture instead of texture_ids
+    DRAW_LIST_TILED = 1 << 1,
+};
+
+typedef struct {
+    size_t count;
+    // Of the mesh, 0 if there is none
+    unsigned int *vao_ids;
+    // Indices or vertices drawn
+    int *element_counts;
+    unsigned int *texture_ids;
+    // Bounds, each axis on its own so that they load straight into lanes
+    float *min_x, *min_y, *min_z;
+    float *max_x, *max_y, *max_z;
+    uint8_t *flags;
+
+    // Entries inside the view, in order, from the latest draw_list_cull
+    uint32_t *visible;
+    size_t visible_count;
+
+    // Between draw_list_begin and draw_list_end
+    unsigned int bound_texture;
+    int texture_bound;
+} DrawList;
+
+// Whether the CPU can run `kernel`.
+int draw_list_kernel_supported(DrawListKernel kernel);
+// The fastest kernel the CPU can run.
+DrawListKernel draw_list_best_kernel(void);
+const char *draw_list_kernel_name(DrawListKernel kernel);
+
+// `count` entries without a mesh.
+void draw_list_init(DrawList *list, size_t count);
+void draw_list_free(DrawList *list);
+// Updates the entry at `index` to the mesh, texture and bounds of a model.
+void draw_list_set(DrawList *list, size_t index, const Mesh *mesh,
+                   unsigned int texture_id, BoundingBox bounds, int flags);
+
+// Lists the entries with a mesh whose bounds touch `view` in list->visible,
+// using the fastest kernel. Returns their count.
+size_t draw_list_cull(DrawList *list, const PointCloudView *view);
+// Same as draw_list_cull with a specific, supported `kernel`.
+size_t draw_list_cull_kernel(DrawListKernel kernel, DrawList *list,
+                             const PointCloudView *view);
+
+// Binds `shader` with `mvp` for draw_list_draw. Any raylib drawing in between
+// needs draw_list_end first.
+void draw_list_begin(DrawList *list, Shader shader, Matrix mvp);
+// Draws the entry at `index` with its own texture.
+void draw_list_draw(DrawList *list, size_t index);
+void draw_list_end(DrawList *list);
+
+#endif
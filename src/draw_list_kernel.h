@@ -0,0 +1,56 @@
+// Vector implementation of draw_list_cull, included by draw_list.c once per
+// instruction set with DRAW_LIST_LANES and DRAW_LIST_SUFFIX defined. Each
+// lane tests the bounds of one entry against all sides of the view.
+
+#define DRAW_LIST_CONCAT_(name, suffix) name##_##suffix
+#define DRAW_LIST_CONCAT(name, suffix) DRAW_LIST_CONCAT_(name, suffix)
+#define K(name) DRAW_LIST_CONCAT(name, DRAW_LIST_SUFFIX)
+
+typedef int32_t K(vi) __attribute__((vector_size(DRAW_LIST_LANES * 4)));
+typedef float K(vf) __attribute__((vector_size(DRAW_LIST_LANES * 4)));
+#define vi K(vi)
+#define vf K(vf)
+
+static inline vf K(load)(const float *values) {
+    vf result;
+    memcpy(&result, values, sizeof(result));
+    return result;
+}
+
+static inline vi K(load_ids)(const unsigned int *ids) {
+    vi result;
+    memcpy(&result, ids, sizeof(result));
+    return result;
+}
+
+static size_t K(cull)(DrawList *list, const PointCloudView *view) {
+    CullCorners corners = cull_corners(list, view);
+    size_t visible_count = 0;
+    size_t i = 0;
+    for (; i + DRAW_LIST_LANES <= list->count; i += DRAW_LIST_LANES) {
+        // Entries without a mesh yet are empty boxes at the origin
+        vi inside = K(load_ids)(list->vao_ids + i) != 0;
+        for (int side = 0; side < 5; side++) {
+            Vector3 normal = view->normals[side];
+            vf distance = K(load)(corners.x[side] + i) * normal.x +
+                          K(load)(corners.y[side] + i) * normal.y +
+                          K(load)(corners.z[side] + i) * normal.z;
+            inside &= distance >= view->offsets[side];
+        }
+        // Written for every lane, kept by advancing past the ones inside
+        for (int lane = 0; lane < DRAW_LIST_LANES; lane++) {
+            list->visible[visible_count] = (uint32_t)(i + (size_t)lane);
+            visible_count -= (size_t)(int64_t)inside[lane];
+        }
+    }
+    for (; i < list->count; i++)
+        if (cull_inside(list, &corners, view, i))
+            list->visible[visible_count++] = (uint32_t)i;
+    return visible_count;
+}
+
+#undef vi
+#undef vf
+#undef K
+#undef DRAW_LIST_CONCAT
+#undef DRAW_LIST_CONCAT_
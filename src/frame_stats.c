@@ -0,0 +1,96 @@
+#include "frame_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+FrameStats frame_stats_init(size_t capacity) {
+    if (!capacity)
+        capacity = 1024;
+    FrameStats stats = {
+        .samples = malloc(capacity * sizeof(double)),
+        .samples_allocated = capacity,
+    };
+    if (!stats.samples)
+        abort();
+    return stats;
+}
+
+void frame_stats_add(FrameStats *stats, double seconds) {
+    if (stats->samples_used >= stats->samples_allocated) {
+        stats->samples_allocated *= 2;
+        stats->samples = realloc(stats->samples,
+                                 stats->samples_allocated * sizeof(double));
+        if (!stats->samples)
+            abort();
+    }
+    stats->samples[stats->samples_used++] = seconds;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted `samples`.
+static inline double percentile(double *samples, size_t count, double p) {
+    size_t rank = (size_t)(p * (double)count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    if (rank > count)
+        rank = count;
+    return samples[rank - 1];
+}
+
+FrameStatsSummary frame_stats_summarize(FrameStats *stats) {
+    FrameStatsSummary summary = {.count = stats->samples_used};
+    if (!summary.count)
+        return summary;
+
+    double *sorted = malloc(summary.count * sizeof(double));
+    if (!sorted)
+        abort();
+    memcpy(sorted, stats->samples, summary.count * sizeof(double));
+    qsort(sorted, summary.count, sizeof(double), &compare_doubles);
+
+    for (size_t i = 0; i < summary.count; i++)
+        summary.total += sorted[i];
+
+    summary.min = sorted[0];
+    summary.max = sorted[summary.count - 1];
+    summary.mean = summary.total / (double)summary.count;
+    summary.p50 = percentile(sorted, summary.count, 0.50);
+    summary.p95 = percentile(sorted, summary.count, 0.95);
+    summary.p99 = percentile(sorted, summary.count, 0.99);
+
+    for (size_t i = 0; i < summary.count; i++) {
+        if (sorted[i] > summary.p50 * FRAME_STATS_HITCH_FACTOR)
+            summary.hitches++;
+    }
+
+    free(sorted);
+    return summary;
+}
+
+void frame_stats_print(FrameStats *stats, FILE *file) {
+    FrameStatsSummary summary = frame_stats_summarize(stats);
+    if (!summary.count) {
+        fprintf(file, "frames: 0\n");
+        return;
+    }
+
+    fprintf(file, "frames: %zu (%.3f s)\n", summary.count, summary.total);
+    fprintf(file,
+            "frame time ms: min %.3f  mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  "
+            "max %.3f\n",
+            summary.min * 1000.0, summary.mean * 1000.0, summary.p50 * 1000.0,
+            summary.p95 * 1000.0, summary.p99 * 1000.0, summary.max * 1000.0);
+    fprintf(file, "hitches (> %.1fx median): %zu\n", FRAME_STATS_HITCH_FACTOR,
+            summary.hitches);
+}
+
+void frame_stats_free(FrameStats *stats) {
+    if (stats->samples) {
+        free(stats->samples);
+        stats->samples = 0;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef _FRAME_STATS
+#define _FRAME_STATS
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Frames taking longer than this many times the median are counted as hitches.
+#define FRAME_STATS_HITCH_FACTOR 2.0
+
+typedef struct {
+    double *samples;
+    size_t samples_allocated;
+    size_t samples_used;
+} FrameStats;
+
+typedef struct {
+    size_t count;
+    double total;
+    double min;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+    size_t hitches;
+} FrameStatsSummary;
+
+// Preallocates room for `capacity` samples, adding samples beyond that
+// allocates. 0 picks a default.
+FrameStats frame_stats_init(size_t capacity);
+// Adds a frame time sample in seconds.
+void frame_stats_add(FrameStats *stats, double seconds);
+FrameStatsSummary frame_stats_summarize(FrameStats *stats);
+// Prints a summary of the collected frame times in milliseconds.
+void frame_stats_print(FrameStats *stats, FILE *file);
+void frame_stats_free(FrameStats *stats);
+
+#endif
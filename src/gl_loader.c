@@ -0,0 +1,307 @@
+#define GL_GLEXT_PROTOTYPES
+#include "gl_loader.h"
+#include "ase_compose.h"
+#include "path.h"
+#include "rlgl.h"
+#include "staging_ring.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GLFW/glfw3.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JOB_FILEPATH_MAX 4096
+// Index of the element buffer in Mesh.vboId, as used by raylib's UploadMesh
+#define MESH_BUFFER_INDICES 6
+
+typedef struct {
+    GlLoadKind kind;
+    uint64_t model_index;
+    char filepath[JOB_FILEPATH_MAX];
+    // Uploaded instead of loading `filepath` if it has vertices
+    Mesh mesh;
+    Model model;
+    Texture texture;
+    GLsync fence;
+    // Handed back empty without loading anything
+    int failed;
+} GlLoadJob;
+
+// First in, first out queue of jobs
+typedef struct {
+    GlLoadJob *data;
+    size_t data_allocated;
+    size_t data_used;
+} JobQueue;
+
+static GLFWwindow *loader_context = 0;
+static pthread_t loader_thread_id = 0;
+static pthread_mutex_t loader_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t loader_wake = PTHREAD_COND_INITIALIZER;
+static int loader_stopping = 0;
+static JobQueue pending = {0};
+static JobQueue finished = {0};
+// Owned by the loader thread
+static StagingRing loader_staging_ring = {0};
+
+static void queue_push(JobQueue *queue, GlLoadJob *job) {
+    if (queue->data_used >= queue->data_allocated) {
+        queue->data_allocated =
+            queue->data_allocated ? queue->data_allocated * 2 : 8;
+        queue->data =
+            realloc(queue->data, queue->data_allocated * sizeof(GlLoadJob));
+        if (!queue->data)
+            abort();
+    }
+    queue->data[queue->data_used++] = *job;
+}
+
+static void queue_pop(JobQueue *queue, GlLoadJob *job) {
+    assert(queue->data_used);
+    *job = queue->data[0];
+    queue->data_used--;
+    memmove(queue->data, queue->data + 1,
+            queue->data_used * sizeof(GlLoadJob));
+}
+
+// Runs on the loader thread with the shared context current.
+static void run_job(GlLoadJob *job) {
+    if (job->failed) {
+        // Only fenced, to come out after the jobs queued before it
+    } else if (job->kind == GL_LOAD_MODEL) {
+        if (job->mesh.vertexCount) {
+            UploadMesh(&job->mesh, false);
+            job->model = LoadModelFromMesh(job->mesh);
+        } else {
+            job->model = LoadModel(job->filepath);
+        }
+        // The vertex arrays belong to this context and are useless to the
+        // render thread, the buffers they point to are shared
+        for (int i = 0; i < job->model.meshCount; i++) {
+            if (job->model.meshes[i].vaoId)
+                rlUnloadVertexArray(job->model.meshes[i].vaoId);
+            job->model.meshes[i].vaoId = 0;
+        }
+    } else if (!path_is_aseprite_texture(job->filepath)) {
+        job->texture = LoadTexture(job->filepath);
+    } else {
+        ase_t *ase = ase_compose_load(job->filepath);
+        if (ase) {
+            job->texture =
+                ase_compose_upload(&loader_staging_ring, ase, (Texture){0});
+            cute_aseprite_free(ase);
+        }
+    }
+
+    job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Make sure the fence reaches the GPU so that the render thread does not
+    // wait on it forever
+    glFlush();
+}
+
+static void *loader_thread(void *_a) {
+    (void)_a;
+    glfwMakeContextCurrent(loader_context);
+    staging_ring_init(&loader_staging_ring, STAGING_RING_SIZE);
+
+    GlLoadJob job;
+    while (1) {
+        pthread_mutex_lock(&loader_lock);
+        while (!pending.data_used && !loader_stopping)
+            pthread_cond_wait(&loader_wake, &loader_lock);
+        if (loader_stopping) {
+            pthread_mutex_unlock(&loader_lock);
+            break;
+        }
+        queue_pop(&pending, &job);
+        pthread_mutex_unlock(&loader_lock);
+
+        run_job(&job);
+
+        pthread_mutex_lock(&loader_lock);
+        queue_push(&finished, &job);
+        pthread_mutex_unlock(&loader_lock);
+    }
+
+    staging_ring_free(&loader_staging_ring);
+    glFinish();
+    glfwMakeContextCurrent(0);
+    return 0;
+}
+
+int gl_loader_start(void) {
+    if (loader_context)
+        return 0;
+
+    // Window hints are left as raylib set them for the main window, so the
+    // context gets the same version and profile
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    loader_context =
+        glfwCreateWindow(1, 1, "", 0, (GLFWwindow *)GetWindowHandle());
+    if (!loader_context) {
+        fprintf(stderr, "ERROR: could not create a shared OpenGL context for "
+                        "the loader thread\n");
+        return 1;
+    }
+
+    loader_stopping = 0;
+    if (pthread_create(&loader_thread_id, 0, &loader_thread, 0)) {
+        glfwDestroyWindow(loader_context);
+        loader_context = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static void unload_job(GlLoadJob *job) {
+    if (job->fence)
+        glDeleteSync(job->fence);
+    if (job->model.meshCount)
+        UnloadModel(job->model);
+    if (job->texture.id)
+        UnloadTexture(job->texture);
+}
+
+void gl_loader_stop(void) {
+    if (!loader_context)
+        return;
+
+    pthread_mutex_lock(&loader_lock);
+    loader_stopping = 1;
+    pthread_cond_signal(&loader_wake);
+    pthread_mutex_unlock(&loader_lock);
+    pthread_join(loader_thread_id, 0);
+
+    // The loader thread has finished everything with glFinish
+    for (size_t i = 0; i < finished.data_used; i++)
+        unload_job(finished.data + i);
+    for (size_t i = 0; i < pending.data_used; i++) {
+        if (pending.data[i].mesh.vertexCount)
+            UnloadMesh(pending.data[i].mesh);
+    }
+
+    free(pending.data);
+    free(finished.data);
+    pending = (JobQueue){0};
+    finished = (JobQueue){0};
+
+    glfwDestroyWindow(loader_context);
+    loader_context = 0;
+    loader_thread_id = 0;
+}
+
+int gl_loader_running(void) {
+    return loader_context != 0;
+}
+
+static void queue_load(GlLoadKind kind, const char *filepath,
+                       uint64_t model_index) {
+    assert(loader_context);
+    GlLoadJob job = {.kind = kind, .model_index = model_index};
+    strncpy(job.filepath, filepath, JOB_FILEPATH_MAX - 1);
+
+    pthread_mutex_lock(&loader_lock);
+    queue_push(&pending, &job);
+    pthread_cond_signal(&loader_wake);
+    pthread_mutex_unlock(&loader_lock);
+}
+
+void gl_loader_load_model(const char *filepath, uint64_t model_index) {
+    queue_load(GL_LOAD_MODEL, filepath, model_index);
+}
+
+void gl_loader_load_texture(const char *filepath, uint64_t model_index) {
+    queue_load(GL_LOAD_TEXTURE, filepath, model_index);
+}
+
+void gl_loader_upload_mesh(Mesh mesh, uint64_t model_index) {
+    assert(loader_context && mesh.vertexCount);
+    GlLoadJob job = {
+        .kind = GL_LOAD_MODEL, .model_index = model_index, .mesh = mesh};
+
+    pthread_mutex_lock(&loader_lock);
+    queue_push(&pending, &job);
+    pthread_cond_signal(&loader_wake);
+    pthread_mutex_unlock(&loader_lock);
+}
+
+void gl_loader_fail(GlLoadKind kind, uint64_t model_index) {
+    assert(loader_context);
+    GlLoadJob job = {.kind = kind, .model_index = model_index, .failed = 1};
+
+    pthread_mutex_lock(&loader_lock);
+    queue_push(&pending, &job);
+    pthread_cond_signal(&loader_wake);
+    pthread_mutex_unlock(&loader_lock);
+}
+
+// Creates a vertex array in the current context for the buffers of `mesh`,
+// with the same layout as raylib's UploadMesh.
+static void rebuild_vertex_array(Mesh *mesh) {
+    static const struct {
+        int location;
+        int components;
+        int type;
+        bool normalized;
+    } attributes[] = {
+        {RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false},
+        {RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, RL_FLOAT, false},
+        {RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 3, RL_FLOAT, false},
+        {RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true},
+        {RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, 4, RL_FLOAT, false},
+        {RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2, 2, RL_FLOAT, false},
+    };
+
+    mesh->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(mesh->vaoId);
+
+    // Buffer i of the mesh holds the attribute i of the table above
+    for (size_t i = 0; i < sizeof(attributes) / sizeof(*attributes); i++) {
+        if (!mesh->vboId[i])
+            continue;
+        rlEnableVertexBuffer(mesh->vboId[i]);
+        rlSetVertexAttribute(attributes[i].location, attributes[i].components,
+                             attributes[i].type, attributes[i].normalized, 0,
+                             0);
+        rlEnableVertexAttribute(attributes[i].location);
+    }
+    if (mesh->vboId[MESH_BUFFER_INDICES])
+        rlEnableVertexBufferElement(mesh->vboId[MESH_BUFFER_INDICES]);
+
+    rlDisableVertexArray();
+}
+
+int gl_loader_poll(GlLoadResult *result) {
+    GlLoadJob job;
+
+    pthread_mutex_lock(&loader_lock);
+    if (!finished.data_used) {
+        pthread_mutex_unlock(&loader_lock);
+        return 0;
+    }
+
+    GLenum status = glClientWaitSync(finished.data[0].fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        pthread_mutex_unlock(&loader_lock);
+        return 0;
+    }
+    queue_pop(&finished, &job);
+    pthread_mutex_unlock(&loader_lock);
+
+    glDeleteSync(job.fence);
+    for (int i = 0; i < job.model.meshCount; i++) {
+        if (job.model.meshes[i].vboId && job.model.meshes[i].vboId[0])
+            rebuild_vertex_array(job.model.meshes + i);
+    }
+
+    *result = (GlLoadResult){
+        .kind = job.kind,
+        .model_index = job.model_index,
+        .model = job.model,
+        .texture = job.texture,
+    };
+    return 1;
+}
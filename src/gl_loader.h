@@ -0,0 +1,52 @@
+#ifndef _GL_LOADER
+#define _GL_LOADER
+
+// Loads models and textures on a separate thread with its own OpenGL context,
+// which shares its objects with the main window. Files are parsed and uploaded
+// on the loader thread, and the results are only handed to the render thread
+// once a fence shows that the GPU has finished the upload.
+//
+// Vertex array objects are not shared between contexts, so they are rebuilt
+// on the render thread by gl_loader_poll.
+
+#include "raylib.h"
+#include <stdint.h>
+
+typedef enum {
+    GL_LOAD_MODEL,
+    GL_LOAD_TEXTURE,
+} GlLoadKind;
+
+typedef struct {
+    GlLoadKind kind;
+    uint64_t model_index;
+    // Set for GL_LOAD_MODEL, meshCount is 0 if loading failed
+    Model model;
+    // Set for GL_LOAD_TEXTURE, id is 0 if loading failed
+    Texture texture;
+} GlLoadResult;
+
+// Creates the shared context and starts the loader thread. Must be called from
+// the thread owning the window, after InitWindow. Returns 0 on success.
+int gl_loader_start(void);
+// Stops the loader thread, unloading anything not yet handed over. Call from
+// the render thread.
+void gl_loader_stop(void);
+// 1 if the loader thread is running.
+int gl_loader_running(void);
+
+// Queues the loading of a file, the result is returned by gl_loader_poll.
+void gl_loader_load_model(const char *filepath, uint64_t model_index);
+void gl_loader_load_texture(const char *filepath, uint64_t model_index);
+// Queues the upload of a mesh built on the CPU, returned as a GL_LOAD_MODEL
+// result. Takes ownership of `mesh`.
+void gl_loader_upload_mesh(Mesh mesh, uint64_t model_index);
+// Queues a failed result, for loads that failed before reaching the loader.
+// Keeps everything handed to the render thread in order.
+void gl_loader_fail(GlLoadKind kind, uint64_t model_index);
+
+// Stores the next finished load to `result`. Returns 0 if none is ready.
+// Results come out in the order they were queued. Call from the render thread.
+int gl_loader_poll(GlLoadResult *result);
+
+#endif
@@ -0,0 +1,176 @@
+#define GL_GLEXT_PROTOTYPES
+#include "gpu_timer.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <assert.h>
+#include <stdlib.h>
+
+static void gl_create(unsigned int *ids, size_t count) {
+    glGenQueries((GLsizei)count, ids);
+}
+
+static void gl_destroy(unsigned int *ids, size_t count) {
+    glDeleteQueries((GLsizei)count, ids);
+}
+
+static void gl_timestamp(unsigned int id) {
+    glQueryCounter(id, GL_TIMESTAMP);
+}
+
+static int gl_result(unsigned int id, uint64_t *nanoseconds) {
+    GLint available = 0;
+    glGetQueryObjectiv(id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return 0;
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(id, GL_QUERY_RESULT, &result);
+    *nanoseconds = result;
+    return 1;
+}
+
+static const GpuTimerQueries gl_queries = {
+    .create = &gl_create,
+    .destroy = &gl_destroy,
+    .timestamp = &gl_timestamp,
+    .result = &gl_result,
+};
+
+// Index of the start query of `scope` in the frame slot `slot`, the end
+// query follows it.
+static inline size_t query_index(GpuTimer *timer, size_t slot, size_t scope) {
+    return (slot * timer->scope_count + scope) * 2;
+}
+
+void gpu_timer_init(GpuTimer *timer, size_t scope_count,
+                    const GpuTimerQueries *queries) {
+    *timer = (GpuTimer){
+        .queries = queries ? *queries : gl_queries,
+        .scope_count = scope_count,
+        .open_scope = -1,
+    };
+    size_t query_count = GPU_TIMER_LATENCY * scope_count * 2;
+    timer->ids = malloc(query_count * sizeof(unsigned int));
+    timer->issued = calloc(GPU_TIMER_LATENCY * scope_count, 1);
+    timer->stats = calloc(scope_count, sizeof(GpuTimerStats));
+    timer->order = malloc(scope_count * sizeof(size_t));
+    if (!timer->ids || !timer->issued || !timer->stats || !timer->order)
+        abort();
+    for (size_t i = 0; i < scope_count; i++)
+        timer->order[i] = i;
+    (*timer->queries.create)(timer->ids, query_count);
+}
+
+void gpu_timer_free(GpuTimer *timer) {
+    if (timer->ids)
+        (*timer->queries.destroy)(timer->ids,
+                                  GPU_TIMER_LATENCY * timer->scope_count * 2);
+    free(timer->ids);
+    free(timer->issued);
+    free(timer->stats);
+    free(timer->order);
+    *timer = (GpuTimer){.open_scope = -1};
+}
+
+static inline void add_sample(GpuTimerStats *stats, double ms) {
+    if (!stats->samples || ms < stats->min_ms)
+        stats->min_ms = ms;
+    if (!stats->samples || ms > stats->max_ms)
+        stats->max_ms = ms;
+    stats->recent_ms =
+        stats->samples ? stats->recent_ms +
+                             (ms - stats->recent_ms) * GPU_TIMER_RECENT_WEIGHT
+                       : ms;
+    stats->last_ms = ms;
+    stats->total_ms += ms;
+    stats->samples++;
+}
+
+void gpu_timer_begin_frame(GpuTimer *timer) {
+    assert(timer->open_scope < 0);
+    size_t slot = timer->frame % GPU_TIMER_LATENCY;
+    uint8_t *issued = timer->issued + slot * timer->scope_count;
+
+    // The queries of the slot were written GPU_TIMER_LATENCY frames ago
+    for (size_t scope = 0; scope < timer->scope_count; scope++) {
+        if (!issued[scope])
+            continue;
+        issued[scope] = 0;
+
+        size_t index = query_index(timer, slot, scope);
+        uint64_t start = 0;
+        uint64_t end = 0;
+        if (!(*timer->queries.result)(timer->ids[index], &start) ||
+            !(*timer->queries.result)(timer->ids[index + 1], &end)) {
+            timer->dropped++;
+            continue;
+        }
+        add_sample(timer->stats + scope,
+                   end > start ? (double)(end - start) / 1e6 : 0.0);
+    }
+    timer->frame++;
+}
+
+// The frame slot written by the current frame.
+static inline size_t current_slot(GpuTimer *timer) {
+    assert(timer->frame);
+    return (timer->frame - 1) % GPU_TIMER_LATENCY;
+}
+
+void gpu_timer_begin(GpuTimer *timer, size_t scope) {
+    assert(scope < timer->scope_count);
+    assert(timer->open_scope < 0);
+    size_t slot = current_slot(timer);
+    timer->open_scope = (long)scope;
+    (*timer->queries.timestamp)(timer->ids[query_index(timer, slot, scope)]);
+}
+
+void gpu_timer_end(GpuTimer *timer, size_t scope) {
+    assert(timer->open_scope == (long)scope);
+    size_t slot = current_slot(timer);
+    (*timer->queries.timestamp)(
+        timer->ids[query_index(timer, slot, scope) + 1]);
+    timer->issued[slot * timer->scope_count + scope] = 1;
+    timer->open_scope = -1;
+}
+
+void gpu_timer_rank(GpuTimer *timer) {
+    // Mostly in order already from the previous frame
+    for (size_t i = 1; i < timer->scope_count; i++) {
+        size_t scope = timer->order[i];
+        double recent = timer->stats[scope].recent_ms;
+        size_t j = i;
+        for (; j > 0 && timer->stats[timer->order[j - 1]].recent_ms < recent;
+             j--)
+            timer->order[j] = timer->order[j - 1];
+        timer->order[j] = scope;
+    }
+}
+
+void gpu_timer_print(GpuTimer *timer, const char *const *names, FILE *file) {
+    size_t *order = malloc(timer->scope_count * sizeof(size_t));
+    assert(order);
+    for (size_t i = 0; i < timer->scope_count; i++) {
+        double total = timer->stats[i].total_ms;
+        size_t j = i;
+        for (; j > 0 && timer->stats[order[j - 1]].total_ms < total; j--)
+            order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    fprintf(file, "GPU time per scope (ms):\n");
+    fprintf(file, "  %10s %8s %8s %8s %8s  %s\n", "total", "mean", "min",
+            "max", "samples", "scope");
+    for (size_t i = 0; i < timer->scope_count; i++) {
+        GpuTimerStats *stats = timer->stats + order[i];
+        if (!stats->samples)
+            continue;
+        fprintf(file, "  %10.3f %8.3f %8.3f %8.3f %8llu  %s\n",
+                stats->total_ms, stats->total_ms / (double)stats->samples,
+                stats->min_ms, stats->max_ms,
+                (unsigned long long)stats->samples, names[order[i]]);
+    }
+    if (timer->dropped)
+        fprintf(file, "  %llu results were not ready in time and dropped\n",
+                (unsigned long long)timer->dropped);
+    free(order);
+}
@@ -0,0 +1,77 @@
+#ifndef _GPU_TIMER
+#define _GPU_TIMER
+
+// Time spent by the GPU on parts of a frame, measured with timestamp queries.
+//
+// Each timed scope writes a timestamp before and after it. The results are
+// read back GPU_TIMER_LATENCY frames later, by which time the GPU is done
+// with them, so reading never stalls. Results still not available then are
+// dropped. The durations are summed up per scope.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Frames the queries are in flight before being read
+#define GPU_TIMER_LATENCY 4
+// Weight of the newest sample in GpuTimerStats.recent_ms
+#define GPU_TIMER_RECENT_WEIGHT 0.1
+
+// Query operations, replaceable for tests. The defaults use GL timestamp
+// queries, which need ARB_timer_query (GL 3.3, also Mesa's llvmpipe).
+typedef struct {
+    void (*create)(unsigned int *ids, size_t count);
+    void (*destroy)(unsigned int *ids, size_t count);
+    // Writes the GPU time into the query once the commands before it finish
+    void (*timestamp)(unsigned int id);
+    // Returns 1 and the time in nanoseconds if the query has its result
+    int (*result)(unsigned int id, uint64_t *nanoseconds);
+} GpuTimerQueries;
+
+typedef struct {
+    uint64_t samples;
+    double total_ms;
+    double min_ms;
+    double max_ms;
+    double last_ms;
+    // Average weighted towards the latest samples
+    double recent_ms;
+} GpuTimerStats;
+
+typedef struct {
+    GpuTimerQueries queries;
+    size_t scope_count;
+    // Start and end query of each scope of each frame in flight
+    unsigned int *ids;
+    // Scopes timed in each frame in flight
+    uint8_t *issued;
+    GpuTimerStats *stats;
+    // Scopes by descending recent_ms, see gpu_timer_rank
+    size_t *order;
+    uint64_t frame;
+    uint64_t dropped;
+    // The scope between gpu_timer_begin and gpu_timer_end, or -1
+    long open_scope;
+} GpuTimer;
+
+// Creates the queries of `scope_count` scopes, with `queries` or the GL ones
+// if 0. Needs the GL context of the frames to time.
+void gpu_timer_init(GpuTimer *timer, size_t scope_count,
+                    const GpuTimerQueries *queries);
+void gpu_timer_free(GpuTimer *timer);
+
+// Starts a frame, first collecting the results of the frame
+// GPU_TIMER_LATENCY frames back.
+void gpu_timer_begin_frame(GpuTimer *timer);
+// Times the GL commands between these, scopes do not nest. Commands batched
+// by rlgl have to be drawn before each.
+void gpu_timer_begin(GpuTimer *timer, size_t scope);
+void gpu_timer_end(GpuTimer *timer, size_t scope);
+
+// Sorts GpuTimer.order by the recent time of the scopes, without allocating.
+void gpu_timer_rank(GpuTimer *timer);
+// Prints the statistics of the scopes that were timed, most expensive in
+// total first. `names` has a name per scope.
+void gpu_timer_print(GpuTimer *timer, const char *const *names, FILE *file);
+
+#endif
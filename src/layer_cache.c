@@ -0,0 +1,184 @@
+#include "layer_cache.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline size_t canvas_size(const LayerCache *cache) {
+    return (size_t)cache->ase->w * (size_t)cache->ase->h;
+}
+
+static inline int layer_index(const LayerCache *cache,
+                              const ase_layer_t *layer) {
+    return (int)(layer - cache->ase->layers);
+}
+
+static inline AseComposeTarget canvas_target(const LayerCache *cache,
+                                             ase_color_t *canvas) {
+    return (AseComposeTarget){
+        .pixels = (uint8_t *)canvas,
+        .stride = (size_t)cache->ase->w * sizeof(ase_color_t),
+        .format = ASE_COMPOSE_RGBA8,
+    };
+}
+
+int layer_cache_init(LayerCache *cache, ase_t *ase, int frame_index) {
+    assert(frame_index >= 0 && frame_index < ase->frame_count);
+    *cache = (LayerCache){
+        .ase = ase,
+        .frame_index = frame_index,
+        .solo_layer = -1,
+    };
+
+    for (int i = 0; i < ase->layer_count; i++) {
+        ase_layer_t *layer = ase->layers + i;
+        cache->layer_parents[i] =
+            layer->parent ? layer_index(cache, layer->parent) : -1;
+        cache->layer_visible[i] = !!(layer->flags & ASE_LAYER_FLAGS_VISIBLE);
+    }
+
+    ase_frame_t *frame = ase->frames + frame_index;
+    cache->cel_count = frame->cel_count;
+    for (int i = 0; i < frame->cel_count; i++) {
+        ase_cel_t *cel = ase_compose_resolve_cel(frame->cels + i);
+        if (!cel) {
+            layer_cache_free(cache);
+            return 1;
+        }
+        cache->cel_pixels[i] =
+            malloc((size_t)cel->w * (size_t)cel->h * sizeof(ase_color_t));
+        if (!cache->cel_pixels[i])
+            abort();
+        ase_compose_decode_cel(ase, cel, cache->cel_pixels[i]);
+    }
+
+    cache->prefixes = calloc((size_t)(cache->cel_count + 1) *
+                                 canvas_size(cache),
+                             sizeof(ase_color_t));
+    cache->solo_pixels = malloc(canvas_size(cache) * sizeof(ase_color_t));
+    if (!cache->prefixes || !cache->solo_pixels)
+        abort();
+    return 0;
+}
+
+void layer_cache_free(LayerCache *cache) {
+    for (int i = 0; i < cache->cel_count; i++)
+        free(cache->cel_pixels[i]);
+    free(cache->prefixes);
+    free(cache->solo_pixels);
+    if (cache->ase)
+        cute_aseprite_free(cache->ase);
+    *cache = (LayerCache){0};
+}
+
+int layer_cache_layer_count(const LayerCache *cache) {
+    return cache->ase->layer_count;
+}
+
+const char *layer_cache_layer_name(const LayerCache *cache, int layer) {
+    assert(layer >= 0 && layer < cache->ase->layer_count);
+    return cache->ase->layers[layer].name;
+}
+
+int layer_cache_visible(const LayerCache *cache, int layer) {
+    assert(layer >= 0 && layer < cache->ase->layer_count);
+    return cache->layer_visible[layer];
+}
+
+static inline ase_cel_t *frame_cel(const LayerCache *cache, int index) {
+    return cache->ase->frames[cache->frame_index].cels + index;
+}
+
+// Whether cel `index` is drawn with the current visibility, matching
+// ase_compose_cel_visible.
+static inline int cel_visible(const LayerCache *cache, int index) {
+    int layer = layer_index(cache, frame_cel(cache, index)->layer);
+    if (!cache->layer_visible[layer])
+        return 0;
+    int parent = cache->layer_parents[layer];
+    return parent < 0 || cache->layer_visible[parent];
+}
+
+void layer_cache_set_visible(LayerCache *cache, int layer, int visible) {
+    assert(layer >= 0 && layer < cache->ase->layer_count);
+    visible = !!visible;
+    if (cache->layer_visible[layer] == visible)
+        return;
+    cache->layer_visible[layer] = visible;
+
+    // Composites from the first cel of the layer or its children onwards
+    // are out of date
+    for (int i = 0; i < cache->cel_count && i < cache->prefixes_valid; i++) {
+        int cel_layer = layer_index(cache, frame_cel(cache, i)->layer);
+        if (cel_layer == layer || cache->layer_parents[cel_layer] == layer) {
+            cache->prefixes_valid = i;
+            break;
+        }
+    }
+}
+
+void layer_cache_set_solo(LayerCache *cache, int layer) {
+    assert(layer >= -1 && layer < cache->ase->layer_count);
+    if (cache->solo_layer != layer)
+        cache->solo_valid = 0;
+    cache->solo_layer = layer;
+}
+
+static inline void blend_cel(LayerCache *cache, int index,
+                             ase_color_t *canvas) {
+    ase_cel_t *cel = ase_compose_resolve_cel(frame_cel(cache, index));
+    AseComposeTarget target = canvas_target(cache, canvas);
+    ase_compose_blend_cel(cache->ase, cel, cache->cel_pixels[index],
+                          ase_compose_cel_opacity(cel), &target);
+    cache->cels_composited++;
+}
+
+const ase_color_t *layer_cache_pixels(LayerCache *cache) {
+    size_t size = canvas_size(cache);
+    cache->cels_composited = 0;
+
+    if (cache->solo_layer >= 0) {
+        if (!cache->solo_valid) {
+            memset(cache->solo_pixels, 0, size * sizeof(ase_color_t));
+            for (int i = 0; i < cache->cel_count; i++) {
+                int layer = layer_index(cache, frame_cel(cache, i)->layer);
+                if (layer == cache->solo_layer ||
+                    cache->layer_parents[layer] == cache->solo_layer)
+                    blend_cel(cache, i, cache->solo_pixels);
+            }
+            cache->solo_valid = 1;
+        }
+        return cache->solo_pixels;
+    }
+
+    for (int i = cache->prefixes_valid; i < cache->cel_count; i++) {
+        ase_color_t *below = cache->prefixes + (size_t)i * size;
+        ase_color_t *canvas = below + size;
+        memcpy(canvas, below, size * sizeof(ase_color_t));
+        if (cel_visible(cache, i))
+            blend_cel(cache, i, canvas);
+    }
+    cache->prefixes_valid = cache->cel_count;
+    return cache->prefixes + (size_t)cache->cel_count * size;
+}
+
+Texture layer_cache_upload(LayerCache *cache, StagingRing *ring,
+                           Texture reuse) {
+    const ase_color_t *pixels = layer_cache_pixels(cache);
+    size_t size = canvas_size(cache) * sizeof(ase_color_t);
+
+    void *staging = staging_ring_reserve(ring, size);
+    if (staging) {
+        memcpy(staging, pixels, size);
+        return staging_ring_upload_texture(ring, cache->ase->w, cache->ase->h,
+                                           reuse);
+    }
+
+    Image image = {
+        .data = (void *)pixels,
+        .width = cache->ase->w,
+        .height = cache->ase->h,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    return LoadTextureFromImage(image);
+}
@@ -0,0 +1,58 @@
+#ifndef _LAYER_CACHE
+#define _LAYER_CACHE
+
+// Per-layer cached composites of one aseprite frame. The cels are decoded to
+// RGBA once and the composite of every prefix of the layer stack is kept, so
+// toggling the visibility of a layer only recomposites the layers above it and
+// previewing a single layer blends just that one, without touching the file.
+
+#include "ase_compose.h"
+#include "cute_aseprite.h"
+#include "raylib.h"
+#include "staging_ring.h"
+
+typedef struct {
+    ase_t *ase;
+    int frame_index;
+    int cel_count;
+    // Decoded pixels of each cel of the frame, links resolved
+    ase_color_t *cel_pixels[CUTE_ASEPRITE_MAX_LAYERS];
+    // Index of each layer's parent layer, -1 if none
+    int layer_parents[CUTE_ASEPRITE_MAX_LAYERS];
+    int layer_visible[CUTE_ASEPRITE_MAX_LAYERS];
+    // The only layer drawn, -1 for the regular composite
+    int solo_layer;
+    // cel_count + 1 canvases, canvas i is the composite of the first i cels
+    ase_color_t *prefixes;
+    // Canvases up to and including this one are up to date
+    int prefixes_valid;
+    // Composite of the solo layer
+    ase_color_t *solo_pixels;
+    int solo_valid;
+    // Cels blended by the last layer_cache_pixels call
+    int cels_composited;
+} LayerCache;
+
+// Decodes frame `frame_index` of `ase`, loaded with ase_compose_load. The
+// cache takes ownership of `ase`. Returns 0 on success.
+int layer_cache_init(LayerCache *cache, ase_t *ase, int frame_index);
+void layer_cache_free(LayerCache *cache);
+
+int layer_cache_layer_count(const LayerCache *cache);
+const char *layer_cache_layer_name(const LayerCache *cache, int layer);
+
+int layer_cache_visible(const LayerCache *cache, int layer);
+void layer_cache_set_visible(LayerCache *cache, int layer, int visible);
+
+// Draws only `layer`, or every visible layer again if -1.
+void layer_cache_set_solo(LayerCache *cache, int layer);
+
+// The composite with the current visibility, ase->w * ase->h RGBA pixels.
+// Valid until the cache is changed.
+const ase_color_t *layer_cache_pixels(LayerCache *cache);
+
+// Uploads the composite, see staging_ring_upload_texture.
+Texture layer_cache_upload(LayerCache *cache, StagingRing *ring,
+                           Texture reuse);
+
+#endif
@@ -0,0 +1,241 @@
+#define GL_GLEXT_PROTOTYPES
+#include "lights.h"
+#include "raymath.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Light of surfaces no light reaches
+#define AMBIENT "0.3"
+
+static const char *lit_vertex_shader =
+    "#version 330                                                   \n"
+    "in vec3 vertexPosition;                                        \n"
+    "in vec2 vertexTexCoord;                                        \n"
+    "in vec3 vertexNormal;                                          \n"
+    "out vec2 fragTexCoord;                                         \n"
+    "out vec3 fragPosition;                                         \n"
+    "out vec3 fragNormal;                                           \n"
+    "uniform mat4 mvp;                                              \n"
+    "uniform mat4 matModel;                                         \n"
+    "uniform mat4 matNormal;                                        \n"
+    "void main()                                                    \n"
+    "{                                                              \n"
+    "    fragTexCoord = vertexTexCoord;                             \n"
+    "    fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));   \n"
+    "    fragNormal = mat3(matNormal)*vertexNormal;                 \n"
+    "    gl_Position = mvp*vec4(vertexPosition, 1.0);               \n"
+    "}                                                              \n";
+
+// Meshes without normals get flat ones from the screen space derivatives
+static const char *lit_fragment_shader =
+    "#version 330                                                   \n"
+    "in vec2 fragTexCoord;                                          \n"
+    "in vec3 fragPosition;                                          \n"
+    "in vec3 fragNormal;                                            \n"
+    "out vec4 finalColor;                                           \n"
+    "uniform sampler2D texture0;                                    \n"
+    "uniform vec4 colDiffuse;                                       \n"
+    "uniform samplerBuffer lights;                                  \n"
+    "uniform int lightOffset;                                       \n"
+    "uniform int lightCount;                                        \n"
+    "void main()                                                    \n"
+    "{                                                              \n"
+    "    vec4 texel = texture(texture0, fragTexCoord)*colDiffuse;   \n"
+    "    vec3 normal = dot(fragNormal, fragNormal) > 1e-8           \n"
+    "        ? normalize(fragNormal)                                \n"
+    "        : normalize(cross(dFdx(fragPosition), dFdy(fragPosition)));\n"
+    "    vec3 light = vec3(" AMBIENT ");                            \n"
+    "    for (int i = 0; i < lightCount; i++) {                     \n"
+    "        vec4 sphere = texelFetch(lights, (lightOffset + i)*2); \n"
+    "        vec4 color = texelFetch(lights, (lightOffset + i)*2 + 1);\n"
+    "        vec3 toLight = sphere.xyz - fragPosition;              \n"
+    "        float distance = length(toLight);                      \n"
+    "        float falloff = clamp(1.0 - distance/sphere.w, 0.0, 1.0);\n"
+    "        float facing = max(dot(normal, toLight/max(distance, 1e-4)), 0.0);\n"
+    "        light += color.rgb*color.a*falloff*falloff*facing;     \n"
+    "    }                                                          \n"
+    "    finalColor = vec4(texel.rgb*light, texel.a);               \n"
+    "}                                                              \n";
+
+void light_set_free(LightSet *set) {
+    free(set->lights);
+    free(set->moved);
+    free(set->culled);
+    free(set->draws);
+    if (set->texture_id)
+        glDeleteTextures(1, &set->texture_id);
+    if (set->buffer_id)
+        glDeleteBuffers(1, &set->buffer_id);
+    *set = (LightSet){0};
+}
+
+static inline void add_light(LightSet *set, PointLight light) {
+    if (set->light_count >= set->lights_allocated) {
+        set->lights_allocated =
+            set->lights_allocated ? set->lights_allocated * 2 : 64;
+        set->lights =
+            realloc(set->lights, set->lights_allocated * sizeof(PointLight));
+        set->moved =
+            realloc(set->moved, set->lights_allocated * sizeof(PointLight));
+        if (!set->lights || !set->moved)
+            abort();
+    }
+    set->lights[set->light_count++] = light;
+}
+
+int light_set_add(LightSet *set, Light light) {
+    if (light.type != LIGHT_POINT)
+        return 1;
+    if (!light.enabled)
+        return 0;
+
+    add_light(set, (PointLight){
+                       .position = light.position,
+                       .radius = light.attenuation,
+                       .color = {light.color.r / 255.0f,
+                                 light.color.g / 255.0f,
+                                 light.color.b / 255.0f},
+                       .intensity = light.color.a / 255.0f,
+                   });
+    return 0;
+}
+
+static inline float random_unit(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / (float)(1 << 24);
+}
+
+void light_set_scatter(LightSet *set, BoundingBox bounds, size_t count,
+                       uint32_t seed) {
+    Vector3 size = Vector3Subtract(bounds.max, bounds.min);
+    float radius = Vector3Length(size) / 8.0f;
+    if (radius <= 0.0f)
+        radius = 1.0f;
+
+    uint32_t state = seed;
+    for (size_t i = 0; i < count; i++) {
+        Vector3 position = {
+            bounds.min.x + size.x * random_unit(&state),
+            bounds.min.y + size.y * random_unit(&state),
+            bounds.min.z + size.z * random_unit(&state),
+        };
+        Color color = ColorFromHSV(360.0f * random_unit(&state), 0.6f, 1.0f);
+        color.a = 255;
+        light_set_add(set, (Light){
+                               .type = LIGHT_POINT,
+                               .enabled = true,
+                               .position = position,
+                               .color = color,
+                               .attenuation = radius,
+                           });
+    }
+}
+
+// Squared distance from `point` to the closest point of `box`.
+static inline float box_distance_squared(BoundingBox box, Vector3 point) {
+    float x = fmaxf(fmaxf(box.min.x - point.x, point.x - box.max.x), 0.0f);
+    float y = fmaxf(fmaxf(box.min.y - point.y, point.y - box.max.y), 0.0f);
+    float z = fmaxf(fmaxf(box.min.z - point.z, point.z - box.max.z), 0.0f);
+    return x * x + y * y + z * z;
+}
+
+void light_set_cull(LightSet *set, const BoundingBox *boxes, size_t box_count,
+                    Matrix transform) {
+    if (box_count > set->draws_allocated) {
+        set->draws_allocated = box_count;
+        set->draws = realloc(set->draws, box_count * sizeof(LightRange));
+        if (!set->draws)
+            abort();
+    }
+    size_t per_draw = set->light_count < LIGHTS_MAX_PER_DRAW
+                          ? set->light_count
+                          : LIGHTS_MAX_PER_DRAW;
+    if (box_count * per_draw > set->culled_allocated) {
+        set->culled_allocated = box_count * per_draw;
+        set->culled =
+            realloc(set->culled, set->culled_allocated * sizeof(PointLight));
+        if (!set->culled)
+            abort();
+    }
+
+    for (size_t i = 0; i < set->light_count; i++) {
+        set->moved[i] = set->lights[i];
+        set->moved[i].position =
+            Vector3Transform(set->lights[i].position, transform);
+    }
+
+    set->draw_count = box_count;
+    set->culled_used = 0;
+    for (size_t i = 0; i < box_count; i++) {
+        LightRange *range = set->draws + i;
+        range->offset = set->culled_used;
+        range->count = 0;
+        for (size_t j = 0; j < set->light_count && range->count < per_draw;
+             j++) {
+            PointLight *light = set->moved + j;
+            if (box_distance_squared(boxes[i], light->position) <
+                light->radius * light->radius)
+                set->culled[range->offset + range->count++] = *light;
+        }
+        set->culled_used += range->count;
+    }
+}
+
+void light_set_upload(LightSet *set) {
+    if (!set->buffer_id) {
+        glGenBuffers(1, &set->buffer_id);
+        glGenTextures(1, &set->texture_id);
+    }
+
+    // Orphaned every frame, the draws of the previous frame may still read
+    // the old storage
+    glBindBuffer(GL_TEXTURE_BUFFER, set->buffer_id);
+    glBufferData(GL_TEXTURE_BUFFER,
+                 (GLsizeiptr)(set->culled_used * sizeof(PointLight)),
+                 set->culled, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + LIGHTS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, set->texture_id);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, set->buffer_id);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+LightShader light_shader_load(void) {
+    LightShader shader = {
+        .shader = LoadShaderFromMemory(lit_vertex_shader, lit_fragment_shader),
+    };
+    shader.light_offset_location =
+        GetShaderLocation(shader.shader, "lightOffset");
+    shader.light_count_location = GetShaderLocation(shader.shader, "lightCount");
+
+    int unit = LIGHTS_TEXTURE_UNIT;
+    SetShaderValue(shader.shader, GetShaderLocation(shader.shader, "lights"),
+                   &unit, SHADER_UNIFORM_INT);
+    return shader;
+}
+
+void light_shader_unload(LightShader *shader) {
+    if (shader->shader.id)
+        UnloadShader(shader->shader);
+    *shader = (LightShader){0};
+}
+
+void light_shader_draw(LightShader *shader, LightSet *set, size_t draw_index,
+                       Mesh mesh, Material material) {
+    assert(draw_index < set->draw_count);
+    LightRange range = set->draws[draw_index];
+    int offset = (int)range.offset;
+    int count = (int)range.count;
+    SetShaderValue(shader->shader, shader->light_offset_location, &offset,
+                   SHADER_UNIFORM_INT);
+    SetShaderValue(shader->shader, shader->light_count_location, &count,
+                   SHADER_UNIFORM_INT);
+
+    material.shader = shader->shader;
+    DrawMesh(mesh, material, MatrixIdentity());
+}
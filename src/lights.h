@@ -0,0 +1,84 @@
+#ifndef _LIGHTS
+#define _LIGHTS
+
+// Point lights for the lit preview, any number of them.
+//
+// rlights gives every light its own uniforms, capped at MAX_LIGHTS. Here the
+// lights are instead culled against the bounds of each model on the CPU every
+// frame. The lights touching a model are copied next to each other into one
+// texture buffer, and each draw only loops over its own range of it, so
+// shading cost follows the lights affecting a model, not the total count.
+
+#include "raylib.h"
+#include "rlights.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Lights shaded per draw at most, the rest are ignored
+#define LIGHTS_MAX_PER_DRAW 64
+// Texture unit of the light buffer, above the units raylib's materials use
+#define LIGHTS_TEXTURE_UNIT 8
+
+// Laid out as the two RGBA32F texels the shader reads per light.
+typedef struct {
+    Vector3 position;
+    // Distance at which the light has faded out completely
+    float radius;
+    Vector3 color;
+    float intensity;
+} PointLight;
+
+typedef struct {
+    size_t offset;
+    size_t count;
+} LightRange;
+
+typedef struct {
+    PointLight *lights;
+    size_t light_count;
+    size_t lights_allocated;
+
+    // Written by light_set_cull: the lights moved to where they are drawn,
+    // the lights of every draw one after another and the range of each draw
+    PointLight *moved;
+    PointLight *culled;
+    size_t culled_used;
+    size_t culled_allocated;
+    LightRange *draws;
+    size_t draw_count;
+    size_t draws_allocated;
+
+    unsigned int buffer_id;
+    unsigned int texture_id;
+} LightSet;
+
+typedef struct {
+    Shader shader;
+    int light_offset_location;
+    int light_count_location;
+} LightShader;
+
+void light_set_free(LightSet *set);
+
+// Adds an rlights point light. `light.attenuation` is the radius and the
+// alpha of `light.color` the intensity. Returns 1 for directional lights,
+// which are not supported.
+int light_set_add(LightSet *set, Light light);
+// Adds `count` randomly colored lights spread over `bounds`, each reaching
+// about an eighth of the way across it.
+void light_set_scatter(LightSet *set, BoundingBox bounds, size_t count,
+                       uint32_t seed);
+
+// Moves the lights by `transform` and finds the ones touching each of `boxes`.
+void light_set_cull(LightSet *set, const BoundingBox *boxes, size_t box_count,
+                    Matrix transform);
+// Uploads the culled lights and binds them to LIGHTS_TEXTURE_UNIT.
+void light_set_upload(LightSet *set);
+
+LightShader light_shader_load(void);
+void light_shader_unload(LightShader *shader);
+// Draws `mesh` lit by the lights culled for `draw_index`.
+void light_shader_draw(LightShader *shader, LightSet *set, size_t draw_index,
+                       Mesh mesh, Material material);
+
+#endif
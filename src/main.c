@@ -1,13 +1,38 @@
 #define FIREWATCH_IMPLEMENTATION
 #include "firewatch.h"
 
-#include "aseprite_texture.h"
+#include "alloc_track.h"
+#include "ase_compose.h"
+#include "ase_probe.h"
+#include "capture.h"
+#include "disk_cache.h"
+#include "discovery.h"
+#include "draw_list.h"
+#include "frame_stats.h"
+#include "gl_loader.h"
+#include "gpu_timer.h"
+#include "layer_cache.h"
+#include "lights.h"
+#include "metrics.h"
 #include "orbital_controls.h"
 #include "path.h"
+#include "point_cloud.h"
 #include "raylib.h"
 #include "raymath.h"
+#include "reload_txn.h"
+#include "replay.h"
+#include "rlgl.h"
+#include "scene_snapshot.h"
+#include "staging_ring.h"
 #include "string_vector.h"
+#include "tiled_texture.h"
+#include "timings.h"
+#include "version_history.h"
+#include "voxel_mesh.h"
+#include <GLFW/glfw3.h>
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -25,6 +50,25 @@
 #define ZOOM_SENSITIVITY_MOUSE 0.006
 #define MODEL_SHIFT_SENSITIVITY 0.004
 #define MODIFIED_CHECK_COOLDOWN_SECONDS 0.5
+// Frames allowed to allocate while everything settles after startup
+#define ALLOC_WARMUP_FRAMES 3
+// With -render-thread, how often the main thread polls input and file watches
+#define INPUT_POLL_RATE 240
+// With -render-thread, frame rate cap of the render thread when vsync is off
+#define RENDER_THREAD_FPS 60
+// Frame rate of captured turntables, which turn by AUTO_ROTATE_SPEED radians
+// per second of video
+#define CAPTURE_FPS 60
+// Point lights of the lit preview unless set with -lights
+#define LIGHT_COUNT 256
+// Radians per second the lights of the lit preview circle the scene
+#define LIGHT_ORBIT_SPEED 0.3
+// GPU timer scopes, followed by one per model or point cloud
+#define GPU_SCOPE_GRID 0
+#define GPU_SCOPE_WIREFRAME 1
+#define GPU_SCOPE_MODELS 2
+// Scopes listed in the GPU time overlay
+#define GPU_OVERLAY_ROWS 10
 
 // Default shader with vertex colors disabled
 static const char *vertex_shader =
@@ -45,9 +89,123 @@ static const char *vertex_shader =
 static Shader shader = {0};
 static Model *models = 0;
 static size_t model_count = 0;
+static ReplayRecorder recorder = {0};
+// Staging memory for texture uploads on this thread
+static StagingRing staging_ring = {0};
+// Only recorded during startup, with -timings
+static Timings timings = {0};
+// Per-layer composites of the textures, created on the first layer key press
+static LayerCache *layer_caches = 0;
+// Layer shown or toggled by the layer keys
+static int selected_layer = 0;
+// Allocations made by reloads during the current frame
+static size_t reload_allocation_count = 0;
+// Bounds of each model, for culling the lights of the lit preview
+static BoundingBox *model_bounds = 0;
+// What drawing needs of each model, updated as loads commit
+static DrawList draw_list = {0};
+// Tried in order for the texture of each model, see discovery.h
+static DiscoveryPatterns sidecar_patterns = {0};
+// The pattern of the texture found for each model at startup
+static int *texture_patterns = 0;
+static LightSet light_set = {0};
+static LightShader light_shader = {0};
+static Vector3 light_orbit_center = {0};
+// Meshers of the models that are sprites extruded into voxels
+static VoxelMesher *voxel_meshers = 0;
+// Versions of the meshes and textures as loaded, stepped through with the
+// arrow keys
+static VersionHistory *mesh_histories = 0;
+static VersionHistory *texture_histories = 0;
+static size_t history_capacity = VERSION_HISTORY_DEFAULT;
+// With -pointcloud, the scans drawn as points instead of the models
+static PointCloud *point_clouds = 0;
+static size_t point_cloud_count = 0;
+// Points drawn per frame, shared by the point clouds
+static uint64_t point_budget = POINT_CLOUD_BUDGET;
+// GPU time of the passes and models, with -gpu-timings or the overlay. Only
+// used by the thread drawing, which creates it on the first frame timed.
+static GpuTimer gpu_timer = {0};
+static int gpu_timings_enabled = 0;
+static const char **gpu_scope_names = 0;
+// Whether the frame being drawn is timed
+static int gpu_frame_timed = 0;
+// When the latest change to the model or texture of each model was seen, 0
+// once it is drawable. Set on the thread watching files, cleared on the one
+// drawing.
+static _Atomic double *model_load_starts = 0;
+static _Atomic double *texture_load_starts = 0;
+// Changes to the files of a model are loaded together once they settle, see
+// reload_txn.h. The initial loads are not grouped.
+static ReloadTxns reload_txns = {0};
+static double reload_window = RELOAD_TXN_WINDOW;
+static int reloads_grouped = 0;
+// Loaded models and textures waiting for the rest of their transaction
+static Model *held_models = 0;
+static Texture *held_textures = 0;
+// Textures of the canvases larger than max_texture_size, drawn with the tiled
+// shader when they have an id
+static TiledTexture *tiled_textures = 0;
+static TiledShader tiled_shader = {0};
+static int max_texture_size = 0;
+// Set for tiled textures composited off the GL thread, which
+// apply_finished_loads uploads
+static atomic_int *tiled_uploads_pending = 0;
+// With -cache, meshes and composited textures are kept on disk, see
+// disk_cache.h
+static DiskCache disk_cache = {0};
+static int disk_cache_enabled = 0;
 
-void load_model(const char *filepath, uint64_t model_index) {
-    printf("mod: %s, %zu\n", filepath, model_index);
+// The disk cache only speeds up the initial loads. A reload is of a file that
+// just changed, which would miss and be written back with an fsync each save.
+static inline int disk_cache_used(void) {
+    return disk_cache_enabled && !reloads_grouped;
+}
+
+// With -render-thread, the render thread owns the GL context and draws the
+// scene snapshots published by the main thread
+static SceneSnapshotBuffer scene_snapshots = {0};
+static pthread_t render_thread = {0};
+static atomic_int render_thread_stopping = 0;
+
+typedef struct {
+    int pending;
+    int width;
+    int height;
+} PendingResize;
+
+// raylib's resize callbacks set the GL viewport, so with the render thread
+// they are deferred to it
+static GLFWwindowsizefun raylib_window_size_callback = 0;
+static GLFWframebuffersizefun raylib_framebuffer_size_callback = 0;
+static PendingResize pending_window_resize = {0};
+static PendingResize pending_framebuffer_resize = {0};
+static pthread_mutex_t pending_resize_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Reports the allocations of a reload started at `start`.
+static inline void end_reload(AllocCount start) {
+    AllocCount allocations = alloc_track_since(start);
+    reload_allocation_count += allocations.count;
+    if (alloc_track_enabled())
+        printf("     %zu allocations, %zu bytes\n", allocations.count,
+               allocations.bytes);
+}
+
+// Updates the draw list entry of the model at `model_index` to its current
+// mesh and texture.
+static inline void update_draw_entry(uint64_t model_index) {
+    Model *model = models + model_index;
+    draw_list_set(
+        &draw_list, model_index, model->meshCount ? model->meshes : 0,
+        model->materialCount
+            ? model->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture.id
+            : 0,
+        model_bounds[model_index],
+        tiled_textures[model_index].id ? DRAW_LIST_TILED : 0);
+}
+
+// Replaces the model at `model_index` with `model`, keeping the texture.
+static inline void set_model(uint64_t model_index, Model model) {
     Texture texture = {0};
     if (models[model_index].materialCount)
         texture =
@@ -56,29 +214,24 @@ void load_model(const char *filepath, uint64_t model_index) {
     if (models[model_index].meshCount)
         UnloadModel(models[model_index]);
 
-    models[model_index] = LoadModel(filepath);
+    models[model_index] = model;
     assert(models[model_index].meshCount);
+    model_bounds[model_index] = GetModelBoundingBox(model);
     models[model_index].materials[0].shader = shader;
     models[model_index].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture =
         texture;
+    update_draw_entry(model_index);
 }
 
-void load_texture(const char *filepath, uint64_t model_index) {
-    printf("tex: %s, %zu\n", filepath, model_index);
-    ImageData image_data = aseprite_load(filepath);
-    assert(image_data.base_image.data);
-    if (!image_data.base_image.data)
-        return;
-
-    Texture texture = LoadTextureFromImage(image_data.base_image);
-    UnloadImage(image_data.base_image);
-    assert(texture.id);
-
+// Replaces the texture of the model at `model_index` with `texture`, which may
+// also be the current texture updated in place.
+static inline void set_texture(uint64_t model_index, Texture texture) {
     if (models[model_index].materialCount) {
-        if (models[model_index]
-                .materials[0]
-                .maps[MATERIAL_MAP_DIFFUSE]
-                .texture.id)
+        unsigned int current_id = models[model_index]
+                                      .materials[0]
+                                      .maps[MATERIAL_MAP_DIFFUSE]
+                                      .texture.id;
+        if (current_id && current_id != texture.id)
             UnloadTexture(models[model_index]
                               .materials[0]
                               .maps[MATERIAL_MAP_DIFFUSE]
@@ -87,31 +240,910 @@ void load_texture(const char *filepath, uint64_t model_index) {
         models[model_index].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture =
             texture;
     }
+    update_draw_entry(model_index);
+}
+
+static inline size_t mesh_bytes(const Mesh *mesh) {
+    size_t vertex_size = (mesh->vertices ? 3 * sizeof(float) : 0) +
+                         (mesh->texcoords ? 2 * sizeof(float) : 0) +
+                         (mesh->texcoords2 ? 2 * sizeof(float) : 0) +
+                         (mesh->normals ? 3 * sizeof(float) : 0) +
+                         (mesh->tangents ? 4 * sizeof(float) : 0) +
+                         (mesh->colors ? 4 : 0);
+    return (size_t)mesh->vertexCount * vertex_size +
+           (mesh->indices ? (size_t)mesh->triangleCount * 3 *
+                                sizeof(unsigned short)
+                          : 0);
+}
+
+// Sums up the memory held by the models, textures and their versions.
+static inline void update_memory_metrics(void) {
+    size_t meshes = 0;
+    size_t textures = 0;
+    size_t history = 0;
+    for (size_t i = 0; i < model_count; i++) {
+        for (int j = 0; j < models[i].meshCount; j++)
+            meshes += mesh_bytes(models[i].meshes + j);
+        if (models[i].materialCount) {
+            Texture texture =
+                models[i].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture;
+            if (texture.id)
+                textures += (size_t)texture.width * (size_t)texture.height * 4;
+        }
+        textures += tiled_texture_bytes(tiled_textures + i);
+        history += mesh_histories[i].compressed_bytes +
+                   texture_histories[i].compressed_bytes;
+    }
+    metrics_set(METRIC_MESH_BYTES, meshes);
+    metrics_set(METRIC_TEXTURE_BYTES, textures);
+    metrics_set(METRIC_HISTORY_BYTES, history);
+}
+
+// Records the time since the change that led to a load, in `starts`.
+static inline void observe_load(_Atomic double *starts, uint64_t model_index,
+                                MetricHistogram histogram) {
+    double start = atomic_exchange(starts + model_index, 0.0);
+    if (start > 0.0)
+        metrics_observe(histogram, timings_now() - start);
+}
+
+// Sets the model at `model_index` to a newly loaded `model` and keeps its mesh
+// in the version history.
+static inline void commit_model(uint64_t model_index, Model model) {
+    set_model(model_index, model);
+    if (history_capacity)
+        version_history_record_mesh(mesh_histories + model_index,
+                                    models[model_index].meshes);
+    observe_load(model_load_starts, model_index, METRIC_MODEL_LOAD_SECONDS);
+    update_memory_metrics();
+}
+
+// Sets the texture of the model at `model_index` to a newly loaded `texture`.
+// Its pixels are kept in the version history by the load, see
+// record_texture_version.
+static inline void commit_texture(uint64_t model_index, Texture texture) {
+    set_texture(model_index, texture);
+    // The canvas shrank to fit a single texture again
+    if (tiled_textures[model_index].id) {
+        tiled_texture_free(tiled_textures + model_index);
+        tiled_texture_init(tiled_textures + model_index);
+        update_draw_entry(model_index);
+    }
+    observe_load(texture_load_starts, model_index,
+                 METRIC_TEXTURE_LOAD_SECONDS);
+    update_memory_metrics();
+}
+
+// Commits what has been held for the transaction of `model_index`.
+static inline void commit_held(uint64_t model_index) {
+    if (held_models[model_index].meshCount) {
+        commit_model(model_index, held_models[model_index]);
+        held_models[model_index] = (Model){0};
+    }
+    if (held_textures[model_index].id) {
+        commit_texture(model_index, held_textures[model_index]);
+        held_textures[model_index] = (Texture){0};
+    }
+}
+
+// Commits a newly loaded model along with the rest of its transaction, or
+// holds it until the rest is loaded.
+static inline void finish_model(uint64_t model_index, Model model) {
+    if (held_models[model_index].meshCount)
+        UnloadModel(held_models[model_index]);
+    held_models[model_index] = model;
+    if (reload_txn_loaded(&reload_txns, model_index, RELOAD_PART_MODEL))
+        commit_held(model_index);
+}
+
+static inline void finish_texture(uint64_t model_index, Texture texture) {
+    // Textures updated in place are already the current one
+    if (held_textures[model_index].id &&
+        held_textures[model_index].id != texture.id)
+        UnloadTexture(held_textures[model_index]);
+    held_textures[model_index] = texture;
+    if (reload_txn_loaded(&reload_txns, model_index, RELOAD_PART_TEXTURE))
+        commit_held(model_index);
+}
+
+// Gives up on `part` of the model at `model_index`, committing the rest of
+// its transaction.
+static inline void fail_load(uint64_t model_index, uint32_t part) {
+    metrics_count(METRIC_LOAD_FAILURES, 1);
+    if (reload_txn_loaded(&reload_txns, model_index, part))
+        commit_held(model_index);
+}
+
+// Like fail_load, for loads that may run on the main thread. With the loader
+// thread running that thread has no OpenGL context, so the failure is queued
+// for apply_finished_loads to commit on the render thread instead.
+static inline void fail_load_queued(uint64_t model_index, uint32_t part) {
+    if (!gl_loader_running()) {
+        fail_load(model_index, part);
+        return;
+    }
+    gl_loader_fail(part == RELOAD_PART_MODEL ? GL_LOAD_MODEL : GL_LOAD_TEXTURE,
+                   model_index);
+}
+
+// Extrudes the first frame of the sprite at `filepath` into voxels. Only the
+// rows whose opacity changed since the previous load are meshed again.
+static inline void load_sprite_model(const char *filepath,
+                                     uint64_t model_index) {
+    double load_start = timings_now();
+    ase_t *ase = ase_compose_load(filepath);
+    if (!ase) {
+        fprintf(stderr, "ERROR: could not load sprite %s\n", filepath);
+        fail_load_queued(model_index, RELOAD_PART_MODEL);
+        return;
+    }
+
+    uint8_t *pixels = malloc((size_t)ase->w * (size_t)ase->h * 4);
+    assert(pixels);
+    AseComposeTarget target = {
+        .pixels = pixels,
+        .stride = (size_t)ase->w * 4,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+    ase_compose_frame(ase, 0, &target);
+
+    VoxelMesher *mesher = voxel_meshers + model_index;
+    voxel_mesher_update(mesher, pixels, ase->w, ase->h);
+    Mesh mesh = voxel_mesher_build(mesher);
+    free(pixels);
+    cute_aseprite_free(ase);
+    timings_add(&timings, TIMING_MESH_LOAD, filepath, load_start);
+    metrics_count(METRIC_VOXEL_BAND_HITS,
+                  mesher->band_count - mesher->bands_meshed);
+    metrics_count(METRIC_VOXEL_BAND_MISSES, mesher->bands_meshed);
+    printf("     %zu triangles (%zu as cubes), %zu of %zu bands meshed\n",
+           voxel_mesher_triangle_count(mesher),
+           voxel_mesher_naive_triangle_count(mesher), mesher->bands_meshed,
+           mesher->band_count);
+
+    if (!mesh.vertexCount) {
+        fprintf(stderr, "ERROR: sprite %s has no opaque pixels\n", filepath);
+        // Like raylib does for models that fail to load, if this thread can
+        // upload the cube
+        if (models[model_index].meshCount || gl_loader_running()) {
+            fail_load_queued(model_index, RELOAD_PART_MODEL);
+            return;
+        }
+        metrics_count(METRIC_LOAD_FAILURES, 1);
+        mesh = GenMeshCube(1.0f, 1.0f, 1.0f);
+    } else if (gl_loader_running()) {
+        gl_loader_upload_mesh(mesh, model_index);
+        return;
+    } else {
+        UploadMesh(&mesh, false);
+    }
+    finish_model(model_index, LoadModelFromMesh(mesh));
+}
+
+// Loads the model at `filepath` from the disk cache, or parses it and stores
+// it there. Only the first mesh is drawn, so models of several are not cached.
+static inline Model load_model_file(const char *filepath) {
+    if (!disk_cache_used())
+        return LoadModel(filepath);
+
+    DiskCacheKey key = disk_cache_key(DISK_CACHE_MESH, filepath);
+    Mesh mesh;
+    if (!disk_cache_get_mesh(&disk_cache, key, &mesh)) {
+        UploadMesh(&mesh, false);
+        return LoadModelFromMesh(mesh);
+    }
+    Model model = LoadModel(filepath);
+    if (model.meshCount == 1)
+        disk_cache_put_mesh(&disk_cache, key, model.meshes);
+    return model;
+}
+
+void load_model(const char *filepath, uint64_t model_index) {
+    AllocCount start = alloc_track_total();
+    printf("mod: %s, %zu\n", filepath, model_index);
+    metrics_count(METRIC_MODEL_LOADS, 1);
+    // Unless timed from the change already
+    double unset = 0.0;
+    atomic_compare_exchange_strong(model_load_starts + model_index, &unset,
+                                   timings_now());
+    replay_record_file_event(&recorder, GetTime(), REPLAY_EVENT_MODEL,
+                             model_index, filepath);
+
+    if (path_is_aseprite(filepath)) {
+        load_sprite_model(filepath, model_index);
+        end_reload(start);
+        return;
+    }
+
+    if (gl_loader_running()) {
+        gl_loader_load_model(filepath, model_index);
+        end_reload(start);
+        return;
+    }
+
+    double load_start = timings_now();
+    Model model = load_model_file(filepath);
+    timings_add(&timings, TIMING_MESH_LOAD, filepath, load_start);
+    finish_model(model_index, model);
+    end_reload(start);
+}
+
+// Uploads the changed tiles of the texture of the model at `model_index`, on
+// the GL thread.
+static inline void upload_tiled_texture(uint64_t model_index) {
+    int error = tiled_texture_upload(tiled_textures + model_index);
+    // Composited again in the meantime, uploaded once that is done
+    if (error == 1)
+        return;
+    if (error) {
+        fail_load(model_index, RELOAD_PART_TEXTURE);
+        return;
+    }
+
+    // Drawn from the tiles from now on, and committed in place like textures
+    // updated in place
+    set_texture(model_index, (Texture){0});
+    observe_load(texture_load_starts, model_index,
+                 METRIC_TEXTURE_LOAD_SECONDS);
+    update_memory_metrics();
+    if (reload_txn_loaded(&reload_txns, model_index, RELOAD_PART_TEXTURE))
+        commit_held(model_index);
+}
+
+// Loads a canvas too large for a single texture into tiles, see
+// tiled_texture.h. The tiles are composited here and uploaded right away if
+// this thread can, otherwise by apply_finished_loads.
+static inline void load_tiled_texture(const char *filepath,
+                                      uint64_t model_index) {
+    double decode_start = timings_now();
+    ase_t *ase = ase_compose_load(filepath);
+    if (!ase) {
+        fprintf(stderr, "ERROR: could not load texture %s\n", filepath);
+        fail_load_queued(model_index, RELOAD_PART_TEXTURE);
+        return;
+    }
+    TiledTexture *tiled = tiled_textures + model_index;
+    size_t changed = tiled_texture_compose(tiled, ase, max_texture_size, 0);
+    timings_add(&timings, TIMING_TEXTURE_DECODE, filepath, decode_start);
+    printf("     %dx%d canvas, %zu of %d tiles composited, %zu changed\n",
+           ase->w, ase->h, tiled->tiles_composited,
+           tiled->composed.columns * tiled->composed.rows, changed);
+    cute_aseprite_free(ase);
+
+    if (gl_loader_running()) {
+        atomic_store(tiled_uploads_pending + model_index, 1);
+        return;
+    }
+    double upload_start = timings_now();
+    upload_tiled_texture(model_index);
+    timings_add(&timings, TIMING_TEXTURE_UPLOAD, filepath, upload_start);
+}
+
+// Keeps the RGBA8 `pixels` of a texture loaded for the model at `model_index`
+// in its version history. Recorded from the pixels the load already has on
+// the CPU, so textures loaded by the loader thread or in tiles are not kept.
+static inline void record_texture_version(uint64_t model_index,
+                                          const void *pixels, int width,
+                                          int height) {
+    if (history_capacity)
+        version_history_record(texture_histories + model_index, pixels,
+                               (size_t)width * (size_t)height * 4, width,
+                               height);
+}
+
+// Uploads RGBA8 `pixels` through the staging ring, into `reuse` if it has the
+// same size, see staging_ring_upload_texture.
+static inline Texture upload_pixels(const void *pixels, int width, int height,
+                                    Texture reuse) {
+    size_t size = (size_t)width * (size_t)height * 4;
+    void *staging = staging_ring_reserve(&staging_ring, size);
+    if (staging) {
+        memcpy(staging, pixels, size);
+        return staging_ring_upload_texture(&staging_ring, width, height,
+                                           reuse);
+    }
+
+    Image image = {
+        .data = (void *)pixels,
+        .width = width,
+        .height = height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    return LoadTextureFromImage(image);
+}
+
+// Uploads the texture stored in the disk cache under `key` for the model at
+// `model_index`. Returns a texture with an id of 0 if there is none.
+static inline Texture load_cached_texture(DiskCacheKey key,
+                                          uint64_t model_index) {
+    DiskCacheBlob blob;
+    Image image = {
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    const uint8_t *pixels = 0;
+    if (disk_cache_get_pixels(&disk_cache, key, &blob, &pixels, &image.width,
+                              &image.height))
+        return (Texture){0};
+    // Uploaded straight from the mapping
+    image.data = (void *)pixels;
+    record_texture_version(model_index, pixels, image.width, image.height);
+    Texture texture = LoadTextureFromImage(image);
+    disk_cache_release(&blob);
+    return texture;
+}
+
+// Composites the first frame of `ase` in memory instead of the staging ring,
+// so that it can be stored in the disk cache under `key` if `cached` and kept
+// in the version history of the model at `model_index` before uploading.
+static inline Texture upload_composited_texture(ase_t *ase, int cached,
+                                                DiskCacheKey key,
+                                                uint64_t model_index,
+                                                Texture current) {
+    size_t size = (size_t)ase->w * (size_t)ase->h * 4;
+    uint8_t *pixels = malloc(size);
+    if (!pixels)
+        abort();
+    AseComposeTarget target = {
+        .pixels = pixels,
+        .stride = (size_t)ase->w * 4,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+    ase_compose_frame(ase, 0, &target);
+    if (cached)
+        disk_cache_put_pixels(&disk_cache, key, pixels, ase->w, ase->h);
+    record_texture_version(model_index, pixels, ase->w, ase->h);
+    Texture texture = upload_pixels(pixels, ase->w, ase->h, current);
+    free(pixels);
+    return texture;
+}
+
+// Loads a texture that is not an aseprite file, such as a PNG.
+static inline void load_image_texture(const char *filepath,
+                                      uint64_t model_index) {
+    if (gl_loader_running()) {
+        gl_loader_load_texture(filepath, model_index);
+        return;
+    }
+
+    double upload_start = timings_now();
+    Texture texture = {0};
+    if (history_capacity) {
+        // Loaded on the CPU first to be kept in the version history
+        Image image = LoadImage(filepath);
+        if (image.data && image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        if (image.data) {
+            record_texture_version(model_index, image.data, image.width,
+                                   image.height);
+            texture = LoadTextureFromImage(image);
+        }
+        UnloadImage(image);
+    } else {
+        texture = LoadTexture(filepath);
+    }
+    timings_add(&timings, TIMING_TEXTURE_UPLOAD, filepath, upload_start);
+    if (!texture.id) {
+        fprintf(stderr, "ERROR: could not load texture %s\n", filepath);
+        fail_load(model_index, RELOAD_PART_TEXTURE);
+        return;
+    }
+    finish_texture(model_index, texture);
+}
+
+void load_texture(const char *filepath, uint64_t model_index) {
+    AllocCount start = alloc_track_total();
+    printf("tex: %s, %zu\n", filepath, model_index);
+    metrics_count(METRIC_TEXTURE_LOADS, 1);
+    double unset = 0.0;
+    atomic_compare_exchange_strong(texture_load_starts + model_index, &unset,
+                                   timings_now());
+    // The layers of the new file are previewed from scratch
+    if (layer_caches)
+        layer_cache_free(layer_caches + model_index);
+    replay_record_file_event(&recorder, GetTime(), REPLAY_EVENT_TEXTURE,
+                             model_index, filepath);
+
+    // Loaded whole by raylib, without layers, tiles or the cache
+    if (!path_is_aseprite_texture(filepath)) {
+        load_image_texture(filepath, model_index);
+        end_reload(start);
+        return;
+    }
+
+    AseProbe probe;
+    if (!ase_probe_file(filepath, &probe) &&
+        tiled_texture_needed(probe.width, probe.height, max_texture_size)) {
+        load_tiled_texture(filepath, model_index);
+        end_reload(start);
+        return;
+    }
+
+    if (gl_loader_running()) {
+        gl_loader_load_texture(filepath, model_index);
+        end_reload(start);
+        return;
+    }
+
+    DiskCacheKey cache_key = {0};
+    int cached = disk_cache_used();
+    if (cached) {
+        double upload_start = timings_now();
+        cache_key = disk_cache_key(DISK_CACHE_PIXELS, filepath);
+        Texture texture = load_cached_texture(cache_key, model_index);
+        if (texture.id) {
+            timings_add(&timings, TIMING_TEXTURE_UPLOAD, filepath,
+                        upload_start);
+            finish_texture(model_index, texture);
+            end_reload(start);
+            return;
+        }
+    }
+
+    double decode_start = timings_now();
+    ase_t *ase = ase_compose_load(filepath);
+    timings_add(&timings, TIMING_TEXTURE_DECODE, filepath, decode_start);
+    if (!ase) {
+        fprintf(stderr, "ERROR: could not load texture %s\n", filepath);
+        fail_load(model_index, RELOAD_PART_TEXTURE);
+        end_reload(start);
+        return;
+    }
+
+    // Composited a band at a time into the staging ring, unless the whole
+    // frame is needed on the CPU
+    double upload_start = timings_now();
+    Texture current = {0};
+    if (models[model_index].materialCount)
+        current =
+            models[model_index].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture;
+    Texture texture =
+        cached || history_capacity
+            ? upload_composited_texture(ase, cached, cache_key, model_index,
+                                        current)
+            : ase_compose_upload(&staging_ring, ase, current);
+    timings_add(&timings, TIMING_TEXTURE_UPLOAD, filepath, upload_start);
+    cute_aseprite_free(ase);
+    if (!texture.id) {
+        fprintf(stderr, "ERROR: could not upload texture %s\n", filepath);
+        fail_load(model_index, RELOAD_PART_TEXTURE);
+        end_reload(start);
+        return;
+    }
+
+    finish_texture(model_index, texture);
+    end_reload(start);
+}
+
+// Swaps in the models and textures the loader thread has finished uploading.
+static inline void apply_finished_loads(void) {
+    GlLoadResult result;
+    while (gl_loader_poll(&result)) {
+        if (result.kind == GL_LOAD_MODEL) {
+            if (!result.model.meshCount) {
+                fprintf(stderr, "ERROR: could not load model %zu\n",
+                        (size_t)result.model_index);
+                fail_load(result.model_index, RELOAD_PART_MODEL);
+                continue;
+            }
+            finish_model(result.model_index, result.model);
+        } else {
+            if (!result.texture.id) {
+                fprintf(stderr, "ERROR: could not load texture of model %zu\n",
+                        (size_t)result.model_index);
+                fail_load(result.model_index, RELOAD_PART_TEXTURE);
+                continue;
+            }
+            finish_texture(result.model_index, result.texture);
+        }
+    }
+
+    if (tiled_uploads_pending) {
+        for (size_t i = 0; i < model_count; i++) {
+            if (atomic_exchange(tiled_uploads_pending + i, 0))
+                upload_tiled_texture(i);
+        }
+    }
+}
+
+// File watch callbacks, the changes are loaded by start_settled_reloads.
+static void model_changed(const char *filepath, uint64_t model_index) {
+    if (!reloads_grouped) {
+        load_model(filepath, model_index);
+        return;
+    }
+    // Timed from the change, the transaction window included
+    atomic_store(model_load_starts + model_index, timings_now());
+    reload_txn_change(&reload_txns, model_index, RELOAD_PART_MODEL);
+}
+
+static void texture_changed(const char *filepath, uint64_t model_index) {
+    if (!reloads_grouped) {
+        load_texture(filepath, model_index);
+        return;
+    }
+    atomic_store(texture_load_starts + model_index, timings_now());
+    reload_txn_change(&reload_txns, model_index, RELOAD_PART_TEXTURE);
+}
+
+// Writes the texture file found for the model at `model_index` at startup.
+// Returns 0 if the model has one.
+static inline int write_texture_filepath(char *destination, size_t size,
+                                         StringVector *model_filepaths,
+                                         size_t model_index) {
+    return discovery_write_texture_file(
+        destination, size, stringvec_get(model_filepaths, model_index),
+        &sidecar_patterns, texture_patterns[model_index]);
+}
+
+// Loads the changed files of the models whose changes have settled.
+static inline void start_settled_reloads(StringVector *model_filepaths) {
+    size_t model_index = 0;
+    uint32_t parts = 0;
+    char texture_filepath[PATH_MAX] = {0};
+    while (reload_txn_next(&reload_txns, &model_index, &parts)) {
+        const char *model_filepath =
+            stringvec_get(model_filepaths, model_index);
+        if (parts & RELOAD_PART_MODEL)
+            load_model(model_filepath, model_index);
+        if ((parts & RELOAD_PART_TEXTURE) &&
+            !write_texture_filepath(texture_filepath, sizeof(texture_filepath),
+                                    model_filepaths, model_index))
+            load_texture(texture_filepath, model_index);
+    }
 }
 
-static inline void setup_models(StringVector *model_filepaths) {
+// Registers a watch on `filepath`, which also does the initial load through
+// `callback`. Loads the file without a watch if the watch cannot be created.
+// The time spent on registering the watch alone is recorded.
+static inline void watch_file(const char *filepath, uint64_t cookie,
+                              FileRefreshFunction callback) {
+    double start = timings_now();
+    double recorded_before = timings.recorded_seconds;
+    int error = firewatch_new_file(filepath, cookie, callback, 0);
+    double loading = timings.recorded_seconds - recorded_before;
+    timings_add_seconds(&timings, TIMING_WATCH, filepath,
+                        timings_now() - start - loading);
+
+    if (error)
+        (*callback)(filepath, cookie);
+}
+
+// Finds the texture file of each model, see discovery.h.
+static inline void discover_textures(StringVector *model_filepaths) {
+    double start = timings_now();
+    texture_patterns = calloc(model_count, sizeof(int));
+    const char **filepaths = calloc(model_count, sizeof(char *));
+    assert(texture_patterns && filepaths);
+    for (size_t i = 0; i < model_count; i++)
+        filepaths[i] = stringvec_get(model_filepaths, i);
+
+    size_t missing = discovery_find_textures(
+        texture_patterns, filepaths, model_count, &sidecar_patterns, 0);
+    timings_add(&timings, TIMING_DISCOVERY, 0, start);
+    for (size_t i = 0; missing && i < model_count; i++)
+        if (texture_patterns[i] == DISCOVERY_MISSING)
+            fprintf(stderr, "ERROR: no texture found for %s\n", filepaths[i]);
+    free(filepaths);
+}
+
+// Probes the textures of the models without decoding them and sets up the
+// staging ring to hold at least the largest one.
+static inline void plan_textures(StringVector *model_filepaths) {
+    double start = timings_now();
+    char texture_filepath[PATH_MAX] = {0};
+    size_t largest_frame = 0;
+    size_t first_frames = 0;
+    size_t decoded = 0;
+    size_t tiled = 0;
+    for (size_t i = 0; i < model_count; i++) {
+        // Images other than aseprite files are not probed
+        if (write_texture_filepath(texture_filepath, sizeof(texture_filepath),
+                                   model_filepaths, i) ||
+            !path_is_aseprite_texture(texture_filepath))
+            continue;
+
+        AseProbe probe;
+        if (ase_probe_file(texture_filepath, &probe)) {
+            fprintf(stderr, "ERROR: %s is not an aseprite file\n",
+                    texture_filepath);
+            continue;
+        }
+        decoded += ase_probe_decoded_size(&probe);
+        // Composited into their own tiles instead of the ring
+        if (tiled_texture_needed(probe.width, probe.height, max_texture_size)) {
+            tiled++;
+            continue;
+        }
+        size_t frame_size = ase_probe_frame_size(&probe);
+        if (frame_size > largest_frame)
+            largest_frame = frame_size;
+        first_frames += frame_size + STAGING_RING_ALIGNMENT;
+    }
+    timings_add(&timings, TIMING_TEXTURE_PROBE, 0, start);
+
+    printf("textures: %zu (%zu tiled), up to %.1f MB decoded, largest %.1f "
+           "MB\n",
+           model_count, tiled, (double)decoded / (1024.0 * 1024.0),
+           (double)largest_frame / (1024.0 * 1024.0));
+
+    // Room for uploading every texture at once up to the default size, and
+    // always for the largest one
+    size_t ring_size =
+        first_frames < STAGING_RING_SIZE ? first_frames : STAGING_RING_SIZE;
+    if (ring_size < largest_frame + STAGING_RING_ALIGNMENT)
+        ring_size = largest_frame + STAGING_RING_ALIGNMENT;
+    staging_ring_init(&staging_ring, ring_size);
+}
+
+// Loads the models and their textures. File watches are not registered if
+// `watch_files` is 0, used for replays where file changes come from the
+// recording instead.
+static inline void setup_models(StringVector *model_filepaths,
+                                int watch_files) {
     model_count = model_filepaths->indices_used;
     assert(model_count);
     models = calloc(model_count, sizeof(Model));
     assert(models);
+    model_bounds = calloc(model_count, sizeof(BoundingBox));
+    assert(model_bounds);
+    voxel_meshers = calloc(model_count, sizeof(VoxelMesher));
+    assert(voxel_meshers);
+    mesh_histories = calloc(model_count, sizeof(VersionHistory));
+    texture_histories = calloc(model_count, sizeof(VersionHistory));
+    assert(mesh_histories && texture_histories);
+    model_load_starts = calloc(model_count, sizeof(*model_load_starts));
+    texture_load_starts = calloc(model_count, sizeof(*texture_load_starts));
+    assert(model_load_starts && texture_load_starts);
+    reload_txn_init(&reload_txns, model_count, reload_window, 0);
+    held_models = calloc(model_count, sizeof(Model));
+    held_textures = calloc(model_count, sizeof(Texture));
+    assert(held_models && held_textures);
+    tiled_textures = calloc(model_count, sizeof(TiledTexture));
+    tiled_uploads_pending = calloc(model_count, sizeof(atomic_int));
+    assert(tiled_textures && tiled_uploads_pending);
+    for (size_t i = 0; i < model_count; i++)
+        tiled_texture_init(tiled_textures + i);
+    draw_list_init(&draw_list, model_count);
+    for (size_t i = 0; i < model_count; i++) {
+        version_history_init(mesh_histories + i, history_capacity);
+        version_history_init(texture_histories + i, history_capacity);
+    }
+
+    discover_textures(model_filepaths);
+    plan_textures(model_filepaths);
 
+    char texture_filepath[PATH_MAX] = {0};
     for (size_t i = 0; i < model_count; i++) {
         char *model_filepath = stringvec_get(model_filepaths, i);
         if (!model_filepath)
             break;
 
-        firewatch_new_file(model_filepath, i, &load_model, 0);
-        load_model(model_filepath, i);
+        if (watch_files)
+            watch_file(model_filepath, i, &model_changed);
+        else
+            load_model(model_filepath, i);
+
+        // Drawn untextured
+        if (write_texture_filepath(texture_filepath, sizeof(texture_filepath),
+                                   model_filepaths, i))
+            continue;
+        if (watch_files)
+            watch_file(texture_filepath, i, &texture_changed);
+        else
+            load_texture(texture_filepath, i);
+    }
+    reloads_grouped = watch_files;
+}
+
+// Spreads `light_count` lights over the models for the lit preview.
+static inline void setup_lights(size_t light_count) {
+    light_shader = light_shader_load();
+
+    BoundingBox bounds = model_bounds[0];
+    for (size_t i = 1; i < model_count; i++) {
+        bounds.min = Vector3Min(bounds.min, model_bounds[i].min);
+        bounds.max = Vector3Max(bounds.max, model_bounds[i].max);
+    }
+    light_orbit_center = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5f);
+    light_set_scatter(&light_set, bounds, light_count, 1);
+
+    // Sizes the culled light lists so that drawing does not allocate
+    light_set_cull(&light_set, model_bounds, model_count, MatrixIdentity());
+}
+
+// Shows the version of the model at `model_index` selected in its history.
+static inline void restore_mesh(uint64_t model_index) {
+    VersionHistory *history = mesh_histories + model_index;
+    const AssetVersion *version =
+        version_history_get(history, history->shown);
+    Mesh mesh = version_history_read_mesh(version);
+    if (!mesh.vertexCount) {
+        fprintf(stderr, "ERROR: could not restore version %llu of model %zu\n",
+                (unsigned long long)version->number, (size_t)model_index);
+        return;
+    }
+    UploadMesh(&mesh, false);
+    set_model(model_index, LoadModelFromMesh(mesh));
+    update_memory_metrics();
+}
+
+// Shows the version of the texture of the model at `model_index` selected in
+// its history. Decompressed on the CPU, as it reads back what it writes, and
+// uploaded into the current texture if it has the same size.
+static inline void restore_texture(uint64_t model_index) {
+    VersionHistory *history = texture_histories + model_index;
+    const AssetVersion *version =
+        version_history_get(history, history->shown);
+    Texture current =
+        models[model_index].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture;
+
+    uint8_t *pixels = malloc(version->raw_size);
+    assert(pixels);
+    if (version_history_read(version, pixels)) {
+        fprintf(stderr, "ERROR: could not restore texture of model %zu\n",
+                (size_t)model_index);
+        free(pixels);
+        return;
+    }
+    set_texture(model_index, upload_pixels(pixels, version->width,
+                                           version->height, current));
+    free(pixels);
+    update_memory_metrics();
+}
+
+// Steps every model and texture to its previous (`direction` 1) or next (-1)
+// version, where there is one. Nothing is read from disk.
+static inline void step_versions(int direction) {
+    AllocCount start = alloc_track_total();
+    for (size_t i = 0; i < model_count; i++) {
+        if (version_history_step(mesh_histories + i, direction))
+            restore_mesh(i);
+        if (version_history_step(texture_histories + i, direction))
+            restore_texture(i);
+    }
+
+    size_t compressed_bytes = 0;
+    for (size_t i = 0; i < model_count; i++)
+        compressed_bytes += mesh_histories[i].compressed_bytes +
+                            texture_histories[i].compressed_bytes;
+    if (model_count)
+        printf("version: mesh -%zu of %zu, texture -%zu of %zu, %.1f MB "
+               "kept\n",
+               mesh_histories[0].shown, mesh_histories[0].count,
+               texture_histories[0].shown, texture_histories[0].count,
+               (double)compressed_bytes / (1024.0 * 1024.0));
+    end_reload(start);
+}
+
+// Loads the scans as point clouds, building their octrees on every processor
+// where not cached. Returns the bounds of the clouds.
+static inline BoundingBox setup_point_clouds(StringVector *scan_filepaths) {
+    point_cloud_count = scan_filepaths->indices_used;
+    point_clouds = calloc(point_cloud_count, sizeof(PointCloud));
+    assert(point_clouds);
+
+    BoundingBox bounds = {0};
+    int bounds_set = 0;
+    size_t point_cloud_bytes = 0;
+    for (size_t i = 0; i < point_cloud_count; i++) {
+        char *scan_filepath = stringvec_get(scan_filepaths, i);
+        double start = timings_now();
+        if (point_cloud_load(point_clouds + i, scan_filepath, 0))
+            continue;
+        timings_add(&timings, TIMING_MESH_LOAD, scan_filepath, start);
+
+        const CloudNode *root = point_clouds[i].nodes;
+        BoundingBox root_bounds = {
+            {root->min[0], root->min[1], root->min[2]},
+            {root->min[0] + root->size, root->min[1] + root->size,
+             root->min[2] + root->size},
+        };
+        if (bounds_set) {
+            bounds.min = Vector3Min(bounds.min, root_bounds.min);
+            bounds.max = Vector3Max(bounds.max, root_bounds.max);
+        } else {
+            bounds = root_bounds;
+            bounds_set = 1;
+        }
+        metrics_count(point_clouds[i].built ? METRIC_OCTREE_CACHE_MISSES
+                                            : METRIC_OCTREE_CACHE_HITS,
+                      1);
+        point_cloud_bytes += point_clouds[i].point_count * sizeof(CloudPoint) +
+                             point_clouds[i].node_count * sizeof(CloudNode);
+        printf("point cloud %s: %llu points, %zu nodes%s\n", scan_filepath,
+               (unsigned long long)point_clouds[i].point_count,
+               point_clouds[i].node_count,
+               point_clouds[i].built ? ", built" : "");
+    }
+    metrics_set(METRIC_POINT_CLOUD_BYTES, point_cloud_bytes);
+    return bounds;
+}
+
+// Applies the layer keys in `flags` to the textures of every model: selects
+// the previous or next layer, toggles the visibility of the selected layer or
+// shows it alone.
+static inline void update_layer_preview(StringVector *model_filepaths,
+                                        uint32_t flags) {
+    if (!layer_caches) {
+        layer_caches = calloc(model_count, sizeof(LayerCache));
+        assert(layer_caches);
+    }
+
+    char texture_filepath[PATH_MAX] = {0};
+    int layer_count = 0;
+    for (size_t i = 0; i < model_count; i++) {
+        LayerCache *cache = layer_caches + i;
+        if (!cache->ase) {
+            if (write_texture_filepath(texture_filepath,
+                                       sizeof(texture_filepath),
+                                       model_filepaths, i) ||
+                !path_is_aseprite_texture(texture_filepath))
+                continue;
 
-        char *texture_filepath =
-            path_get_corresponding_texture_file(model_filepath);
-        assert(texture_filepath);
+            ase_t *ase = ase_compose_load(texture_filepath);
+            if (!ase)
+                continue;
+            // Layers of tiled canvases are not previewed
+            if (tiled_texture_needed(ase->w, ase->h, max_texture_size)) {
+                cute_aseprite_free(ase);
+                continue;
+            }
+            if (layer_cache_init(cache, ase, 0))
+                continue;
+        }
+        if (layer_cache_layer_count(cache) > layer_count)
+            layer_count = layer_cache_layer_count(cache);
+    }
+
+    int previous_layer = selected_layer;
+    if ((flags & REPLAY_KEY_LAYER_PREVIOUS) && selected_layer > 0)
+        selected_layer--;
+    if ((flags & REPLAY_KEY_LAYER_NEXT) && selected_layer + 1 < layer_count)
+        selected_layer++;
+
+    for (size_t i = 0; i < model_count; i++) {
+        LayerCache *cache = layer_caches + i;
+        if (!cache->ase || selected_layer >= layer_cache_layer_count(cache))
+            continue;
 
-        firewatch_new_file(texture_filepath, i, &load_texture, 0);
-        load_texture(texture_filepath, i);
+        if (flags & REPLAY_KEY_LAYER_VISIBILITY)
+            layer_cache_set_visible(
+                cache, selected_layer,
+                !layer_cache_visible(cache, selected_layer));
+        if (flags & REPLAY_KEY_LAYER_SOLO)
+            layer_cache_set_solo(cache, cache->solo_layer == selected_layer
+                                            ? -1
+                                            : selected_layer);
+        else if (cache->solo_layer >= 0 && selected_layer != previous_layer)
+            layer_cache_set_solo(cache, selected_layer);
 
-        free(texture_filepath);
+        Texture current =
+            models[i].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture;
+        set_texture(i, layer_cache_upload(cache, &staging_ring, current));
+        metrics_count(METRIC_LAYER_CACHE_HITS,
+                      (uint64_t)(cache->cel_count - cache->cels_composited));
+        metrics_count(METRIC_LAYER_CACHE_MISSES,
+                      (uint64_t)cache->cels_composited);
     }
+
+    if (layer_caches[0].ase && selected_layer < layer_count)
+        printf("layer %d: %s%s%s\n", selected_layer,
+               layer_cache_layer_name(layer_caches, selected_layer),
+               layer_cache_visible(layer_caches, selected_layer)
+                   ? ""
+                   : " (hidden)",
+               layer_caches[0].solo_layer >= 0 ? " (solo)" : "");
+}
+
+static inline void unload_layer_caches(void) {
+    if (!layer_caches)
+        return;
+    for (size_t i = 0; i < model_count; i++)
+        layer_cache_free(layer_caches + i);
+    free(layer_caches);
+    layer_caches = 0;
 }
 
 static inline void unload_models(void) {
@@ -125,9 +1157,301 @@ static inline void unload_models(void) {
     }
 }
 
+static void defer_window_resize(GLFWwindow *window, int width, int height) {
+    (void)window;
+    pthread_mutex_lock(&pending_resize_lock);
+    pending_window_resize = (PendingResize){1, width, height};
+    pthread_mutex_unlock(&pending_resize_lock);
+}
+
+static void defer_framebuffer_resize(GLFWwindow *window, int width,
+                                     int height) {
+    (void)window;
+    pthread_mutex_lock(&pending_resize_lock);
+    pending_framebuffer_resize = (PendingResize){1, width, height};
+    pthread_mutex_unlock(&pending_resize_lock);
+}
+
+// Runs the resize callbacks deferred by the main thread. Called on the render
+// thread.
+static inline void apply_pending_resizes(GLFWwindow *window) {
+    pthread_mutex_lock(&pending_resize_lock);
+    PendingResize window_resize = pending_window_resize;
+    PendingResize framebuffer_resize = pending_framebuffer_resize;
+    pending_window_resize.pending = 0;
+    pending_framebuffer_resize.pending = 0;
+    pthread_mutex_unlock(&pending_resize_lock);
+
+    if (window_resize.pending && raylib_window_size_callback)
+        (*raylib_window_size_callback)(window, window_resize.width,
+                                       window_resize.height);
+    if (framebuffer_resize.pending && raylib_framebuffer_size_callback)
+        (*raylib_framebuffer_size_callback)(window, framebuffer_resize.width,
+                                            framebuffer_resize.height);
+}
+
+// Starts timing `scope` on the GPU if enabled. Draws what rlgl has batched
+// first so that it is not counted.
+static inline void gpu_scope_begin(size_t scope) {
+    if (!gpu_frame_timed)
+        return;
+    rlDrawRenderBatchActive();
+    gpu_timer_begin(&gpu_timer, scope);
+}
+
+static inline void gpu_scope_end(size_t scope) {
+    if (!gpu_frame_timed)
+        return;
+    rlDrawRenderBatchActive();
+    gpu_timer_end(&gpu_timer, scope);
+}
+
+// Lists the scopes taking the most GPU time lately, in the top left corner.
+static inline void draw_gpu_overlay(void) {
+    gpu_timer_rank(&gpu_timer);
+    DrawText("GPU ms", 10, 10, 20, RAYWHITE);
+    int y = 34;
+    for (size_t i = 0; i < gpu_timer.scope_count && i < GPU_OVERLAY_ROWS;
+         i++) {
+        size_t scope = gpu_timer.order[i];
+        GpuTimerStats *stats = gpu_timer.stats + scope;
+        if (!stats->samples)
+            break;
+        DrawText(TextFormat("%7.3f  %s", stats->recent_ms,
+                            gpu_scope_names[scope]),
+                 10, y, 10, RAYWHITE);
+        y += 14;
+    }
+}
+
+// Draws the models between BeginDrawing and the end of the frame.
+static inline void draw_scene(const SceneSnapshot *scene) {
+    gpu_frame_timed = gpu_timings_enabled || scene->gpu_overlay_enabled;
+    if (gpu_frame_timed) {
+        if (!gpu_timer.scope_count)
+            gpu_timer_init(&gpu_timer,
+                           GPU_SCOPE_MODELS + model_count + point_cloud_count,
+                           0);
+        gpu_timer_begin_frame(&gpu_timer);
+    }
+
+    if (scene->window_focused)
+        ClearBackground((Color){0x48, 0x48, 0x48, 0xff});
+    else
+        ClearBackground(BLACK);
+
+    if (scene->lighting_enabled) {
+        // The lights circle the scene
+        Matrix orbit = MatrixMultiply(
+            MatrixMultiply(MatrixTranslate(-light_orbit_center.x,
+                                           -light_orbit_center.y,
+                                           -light_orbit_center.z),
+                           MatrixRotateY(
+                               (float)(scene->time * LIGHT_ORBIT_SPEED))),
+            MatrixTranslate(light_orbit_center.x, light_orbit_center.y,
+                            light_orbit_center.z));
+        light_set_cull(&light_set, model_bounds, model_count, orbit);
+        light_set_upload(&light_set);
+    }
+
+    BeginMode3D(scene->camera);
+
+    PointCloudView view =
+        point_cloud_view(scene->camera, GetScreenWidth(), GetScreenHeight());
+    size_t visible_count = draw_list_cull(&draw_list, &view);
+    // The models are drawn as in DrawMesh, with the identity transform
+    Matrix mvp =
+        MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    // Whether the list's shader is bound, undone by any other draw
+    int list_bound = 0;
+    for (size_t v = 0; v < visible_count; v++) {
+        size_t i = draw_list.visible[v];
+
+        // Tiled textures are drawn unlit
+        int own_shader =
+            draw_list.flags[i] & DRAW_LIST_TILED || scene->lighting_enabled;
+        // The timer scopes flush raylib's batch, which binds its own state
+        if (list_bound && (own_shader || gpu_frame_timed)) {
+            draw_list_end(&draw_list);
+            list_bound = 0;
+        }
+
+        gpu_scope_begin(GPU_SCOPE_MODELS + i);
+        if (draw_list.flags[i] & DRAW_LIST_TILED) {
+            tiled_texture_draw(&tiled_shader, tiled_textures + i,
+                               models[i].meshes[0], models[i].materials[0]);
+        } else if (scene->lighting_enabled) {
+            light_shader_draw(&light_shader, &light_set, i,
+                              models[i].meshes[0], models[i].materials[0]);
+        } else {
+            if (!list_bound)
+                draw_list_begin(&draw_list, shader, mvp);
+            list_bound = 1;
+            draw_list_draw(&draw_list, i);
+        }
+        gpu_scope_end(GPU_SCOPE_MODELS + i);
+    }
+    if (list_bound)
+        draw_list_end(&draw_list);
+
+    // Drawn after the models so that the pass is timed as a whole
+    if (scene->wireframe_enabled && model_count) {
+        gpu_scope_begin(GPU_SCOPE_WIREFRAME);
+        for (size_t i = 0; i < model_count; i++)
+            DrawModelWires(models[i], Vector3Zero(), 1.0f, BLACK);
+        gpu_scope_end(GPU_SCOPE_WIREFRAME);
+    }
+
+    for (size_t i = 0; i < point_cloud_count; i++) {
+        gpu_scope_begin(GPU_SCOPE_MODELS + model_count + i);
+        point_cloud_draw(point_clouds + i, scene->camera,
+                         point_budget / point_cloud_count);
+        gpu_scope_end(GPU_SCOPE_MODELS + model_count + i);
+    }
+
+    if (scene->grid_enabled) {
+        gpu_scope_begin(GPU_SCOPE_GRID);
+        DrawGrid(20, 1.0f);
+        gpu_scope_end(GPU_SCOPE_GRID);
+    }
+
+    EndMode3D();
+
+    if (scene->gpu_overlay_enabled)
+        draw_gpu_overlay();
+}
+
+// Draws the latest scene snapshot until render_thread_stopping is set. Also
+// commits the finished loads, which need the GL context.
+static void *render_thread_main(void *arg) {
+    (void)arg;
+    GLFWwindow *window = GetWindowHandle();
+    glfwMakeContextCurrent(window);
+
+    SceneSnapshot scene = {0};
+    double frame_start = GetTime();
+    while (!atomic_load(&render_thread_stopping)) {
+        scene_snapshot_read(&scene_snapshots, &scene);
+        apply_pending_resizes(window);
+        apply_finished_loads();
+
+        BeginDrawing();
+        draw_scene(&scene);
+        // Instead of EndDrawing, which would also poll input
+        rlDrawRenderBatchActive();
+        SwapScreenBuffer();
+
+        double remaining = 1.0 / RENDER_THREAD_FPS - (GetTime() - frame_start);
+        if (remaining > 0.0)
+            WaitTime(remaining);
+        double frame_end = GetTime();
+        metrics_observe(METRIC_FRAME_SECONDS, frame_end - frame_start);
+        frame_start = frame_end;
+    }
+
+    glfwMakeContextCurrent(0);
+    return 0;
+}
+
+// Hands the GL context over to a new render thread. Returns 0 on success.
+static inline int render_thread_start(const SceneSnapshot *initial) {
+    scene_snapshot_init(&scene_snapshots, initial);
+
+    GLFWwindow *window = GetWindowHandle();
+    raylib_window_size_callback =
+        glfwSetWindowSizeCallback(window, &defer_window_resize);
+    raylib_framebuffer_size_callback =
+        glfwSetFramebufferSizeCallback(window, &defer_framebuffer_resize);
+
+    glfwMakeContextCurrent(0);
+    atomic_store(&render_thread_stopping, 0);
+    if (pthread_create(&render_thread, 0, &render_thread_main, 0)) {
+        glfwMakeContextCurrent(window);
+        glfwSetWindowSizeCallback(window, raylib_window_size_callback);
+        glfwSetFramebufferSizeCallback(window,
+                                       raylib_framebuffer_size_callback);
+        scene_snapshot_free(&scene_snapshots);
+        return 1;
+    }
+    return 0;
+}
+
+// Joins the render thread and takes the GL context back.
+static inline void render_thread_stop(void) {
+    atomic_store(&render_thread_stopping, 1);
+    pthread_join(render_thread, 0);
+
+    GLFWwindow *window = GetWindowHandle();
+    glfwMakeContextCurrent(window);
+    glfwSetWindowSizeCallback(window, raylib_window_size_callback);
+    glfwSetFramebufferSizeCallback(window, raylib_framebuffer_size_callback);
+    scene_snapshot_free(&scene_snapshots);
+}
+
+// Reads the input of the current frame from raylib.
+static inline ReplayFrame poll_input(void) {
+    ReplayFrame input = {
+        .time = GetTime(),
+        .mouse_delta = GetMouseDelta(),
+        .wheel = GetMouseWheelMove(),
+    };
+
+    if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE))
+        input.flags |= REPLAY_MOUSE_MIDDLE_PRESSED;
+    if (IsMouseButtonReleased(MOUSE_BUTTON_MIDDLE))
+        input.flags |= REPLAY_MOUSE_MIDDLE_RELEASED;
+    if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE))
+        input.flags |= REPLAY_MOUSE_MIDDLE_DOWN;
+    if (IsKeyPressed(KEY_G))
+        input.flags |= REPLAY_KEY_GRID;
+    if (IsKeyPressed(KEY_W))
+        input.flags |= REPLAY_KEY_WIREFRAME;
+    if (IsKeyPressed(KEY_B))
+        input.flags |= REPLAY_KEY_RESET_CAMERA;
+    if (IsKeyPressed(KEY_PAGE_UP))
+        input.flags |= REPLAY_KEY_LAYER_PREVIOUS;
+    if (IsKeyPressed(KEY_PAGE_DOWN))
+        input.flags |= REPLAY_KEY_LAYER_NEXT;
+    if (IsKeyPressed(KEY_V))
+        input.flags |= REPLAY_KEY_LAYER_VISIBILITY;
+    if (IsKeyPressed(KEY_O))
+        input.flags |= REPLAY_KEY_LAYER_SOLO;
+    if (IsKeyPressed(KEY_L))
+        input.flags |= REPLAY_KEY_LIGHTING;
+    if (IsKeyPressed(KEY_LEFT))
+        input.flags |= REPLAY_KEY_VERSION_PREVIOUS;
+    if (IsKeyPressed(KEY_RIGHT))
+        input.flags |= REPLAY_KEY_VERSION_NEXT;
+    if (IsKeyPressed(KEY_F3))
+        input.flags |= REPLAY_KEY_GPU_OVERLAY;
+
+    return input;
+}
+
 int main(int argc, char **argv) {
+    double startup_start = timings_now();
     StringVector model_filepaths = stringvec_init();
     int grid_enabled = 1;
+    int wireframe_enabled = 0;
+    int lighting_enabled = 0;
+    int gpu_overlay_enabled = 0;
+    size_t light_count = LIGHT_COUNT;
+    const char *record_filepath = 0;
+    const char *replay_filepath = 0;
+    int use_upload_thread = 0;
+    int use_render_thread = 0;
+    int use_point_clouds = 0;
+    const char *capture_directory = 0;
+    CaptureFormat capture_format = CAPTURE_FORMAT_QOI;
+    const char *metrics_filepath = 0;
+    const char *cache_directory = 0;
+    uint64_t cache_capacity = DISK_CACHE_CAPACITY;
+    double metrics_interval = METRICS_EXPORT_INTERVAL;
+    // 0 captures one turn of the turntable, or the whole replay
+    size_t capture_frames = 0;
+    int window_width = 800;
+    int window_height = 450;
+    discovery_parse_patterns(&sidecar_patterns, DISCOVERY_DEFAULT_PATTERNS);
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "-skybox")) {
@@ -135,6 +1459,138 @@ int main(int argc, char **argv) {
             continue;
         }
 
+        if (!strcmp(argv[i], "-upload-thread")) {
+            use_upload_thread = 1;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-render-thread")) {
+            use_render_thread = 1;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-lit")) {
+            lighting_enabled = 1;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-lights") && i + 1 < argc) {
+            light_count = strtoull(argv[++i], 0, 10);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-pointcloud")) {
+            use_point_clouds = 1;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-point-budget") && i + 1 < argc) {
+            point_budget = strtoull(argv[++i], 0, 10);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-history") && i + 1 < argc) {
+            history_capacity = strtoull(argv[++i], 0, 10);
+            if (history_capacity > VERSION_HISTORY_MAX)
+                history_capacity = VERSION_HISTORY_MAX;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-timings")) {
+            timings.enabled = 1;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-gpu-timings")) {
+            gpu_timings_enabled = 1;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-max-texture-size") && i + 1 < argc) {
+            max_texture_size = atoi(argv[++i]);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-reload-window") && i + 1 < argc) {
+            reload_window = strtod(argv[++i], 0);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-sidecar") && i + 1 < argc) {
+            // Comma separated, e.g. ".ase,.png"
+            if (discovery_parse_patterns(&sidecar_patterns, argv[++i])) {
+                fprintf(stderr, "Error: invalid sidecar patterns \"%s\".\n",
+                        argv[i]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-cache") && i + 1 < argc) {
+            cache_directory = argv[++i];
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-cache-size") && i + 1 < argc) {
+            // In megabytes
+            cache_capacity = strtoull(argv[++i], 0, 10) * 1024 * 1024;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-metrics") && i + 1 < argc) {
+            metrics_filepath = argv[++i];
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-metrics-interval") && i + 1 < argc) {
+            metrics_interval = strtod(argv[++i], 0);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-record") && i + 1 < argc) {
+            record_filepath = argv[++i];
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-replay") && i + 1 < argc) {
+            replay_filepath = argv[++i];
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-capture") && i + 1 < argc) {
+            capture_directory = argv[++i];
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-capture-format") && i + 1 < argc) {
+            i++;
+            if (!strcmp(argv[i], "qoi"))
+                capture_format = CAPTURE_FORMAT_QOI;
+            else if (!strcmp(argv[i], "png"))
+                capture_format = CAPTURE_FORMAT_PNG;
+            else {
+                fprintf(stderr, "Error: unsupported capture format \"%s\".\n",
+                        argv[i]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-capture-frames") && i + 1 < argc) {
+            capture_frames = strtoull(argv[++i], 0, 10);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-capture-size") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &window_width, &window_height) != 2 ||
+                window_width <= 0 || window_height <= 0) {
+                fprintf(stderr, "Error: invalid capture size \"%s\".\n",
+                        argv[i]);
+                return 1;
+            }
+            continue;
+        }
+
         if (*argv[i] == '-') {
             fprintf(stderr, "Unsupported command-line option \"%s\"", argv[i]);
             return 1;
@@ -143,17 +1599,132 @@ int main(int argc, char **argv) {
         stringvec_append(&model_filepaths, argv[i], strlen(argv[i]));
     }
 
+    if (record_filepath && replay_filepath) {
+        fprintf(stderr, "Error: -record and -replay are mutually exclusive.\n");
+        return 1;
+    }
+
+    // Replays load files from the frame loop, which needs the GL context
+    if (use_render_thread && replay_filepath) {
+        fprintf(stderr,
+                "Error: -render-thread and -replay are mutually exclusive.\n");
+        return 1;
+    }
+
+    // Versions are only switched between without the render thread, whose
+    // frames would stall on recording them
+    if (use_render_thread)
+        history_capacity = 0;
+
+    // Frames are read back between drawing and swapping on the main thread
+    if (use_render_thread && capture_directory) {
+        fprintf(stderr,
+                "Error: -render-thread and -capture are mutually exclusive.\n");
+        return 1;
+    }
+
+    ReplayLog replay = {0};
+    if (replay_filepath) {
+        if (replay_log_load(&replay, replay_filepath)) {
+            fprintf(stderr, "Error: could not read replay file %s.\n",
+                    replay_filepath);
+            return 1;
+        }
+        grid_enabled = replay.grid_enabled;
+        wireframe_enabled = replay.wireframe_enabled;
+
+        // Use the models of the recorded session unless overridden
+        if (!stringvec_count(&model_filepaths)) {
+            for (size_t i = 0; i < replay.model_count; i++)
+                stringvec_append(&model_filepaths, replay.model_filepaths[i],
+                                 strlen(replay.model_filepaths[i]));
+        }
+    }
+
     if (!stringvec_count(&model_filepaths)) {
         fprintf(stderr, "Error: No model files were supplied as arguments.\n");
         return 1;
     }
+    timings_add(&timings, TIMING_ARGUMENTS, 0, startup_start);
 
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
-    InitWindow(800, 450, "Bricklayer");
-    SetTargetFPS(60);
+    double phase_start = timings_now();
+    // The render thread is paced by vsync where available. Captured frames
+    // keep the size they start with.
+    SetConfigFlags((capture_directory ? 0 : FLAG_WINDOW_RESIZABLE) |
+                   (use_render_thread ? FLAG_VSYNC_HINT : 0));
+    InitWindow(window_width, window_height, "Bricklayer");
+    // Replays run uncapped so that the frame times reflect the actual work
+    SetTargetFPS(replay_filepath ? 0 : 60);
+    timings_add(&timings, TIMING_WINDOW, 0, phase_start);
 
+    phase_start = timings_now();
     shader = LoadShaderFromMemory(vertex_shader, 0);
-    setup_models(&model_filepaths);
+    tiled_shader = tiled_shader_load();
+    // Canvases larger than this are tiled, -max-texture-size can only lower it
+    int gl_max_texture_size = tiled_texture_max_size();
+    if (max_texture_size <= 0 || max_texture_size > gl_max_texture_size)
+        max_texture_size = gl_max_texture_size;
+    timings_add(&timings, TIMING_SHADER, 0, phase_start);
+
+    if (cache_directory) {
+        disk_cache_enabled =
+            !disk_cache_open(&disk_cache, cache_directory, cache_capacity);
+        if (disk_cache_enabled && disk_cache_start(&disk_cache, 0))
+            fprintf(stderr, "ERROR: could not start compacting the cache, it "
+                            "may grow past its size\n");
+    }
+
+    // Point clouds have no textures or lights, and are not reloaded
+    BoundingBox point_cloud_bounds = {0};
+    if (use_point_clouds) {
+        point_cloud_bounds = setup_point_clouds(&model_filepaths);
+    } else {
+        setup_models(&model_filepaths, !replay_filepath);
+        setup_lights(light_count);
+    }
+
+    // Scopes are named after the passes and files
+    size_t scene_object_count = model_count + point_cloud_count;
+    gpu_scope_names =
+        malloc((GPU_SCOPE_MODELS + scene_object_count) * sizeof(char *));
+    assert(gpu_scope_names);
+    gpu_scope_names[GPU_SCOPE_GRID] = "grid";
+    gpu_scope_names[GPU_SCOPE_WIREFRAME] = "wireframe";
+    for (size_t i = 0; i < scene_object_count; i++)
+        gpu_scope_names[GPU_SCOPE_MODELS + i] =
+            stringvec_get(&model_filepaths, i);
+
+    if (metrics_filepath &&
+        metrics_export_start(metrics_filepath, metrics_interval))
+        fprintf(stderr, "ERROR: could not start writing metrics to %s\n",
+                metrics_filepath);
+
+    if (timings.enabled) {
+        timings_print(&timings, timings_now() - startup_start, stdout);
+        // Reloads are not part of startup
+        timings.enabled = 0;
+    }
+
+    // The initial loads above are done synchronously so that every model is
+    // drawable from the first frame, reloads go through the loader thread.
+    // The render thread needs it, the main thread has no GL context to load
+    // on.
+    if ((use_upload_thread || use_render_thread) && gl_loader_start()) {
+        fprintf(stderr, "ERROR: could not start the upload thread, loading "
+                        "on the render thread instead.\n");
+        use_render_thread = 0;
+    }
+
+    if (record_filepath) {
+        if (replay_recorder_open(&recorder, record_filepath, grid_enabled,
+                                 wireframe_enabled)) {
+            fprintf(stderr, "Error: could not open %s for recording.\n",
+                    record_filepath);
+            return 1;
+        }
+        for (size_t i = 0; i < model_count; i++)
+            replay_record_model(&recorder, stringvec_get(&model_filepaths, i));
+    }
 
     Camera starting_camera = {
         .position = (Vector3){0.0f, 1.0f, 3.0f},
@@ -161,60 +1732,252 @@ int main(int argc, char **argv) {
         .up = (Vector3){0.0f, 1.0f, 0.0f},
         .fovy = 45.0,
     };
+    if (use_point_clouds &&
+        point_cloud_bounds.max.x > point_cloud_bounds.min.x) {
+        // Scans are in their own units, the whole of them is in view
+        Vector3 center = Vector3Scale(
+            Vector3Add(point_cloud_bounds.min, point_cloud_bounds.max), 0.5f);
+        float extent =
+            Vector3Length(Vector3Subtract(point_cloud_bounds.max, center));
+        starting_camera.target = center;
+        starting_camera.position =
+            Vector3Add(center, (Vector3){0.0f, extent * 0.8f, extent * 2.4f});
+    }
     Camera camera = starting_camera;
 
-    int wireframe_enabled = 0;
+    if (use_render_thread) {
+        SceneSnapshot initial = {
+            .camera = camera,
+            .grid_enabled = grid_enabled,
+            .wireframe_enabled = wireframe_enabled,
+            .lighting_enabled = lighting_enabled,
+            .gpu_overlay_enabled = gpu_overlay_enabled,
+            .window_focused = IsWindowFocused(),
+            .time = GetTime(),
+        };
+        if (render_thread_start(&initial)) {
+            fprintf(stderr, "ERROR: could not start the render thread, "
+                            "drawing on the main thread instead.\n");
+            use_render_thread = 0;
+        }
+    }
+
+    Capture capture = {0};
+    if (capture_directory) {
+        if (capture_init(&capture, capture_directory, capture_format,
+                         GetRenderWidth(), GetRenderHeight(), 0))
+            return 1;
+        // Turntables make one full turn
+        if (!capture_frames && !replay_filepath)
+            capture_frames =
+                (size_t)(2.0 * PI / AUTO_ROTATE_SPEED * CAPTURE_FPS + 0.5);
+    }
+
+    // Frame times are only collected for replays, preallocated so that the
+    // frame loop does not allocate
+    FrameStats frame_stats = {0};
+    if (replay_filepath)
+        frame_stats = frame_stats_init(replay.frame_count);
+    size_t frame_index = 0;
+    size_t replay_frame = 0;
+    size_t replay_event = 0;
+    double frame_start = GetTime();
 
     while (!WindowShouldClose()) {
-        // Check for file changes
-        firewatch_check();
+        AllocCount frame_allocation_start = alloc_track_total();
+        reload_allocation_count = 0;
+        ReplayFrame input = {0};
 
-        if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE))
-            DisableCursor();
-        if (IsMouseButtonReleased(MOUSE_BUTTON_MIDDLE))
-            EnableCursor();
-        if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE)) {
-            orbital_camera_update(&camera, 0);
+        if (replay_filepath) {
+            if (replay_frame >= replay.frame_count)
+                break;
+
+            // Fire the file changes recorded for this frame
+            while (replay_event < replay.event_count &&
+                   replay.events[replay_event].frame <= replay_frame) {
+                ReplayFileEvent *event = replay.events + replay_event++;
+                if (event->cookie >= model_count)
+                    continue;
+                if (event->kind == REPLAY_EVENT_MODEL)
+                    load_model(event->filepath, event->cookie);
+                else
+                    load_texture(event->filepath, event->cookie);
+            }
+
+            input = replay.frames[replay_frame++];
+            camera.position = input.camera_position;
+            camera.target = input.camera_target;
+            camera.up = input.camera_up;
+        } else {
+            // Check for file changes
+            FirewatchStats firewatch = firewatch_stats();
+            metrics_set(METRIC_FIREWATCH_QUEUE_DEPTH, firewatch.queued);
+            metrics_store(METRIC_FIREWATCH_EVENTS, firewatch.events);
+            metrics_store(METRIC_FIREWATCH_DROPPED, firewatch.dropped);
+            firewatch_check();
+            if (reloads_grouped)
+                start_settled_reloads(&model_filepaths);
+
+            input = poll_input();
+
+            if (input.flags & REPLAY_MOUSE_MIDDLE_PRESSED)
+                DisableCursor();
+            if (input.flags & REPLAY_MOUSE_MIDDLE_RELEASED)
+                EnableCursor();
+            if (input.flags & REPLAY_MOUSE_MIDDLE_DOWN) {
+                orbital_camera_update(&camera, 0);
+            }
+            orbital_adjust_camera_zoom(&camera, input.wheel);
+
+            if (capture_directory) {
+                Vector3 offset = Vector3Subtract(camera.position, camera.target);
+                offset = Vector3RotateByAxisAngle(
+                    offset, camera.up, AUTO_ROTATE_SPEED / CAPTURE_FPS);
+                camera.position = Vector3Add(camera.target, offset);
+            }
         }
-        orbital_adjust_camera_zoom(&camera, GetMouseWheelMove());
 
-        if (IsKeyPressed(KEY_G))
+        if (input.flags & REPLAY_KEY_GRID)
             grid_enabled = !grid_enabled;
-        if (IsKeyPressed(KEY_W))
+        if (input.flags & REPLAY_KEY_WIREFRAME)
             wireframe_enabled = !wireframe_enabled;
-        if (IsKeyPressed(KEY_B))
+        if ((input.flags & REPLAY_KEY_LIGHTING) && model_count)
+            lighting_enabled = !lighting_enabled;
+        if (input.flags & REPLAY_KEY_GPU_OVERLAY)
+            gpu_overlay_enabled = !gpu_overlay_enabled;
+        if (input.flags & REPLAY_KEY_RESET_CAMERA)
             camera = starting_camera;
+        // Uploads the previews, which needs the GL context
+        if ((input.flags & (REPLAY_KEY_LAYER_PREVIOUS | REPLAY_KEY_LAYER_NEXT |
+                            REPLAY_KEY_LAYER_VISIBILITY |
+                            REPLAY_KEY_LAYER_SOLO)) &&
+            !use_render_thread && model_count)
+            update_layer_preview(&model_filepaths, input.flags);
+        // Uploads as well
+        if ((input.flags &
+             (REPLAY_KEY_VERSION_PREVIOUS | REPLAY_KEY_VERSION_NEXT)) &&
+            !use_render_thread && model_count)
+            step_versions(input.flags & REPLAY_KEY_VERSION_PREVIOUS ? 1 : -1);
 
-        // ----- Drawing -----
+        input.camera_position = camera.position;
+        input.camera_target = camera.target;
+        input.camera_up = camera.up;
+        replay_record_frame(&recorder, &input);
 
-        BeginDrawing();
+        SceneSnapshot frame_scene = {0};
+        SceneSnapshot *scene = use_render_thread
+                                   ? scene_snapshot_back(&scene_snapshots)
+                                   : &frame_scene;
+        scene->camera = camera;
+        scene->grid_enabled = grid_enabled;
+        scene->wireframe_enabled = wireframe_enabled;
+        scene->lighting_enabled = lighting_enabled;
+        scene->gpu_overlay_enabled = gpu_overlay_enabled;
+        scene->window_focused = IsWindowFocused();
+        scene->time = input.time;
 
-        if (IsWindowFocused())
-            ClearBackground((Color){0x48, 0x48, 0x48, 0xff});
-        else
-            ClearBackground(BLACK);
+        if (use_render_thread) {
+            scene_snapshot_publish(&scene_snapshots);
+            PollInputEvents();
+            WaitTime(1.0 / INPUT_POLL_RATE);
+        } else {
+            apply_finished_loads();
 
-        BeginMode3D(camera);
+            BeginDrawing();
+            draw_scene(scene);
+            if (capture_directory) {
+                rlDrawRenderBatchActive();
+                capture_read_frame(&capture);
+            }
+            EndDrawing();
+        }
 
-        for (size_t i = 0; i < model_count; i++) {
-            assert(models[i].meshCount);
+        double frame_end = GetTime();
+        if (replay_filepath)
+            frame_stats_add(&frame_stats, frame_end - frame_start);
+        // The render thread times its own frames
+        if (!use_render_thread)
+            metrics_observe(METRIC_FRAME_SECONDS, frame_end - frame_start);
+        frame_start = frame_end;
 
-            // DrawModel(models[i], Vector3Zero(), 1.0f, RAYWHITE);
-            DrawMesh(models[i].meshes[0], models[i].materials[0],
-                     MatrixIdentity());
-            if (wireframe_enabled)
-                DrawModelWires(models[i], Vector3Zero(), 1.0f, BLACK);
-        }
+        size_t frame_allocations =
+            alloc_track_since(frame_allocation_start).count -
+            reload_allocation_count;
+        if (frame_allocations && frame_index >= ALLOC_WARMUP_FRAMES)
+            fprintf(stderr,
+                    "WARNING: frame %zu made %zu allocations outside of "
+                    "reloads\n",
+                    frame_index, frame_allocations);
+        frame_index++;
+
+        if (capture_frames && capture.frame_count >= capture_frames)
+            break;
+    }
 
-        if (grid_enabled)
-            DrawGrid(20, 1.0f);
+    if (replay_filepath) {
+        printf("Replay of %s:\n", replay_filepath);
+        frame_stats_print(&frame_stats, stdout);
+    }
 
-        EndMode3D();
-        EndDrawing();
+    if (capture_directory) {
+        capture_finish(&capture, 1);
+        capture_print(&capture, stdout);
+        capture_free(&capture);
     }
 
+    metrics_export_stop();
+    if (disk_cache_enabled)
+        disk_cache_close(&disk_cache);
+    replay_recorder_close(&recorder);
+    replay_log_free(&replay);
+    frame_stats_free(&frame_stats);
+    timings_free(&timings);
+    if (use_render_thread)
+        render_thread_stop();
+    gl_loader_stop();
+    // The drawing thread is done with the timer
+    if (gpu_timings_enabled)
+        gpu_timer_print(&gpu_timer, gpu_scope_names, stdout);
+    if (gpu_timer.scope_count)
+        gpu_timer_free(&gpu_timer);
+    free(gpu_scope_names);
+    unload_layer_caches();
     unload_models();
+    light_set_free(&light_set);
+    light_shader_unload(&light_shader);
+    free(model_bounds);
+    free(texture_patterns);
+    draw_list_free(&draw_list);
+    for (size_t i = 0; i < model_count; i++)
+        voxel_mesher_free(voxel_meshers + i);
+    free(voxel_meshers);
+    for (size_t i = 0; i < model_count; i++) {
+        version_history_free(mesh_histories + i);
+        version_history_free(texture_histories + i);
+    }
+    free(mesh_histories);
+    free(texture_histories);
+    free(model_load_starts);
+    free(texture_load_starts);
+    for (size_t i = 0; i < model_count; i++) {
+        if (held_models[i].meshCount)
+            UnloadModel(held_models[i]);
+        if (held_textures[i].id)
+            UnloadTexture(held_textures[i]);
+    }
+    free(held_models);
+    free(held_textures);
+    for (size_t i = 0; i < model_count; i++)
+        tiled_texture_free(tiled_textures + i);
+    free(tiled_textures);
+    free(tiled_uploads_pending);
+    reload_txn_free(&reload_txns);
+    for (size_t i = 0; i < point_cloud_count; i++)
+        point_cloud_free(point_clouds + i);
+    free(point_clouds);
+    staging_ring_free(&staging_ring);
     stringvec_free(&model_filepaths);
+    tiled_shader_unload(&tiled_shader);
     UnloadShader(shader);
     CloseWindow();
 
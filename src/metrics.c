@@ -0,0 +1,375 @@
+#define _DEFAULT_SOURCE
+#include "metrics.h"
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#define METRICS_FILEPATH_MAX 4096
+
+// A metric of an OpenMetrics family, metrics of the same family differ by
+// their label
+typedef struct {
+    const char *family;
+    const char *help;
+    // Only for families named after their unit
+    const char *unit;
+    // `name="value"`, or 0
+    const char *label;
+} MetricInfo;
+
+typedef struct {
+    MetricInfo info;
+    double bounds[METRICS_MAX_BUCKETS];
+    int bound_count;
+} HistogramInfo;
+
+static const MetricInfo counter_infos[METRIC_COUNTER_COUNT] = {
+    [METRIC_MODEL_LOADS] = {"bricklayer_asset_loads",
+                            "Models and textures loaded.", 0,
+                            "kind=\"model\""},
+    [METRIC_TEXTURE_LOADS] = {"bricklayer_asset_loads",
+                              "Models and textures loaded.", 0,
+                              "kind=\"texture\""},
+    [METRIC_LOAD_FAILURES] = {"bricklayer_asset_load_failures",
+                              "Models and textures that failed to load.", 0,
+                              0},
+    [METRIC_FIREWATCH_EVENTS] = {"bricklayer_firewatch_events",
+                                 "Changes to watched files.", 0, 0},
+    [METRIC_FIREWATCH_DROPPED] = {"bricklayer_firewatch_dropped_events",
+                                  "File changes lost to an overflowing event "
+                                  "queue.",
+                                  0, 0},
+    [METRIC_DECODE_FILE_BYTES] = {"bricklayer_decode_bytes",
+                                  "Bytes of .aseprite files decoded, and of "
+                                  "their frames in RGBA.",
+                                  "bytes", "stage=\"file\""},
+    [METRIC_DECODE_PIXEL_BYTES] = {"bricklayer_decode_bytes",
+                                   "Bytes of .aseprite files decoded, and of "
+                                   "their frames in RGBA.",
+                                   "bytes", "stage=\"pixels\""},
+    [METRIC_DECODE_NANOSECONDS] = {"bricklayer_decode_seconds",
+                                   "Time spent decoding .aseprite files.",
+                                   "seconds", 0},
+    [METRIC_OCTREE_CACHE_HITS] = {"bricklayer_cache_hits",
+                                  "Work reused from a cache.", 0,
+                                  "cache=\"octree\""},
+    [METRIC_OCTREE_CACHE_MISSES] = {"bricklayer_cache_misses",
+                                    "Work redone for lack of a cache entry.",
+                                    0, "cache=\"octree\""},
+    [METRIC_VOXEL_BAND_HITS] = {"bricklayer_cache_hits",
+                                "Work reused from a cache.", 0,
+                                "cache=\"voxel_bands\""},
+    [METRIC_VOXEL_BAND_MISSES] = {"bricklayer_cache_misses",
+                                  "Work redone for lack of a cache entry.", 0,
+                                  "cache=\"voxel_bands\""},
+    [METRIC_LAYER_CACHE_HITS] = {"bricklayer_cache_hits",
+                                 "Work reused from a cache.", 0,
+                                 "cache=\"layers\""},
+    [METRIC_LAYER_CACHE_MISSES] = {"bricklayer_cache_misses",
+                                   "Work redone for lack of a cache entry.", 0,
+                                   "cache=\"layers\""},
+    [METRIC_DISK_CACHE_HITS] = {"bricklayer_cache_hits",
+                                "Work reused from a cache.", 0,
+                                "cache=\"disk\""},
+    [METRIC_DISK_CACHE_MISSES] = {"bricklayer_cache_misses",
+                                  "Work redone for lack of a cache entry.", 0,
+                                  "cache=\"disk\""},
+    [METRIC_DISK_CACHE_EVICTIONS] = {"bricklayer_disk_cache_evictions",
+                                     "Entries removed from the on-disk cache "
+                                     "to stay under its cap.",
+                                     0, 0},
+};
+
+static const MetricInfo gauge_infos[METRIC_GAUGE_COUNT] = {
+    [METRIC_FIREWATCH_QUEUE_DEPTH] = {"bricklayer_firewatch_queue_depth",
+                                      "File changes waiting to be handled.",
+                                      0, 0},
+    [METRIC_MESH_BYTES] = {"bricklayer_asset_memory_bytes",
+                           "Memory held by each class of asset.", "bytes",
+                           "class=\"mesh\""},
+    [METRIC_TEXTURE_BYTES] = {"bricklayer_asset_memory_bytes",
+                              "Memory held by each class of asset.", "bytes",
+                              "class=\"texture\""},
+    [METRIC_HISTORY_BYTES] = {"bricklayer_asset_memory_bytes",
+                              "Memory held by each class of asset.", "bytes",
+                              "class=\"history\""},
+    [METRIC_POINT_CLOUD_BYTES] = {"bricklayer_asset_memory_bytes",
+                                  "Memory held by each class of asset.",
+                                  "bytes", "class=\"point_cloud\""},
+    [METRIC_DISK_CACHE_BYTES] = {"bricklayer_disk_cache_bytes",
+                                 "Size of the on-disk asset cache.", "bytes",
+                                 0},
+};
+
+static const HistogramInfo histogram_infos[METRIC_HISTOGRAM_COUNT] = {
+    [METRIC_FRAME_SECONDS] = {{"bricklayer_frame_seconds", "Frame times.",
+                               "seconds", 0},
+                              {0.002, 0.004, 0.008, 0.012, 0.017, 0.025, 0.033,
+                               0.05, 0.1, 0.25, 1.0},
+                              11},
+    [METRIC_MODEL_LOAD_SECONDS] = {{"bricklayer_asset_load_seconds",
+                                    "Time from a file change to the new "
+                                    "version being drawn.",
+                                    "seconds", "kind=\"model\""},
+                                   {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25,
+                                    0.5, 1.0, 2.5, 10.0},
+                                   11},
+    [METRIC_TEXTURE_LOAD_SECONDS] = {{"bricklayer_asset_load_seconds",
+                                      "Time from a file change to the new "
+                                      "version being drawn.",
+                                      "seconds", "kind=\"texture\""},
+                                     {0.001, 0.005, 0.01, 0.025, 0.05, 0.1,
+                                      0.25, 0.5, 1.0, 2.5, 10.0},
+                                     11},
+};
+
+typedef struct {
+    // Observations per bucket, not cumulative, the last one for +Inf
+    atomic_uint_fast64_t buckets[METRICS_MAX_BUCKETS + 1];
+    atomic_uint_fast64_t sum_nanoseconds;
+} Histogram;
+
+static atomic_uint_fast64_t counters[METRIC_COUNTER_COUNT];
+static atomic_uint_fast64_t gauges[METRIC_GAUGE_COUNT];
+static Histogram histograms[METRIC_HISTOGRAM_COUNT];
+
+static pthread_t export_thread = {0};
+static pthread_mutex_t export_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t export_wake = PTHREAD_COND_INITIALIZER;
+static int export_running = 0;
+static int export_stopping = 0;
+static double export_interval = METRICS_EXPORT_INTERVAL;
+static char export_filepath[METRICS_FILEPATH_MAX] = {0};
+
+void metrics_count(MetricCounter counter, uint64_t amount) {
+    atomic_fetch_add_explicit(counters + counter, amount,
+                              memory_order_relaxed);
+}
+
+void metrics_store(MetricCounter counter, uint64_t value) {
+    atomic_store_explicit(counters + counter, value, memory_order_relaxed);
+}
+
+void metrics_set(MetricGauge gauge, uint64_t value) {
+    atomic_store_explicit(gauges + gauge, value, memory_order_relaxed);
+}
+
+void metrics_observe(MetricHistogram histogram, double seconds) {
+    const HistogramInfo *info = histogram_infos + histogram;
+    int bucket = 0;
+    while (bucket < info->bound_count && seconds > info->bounds[bucket])
+        bucket++;
+    Histogram *state = histograms + histogram;
+    atomic_fetch_add_explicit(state->buckets + bucket, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(
+        &state->sum_nanoseconds,
+        seconds > 0.0 ? (uint64_t)(seconds * 1e9 + 0.5) : 0,
+        memory_order_relaxed);
+}
+
+void metrics_reset(void) {
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+        atomic_store(counters + i, 0);
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++)
+        atomic_store(gauges + i, 0);
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        for (int j = 0; j <= METRICS_MAX_BUCKETS; j++)
+            atomic_store(histograms[i].buckets + j, 0);
+        atomic_store(&histograms[i].sum_nanoseconds, 0);
+    }
+}
+
+// 1 if a metric before `index` in `infos` is of the same family, which has
+// been written with it.
+static inline int family_written(const MetricInfo *infos, size_t stride,
+                                 size_t index) {
+    const char *family =
+        ((const MetricInfo *)((const char *)infos + index * stride))->family;
+    for (size_t i = 0; i < index; i++) {
+        if (!strcmp(((const MetricInfo *)((const char *)infos + i * stride))
+                        ->family,
+                    family))
+            return 1;
+    }
+    return 0;
+}
+
+static inline void write_family_header(FILE *file, const MetricInfo *info,
+                                       const char *type) {
+    fprintf(file, "# TYPE %s %s\n", info->family, type);
+    if (info->unit)
+        fprintf(file, "# UNIT %s %s\n", info->family, info->unit);
+    fprintf(file, "# HELP %s %s\n", info->family, info->help);
+}
+
+// Writes `name{label}` or `name` for a metric without a label.
+static inline void write_name(FILE *file, const MetricInfo *info,
+                              const char *suffix) {
+    fprintf(file, "%s%s", info->family, suffix);
+    if (info->label)
+        fprintf(file, "{%s}", info->label);
+}
+
+static void write_counters(FILE *file) {
+    for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        if (family_written(counter_infos, sizeof(MetricInfo), i))
+            continue;
+        write_family_header(file, counter_infos + i, "counter");
+        for (size_t j = i; j < METRIC_COUNTER_COUNT; j++) {
+            const MetricInfo *info = counter_infos + j;
+            if (strcmp(info->family, counter_infos[i].family))
+                continue;
+            uint64_t value = atomic_load_explicit(counters + j,
+                                                  memory_order_relaxed);
+            write_name(file, info, "_total");
+            if (j == METRIC_DECODE_NANOSECONDS)
+                fprintf(file, " %.9f\n", (double)value / 1e9);
+            else
+                fprintf(file, " %llu\n", (unsigned long long)value);
+        }
+    }
+}
+
+static void write_gauges(FILE *file) {
+    for (size_t i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        if (family_written(gauge_infos, sizeof(MetricInfo), i))
+            continue;
+        write_family_header(file, gauge_infos + i, "gauge");
+        for (size_t j = i; j < METRIC_GAUGE_COUNT; j++) {
+            const MetricInfo *info = gauge_infos + j;
+            if (strcmp(info->family, gauge_infos[i].family))
+                continue;
+            write_name(file, info, "");
+            fprintf(file, " %llu\n",
+                    (unsigned long long)atomic_load_explicit(
+                        gauges + j, memory_order_relaxed));
+        }
+    }
+}
+
+static void write_histogram(FILE *file, MetricHistogram histogram) {
+    const HistogramInfo *info = histogram_infos + histogram;
+    Histogram *state = histograms + histogram;
+    const char *label = info->info.label;
+    const char *separator = label ? "," : "";
+    if (!label)
+        label = "";
+
+    // The count is taken from the buckets so that the two always agree
+    uint64_t cumulative = 0;
+    for (int i = 0; i <= info->bound_count; i++) {
+        cumulative +=
+            atomic_load_explicit(state->buckets + i, memory_order_relaxed);
+        if (i < info->bound_count)
+            fprintf(file, "%s_bucket{%s%sle=\"%g\"} %llu\n", info->info.family,
+                    label, separator, info->bounds[i],
+                    (unsigned long long)cumulative);
+        else
+            fprintf(file, "%s_bucket{%s%sle=\"+Inf\"} %llu\n",
+                    info->info.family, label, separator,
+                    (unsigned long long)cumulative);
+    }
+    write_name(file, &info->info, "_sum");
+    fprintf(file, " %.9f\n",
+            (double)atomic_load_explicit(&state->sum_nanoseconds,
+                                         memory_order_relaxed) /
+                1e9);
+    write_name(file, &info->info, "_count");
+    fprintf(file, " %llu\n", (unsigned long long)cumulative);
+}
+
+static void write_histograms(FILE *file) {
+    for (size_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        if (family_written(&histogram_infos[0].info, sizeof(HistogramInfo), i))
+            continue;
+        write_family_header(file, &histogram_infos[i].info, "histogram");
+        for (size_t j = i; j < METRIC_HISTOGRAM_COUNT; j++) {
+            if (!strcmp(histogram_infos[j].info.family,
+                        histogram_infos[i].info.family))
+                write_histogram(file, (MetricHistogram)j);
+        }
+    }
+}
+
+void metrics_write(FILE *file) {
+    write_counters(file);
+    write_gauges(file);
+    write_histograms(file);
+    fprintf(file, "# EOF\n");
+}
+
+// Writes the metrics next to the exported file and renames them over it.
+static int export_metrics(void) {
+    char temporary[METRICS_FILEPATH_MAX + 8];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", export_filepath);
+    FILE *file = fopen(temporary, "w");
+    if (!file)
+        return 1;
+    metrics_write(file);
+    if (fclose(file) || rename(temporary, export_filepath)) {
+        remove(temporary);
+        return 1;
+    }
+    return 0;
+}
+
+static void *export_thread_main(void *arg) {
+    (void)arg;
+    int failed = 0;
+    pthread_mutex_lock(&export_lock);
+    while (1) {
+        int stopping = export_stopping;
+        pthread_mutex_unlock(&export_lock);
+
+        if (export_metrics() && !failed) {
+            // Only reported once, the file may become writable later
+            fprintf(stderr, "ERROR: could not write metrics to %s\n",
+                    export_filepath);
+            failed = 1;
+        }
+        if (stopping)
+            return 0;
+
+        struct timespec wake_time;
+        clock_gettime(CLOCK_REALTIME, &wake_time);
+        double seconds = (double)wake_time.tv_sec +
+                         (double)wake_time.tv_nsec / 1e9 + export_interval;
+        wake_time.tv_sec = (time_t)seconds;
+        wake_time.tv_nsec =
+            (long)((seconds - (double)wake_time.tv_sec) * 1e9);
+
+        pthread_mutex_lock(&export_lock);
+        while (!export_stopping &&
+               pthread_cond_timedwait(&export_wake, &export_lock,
+                                      &wake_time) != ETIMEDOUT)
+            ;
+    }
+}
+
+int metrics_export_start(const char *filepath, double interval) {
+    assert(!export_running);
+    if (strlen(filepath) >= METRICS_FILEPATH_MAX)
+        return 1;
+    strcpy(export_filepath, filepath);
+    export_interval = interval > 0.0 ? interval : METRICS_EXPORT_INTERVAL;
+    export_stopping = 0;
+    if (pthread_create(&export_thread, 0, &export_thread_main, 0))
+        return 1;
+    export_running = 1;
+    return 0;
+}
+
+void metrics_export_stop(void) {
+    if (!export_running)
+        return;
+    pthread_mutex_lock(&export_lock);
+    export_stopping = 1;
+    pthread_cond_signal(&export_wake);
+    pthread_mutex_unlock(&export_lock);
+    pthread_join(export_thread, 0);
+    export_running = 0;
+}
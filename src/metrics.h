@@ -0,0 +1,86 @@
+#ifndef _METRICS
+#define _METRICS
+
+// Process metrics in the OpenMetrics text format, for watching long-running
+// viewers. Recording is lock-free and never allocates, so it can be done from
+// any thread and from the frame loop. Nothing is exported unless
+// metrics_export_start is called.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Seconds between rewrites of the exported file unless set otherwise
+#define METRICS_EXPORT_INTERVAL 5.0
+// Upper bounds of the histogram buckets, not counting +Inf
+#define METRICS_MAX_BUCKETS 16
+
+// Monotonically increasing counts
+typedef enum {
+    METRIC_MODEL_LOADS,
+    METRIC_TEXTURE_LOADS,
+    METRIC_LOAD_FAILURES,
+    // File changes seen by the file watcher, and changes lost when the
+    // kernel's event queue overflowed
+    METRIC_FIREWATCH_EVENTS,
+    METRIC_FIREWATCH_DROPPED,
+    // .aseprite files read, their parsed size, and the time spent on them
+    METRIC_DECODE_FILE_BYTES,
+    METRIC_DECODE_PIXEL_BYTES,
+    METRIC_DECODE_NANOSECONDS,
+    // Point cloud octrees read from their cache file, or built
+    METRIC_OCTREE_CACHE_HITS,
+    METRIC_OCTREE_CACHE_MISSES,
+    // Row bands of extruded sprites kept, or meshed again, on reloads
+    METRIC_VOXEL_BAND_HITS,
+    METRIC_VOXEL_BAND_MISSES,
+    // Cels of layer previews whose composite was kept, or blended again
+    METRIC_LAYER_CACHE_HITS,
+    METRIC_LAYER_CACHE_MISSES,
+    // Lookups in the on-disk asset cache, and entries it evicted
+    METRIC_DISK_CACHE_HITS,
+    METRIC_DISK_CACHE_MISSES,
+    METRIC_DISK_CACHE_EVICTIONS,
+    METRIC_COUNTER_COUNT,
+} MetricCounter;
+
+// Values that go up and down
+typedef enum {
+    METRIC_FIREWATCH_QUEUE_DEPTH,
+    // Memory held per asset class
+    METRIC_MESH_BYTES,
+    METRIC_TEXTURE_BYTES,
+    METRIC_HISTORY_BYTES,
+    METRIC_POINT_CLOUD_BYTES,
+    // Size of the on-disk asset cache
+    METRIC_DISK_CACHE_BYTES,
+    METRIC_GAUGE_COUNT,
+} MetricGauge;
+
+typedef enum {
+    METRIC_FRAME_SECONDS,
+    // From the file change to the new version being drawable
+    METRIC_MODEL_LOAD_SECONDS,
+    METRIC_TEXTURE_LOAD_SECONDS,
+    METRIC_HISTOGRAM_COUNT,
+} MetricHistogram;
+
+void metrics_count(MetricCounter counter, uint64_t amount);
+// Sets a counter kept by another module, which only ever increases it.
+void metrics_store(MetricCounter counter, uint64_t value);
+void metrics_set(MetricGauge gauge, uint64_t value);
+void metrics_observe(MetricHistogram histogram, double seconds);
+
+// Writes every metric in the OpenMetrics text format, ending with "# EOF".
+void metrics_write(FILE *file);
+// Zeroes every metric, for tests.
+void metrics_reset(void);
+
+// Starts a thread rewriting `filepath` every `interval` seconds. The file is
+// replaced atomically, so readers never see it half written. Returns 0 on
+// success.
+int metrics_export_start(const char *filepath, double interval);
+// Writes the file one last time and stops the thread.
+void metrics_export_stop(void);
+
+#endif
@@ -11,9 +11,44 @@ char *path_get_corresponding_texture_file(const char *src) {
     size_t target_length = length + 6;
 
     char *destination = (char *)malloc(target_length);
-    memcpy(destination, src, length);
-    destination[target_length - 9] = 0;
-    strcat(destination, "aseprite");
+    if (!destination)
+        return 0;
+    path_write_corresponding_texture_file(destination, target_length, src);
 
     return destination;
 }
+
+int path_write_corresponding_texture_file(char *destination, size_t size,
+                                          const char *src) {
+    size_t length = strlen(src);
+    if (length < 3 || length + 6 > size)
+        return 1;
+
+    memcpy(destination, src, length - 3);
+    memcpy(destination + length - 3, "aseprite", 9);
+    return 0;
+}
+
+int path_is_aseprite(const char *filepath) {
+    size_t length = strlen(filepath);
+    return length >= 9 && !strcmp(filepath + length - 9, ".aseprite");
+}
+
+int path_is_aseprite_texture(const char *filepath) {
+    size_t length = strlen(filepath);
+    return path_is_aseprite(filepath) ||
+           (length >= 4 && !strcmp(filepath + length - 4, ".ase"));
+}
+
+int path_write_texture_file(char *destination, size_t size,
+                            const char *model_filepath) {
+    if (!path_is_aseprite(model_filepath))
+        return path_write_corresponding_texture_file(destination, size,
+                                                     model_filepath);
+
+    size_t length = strlen(model_filepath);
+    if (length + 1 > size)
+        return 1;
+    memcpy(destination, model_filepath, length + 1);
+    return 0;
+}
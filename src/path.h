@@ -1,8 +1,28 @@
 #ifndef _PATH
 #define _PATH
 
+#include <stddef.h>
+
 // Replaces the last three characters of a string with "aseprite". Free returned
 // char* after use.
 char *path_get_corresponding_texture_file(const char *src);
 
+// Same as path_get_corresponding_texture_file but writes the result to
+// `destination` of `size` bytes without allocating. Returns 0 on success, 1 if
+// `src` is too short or the result does not fit.
+int path_write_corresponding_texture_file(char *destination, size_t size,
+                                          const char *src);
+
+// 1 if `filepath` ends in ".aseprite".
+int path_is_aseprite(const char *filepath);
+// 1 if `filepath` ends in ".aseprite" or ".ase", which are composited instead
+// of loaded as plain images.
+int path_is_aseprite_texture(const char *filepath);
+
+// Writes the texture of the model at `model_filepath` to `destination`: the
+// file itself for sprites extruded into voxels, the corresponding texture file
+// otherwise. Returns 0 on success.
+int path_write_texture_file(char *destination, size_t size,
+                            const char *model_filepath);
+
 #endif
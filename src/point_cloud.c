@@ -0,0 +1,1030 @@
+#define _DEFAULT_SOURCE
+#define GL_GLEXT_PROTOTYPES
+#include "point_cloud.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC "BLPC"
+#define CACHE_VERSION 1
+#define CACHE_EXTENSION ".octree"
+// The points start after the header, aligned for the GPU uploads
+#define CACHE_POINTS_OFFSET 64
+#define MAX_WORKERS 64
+// Pixels wide of each drawn point
+#define POINT_SIZE "2.0"
+// Points of vertices without a color
+#define DEFAULT_COLOR 200
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime_seconds;
+    int64_t source_mtime_nanoseconds;
+    // Points of the leaves, followed by the subsamples of the inner nodes
+    uint64_t point_count;
+    uint64_t sample_count;
+    uint64_t node_count;
+} CacheHeader;
+
+_Static_assert(sizeof(CacheHeader) <= CACHE_POINTS_OFFSET,
+               "the cache header overlaps the points");
+
+typedef struct {
+    uint32_t node;
+    int depth;
+} BuildTask;
+
+// State shared by the workers building one octree.
+typedef struct {
+    int fd;
+    CloudPoint *points;
+    uint64_t point_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    BuildTask *tasks;
+    size_t task_count;
+    size_t tasks_allocated;
+    // Tasks taken but not finished, which may still add more
+    size_t active_count;
+    CloudNode *nodes;
+    size_t node_count;
+    size_t nodes_allocated;
+
+    atomic_uint_fast64_t sample_count;
+    atomic_int failed;
+} Builder;
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    CloudPoint *points;
+    uint64_t count;
+    float min[3];
+    float max[3];
+} ParseChunk;
+
+static const char *point_vertex_shader =
+    "#version 330                                       \n"
+    "in vec3 vertexPosition;                            \n"
+    "in vec4 vertexColor;                               \n"
+    "out vec4 fragColor;                                \n"
+    "uniform mat4 mvp;                                  \n"
+    "void main()                                        \n"
+    "{                                                  \n"
+    "    fragColor = vertexColor;                       \n"
+    "    gl_Position = mvp*vec4(vertexPosition, 1.0);   \n"
+    "    gl_PointSize = " POINT_SIZE ";                 \n"
+    "}                                                  \n";
+
+static const char *point_fragment_shader =
+    "#version 330                                       \n"
+    "in vec4 fragColor;                                 \n"
+    "out vec4 finalColor;                               \n"
+    "void main()                                        \n"
+    "{                                                  \n"
+    "    finalColor = fragColor;                        \n"
+    "}                                                  \n";
+
+// Points of the node that are drawn, leaves at the maximum depth can have
+// more than fit in a slot.
+static inline uint32_t drawn_count(const CloudNode *node) {
+    return node->count < POINT_CLOUD_NODE_POINTS ? node->count
+                                                 : POINT_CLOUD_NODE_POINTS;
+}
+
+static inline int is_vertex_line(const char *line, const char *end) {
+    return end - line > 2 && line[0] == 'v' &&
+           (line[1] == ' ' || line[1] == '\t');
+}
+
+static inline const char *line_end(const char *line, const char *end) {
+    const char *newline = memchr(line, '\n', (size_t)(end - line));
+    return newline ? newline + 1 : end;
+}
+
+// Parses a decimal float at `cursor`. Returns the character after it, or 0
+// if there is none.
+static const char *parse_float(const char *cursor, const char *end,
+                               float *out) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+        cursor++;
+
+    int negative = 0;
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+        negative = *cursor++ == '-';
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++) {
+        if (mantissa < UINT64_MAX / 10 - 10)
+            mantissa = mantissa * 10 + (uint64_t)(*cursor - '0');
+        else
+            exponent++;
+        digits++;
+    }
+    if (cursor < end && *cursor == '.') {
+        for (cursor++; cursor < end && *cursor >= '0' && *cursor <= '9';
+             cursor++) {
+            if (mantissa < UINT64_MAX / 10 - 10) {
+                mantissa = mantissa * 10 + (uint64_t)(*cursor - '0');
+                exponent--;
+            }
+            digits++;
+        }
+    }
+    if (!digits)
+        return 0;
+
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        cursor++;
+        int exponent_negative = 0;
+        if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            exponent_negative = *cursor++ == '-';
+        int value = 0;
+        for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
+            if (value < 1000)
+                value = value * 10 + (*cursor - '0');
+        exponent += exponent_negative ? -value : value;
+    }
+
+    double value = (double)mantissa;
+    if (exponent)
+        value *= pow(10.0, exponent);
+    *out = (float)(negative ? -value : value);
+    return cursor;
+}
+
+static inline uint8_t color_channel(float value) {
+    if (value <= 0.0f)
+        return 0;
+    if (value >= 1.0f)
+        return 255;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+// Parses the `v x y z [r g b]` line at `line` into `point`. Returns 0 on
+// success.
+static inline int parse_vertex(const char *line, const char *end,
+                               CloudPoint *point) {
+    float values[6];
+    const char *cursor = line + 1;
+    int value_count = 0;
+    while (value_count < 6) {
+        const char *next = parse_float(cursor, end, values + value_count);
+        if (!next)
+            break;
+        cursor = next;
+        value_count++;
+    }
+    if (value_count < 3)
+        return 1;
+
+    point->x = values[0];
+    point->y = values[1];
+    point->z = values[2];
+    if (value_count == 6) {
+        point->r = color_channel(values[3]);
+        point->g = color_channel(values[4]);
+        point->b = color_channel(values[5]);
+    } else {
+        point->r = point->g = point->b = DEFAULT_COLOR;
+    }
+    point->a = 255;
+    return 0;
+}
+
+static void *count_vertices(void *arg) {
+    ParseChunk *chunk = arg;
+    for (const char *line = chunk->begin; line < chunk->end;
+         line = line_end(line, chunk->end))
+        chunk->count += is_vertex_line(line, chunk->end);
+    return 0;
+}
+
+// Fills the points of the chunk, counted before by count_vertices.
+static void *parse_vertices(void *arg) {
+    ParseChunk *chunk = arg;
+    for (int axis = 0; axis < 3; axis++) {
+        chunk->min[axis] = FLT_MAX;
+        chunk->max[axis] = -FLT_MAX;
+    }
+
+    uint64_t count = 0;
+    for (const char *line = chunk->begin; line < chunk->end && count <
+                                          chunk->count;) {
+        const char *next = line_end(line, chunk->end);
+        if (is_vertex_line(line, chunk->end)) {
+            CloudPoint *point = chunk->points + count++;
+            // Vertices that do not parse still keep the order of the indices
+            if (parse_vertex(line, next, point))
+                *point = (CloudPoint){0, 0, 0, 0, 0, 0, 0};
+            float position[3] = {point->x, point->y, point->z};
+            for (int axis = 0; axis < 3; axis++) {
+                if (position[axis] < chunk->min[axis])
+                    chunk->min[axis] = position[axis];
+                if (position[axis] > chunk->max[axis])
+                    chunk->max[axis] = position[axis];
+            }
+        }
+        line = next;
+    }
+    return 0;
+}
+
+// Runs `function` on every chunk, on a thread each but the first.
+static void run_chunks(void *(*function)(void *), ParseChunk *chunks,
+                       int chunk_count) {
+    pthread_t threads[MAX_WORKERS];
+    int started[MAX_WORKERS] = {0};
+    for (int i = 1; i < chunk_count; i++)
+        started[i] = !pthread_create(threads + i, 0, function, chunks + i);
+    (*function)(chunks);
+    for (int i = 1; i < chunk_count; i++) {
+        if (started[i])
+            pthread_join(threads[i], 0);
+        else
+            (*function)(chunks + i);
+    }
+}
+
+static inline int octant(const CloudPoint *point, const float center[3]) {
+    return (point->x >= center[0]) | (point->y >= center[1]) << 1 |
+           (point->z >= center[2]) << 2;
+}
+
+static inline void swap_points(CloudPoint *a, CloudPoint *b) {
+    CloudPoint swapped = *a;
+    *a = *b;
+    *b = swapped;
+}
+
+// Adds a task under the builder lock.
+static inline void push_task(Builder *builder, BuildTask task) {
+    if (builder->task_count == builder->tasks_allocated) {
+        builder->tasks_allocated =
+            builder->tasks_allocated ? builder->tasks_allocated * 2 : 64;
+        builder->tasks = realloc(builder->tasks, builder->tasks_allocated *
+                                                     sizeof(BuildTask));
+        if (!builder->tasks)
+            abort();
+    }
+    builder->tasks[builder->task_count++] = task;
+    pthread_cond_signal(&builder->wake);
+}
+
+// Adds `count` nodes under the builder lock. Returns the index of the first.
+static inline size_t add_nodes(Builder *builder, size_t count) {
+    if (builder->node_count + count > builder->nodes_allocated) {
+        while (builder->node_count + count > builder->nodes_allocated)
+            builder->nodes_allocated =
+                builder->nodes_allocated ? builder->nodes_allocated * 2 : 64;
+        builder->nodes = realloc(builder->nodes, builder->nodes_allocated *
+                                                     sizeof(CloudNode));
+        if (!builder->nodes)
+            abort();
+    }
+    size_t first = builder->node_count;
+    builder->node_count += count;
+    return first;
+}
+
+// Splits the points of the node into its octants in place, adds the
+// non-empty ones as children and writes the subsample of the node.
+static void split_node(Builder *builder, BuildTask task,
+                       CloudPoint *samples) {
+    pthread_mutex_lock(&builder->lock);
+    CloudNode node = builder->nodes[task.node];
+    pthread_mutex_unlock(&builder->lock);
+
+    if (node.total <= POINT_CLOUD_NODE_POINTS ||
+        task.depth >= POINT_CLOUD_MAX_DEPTH)
+        return;
+
+    CloudPoint *points = builder->points + node.offset;
+    float half = node.size * 0.5f;
+    float center[3] = {node.min[0] + half, node.min[1] + half,
+                       node.min[2] + half};
+
+    uint64_t counts[8] = {0};
+    for (uint64_t i = 0; i < node.total; i++)
+        counts[octant(points + i, center)]++;
+
+    // Every point is swapped straight into its octant, which leaves the
+    // points of each octant contiguous
+    uint64_t next[8];
+    uint64_t ends[8];
+    uint64_t start = 0;
+    for (int i = 0; i < 8; i++) {
+        next[i] = start;
+        start += counts[i];
+        ends[i] = start;
+    }
+    for (int i = 0; i < 8; i++) {
+        while (next[i] < ends[i]) {
+            int target = octant(points + next[i], center);
+            if (target == i)
+                next[i]++;
+            else
+                swap_points(points + next[i], points + next[target]++);
+        }
+    }
+
+    // Every octant in proportion to its points
+    for (uint32_t i = 0; i < POINT_CLOUD_NODE_POINTS; i++)
+        samples[i] = points[(uint64_t)i * node.total / POINT_CLOUD_NODE_POINTS];
+    uint64_t sample_offset = atomic_fetch_add(&builder->sample_count,
+                                              POINT_CLOUD_NODE_POINTS);
+    size_t sample_bytes = POINT_CLOUD_NODE_POINTS * sizeof(CloudPoint);
+    off_t file_offset =
+        CACHE_POINTS_OFFSET +
+        (off_t)((builder->point_count + sample_offset) * sizeof(CloudPoint));
+    if (pwrite(builder->fd, samples, sample_bytes, file_offset) !=
+        (ssize_t)sample_bytes)
+        atomic_store(&builder->failed, 1);
+
+    uint32_t child_count = 0;
+    for (int i = 0; i < 8; i++)
+        child_count += counts[i] > 0;
+
+    pthread_mutex_lock(&builder->lock);
+    size_t first_child = add_nodes(builder, child_count);
+    CloudNode *parent = builder->nodes + task.node;
+    parent->first_child = (int32_t)first_child;
+    parent->child_count = child_count;
+    parent->offset = builder->point_count + sample_offset;
+    parent->count = POINT_CLOUD_NODE_POINTS;
+
+    size_t child = first_child;
+    for (int i = 0; i < 8; i++) {
+        if (!counts[i])
+            continue;
+        builder->nodes[child] = (CloudNode){
+            .min = {node.min[0] + (i & 1 ? half : 0),
+                    node.min[1] + (i & 2 ? half : 0),
+                    node.min[2] + (i & 4 ? half : 0)},
+            .size = half,
+            .offset = node.offset + next[i] - counts[i],
+            .count = (uint32_t)(counts[i] < UINT32_MAX ? counts[i]
+                                                       : UINT32_MAX),
+            .total = counts[i],
+            .first_child = -1,
+        };
+        push_task(builder, (BuildTask){(uint32_t)child, task.depth + 1});
+        child++;
+    }
+    pthread_mutex_unlock(&builder->lock);
+}
+
+static void *build_worker(void *arg) {
+    Builder *builder = arg;
+    CloudPoint *samples =
+        malloc(POINT_CLOUD_NODE_POINTS * sizeof(CloudPoint));
+    if (!samples)
+        abort();
+
+    pthread_mutex_lock(&builder->lock);
+    while (1) {
+        while (!builder->task_count && builder->active_count)
+            pthread_cond_wait(&builder->wake, &builder->lock);
+        if (!builder->task_count)
+            break;
+
+        BuildTask task = builder->tasks[--builder->task_count];
+        builder->active_count++;
+        pthread_mutex_unlock(&builder->lock);
+
+        split_node(builder, task, samples);
+
+        pthread_mutex_lock(&builder->lock);
+        builder->active_count--;
+        if (!builder->active_count && !builder->task_count)
+            pthread_cond_broadcast(&builder->wake);
+    }
+    pthread_mutex_unlock(&builder->lock);
+
+    free(samples);
+    return 0;
+}
+
+static inline void write_cache_path(char *out, size_t size,
+                                    const char *filepath, const char *suffix) {
+    snprintf(out, size, "%s" CACHE_EXTENSION "%s", filepath, suffix);
+}
+
+// Parses the points of the scan into `fd`, then builds the octree in it.
+// Returns 0 on success.
+static int build_cache(int fd, const char *filepath, struct stat *source_stat,
+                       int worker_count) {
+    int source_fd = open(filepath, O_RDONLY);
+    if (source_fd < 0)
+        return 1;
+    size_t source_size = (size_t)source_stat->st_size;
+    const char *source =
+        source_size ? mmap(0, source_size, PROT_READ, MAP_PRIVATE, source_fd, 0)
+                    : MAP_FAILED;
+    close(source_fd);
+    if (source == MAP_FAILED)
+        return 1;
+    madvise((void *)source, source_size, MADV_SEQUENTIAL);
+
+    // Chunks start at the beginning of a line
+    ParseChunk chunks[MAX_WORKERS] = {0};
+    const char *source_end = source + source_size;
+    const char *chunk_begin = source;
+    for (int i = 0; i < worker_count; i++) {
+        const char *chunk_end =
+            i + 1 == worker_count
+                ? source_end
+                : source + source_size * (size_t)(i + 1) / (size_t)worker_count;
+        if (chunk_end < chunk_begin)
+            chunk_end = chunk_begin;
+        if (chunk_end > source && chunk_end < source_end)
+            chunk_end = line_end(chunk_end - 1, source_end);
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+
+    run_chunks(&count_vertices, chunks, worker_count);
+    uint64_t point_count = 0;
+    for (int i = 0; i < worker_count; i++)
+        point_count += chunks[i].count;
+    if (!point_count) {
+        munmap((void *)source, source_size);
+        fprintf(stderr, "ERROR: %s has no vertices\n", filepath);
+        return 1;
+    }
+
+    size_t points_size = point_count * sizeof(CloudPoint);
+    if (ftruncate(fd, CACHE_POINTS_OFFSET + (off_t)points_size)) {
+        munmap((void *)source, source_size);
+        return 1;
+    }
+    uint8_t *map = mmap(0, CACHE_POINTS_OFFSET + points_size,
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        munmap((void *)source, source_size);
+        return 1;
+    }
+
+    CloudPoint *points = (CloudPoint *)(map + CACHE_POINTS_OFFSET);
+    uint64_t offset = 0;
+    for (int i = 0; i < worker_count; i++) {
+        chunks[i].points = points + offset;
+        offset += chunks[i].count;
+    }
+    run_chunks(&parse_vertices, chunks, worker_count);
+    munmap((void *)source, source_size);
+
+    // The root is a cube around every point
+    float min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int i = 0; i < worker_count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (!chunks[i].count)
+                continue;
+            if (chunks[i].min[axis] < min[axis])
+                min[axis] = chunks[i].min[axis];
+            if (chunks[i].max[axis] > max[axis])
+                max[axis] = chunks[i].max[axis];
+        }
+    }
+    float size = 0.0f;
+    for (int axis = 0; axis < 3; axis++)
+        if (max[axis] - min[axis] > size)
+            size = max[axis] - min[axis];
+    // The points on the far faces are still inside
+    size = size * 1.0001f + FLT_MIN;
+
+    Builder builder = {
+        .fd = fd,
+        .points = points,
+        .point_count = point_count,
+    };
+    pthread_mutex_init(&builder.lock, 0);
+    pthread_cond_init(&builder.wake, 0);
+    add_nodes(&builder, 1);
+    builder.nodes[0] = (CloudNode){
+        .min = {min[0], min[1], min[2]},
+        .size = size,
+        .count = (uint32_t)(point_count < UINT32_MAX ? point_count
+                                                     : UINT32_MAX),
+        .total = point_count,
+        .first_child = -1,
+    };
+    push_task(&builder, (BuildTask){0, 0});
+
+    // The first splits are over most of the points and run alone, the
+    // workers pick up the subtrees as they appear
+    pthread_t threads[MAX_WORKERS];
+    int started = 0;
+    for (int i = 1; i < worker_count; i++)
+        started += !pthread_create(threads + started, 0, &build_worker,
+                                   &builder);
+    build_worker(&builder);
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], 0);
+
+    int error = atomic_load(&builder.failed);
+    munmap(map, CACHE_POINTS_OFFSET + points_size);
+
+    uint64_t sample_count = atomic_load(&builder.sample_count);
+    size_t nodes_size = builder.node_count * sizeof(CloudNode);
+    off_t nodes_offset =
+        CACHE_POINTS_OFFSET +
+        (off_t)((point_count + sample_count) * sizeof(CloudPoint));
+    if (!error &&
+        pwrite(fd, builder.nodes, nodes_size, nodes_offset) !=
+            (ssize_t)nodes_size)
+        error = 1;
+
+    // Written last, a cache without it is never used
+    CacheHeader header = {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .source_size = (uint64_t)source_stat->st_size,
+        .source_mtime_seconds = source_stat->st_mtim.tv_sec,
+        .source_mtime_nanoseconds = source_stat->st_mtim.tv_nsec,
+        .point_count = point_count,
+        .sample_count = sample_count,
+        .node_count = builder.node_count,
+    };
+    if (!error &&
+        pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+        error = 1;
+
+    free(builder.nodes);
+    free(builder.tasks);
+    pthread_mutex_destroy(&builder.lock);
+    pthread_cond_destroy(&builder.wake);
+    return error;
+}
+
+// Maps the cache at `cache_filepath` if it is complete and of the scan
+// described by `source_stat`. Returns 0 on success.
+static int map_cache(PointCloud *cloud, const char *cache_filepath,
+                     struct stat *source_stat) {
+    int fd = open(cache_filepath, O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    struct stat cache_stat;
+    CacheHeader header;
+    if (fstat(fd, &cache_stat) ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, CACHE_MAGIC, 4) ||
+        header.version != CACHE_VERSION ||
+        header.source_size != (uint64_t)source_stat->st_size ||
+        header.source_mtime_seconds != source_stat->st_mtim.tv_sec ||
+        header.source_mtime_nanoseconds != source_stat->st_mtim.tv_nsec ||
+        !header.node_count ||
+        (uint64_t)cache_stat.st_size !=
+            CACHE_POINTS_OFFSET +
+                (header.point_count + header.sample_count) *
+                    sizeof(CloudPoint) +
+                header.node_count * sizeof(CloudNode)) {
+        close(fd);
+        return 1;
+    }
+
+    void *map = mmap(0, (size_t)cache_stat.st_size, PROT_READ, MAP_SHARED, fd,
+                     0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return 1;
+
+    cloud->map = map;
+    cloud->map_size = (size_t)cache_stat.st_size;
+    cloud->points = (const CloudPoint *)(cloud->map + CACHE_POINTS_OFFSET);
+    cloud->point_count = header.point_count;
+    cloud->nodes =
+        (const CloudNode *)(cloud->map + CACHE_POINTS_OFFSET +
+                            (header.point_count + header.sample_count) *
+                                sizeof(CloudPoint));
+    cloud->node_count = header.node_count;
+    // Only the nodes drawn are read
+    madvise(cloud->map, cloud->map_size, MADV_RANDOM);
+    return 0;
+}
+
+int point_cloud_load(PointCloud *cloud, const char *filepath,
+                     int worker_count) {
+    *cloud = (PointCloud){0};
+
+    struct stat source_stat;
+    if (stat(filepath, &source_stat)) {
+        fprintf(stderr, "ERROR: could not read point cloud %s\n", filepath);
+        return 1;
+    }
+
+    char cache_filepath[PATH_MAX];
+    write_cache_path(cache_filepath, sizeof(cache_filepath), filepath, "");
+    if (map_cache(cloud, cache_filepath, &source_stat)) {
+        if (!worker_count) {
+            long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+            worker_count = processor_count > 0 ? (int)processor_count : 1;
+        }
+        if (worker_count > MAX_WORKERS)
+            worker_count = MAX_WORKERS;
+
+        // Built next to the cache and moved over it when complete
+        char building_filepath[PATH_MAX];
+        write_cache_path(building_filepath, sizeof(building_filepath),
+                         filepath, ".tmp");
+        int fd = open(building_filepath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "ERROR: could not create %s\n", building_filepath);
+            return 1;
+        }
+        int error = build_cache(fd, filepath, &source_stat, worker_count);
+        close(fd);
+        if (error || rename(building_filepath, cache_filepath) ||
+            map_cache(cloud, cache_filepath, &source_stat)) {
+            unlink(building_filepath);
+            fprintf(stderr, "ERROR: could not build the octree of %s\n",
+                    filepath);
+            return 1;
+        }
+        cloud->built = 1;
+    }
+
+    cloud->selected = calloc(cloud->node_count, 1);
+    cloud->heap = malloc(cloud->node_count * sizeof(uint32_t));
+    cloud->heap_errors = malloc(cloud->node_count * sizeof(float));
+    cloud->stack = malloc(cloud->node_count * sizeof(uint32_t));
+    cloud->cut = malloc(cloud->node_count * sizeof(uint32_t));
+    cloud->parents = malloc(cloud->node_count * sizeof(uint32_t));
+    if (!cloud->selected || !cloud->heap || !cloud->heap_errors ||
+        !cloud->stack || !cloud->cut || !cloud->parents)
+        abort();
+
+    cloud->parents[0] = UINT32_MAX;
+    for (size_t i = 0; i < cloud->node_count; i++) {
+        const CloudNode *node = cloud->nodes + i;
+        for (uint32_t child = 0; child < node->child_count; child++)
+            cloud->parents[(size_t)node->first_child + child] = (uint32_t)i;
+    }
+    return 0;
+}
+
+void point_cloud_free(PointCloud *cloud) {
+    if (cloud->vertex_array) {
+        glDeleteVertexArrays(1, &cloud->vertex_array);
+        glDeleteBuffers(1, &cloud->buffer);
+        UnloadShader(cloud->shader);
+    }
+    if (cloud->map)
+        munmap(cloud->map, cloud->map_size);
+    free(cloud->selected);
+    free(cloud->heap);
+    free(cloud->heap_errors);
+    free(cloud->stack);
+    free(cloud->cut);
+    free(cloud->parents);
+    free(cloud->node_slots);
+    free(cloud->slot_nodes);
+    free(cloud->slot_frames);
+    free(cloud->slot_drawn);
+    *cloud = (PointCloud){0};
+}
+
+static inline float dot(Vector3 a, Vector3 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline Vector3 cross(Vector3 a, Vector3 b) {
+    return (Vector3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                     a.x * b.y - a.y * b.x};
+}
+
+static inline Vector3 normalized(Vector3 v) {
+    float length = sqrtf(dot(v, v));
+    return length > 0.0f
+               ? (Vector3){v.x / length, v.y / length, v.z / length}
+               : v;
+}
+
+static inline Vector3 along(Vector3 a, Vector3 b, float amount) {
+    return (Vector3){a.x + b.x * amount, a.y + b.y * amount,
+                     a.z + b.z * amount};
+}
+
+PointCloudView point_cloud_view(Camera camera, int width, int height) {
+    Vector3 forward = normalized((Vector3){camera.target.x - camera.position.x,
+                                           camera.target.y - camera.position.y,
+                                           camera.target.z - camera.position.z});
+    Vector3 right = normalized(cross(forward, camera.up));
+    Vector3 up = cross(right, forward);
+    float tan_vertical = tanf(camera.fovy * 0.5f * DEG2RAD);
+    float tan_horizontal = tan_vertical * (float)width / (float)height;
+
+    PointCloudView view = {
+        .eye = camera.position,
+        .pixels_per_unit = (float)height / (2.0f * tan_vertical),
+    };
+    // Each side of the frustum is spanned by one of its edges and the axis
+    // along that side
+    Vector3 edges[4] = {
+        along(forward, right, -tan_horizontal),
+        along(forward, right, tan_horizontal),
+        along(forward, up, -tan_vertical),
+        along(forward, up, tan_vertical),
+    };
+    Vector3 axes[4] = {up, up, right, right};
+    for (int i = 0; i < 4; i++) {
+        Vector3 normal = normalized(cross(edges[i], axes[i]));
+        if (dot(normal, forward) < 0.0f)
+            normal = (Vector3){-normal.x, -normal.y, -normal.z};
+        view.normals[i] = normal;
+        view.offsets[i] = dot(normal, camera.position);
+    }
+    view.normals[4] = forward;
+    view.offsets[4] = dot(forward, camera.position);
+    return view;
+}
+
+static inline int node_visible(const CloudNode *node,
+                               const PointCloudView *view) {
+    for (int i = 0; i < 5; i++) {
+        // The corner furthest inside
+        Vector3 normal = view->normals[i];
+        Vector3 corner = {node->min[0] + (normal.x >= 0.0f ? node->size : 0),
+                          node->min[1] + (normal.y >= 0.0f ? node->size : 0),
+                          node->min[2] + (normal.z >= 0.0f ? node->size : 0)};
+        if (dot(normal, corner) < view->offsets[i])
+            return 0;
+    }
+    return 1;
+}
+
+// Pixels between the drawn points of the node at its closest.
+static inline float node_error(const CloudNode *node,
+                               const PointCloudView *view) {
+    float distance_squared = 0.0f;
+    float eye[3] = {view->eye.x, view->eye.y, view->eye.z};
+    for (int axis = 0; axis < 3; axis++) {
+        float below = node->min[axis] - eye[axis];
+        float above = eye[axis] - (node->min[axis] + node->size);
+        float outside = below > above ? below : above;
+        if (outside > 0.0f)
+            distance_squared += outside * outside;
+    }
+    if (distance_squared < 1e-12f)
+        return FLT_MAX;
+
+    float spacing = node->size / sqrtf((float)drawn_count(node));
+    return spacing * view->pixels_per_unit / sqrtf(distance_squared);
+}
+
+static inline void heap_push(PointCloud *cloud, uint32_t node, float error) {
+    size_t i = cloud->heap_count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (cloud->heap_errors[parent] >= error)
+            break;
+        cloud->heap[i] = cloud->heap[parent];
+        cloud->heap_errors[i] = cloud->heap_errors[parent];
+        i = parent;
+    }
+    cloud->heap[i] = node;
+    cloud->heap_errors[i] = error;
+}
+
+static inline uint32_t heap_pop(PointCloud *cloud, float *error) {
+    uint32_t top = cloud->heap[0];
+    *error = cloud->heap_errors[0];
+
+    uint32_t last = cloud->heap[--cloud->heap_count];
+    float last_error = cloud->heap_errors[cloud->heap_count];
+    size_t i = 0;
+    while (1) {
+        size_t child = i * 2 + 1;
+        if (child >= cloud->heap_count)
+            break;
+        if (child + 1 < cloud->heap_count &&
+            cloud->heap_errors[child + 1] > cloud->heap_errors[child])
+            child++;
+        if (cloud->heap_errors[child] <= last_error)
+            break;
+        cloud->heap[i] = cloud->heap[child];
+        cloud->heap_errors[i] = cloud->heap_errors[child];
+        i = child;
+    }
+    cloud->heap[i] = last;
+    cloud->heap_errors[i] = last_error;
+    return top;
+}
+
+// States of the nodes in PointCloud.selected
+#define NODE_DRAWN 1
+#define NODE_REFINED 2
+
+void point_cloud_select(PointCloud *cloud, const PointCloudView *view,
+                        uint64_t budget) {
+    cloud->cut_count = 0;
+    cloud->cut_points = 0;
+    cloud->heap_count = 0;
+    if (!cloud->node_count || !node_visible(cloud->nodes, view))
+        return;
+
+    const CloudNode *nodes = cloud->nodes;
+    uint64_t total = drawn_count(nodes);
+    cloud->selected[0] = NODE_DRAWN;
+    if (nodes[0].child_count)
+        heap_push(cloud, 0, node_error(nodes, view));
+
+    // Refines the node with the widest spacing first, as long as the budget
+    // allows. Children outside the view are dropped.
+    while (cloud->heap_count) {
+        float error;
+        uint32_t index = heap_pop(cloud, &error);
+        if (error <= POINT_CLOUD_TARGET_SPACING)
+            break;
+
+        const CloudNode *node = nodes + index;
+        uint64_t children_total = 0;
+        for (uint32_t i = 0; i < node->child_count; i++) {
+            const CloudNode *child = nodes + node->first_child + i;
+            if (node_visible(child, view))
+                children_total += drawn_count(child);
+        }
+        if (total - drawn_count(node) + children_total > budget)
+            continue;
+
+        total = total - drawn_count(node) + children_total;
+        cloud->selected[index] = NODE_REFINED;
+        for (uint32_t i = 0; i < node->child_count; i++) {
+            uint32_t child_index = (uint32_t)node->first_child + i;
+            const CloudNode *child = nodes + child_index;
+            if (!node_visible(child, view))
+                continue;
+            cloud->selected[child_index] = NODE_DRAWN;
+            if (child->child_count)
+                heap_push(cloud, child_index, node_error(child, view));
+        }
+    }
+
+    // Collects the cut and clears the states for the next selection
+    size_t stack_count = 0;
+    cloud->stack[stack_count++] = 0;
+    while (stack_count) {
+        uint32_t index = cloud->stack[--stack_count];
+        uint8_t state = cloud->selected[index];
+        cloud->selected[index] = 0;
+        if (state == NODE_DRAWN) {
+            cloud->cut[cloud->cut_count++] = index;
+        } else if (state == NODE_REFINED) {
+            const CloudNode *node = nodes + index;
+            for (uint32_t i = 0; i < node->child_count; i++)
+                cloud->stack[stack_count++] = (uint32_t)node->first_child + i;
+        }
+    }
+    cloud->cut_points = total;
+}
+
+// Creates the slots of `budget` points and the shader. The cut can have more
+// nodes than are needed to fill the budget, some of them small leaves, so
+// there are a few slots to spare.
+static void init_slots(PointCloud *cloud, uint64_t budget) {
+    cloud->slot_count = (size_t)(budget / POINT_CLOUD_NODE_POINTS) * 3 / 2 + 16;
+    cloud->node_slots = malloc(cloud->node_count * sizeof(int32_t));
+    cloud->slot_nodes = malloc(cloud->slot_count * sizeof(uint32_t));
+    cloud->slot_frames = calloc(cloud->slot_count, sizeof(uint64_t));
+    cloud->slot_drawn = calloc(cloud->slot_count, sizeof(uint64_t));
+    if (!cloud->node_slots || !cloud->slot_nodes || !cloud->slot_frames ||
+        !cloud->slot_drawn)
+        abort();
+    for (size_t i = 0; i < cloud->node_count; i++)
+        cloud->node_slots[i] = -1;
+    for (size_t i = 0; i < cloud->slot_count; i++)
+        cloud->slot_nodes[i] = UINT32_MAX;
+
+    cloud->shader =
+        LoadShaderFromMemory(point_vertex_shader, point_fragment_shader);
+    cloud->mvp_location = GetShaderLocation(cloud->shader, "mvp");
+
+    glGenVertexArrays(1, &cloud->vertex_array);
+    glBindVertexArray(cloud->vertex_array);
+    glGenBuffers(1, &cloud->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, cloud->buffer);
+    glBufferData(GL_ARRAY_BUFFER,
+                 (GLsizeiptr)(cloud->slot_count * POINT_CLOUD_NODE_POINTS *
+                              sizeof(CloudPoint)),
+                 0, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3,
+                          GL_FLOAT, GL_FALSE, sizeof(CloudPoint), 0);
+    glEnableVertexAttribArray(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+    glVertexAttribPointer(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4,
+                          GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CloudPoint),
+                          (void *)offsetof(CloudPoint, r));
+    glEnableVertexAttribArray(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Uploads the node into the least recently used slot not drawn this frame.
+// Returns 0 on success.
+static int upload_node(PointCloud *cloud, uint32_t index) {
+    size_t oldest = cloud->slot_count;
+    for (size_t i = 0; i < cloud->slot_count; i++) {
+        if (cloud->slot_frames[i] == cloud->frame)
+            continue;
+        if (oldest == cloud->slot_count ||
+            cloud->slot_frames[i] < cloud->slot_frames[oldest])
+            oldest = i;
+    }
+    if (oldest == cloud->slot_count)
+        return 1;
+
+    if (cloud->slot_nodes[oldest] != UINT32_MAX)
+        cloud->node_slots[cloud->slot_nodes[oldest]] = -1;
+    cloud->slot_nodes[oldest] = index;
+    cloud->slot_frames[oldest] = cloud->frame;
+    cloud->node_slots[index] = (int32_t)oldest;
+
+    const CloudNode *node = cloud->nodes + index;
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    (GLintptr)(oldest * POINT_CLOUD_NODE_POINTS *
+                               sizeof(CloudPoint)),
+                    (GLsizeiptr)(drawn_count(node) * sizeof(CloudPoint)),
+                    cloud->points + node->offset);
+    return 0;
+}
+
+void point_cloud_draw(PointCloud *cloud, Camera camera, uint64_t budget) {
+    if (!cloud->node_count)
+        return;
+    if (!cloud->vertex_array)
+        init_slots(cloud, budget);
+
+    PointCloudView view =
+        point_cloud_view(camera, GetScreenWidth(), GetScreenHeight());
+    point_cloud_select(cloud, &view, budget);
+    cloud->frame++;
+
+    // The resident nodes of the cut are kept, then the missing ones are
+    // streamed in a few per frame
+    for (size_t i = 0; i < cloud->cut_count; i++) {
+        int32_t slot = cloud->node_slots[cloud->cut[i]];
+        if (slot >= 0)
+            cloud->slot_frames[slot] = cloud->frame;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, cloud->buffer);
+    int uploads = 0;
+    for (size_t i = 0;
+         i < cloud->cut_count && uploads < POINT_CLOUD_UPLOADS_PER_FRAME; i++) {
+        if (cloud->node_slots[cloud->cut[i]] >= 0)
+            continue;
+        if (upload_node(cloud, cloud->cut[i]))
+            break;
+        uploads++;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    rlDrawRenderBatchActive();
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    SetShaderValueMatrix(cloud->shader, cloud->mvp_location, mvp);
+    rlEnableShader(cloud->shader.id);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(cloud->vertex_array);
+
+    // Nodes still streaming are covered by their closest resident ancestor
+    for (size_t i = 0; i < cloud->cut_count; i++) {
+        uint32_t index = cloud->cut[i];
+        while (index != UINT32_MAX && cloud->node_slots[index] < 0)
+            index = cloud->parents[index];
+        if (index == UINT32_MAX)
+            continue;
+
+        // Ancestors standing in are kept as well
+        int32_t slot = cloud->node_slots[index];
+        cloud->slot_frames[slot] = cloud->frame;
+        if (cloud->slot_drawn[slot] == cloud->frame)
+            continue;
+        cloud->slot_drawn[slot] = cloud->frame;
+        glDrawArrays(GL_POINTS, slot * POINT_CLOUD_NODE_POINTS,
+                     (GLsizei)drawn_count(cloud->nodes + index));
+    }
+
+    glBindVertexArray(0);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    rlDisableShader();
+}
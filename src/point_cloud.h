@@ -0,0 +1,116 @@
+#ifndef _POINT_CLOUD
+#define _POINT_CLOUD
+
+// Point clouds of scans stored as OBJ files of mostly `v` lines, drawn as
+// points through an octree instead of as a mesh.
+//
+// The octree is built out of core into a cache file next to the scan: the
+// points are parsed straight into the memory mapped file by worker threads,
+// then partitioned into octants in place, which leaves them in Morton order
+// with every node a contiguous range. Each inner node also gets a strided
+// subsample of its points. The file is reused as long as the scan does not
+// change, and only the pages of the nodes actually drawn are read.
+//
+// Each frame a cut through the tree is selected: nodes are refined, largest
+// projected point spacing first, until the spacing is below a pixel or the
+// point budget is used up. The selected nodes are streamed into a fixed pool
+// of GPU buffer slots, least recently used first.
+
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Points of an inner node's subsample, and at most in a leaf
+#define POINT_CLOUD_NODE_POINTS 4096
+#define POINT_CLOUD_MAX_DEPTH 21
+// Points drawn per frame at most, unless set otherwise
+#define POINT_CLOUD_BUDGET (2 * 1000 * 1000)
+// Nodes are refined until their points are this many pixels apart
+#define POINT_CLOUD_TARGET_SPACING 1.0f
+// Nodes streamed to the GPU per frame at most
+#define POINT_CLOUD_UPLOADS_PER_FRAME 32
+
+typedef struct {
+    float x, y, z;
+    uint8_t r, g, b, a;
+} CloudPoint;
+
+typedef struct {
+    float min[3];
+    // Edge length of the node's cube
+    float size;
+    // Index of the first point in PointCloud.points: the node's own range for
+    // leaves, its subsample for inner nodes
+    uint64_t offset;
+    // Points below the node in total
+    uint64_t total;
+    uint32_t count;
+    // Children are stored next to each other, -1 for leaves
+    int32_t first_child;
+    uint32_t child_count;
+} CloudNode;
+
+typedef struct {
+    uint8_t *map;
+    size_t map_size;
+    const CloudNode *nodes;
+    size_t node_count;
+    const CloudPoint *points;
+    uint64_t point_count;
+    // 1 if the octree was built by point_cloud_load, 0 if the cache was used
+    int built;
+
+    // Selection state, allocated at load so that drawing does not allocate
+    uint8_t *selected;
+    uint32_t *heap;
+    float *heap_errors;
+    size_t heap_count;
+    uint32_t *stack;
+    uint32_t *cut;
+    size_t cut_count;
+    uint64_t cut_points;
+    // Parent of each node, UINT32_MAX for the root
+    uint32_t *parents;
+
+    // GPU slots of POINT_CLOUD_NODE_POINTS points each
+    unsigned int vertex_array;
+    unsigned int buffer;
+    size_t slot_count;
+    int32_t *node_slots;
+    uint32_t *slot_nodes;
+    // Frames each slot was last used and drawn in
+    uint64_t *slot_frames;
+    uint64_t *slot_drawn;
+    uint64_t frame;
+    Shader shader;
+    int mvp_location;
+} PointCloud;
+
+typedef struct {
+    Vector3 eye;
+    // Half-spaces of the frustum as normal and offset, a point p is inside
+    // when dot(normal, p) >= offset for all of them
+    Vector3 normals[5];
+    float offsets[5];
+    // Screen height divided by the height of the view at distance 1
+    float pixels_per_unit;
+} PointCloudView;
+
+// Loads the octree of the OBJ scan at `filepath`, building it with
+// `worker_count` threads (0 for one per processor) if the cache file is
+// missing or out of date. Returns 0 on success.
+int point_cloud_load(PointCloud *cloud, const char *filepath,
+                     int worker_count);
+void point_cloud_free(PointCloud *cloud);
+
+// The view of `camera` on a `width` x `height` screen.
+PointCloudView point_cloud_view(Camera camera, int width, int height);
+// Selects the nodes to draw into cloud->cut, at most `budget` points.
+void point_cloud_select(PointCloud *cloud, const PointCloudView *view,
+                        uint64_t budget);
+
+// Selects, streams and draws the cloud. Call between BeginMode3D and
+// EndMode3D.
+void point_cloud_draw(PointCloud *cloud, Camera camera, uint64_t budget);
+
+#endif
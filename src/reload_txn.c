@@ -0,0 +1,71 @@
+#include "reload_txn.h"
+#include "timings.h"
+#include <assert.h>
+#include <stdlib.h>
+
+void reload_txn_init(ReloadTxns *txns, size_t slot_count, double window,
+                     double (*clock)(void)) {
+    *txns = (ReloadTxns){
+        .slots = calloc(slot_count ? slot_count : 1, sizeof(ReloadSlot)),
+        .slot_count = slot_count,
+        .window = window,
+        .clock = clock ? clock : &timings_now,
+    };
+    if (!txns->slots)
+        abort();
+    pthread_mutex_init(&txns->lock, 0);
+}
+
+void reload_txn_free(ReloadTxns *txns) {
+    if (!txns->slots)
+        return;
+    pthread_mutex_destroy(&txns->lock);
+    free(txns->slots);
+    txns->slots = 0;
+    txns->slot_count = 0;
+}
+
+void reload_txn_change(ReloadTxns *txns, size_t slot, uint32_t part) {
+    assert(slot < txns->slot_count);
+    double now = (*txns->clock)();
+    pthread_mutex_lock(&txns->lock);
+    ReloadSlot *reload = txns->slots + slot;
+    if (!reload->changed)
+        reload->first_change = now;
+    reload->changed |= part;
+    reload->last_change = now;
+    pthread_mutex_unlock(&txns->lock);
+}
+
+int reload_txn_next(ReloadTxns *txns, size_t *slot, uint32_t *parts) {
+    double now = (*txns->clock)();
+    int found = 0;
+    pthread_mutex_lock(&txns->lock);
+    for (size_t i = 0; i < txns->slot_count; i++) {
+        ReloadSlot *reload = txns->slots + i;
+        if (!reload->changed || reload->loading)
+            continue;
+        if (now - reload->last_change < txns->window &&
+            now - reload->first_change < RELOAD_TXN_MAX_WAIT)
+            continue;
+
+        *slot = i;
+        *parts = reload->changed;
+        reload->loading = reload->changed;
+        reload->changed = 0;
+        found = 1;
+        break;
+    }
+    pthread_mutex_unlock(&txns->lock);
+    return found;
+}
+
+int reload_txn_loaded(ReloadTxns *txns, size_t slot, uint32_t part) {
+    assert(slot < txns->slot_count);
+    pthread_mutex_lock(&txns->lock);
+    ReloadSlot *reload = txns->slots + slot;
+    reload->loading &= ~part;
+    int complete = !reload->loading;
+    pthread_mutex_unlock(&txns->lock);
+    return complete;
+}
@@ -0,0 +1,63 @@
+#ifndef _RELOAD_TXN
+#define _RELOAD_TXN
+
+// Groups the changes to the files of a model slot into reload transactions.
+// Exporters write a model and its texture one after the other, and loading
+// each as it changes would draw the new mesh with the old texture in between.
+//
+// Changes are collected until the slot has been quiet for the window, then
+// every changed part is loaded, and the results are held back until the last
+// of them is in so that they can be swapped in together.
+//
+// Changes are reported and transactions started on one thread, loads may
+// finish on another.
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Seconds a slot has to be quiet before its changes are loaded
+#define RELOAD_TXN_WINDOW 0.1
+// Changes are loaded at the latest this long after the first of them, even
+// if more keep coming
+#define RELOAD_TXN_MAX_WAIT 1.0
+
+// Bits of the parts of a slot
+#define RELOAD_PART_MODEL 0x1
+#define RELOAD_PART_TEXTURE 0x2
+
+typedef struct {
+    // Parts changed since the transaction started loading
+    uint32_t changed;
+    // Parts of the transaction still loading
+    uint32_t loading;
+    double first_change;
+    double last_change;
+} ReloadSlot;
+
+typedef struct {
+    ReloadSlot *slots;
+    size_t slot_count;
+    double window;
+    // Seconds on a monotonic clock
+    double (*clock)(void);
+    pthread_mutex_t lock;
+} ReloadTxns;
+
+// `window` is in seconds, `clock` is timings_now if 0.
+void reload_txn_init(ReloadTxns *txns, size_t slot_count, double window,
+                     double (*clock)(void));
+void reload_txn_free(ReloadTxns *txns);
+
+// Records a change to `part` of `slot`.
+void reload_txn_change(ReloadTxns *txns, size_t slot, uint32_t part);
+// Starts the transaction of a slot whose changes have settled, unless the
+// previous one is still loading. Returns 1 and stores the slot and the parts
+// to load, 0 if no slot is ready.
+int reload_txn_next(ReloadTxns *txns, size_t *slot, uint32_t *parts);
+// Reports `part` of `slot` as loaded, or failed to load. Returns 1 if the
+// transaction is complete and everything held for it can be committed, also
+// for parts loaded outside of a transaction.
+int reload_txn_loaded(ReloadTxns *txns, size_t slot, uint32_t part);
+
+#endif
@@ -0,0 +1,188 @@
+#include "replay.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAGIC "bricklayer-replay 1"
+#define LINE_BUFFER_SIZE 8192
+
+// Floats are written in hexadecimal notation ("%a") so that a replay
+// reproduces the recorded values bit for bit.
+
+int replay_recorder_open(ReplayRecorder *recorder, const char *filepath,
+                         int grid_enabled, int wireframe_enabled) {
+    recorder->frame = 0;
+    recorder->file = fopen(filepath, "w");
+    if (!recorder->file)
+        return 1;
+
+    fprintf(recorder->file, REPLAY_MAGIC "\n");
+    fprintf(recorder->file, "s %d %d\n", grid_enabled, wireframe_enabled);
+    return 0;
+}
+
+void replay_record_model(ReplayRecorder *recorder, const char *filepath) {
+    if (!recorder->file)
+        return;
+    fprintf(recorder->file, "m %s\n", filepath);
+}
+
+void replay_record_frame(ReplayRecorder *recorder, ReplayFrame *frame) {
+    if (!recorder->file)
+        return;
+
+    frame->frame = recorder->frame++;
+    fprintf(recorder->file,
+            "f %llu %a %u %a %a %a %a %a %a %a %a %a %a %a %a\n",
+            (unsigned long long)frame->frame, frame->time, frame->flags,
+            frame->mouse_delta.x, frame->mouse_delta.y, frame->wheel,
+            frame->camera_position.x, frame->camera_position.y,
+            frame->camera_position.z, frame->camera_target.x,
+            frame->camera_target.y, frame->camera_target.z,
+            frame->camera_up.x, frame->camera_up.y, frame->camera_up.z);
+}
+
+void replay_record_file_event(ReplayRecorder *recorder, double time,
+                              ReplayEventKind kind, uint64_t cookie,
+                              const char *filepath) {
+    if (!recorder->file)
+        return;
+    fprintf(recorder->file, "e %llu %a %d %llu %s\n",
+            (unsigned long long)recorder->frame, time, (int)kind,
+            (unsigned long long)cookie, filepath);
+}
+
+void replay_recorder_close(ReplayRecorder *recorder) {
+    if (!recorder->file)
+        return;
+    fclose(recorder->file);
+    recorder->file = 0;
+}
+
+static inline void log_append_frame(ReplayLog *log, ReplayFrame frame) {
+    if (log->frame_count >= log->frames_allocated) {
+        log->frames_allocated =
+            log->frames_allocated ? log->frames_allocated * 2 : 256;
+        log->frames = realloc(log->frames,
+                              log->frames_allocated * sizeof(ReplayFrame));
+        if (!log->frames)
+            abort();
+    }
+    log->frames[log->frame_count++] = frame;
+}
+
+static inline void log_append_event(ReplayLog *log, ReplayFileEvent event) {
+    if (log->event_count >= log->events_allocated) {
+        log->events_allocated =
+            log->events_allocated ? log->events_allocated * 2 : 16;
+        log->events = realloc(log->events, log->events_allocated *
+                                               sizeof(ReplayFileEvent));
+        if (!log->events)
+            abort();
+    }
+    log->events[log->event_count++] = event;
+}
+
+static inline void log_append_model(ReplayLog *log, const char *filepath) {
+    log->model_filepaths = realloc(
+        log->model_filepaths, (log->model_count + 1) * sizeof(char *));
+    if (!log->model_filepaths)
+        abort();
+    log->model_filepaths[log->model_count++] = strdup(filepath);
+}
+
+// Strips the trailing newline of a line read with fgets.
+static inline void strip_newline(char *line) {
+    size_t length = strlen(line);
+    if (length && line[length - 1] == '\n')
+        line[length - 1] = 0;
+}
+
+int replay_log_load(ReplayLog *log, const char *filepath) {
+    memset(log, 0, sizeof(ReplayLog));
+    log->grid_enabled = 1;
+
+    FILE *file = fopen(filepath, "r");
+    if (!file)
+        return 1;
+
+    char line[LINE_BUFFER_SIZE] = {0};
+    if (!fgets(line, LINE_BUFFER_SIZE, file) ||
+        strncmp(line, REPLAY_MAGIC, strlen(REPLAY_MAGIC))) {
+        fclose(file);
+        return 1;
+    }
+
+    while (fgets(line, LINE_BUFFER_SIZE, file)) {
+        strip_newline(line);
+
+        switch (line[0]) {
+        case 's':
+            sscanf(line, "s %d %d", &log->grid_enabled,
+                   &log->wireframe_enabled);
+            break;
+
+        case 'm':
+            if (line[1] == ' ')
+                log_append_model(log, line + 2);
+            break;
+
+        case 'f': {
+            ReplayFrame frame = {0};
+            unsigned long long frame_index = 0;
+            int fields = sscanf(
+                line, "f %llu %la %u %a %a %a %a %a %a %a %a %a %a %a %a",
+                &frame_index, &frame.time, &frame.flags, &frame.mouse_delta.x,
+                &frame.mouse_delta.y, &frame.wheel, &frame.camera_position.x,
+                &frame.camera_position.y, &frame.camera_position.z,
+                &frame.camera_target.x, &frame.camera_target.y,
+                &frame.camera_target.z, &frame.camera_up.x,
+                &frame.camera_up.y, &frame.camera_up.z);
+            if (fields != 15)
+                goto malformed;
+            frame.frame = frame_index;
+            log_append_frame(log, frame);
+        } break;
+
+        case 'e': {
+            ReplayFileEvent event = {0};
+            unsigned long long frame_index = 0, cookie = 0;
+            int kind = 0, path_offset = 0;
+            int fields = sscanf(line, "e %llu %la %d %llu %n", &frame_index,
+                                &event.time, &kind, &cookie, &path_offset);
+            if (fields != 4 || !path_offset)
+                goto malformed;
+            event.frame = frame_index;
+            event.kind = (ReplayEventKind)kind;
+            event.cookie = cookie;
+            event.filepath = strdup(line + path_offset);
+            log_append_event(log, event);
+        } break;
+
+        default:
+            break;
+        }
+    }
+
+    fclose(file);
+    return 0;
+
+malformed:
+    fprintf(stderr, "ERROR: malformed line in replay file %s: \"%s\"\n",
+            filepath, line);
+    fclose(file);
+    replay_log_free(log);
+    return 1;
+}
+
+void replay_log_free(ReplayLog *log) {
+    for (size_t i = 0; i < log->model_count; i++)
+        free(log->model_filepaths[i]);
+    for (size_t i = 0; i < log->event_count; i++)
+        free(log->events[i].filepath);
+    free(log->model_filepaths);
+    free(log->frames);
+    free(log->events);
+    memset(log, 0, sizeof(ReplayLog));
+}
@@ -0,0 +1,92 @@
+#ifndef _REPLAY
+#define _REPLAY
+
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Bits of ReplayFrame.flags
+#define REPLAY_MOUSE_MIDDLE_PRESSED 0x01
+#define REPLAY_MOUSE_MIDDLE_RELEASED 0x02
+#define REPLAY_MOUSE_MIDDLE_DOWN 0x04
+#define REPLAY_KEY_GRID 0x08
+#define REPLAY_KEY_WIREFRAME 0x10
+#define REPLAY_KEY_RESET_CAMERA 0x20
+#define REPLAY_KEY_LAYER_PREVIOUS 0x40
+#define REPLAY_KEY_LAYER_NEXT 0x80
+#define REPLAY_KEY_LAYER_VISIBILITY 0x100
+#define REPLAY_KEY_LAYER_SOLO 0x200
+#define REPLAY_KEY_LIGHTING 0x400
+#define REPLAY_KEY_VERSION_PREVIOUS 0x800
+#define REPLAY_KEY_VERSION_NEXT 0x1000
+#define REPLAY_KEY_GPU_OVERLAY 0x2000
+
+typedef enum {
+    REPLAY_EVENT_MODEL,
+    REPLAY_EVENT_TEXTURE,
+} ReplayEventKind;
+
+// Input of a single iteration of the main loop, along with the camera state
+// after that input was applied. The camera is stored so that a replay does not
+// depend on how the orbital controls turn mouse movement into rotation.
+typedef struct {
+    uint64_t frame;
+    double time;
+    uint32_t flags;
+    Vector2 mouse_delta;
+    float wheel;
+    Vector3 camera_position;
+    Vector3 camera_target;
+    Vector3 camera_up;
+} ReplayFrame;
+
+// A file change reported by firewatch during frame `frame`.
+typedef struct {
+    uint64_t frame;
+    double time;
+    ReplayEventKind kind;
+    uint64_t cookie;
+    char *filepath;
+} ReplayFileEvent;
+
+typedef struct {
+    FILE *file;
+    uint64_t frame;
+} ReplayRecorder;
+
+typedef struct {
+    int grid_enabled;
+    int wireframe_enabled;
+
+    char **model_filepaths;
+    size_t model_count;
+
+    ReplayFrame *frames;
+    size_t frame_count;
+    size_t frames_allocated;
+
+    ReplayFileEvent *events;
+    size_t event_count;
+    size_t events_allocated;
+} ReplayLog;
+
+// Opens `filepath` for writing a new recording. Returns 0 on success.
+int replay_recorder_open(ReplayRecorder *recorder, const char *filepath,
+                         int grid_enabled, int wireframe_enabled);
+// Writes the model list of the session, call before the first frame.
+void replay_record_model(ReplayRecorder *recorder, const char *filepath);
+// Writes the input of the current frame and advances the frame counter.
+void replay_record_frame(ReplayRecorder *recorder, ReplayFrame *frame);
+// Writes a file change event that happened during the current frame. Does
+// nothing if the recorder is not open.
+void replay_record_file_event(ReplayRecorder *recorder, double time,
+                              ReplayEventKind kind, uint64_t cookie,
+                              const char *filepath);
+void replay_recorder_close(ReplayRecorder *recorder);
+
+// Reads a recording made with ReplayRecorder. Returns 0 on success.
+int replay_log_load(ReplayLog *log, const char *filepath);
+void replay_log_free(ReplayLog *log);
+
+#endif
@@ -0,0 +1,36 @@
+#include "scene_snapshot.h"
+
+void scene_snapshot_init(SceneSnapshotBuffer *buffer,
+                         const SceneSnapshot *initial) {
+    buffer->buffers[0] = *initial;
+    buffer->buffers[1] = *initial;
+    buffer->front = 0;
+    pthread_mutex_init(&buffer->lock, 0);
+}
+
+void scene_snapshot_free(SceneSnapshotBuffer *buffer) {
+    pthread_mutex_destroy(&buffer->lock);
+}
+
+SceneSnapshot *scene_snapshot_back(SceneSnapshotBuffer *buffer) {
+    // Only the publishing thread changes `front`, no lock needed to read it
+    return buffer->buffers + !buffer->front;
+}
+
+void scene_snapshot_publish(SceneSnapshotBuffer *buffer) {
+    SceneSnapshot *back = buffer->buffers + !buffer->front;
+    back->sequence = buffer->buffers[buffer->front].sequence + 1;
+
+    pthread_mutex_lock(&buffer->lock);
+    buffer->front = !buffer->front;
+    pthread_mutex_unlock(&buffer->lock);
+
+    // Start the next snapshot from the one just published
+    buffer->buffers[!buffer->front] = *back;
+}
+
+void scene_snapshot_read(SceneSnapshotBuffer *buffer, SceneSnapshot *out) {
+    pthread_mutex_lock(&buffer->lock);
+    *out = buffer->buffers[buffer->front];
+    pthread_mutex_unlock(&buffer->lock);
+}
@@ -0,0 +1,45 @@
+#ifndef _SCENE_SNAPSHOT
+#define _SCENE_SNAPSHOT
+
+// Double-buffered scene state handed from the input thread to the render
+// thread. The input thread fills the back buffer without holding the lock and
+// publishes it with a swap, the render thread copies the front buffer out.
+// A published snapshot is never modified.
+
+#include "raylib.h"
+#include <pthread.h>
+#include <stdint.h>
+
+typedef struct {
+    // Incremented on every publish
+    uint64_t sequence;
+    Camera camera;
+    int grid_enabled;
+    int wireframe_enabled;
+    int lighting_enabled;
+    int gpu_overlay_enabled;
+    int window_focused;
+    // Seconds since startup, moves the lights of the lit preview
+    double time;
+} SceneSnapshot;
+
+typedef struct {
+    SceneSnapshot buffers[2];
+    int front;
+    pthread_mutex_t lock;
+} SceneSnapshotBuffer;
+
+// Publishes `initial` as the first snapshot.
+void scene_snapshot_init(SceneSnapshotBuffer *buffer,
+                         const SceneSnapshot *initial);
+void scene_snapshot_free(SceneSnapshotBuffer *buffer);
+
+// The snapshot to fill before the next scene_snapshot_publish. Only the
+// publishing thread may use it.
+SceneSnapshot *scene_snapshot_back(SceneSnapshotBuffer *buffer);
+void scene_snapshot_publish(SceneSnapshotBuffer *buffer);
+
+// Copies the latest published snapshot to `out`.
+void scene_snapshot_read(SceneSnapshotBuffer *buffer, SceneSnapshot *out);
+
+#endif
@@ -0,0 +1,195 @@
+#define GL_GLEXT_PROTOTYPES
+#include "staging_ring.h"
+#include "rlgl.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GLFW/glfw3.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline size_t align_up(size_t value) {
+    return (value + STAGING_RING_ALIGNMENT - 1) &
+           ~(size_t)(STAGING_RING_ALIGNMENT - 1);
+}
+
+static int gl_fence_signaled(void *fence, int wait) {
+    GLenum status =
+        glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         wait ? (GLuint64)1000 * 1000 * 1000 : 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return 0;
+    glDeleteSync((GLsync)fence);
+    return 1;
+}
+
+int staging_ring_init(StagingRing *ring, size_t size) {
+    if (!glfwExtensionSupported("GL_ARB_buffer_storage")) {
+        staging_ring_init_client(ring, size);
+        return 0;
+    }
+
+    *ring = (StagingRing){.size = size, .fence_signaled = &gl_fence_signaled};
+
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &ring->buffer_id);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->buffer_id);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, 0, flags);
+    ring->memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                    (GLsizeiptr)size, flags);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!ring->memory) {
+        fprintf(stderr, "ERROR: could not map the staging buffer, using "
+                        "client memory instead\n");
+        glDeleteBuffers(1, &ring->buffer_id);
+        staging_ring_init_client(ring, size);
+    }
+    return 0;
+}
+
+void staging_ring_init_client(StagingRing *ring, size_t size) {
+    *ring = (StagingRing){
+        .size = size,
+        .memory = malloc(size),
+        .fence_signaled = &gl_fence_signaled,
+    };
+    if (!ring->memory)
+        abort();
+}
+
+void staging_ring_free(StagingRing *ring) {
+    if (!ring->memory)
+        return;
+
+    while (ring->region_count)
+        staging_ring_retire(ring, 1);
+
+    if (ring->buffer_id) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->buffer_id);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &ring->buffer_id);
+    } else {
+        free(ring->memory);
+    }
+    ring->memory = 0;
+}
+
+void staging_ring_retire(StagingRing *ring, int wait) {
+    while (ring->region_count) {
+        StagingRegion *region = ring->regions + ring->region_first;
+        // Only wait for the oldest, the rest are checked without blocking
+        if (region->fence && !ring->fence_signaled(region->fence, wait))
+            break;
+        wait = 0;
+
+        ring->tail = region->end;
+        ring->region_first =
+            (ring->region_first + 1) % STAGING_RING_MAX_REGIONS;
+        ring->region_count--;
+    }
+
+    // Start over from the beginning for the most contiguous room
+    if (!ring->region_count)
+        ring->head = ring->tail = 0;
+}
+
+// Finds room for `size` bytes, returns 1 and stores the offset on success.
+static int find_room(StagingRing *ring, size_t size, size_t *offset) {
+    if (ring->region_count >= STAGING_RING_MAX_REGIONS)
+        return 0;
+
+    size_t start = align_up(ring->head);
+    if (!ring->region_count || ring->head > ring->tail) {
+        // The regions in flight are [tail, head), free space at the end and
+        // before the tail
+        if (start + size <= ring->size) {
+            *offset = start;
+            return 1;
+        }
+        if (size <= ring->tail || (!ring->region_count && size <= ring->size)) {
+            *offset = 0;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Wrapped around, free space is [head, tail)
+    if (ring->head < ring->tail && start + size <= ring->tail) {
+        *offset = start;
+        return 1;
+    }
+    return 0;
+}
+
+void *staging_ring_reserve(StagingRing *ring, size_t size) {
+    assert(!ring->reserved_size);
+    if (!size || size > ring->size)
+        return 0;
+
+    staging_ring_retire(ring, 0);
+
+    size_t offset = 0;
+    while (!find_room(ring, size, &offset)) {
+        assert(ring->region_count);
+        staging_ring_retire(ring, 1);
+    }
+
+    ring->reserved_offset = offset;
+    ring->reserved_size = size;
+    ring->head = offset + size;
+    return ring->memory + offset;
+}
+
+void staging_ring_commit(StagingRing *ring, void *fence) {
+    assert(ring->reserved_size);
+    size_t index =
+        (ring->region_first + ring->region_count) % STAGING_RING_MAX_REGIONS;
+    ring->regions[index] = (StagingRegion){
+        .end = ring->reserved_offset + ring->reserved_size,
+        .fence = fence,
+    };
+    ring->region_count++;
+    ring->reserved_size = 0;
+}
+
+Texture staging_ring_upload_texture(StagingRing *ring, int width, int height,
+                                    Texture reuse) {
+    assert(ring->reserved_size >= (size_t)width * (size_t)height * 4);
+
+    Texture texture = reuse;
+    if (!reuse.id || reuse.width != width || reuse.height != height ||
+        reuse.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 ||
+        reuse.mipmaps != 1) {
+        texture = (Texture){
+            .id = rlLoadTexture(0, width, height,
+                                PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1),
+            .width = width,
+            .height = height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+        };
+    }
+
+    const void *pixels = ring->memory + ring->reserved_offset;
+    if (ring->buffer_id) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->buffer_id);
+        pixels = (const void *)(uintptr_t)ring->reserved_offset;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    void *fence = 0;
+    if (ring->buffer_id) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    staging_ring_commit(ring, fence);
+    return texture;
+}
@@ -0,0 +1,77 @@
+#ifndef _STAGING_RING
+#define _STAGING_RING
+
+// A ring of staging memory for texture uploads. Pixels are written straight
+// into the ring, uploaded from there and the memory is reused once a fence
+// shows the GPU has read it.
+//
+// When the context supports GL_ARB_buffer_storage the ring is a persistently
+// mapped pixel unpack buffer, so uploads are asynchronous copies on the GPU
+// side. Otherwise it is plain client memory and uploads copy it synchronously.
+// The mapping is write only: reserved memory must never be read, so anything
+// that blends or decompresses in place does so elsewhere and copies it in.
+//
+// A ring belongs to the thread whose context created it.
+
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define STAGING_RING_SIZE (64 * 1024 * 1024)
+#define STAGING_RING_MAX_REGIONS 64
+#define STAGING_RING_ALIGNMENT 64
+
+// Returns 1 if `fence` has been signalled, waiting for it if `wait` is 1.
+typedef int (*StagingFenceSignaled)(void *fence, int wait);
+
+// An uploaded part of the ring, in use until its fence is signalled.
+typedef struct {
+    size_t end;
+    void *fence;
+} StagingRegion;
+
+typedef struct {
+    uint8_t *memory;
+    size_t size;
+    // Next free byte and start of the oldest region in flight
+    size_t head;
+    size_t tail;
+
+    StagingRegion regions[STAGING_RING_MAX_REGIONS];
+    size_t region_first;
+    size_t region_count;
+
+    // The reservation made by staging_ring_reserve, not yet committed
+    size_t reserved_offset;
+    size_t reserved_size;
+
+    // 0 if the ring is client memory
+    unsigned int buffer_id;
+    StagingFenceSignaled fence_signaled;
+} StagingRing;
+
+// Creates a ring of `size` bytes for the current context. Returns 0 on
+// success.
+int staging_ring_init(StagingRing *ring, size_t size);
+// Creates a ring backed by client memory, the fallback of staging_ring_init.
+void staging_ring_init_client(StagingRing *ring, size_t size);
+void staging_ring_free(StagingRing *ring);
+
+// Reserves `size` bytes to write to, waiting for earlier uploads if the ring
+// is full. Returns 0 if `size` does not fit in the ring at all. Only one
+// reservation can be pending at a time.
+void *staging_ring_reserve(StagingRing *ring, size_t size);
+// Hands the pending reservation over to the GPU, it is reused once `fence`
+// is signalled. A 0 fence releases the memory right away.
+void staging_ring_commit(StagingRing *ring, void *fence);
+// Releases the regions whose fences have been signalled.
+void staging_ring_retire(StagingRing *ring, int wait);
+
+// Uploads the pending reservation as RGBA8 pixels of a `width` x `height`
+// texture and commits it. The pixels are written into `reuse` if it has the
+// same size and format, no new texture storage is allocated then. Otherwise a
+// new texture is created.
+Texture staging_ring_upload_texture(StagingRing *ring, int width, int height,
+                                    Texture reuse);
+
+#endif
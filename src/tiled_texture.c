@@ -0,0 +1,414 @@
+#define GL_GLEXT_PROTOTYPES
+#include "tiled_texture.h"
+#include "ase_compose.h"
+#include "raymath.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Same as the default vertex shader of the viewer
+static const char *tiled_vertex_shader =
+    "#version 330                                                   \n"
+    "in vec3 vertexPosition;                                        \n"
+    "in vec2 vertexTexCoord;                                        \n"
+    "out vec2 fragTexCoord;                                         \n"
+    "uniform mat4 mvp;                                              \n"
+    "void main()                                                    \n"
+    "{                                                              \n"
+    "    fragTexCoord = vertexTexCoord;                             \n"
+    "    gl_Position = mvp*vec4(vertexPosition, 1.0);               \n"
+    "}                                                              \n";
+
+// Coordinates outside of the canvas repeat, like the untiled textures
+static const char *tiled_fragment_shader =
+    "#version 330                                                   \n"
+    "in vec2 fragTexCoord;                                          \n"
+    "out vec4 finalColor;                                           \n"
+    "uniform sampler2DArray texture0;                               \n"
+    "uniform vec4 colDiffuse;                                       \n"
+    "uniform vec2 canvasSize;                                       \n"
+    "uniform float tileSize;                                        \n"
+    "void main()                                                    \n"
+    "{                                                              \n"
+    "    vec2 tiles = ceil(canvasSize/tileSize);                    \n"
+    "    vec2 pixel = fract(fragTexCoord)*canvasSize;               \n"
+    "    vec2 tile = min(floor(pixel/tileSize), tiles - 1.0);       \n"
+    "    vec2 local = (pixel - tile*tileSize)/tileSize;             \n"
+    "    float layer = tile.y*tiles.x + tile.x;                     \n"
+    "    finalColor = texture(texture0, vec3(local, layer))*colDiffuse;\n"
+    "}                                                              \n";
+
+typedef struct {
+    TiledTexture *texture;
+    ase_t *ase;
+    // Of how the pixels of the cels are read, the start of every tile's hash
+    uint64_t seed;
+    int pixel_size;
+    atomic_size_t *next_tile;
+    atomic_size_t *tiles_composited;
+} ComposeWorker;
+
+void tiled_texture_init(TiledTexture *texture) {
+    *texture = (TiledTexture){0};
+    pthread_mutex_init(&texture->lock, 0);
+}
+
+void tiled_texture_free(TiledTexture *texture) {
+    if (texture->id)
+        glDeleteTextures(1, &texture->id);
+    free(texture->pixels);
+    free(texture->hashes);
+    free(texture->sources);
+    free(texture->dirty);
+    pthread_mutex_destroy(&texture->lock);
+    *texture = (TiledTexture){0};
+}
+
+int tiled_texture_max_size(void) {
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    return (int)max_size;
+}
+
+int tiled_texture_needed(int width, int height, int max_size) {
+    return width > max_size || height > max_size;
+}
+
+TilePlan tiled_texture_plan(int width, int height, int max_size) {
+    assert(width > 0 && height > 0 && max_size > 0);
+    int tile_size = TILED_TEXTURE_TILE_SIZE;
+    if (tile_size > max_size)
+        tile_size = max_size;
+    return (TilePlan){
+        .width = width,
+        .height = height,
+        .tile_size = tile_size,
+        .columns = (width + tile_size - 1) / tile_size,
+        .rows = (height + tile_size - 1) / tile_size,
+    };
+}
+
+static inline size_t tile_count(TilePlan plan) {
+    return (size_t)plan.columns * (size_t)plan.rows;
+}
+
+static inline size_t tile_bytes(TilePlan plan) {
+    return (size_t)plan.tile_size * (size_t)plan.tile_size * 4;
+}
+
+static inline int same_plan(TilePlan a, TilePlan b) {
+    return a.width == b.width && a.height == b.height &&
+           a.tile_size == b.tile_size;
+}
+
+// FNV-1a over words instead of bytes, with a shift to carry the high bits of
+// the product back down.
+static uint64_t hash_pixels(const uint8_t *pixels, size_t stride, int width,
+                            int height) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t row_size = (size_t)width * 4;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = pixels + (size_t)y * stride;
+        size_t i = 0;
+        for (; i + 8 <= row_size; i += 8) {
+            uint64_t word;
+            memcpy(&word, row + i, 8);
+            hash = (hash ^ word) * 0x100000001b3ull;
+            hash ^= hash >> 29;
+        }
+        if (i < row_size) {
+            uint32_t word;
+            memcpy(&word, row + i, 4);
+            hash = (hash ^ word) * 0x100000001b3ull;
+            hash ^= hash >> 29;
+        }
+    }
+    return hash;
+}
+
+// Same mixing as hash_pixels, in four independent lanes so that the
+// multiplications of large cels overlap.
+static inline uint64_t hash_bytes(uint64_t hash, const void *data,
+                                  size_t size) {
+    const uint8_t *bytes = data;
+    uint64_t lanes[4] = {hash, hash ^ 1, hash ^ 2, hash ^ 3};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            memcpy(&word, bytes + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0x100000001b3ull;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    if (i)
+        for (int lane = 0; lane < 4; lane++)
+            hash = (hash ^ lanes[lane]) * 0x100000001b3ull;
+    for (; i < size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+// Hash of the parts of the cels of the first frame inside the rectangle at
+// `x`, `y` of `w` x `h` pixels, along with everything changing how they are
+// blended. Only the rows inside the rectangle are read, which compositing the
+// tile reads next.
+static uint64_t hash_sources(const ComposeWorker *worker, int x, int y, int w,
+                             int h) {
+    ase_frame_t *frame = worker->ase->frames;
+    uint64_t hash = worker->seed;
+    for (int i = 0; i < frame->cel_count; i++) {
+        ase_cel_t *cel = frame->cels + i;
+        if (!ase_compose_cel_visible(cel))
+            continue;
+        cel = ase_compose_resolve_cel(cel);
+        if (!cel || cel->x >= x + w || cel->x + cel->w <= x ||
+            cel->y >= y + h || cel->y + cel->h <= y)
+            continue;
+
+        int left = cel->x < x ? x - cel->x : 0;
+        int top = cel->y < y ? y - cel->y : 0;
+        int right = cel->x + cel->w > x + w ? x + w - cel->x : cel->w;
+        int bottom = cel->y + cel->h > y + h ? y + h - cel->y : cel->h;
+        int params[7] = {
+            i,      cel->layer->blend_mode, ase_compose_cel_opacity(cel),
+            cel->x, cel->y,                 cel->w,
+            cel->h,
+        };
+        hash = hash_bytes(hash, params, sizeof(params));
+        size_t pixel_size = (size_t)worker->pixel_size;
+        const uint8_t *pixels = cel->pixels;
+        for (int row = top; row < bottom; row++)
+            hash = hash_bytes(
+                hash,
+                pixels + ((size_t)row * (size_t)cel->w + (size_t)left) *
+                             pixel_size,
+                (size_t)(right - left) * pixel_size);
+    }
+    // 0 is left for tiles never composited
+    return hash | 1;
+}
+
+static void *compose_worker(void *arg) {
+    ComposeWorker *worker = arg;
+    TiledTexture *texture = worker->texture;
+    TilePlan plan = texture->composed;
+    size_t count = tile_count(plan);
+    size_t stride = (size_t)plan.tile_size * 4;
+
+    while (1) {
+        size_t tile = atomic_fetch_add(worker->next_tile, 1);
+        if (tile >= count)
+            break;
+
+        int x = (int)(tile % (size_t)plan.columns) * plan.tile_size;
+        int y = (int)(tile / (size_t)plan.columns) * plan.tile_size;
+        int width = plan.width - x < plan.tile_size ? plan.width - x
+                                                    : plan.tile_size;
+        int height = plan.height - y < plan.tile_size ? plan.height - y
+                                                      : plan.tile_size;
+
+        // Composited again only if the cels overlapping it changed
+        uint64_t sources = hash_sources(worker, x, y, width, height);
+        if (sources == texture->sources[tile])
+            continue;
+        texture->sources[tile] = sources;
+        atomic_fetch_add(worker->tiles_composited, 1);
+
+        AseComposeTarget target = {
+            .pixels = texture->pixels + tile * tile_bytes(plan),
+            .stride = stride,
+            .format = ASE_COMPOSE_RGBA8,
+        };
+        ase_compose_region(worker->ase, 0, x, y, width, height, &target);
+
+        uint64_t hash = hash_pixels(target.pixels, stride, width, height);
+        if (hash != texture->hashes[tile])
+            texture->dirty[tile] = 1;
+        texture->hashes[tile] = hash;
+    }
+    return 0;
+}
+
+size_t tiled_texture_compose(TiledTexture *texture, ase_t *ase, int max_size,
+                             int worker_count) {
+    TilePlan plan = tiled_texture_plan(ase->w, ase->h, max_size);
+    size_t count = tile_count(plan);
+
+    pthread_mutex_lock(&texture->lock);
+    if (!same_plan(plan, texture->composed)) {
+        free(texture->pixels);
+        free(texture->hashes);
+        free(texture->sources);
+        free(texture->dirty);
+        // The parts of the edge tiles past the canvas are never sampled, but
+        // are uploaded along with the rest
+        texture->pixels = calloc(count, tile_bytes(plan));
+        texture->hashes = calloc(count, sizeof(uint64_t));
+        texture->sources = calloc(count, sizeof(uint64_t));
+        texture->dirty = malloc(count);
+        if (!texture->pixels || !texture->hashes || !texture->sources ||
+            !texture->dirty)
+            abort();
+        // A new array texture is created for the new size
+        memset(texture->dirty, 1, count);
+        texture->composed = plan;
+    }
+
+    // Indexed pixels change color with the palette
+    uint64_t seed = hash_bytes(0xcbf29ce484222325ull, &ase->mode,
+                               sizeof(ase->mode));
+    int pixel_size = 4;
+    if (ase->mode == ASE_MODE_GRAYSCALE) {
+        pixel_size = 2;
+    } else if (ase->mode == ASE_MODE_INDEXED) {
+        pixel_size = 1;
+        seed = hash_bytes(seed, &ase->transparent_palette_entry_index,
+                          sizeof(int));
+        for (int i = 0; i < ase->palette.entry_count; i++)
+            seed = hash_bytes(seed, &ase->palette.entries[i].color,
+                              sizeof(ase_color_t));
+    }
+
+    if (!worker_count) {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        worker_count = processor_count > 0 ? (int)processor_count : 1;
+    }
+    if (worker_count > TILED_TEXTURE_MAX_WORKERS)
+        worker_count = TILED_TEXTURE_MAX_WORKERS;
+    if ((size_t)worker_count > count)
+        worker_count = (int)count;
+
+    // The calling thread is one of the workers
+    atomic_size_t next_tile = 0;
+    atomic_size_t tiles_composited = 0;
+    ComposeWorker worker = {
+        .texture = texture,
+        .ase = ase,
+        .seed = seed,
+        .pixel_size = pixel_size,
+        .next_tile = &next_tile,
+        .tiles_composited = &tiles_composited,
+    };
+    pthread_t threads[TILED_TEXTURE_MAX_WORKERS];
+    int started[TILED_TEXTURE_MAX_WORKERS] = {0};
+    for (int i = 1; i < worker_count; i++)
+        started[i] = !pthread_create(threads + i, 0, &compose_worker, &worker);
+    compose_worker(&worker);
+    for (int i = 1; i < worker_count; i++) {
+        if (started[i])
+            pthread_join(threads[i], 0);
+    }
+    texture->tiles_composited = tiles_composited;
+
+    texture->dirty_count = 0;
+    for (size_t i = 0; i < count; i++)
+        texture->dirty_count += texture->dirty[i];
+    size_t dirty_count = texture->dirty_count;
+    pthread_mutex_unlock(&texture->lock);
+    return dirty_count;
+}
+
+int tiled_texture_upload(TiledTexture *texture) {
+    if (pthread_mutex_trylock(&texture->lock))
+        return 1;
+    TilePlan plan = texture->composed;
+    if (!texture->pixels || !texture->dirty_count) {
+        pthread_mutex_unlock(&texture->lock);
+        return 0;
+    }
+
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (tile_count(plan) > (size_t)max_layers) {
+        fprintf(stderr,
+                "ERROR: a %dx%d canvas needs %zu tiles, the GL limit is %d\n",
+                plan.width, plan.height, tile_count(plan), (int)max_layers);
+        pthread_mutex_unlock(&texture->lock);
+        return 2;
+    }
+
+    if (texture->id && same_plan(plan, texture->plan)) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+    } else {
+        if (texture->id)
+            glDeleteTextures(1, &texture->id);
+        glGenTextures(1, &texture->id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, plan.tile_size,
+                     plan.tile_size, (GLsizei)tile_count(plan), 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, 0);
+        // Sampled like the untiled textures, which raylib leaves at point
+        // filtering. Clamped so that tile edges do not pull in the opposite
+        // edge.
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,
+                        GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,
+                        GL_CLAMP_TO_EDGE);
+        texture->plan = plan;
+    }
+
+    for (size_t i = 0; i < tile_count(plan); i++) {
+        if (!texture->dirty[i])
+            continue;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)i,
+                        plan.tile_size, plan.tile_size, 1, GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        texture->pixels + i * tile_bytes(plan));
+        texture->dirty[i] = 0;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    texture->dirty_count = 0;
+    pthread_mutex_unlock(&texture->lock);
+    return 0;
+}
+
+size_t tiled_texture_bytes(const TiledTexture *texture) {
+    if (!texture->id)
+        return 0;
+    return tile_count(texture->plan) * tile_bytes(texture->plan);
+}
+
+TiledShader tiled_shader_load(void) {
+    TiledShader shader = {
+        .shader =
+            LoadShaderFromMemory(tiled_vertex_shader, tiled_fragment_shader),
+    };
+    shader.canvas_size_location =
+        GetShaderLocation(shader.shader, "canvasSize");
+    shader.tile_size_location = GetShaderLocation(shader.shader, "tileSize");
+    return shader;
+}
+
+void tiled_shader_unload(TiledShader *shader) {
+    if (shader->shader.id)
+        UnloadShader(shader->shader);
+    *shader = (TiledShader){0};
+}
+
+void tiled_texture_draw(TiledShader *shader, const TiledTexture *texture,
+                        Mesh mesh, Material material) {
+    float canvas_size[2] = {(float)texture->plan.width,
+                            (float)texture->plan.height};
+    float tile_size = (float)texture->plan.tile_size;
+    SetShaderValue(shader->shader, shader->canvas_size_location, canvas_size,
+                   SHADER_UNIFORM_VEC2);
+    SetShaderValue(shader->shader, shader->tile_size_location, &tile_size,
+                   SHADER_UNIFORM_FLOAT);
+
+    // texture0 is sampled from unit 0, where the 2D texture raylib binds for
+    // the material does not get in the way of the array
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+    material.shader = shader->shader;
+    DrawMesh(mesh, material, MatrixIdentity());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
@@ -0,0 +1,94 @@
+#ifndef _TILED_TEXTURE
+#define _TILED_TEXTURE
+
+// Textures of aseprite canvases larger than the GL texture size limit, split
+// into square tiles stored as the layers of a 2D array texture. The tiled
+// shader maps the texture coordinates of the canvas to a tile and a position
+// within it, so meshes are drawn with their UVs unchanged.
+//
+// Tiles are composited on worker threads straight from the cels overlapping
+// them, and each tile is hashed so that reloads only upload the tiles whose
+// pixels changed. The tiles are kept between reloads, and only those
+// overlapping a cel that changed are composited again.
+//
+// Compositing may happen on any thread, uploading and drawing on the thread
+// owning the GL context.
+
+#include "cute_aseprite.h"
+#include "raylib.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Edge length of the tiles, unless the GL limit is smaller. Smaller tiles
+// mean less to upload for a small edit but more layers.
+#define TILED_TEXTURE_TILE_SIZE 2048
+#define TILED_TEXTURE_MAX_WORKERS 16
+
+typedef struct {
+    int width;
+    int height;
+    int tile_size;
+    int columns;
+    int rows;
+} TilePlan;
+
+typedef struct {
+    // Drawn, set by tiled_texture_upload. The GL_TEXTURE_2D_ARRAY has a layer
+    // per tile, row by row, 0 until the first upload.
+    unsigned int id;
+    TilePlan plan;
+
+    // Set by tiled_texture_compose, guarded by `lock`
+    pthread_mutex_t lock;
+    TilePlan composed;
+    // RGBA8 tiles of tile_size x tile_size pixels, in layer order
+    uint8_t *pixels;
+    // Of the tiles last composited
+    uint64_t *hashes;
+    // Of the cels overlapping each tile when it was last composited, 0 if it
+    // never was
+    uint64_t *sources;
+    // Tiles composited by the latest tiled_texture_compose
+    size_t tiles_composited;
+    // 1 for the tiles changed since the last upload
+    uint8_t *dirty;
+    size_t dirty_count;
+} TiledTexture;
+
+typedef struct {
+    Shader shader;
+    int canvas_size_location;
+    int tile_size_location;
+} TiledShader;
+
+void tiled_texture_init(TiledTexture *texture);
+void tiled_texture_free(TiledTexture *texture);
+
+// GL_MAX_TEXTURE_SIZE of the current context.
+int tiled_texture_max_size(void);
+// Whether a `width` x `height` canvas has to be tiled.
+int tiled_texture_needed(int width, int height, int max_size);
+// Tiles covering a `width` x `height` canvas, none larger than `max_size`.
+TilePlan tiled_texture_plan(int width, int height, int max_size);
+
+// Composites the first frame of `ase` tile by tile on `worker_count` threads,
+// or one per processor if 0, and marks the tiles whose pixels changed. Tiles
+// whose cels are the same as last time are skipped. Every tile changes if the
+// canvas size did. Returns the number of tiles to upload.
+size_t tiled_texture_compose(TiledTexture *texture, ase_t *ase, int max_size,
+                             int worker_count);
+// Uploads the changed tiles, creating the array texture if the tiles do not
+// fit the current one. Returns 0 if it was uploaded, 1 if compositing is in
+// progress on another thread, 2 if the GL limits cannot hold the tiles.
+int tiled_texture_upload(TiledTexture *texture);
+// Bytes of the array texture.
+size_t tiled_texture_bytes(const TiledTexture *texture);
+
+TiledShader tiled_shader_load(void);
+void tiled_shader_unload(TiledShader *shader);
+// Draws `mesh` with `texture` in place of the diffuse map of `material`.
+void tiled_texture_draw(TiledShader *shader, const TiledTexture *texture,
+                        Mesh mesh, Material material);
+
+#endif
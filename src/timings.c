@@ -0,0 +1,134 @@
+#define _DEFAULT_SOURCE
+#include "timings.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *kind_names[TIMING_KIND_COUNT] = {
+    [TIMING_ARGUMENTS] = "argument parsing",
+    [TIMING_WINDOW] = "window and GL init",
+    [TIMING_SHADER] = "shader compile",
+    [TIMING_DISCOVERY] = "texture discovery",
+    [TIMING_TEXTURE_PROBE] = "texture probe",
+    [TIMING_MESH_LOAD] = "mesh load",
+    [TIMING_TEXTURE_DECODE] = "texture decode",
+    [TIMING_TEXTURE_UPLOAD] = "texture upload",
+    [TIMING_WATCH] = "watch registration",
+};
+
+double timings_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void timings_add(Timings *timings, TimingKind kind, const char *filepath,
+                 double start) {
+    if (!timings->enabled)
+        return;
+    timings_add_seconds(timings, kind, filepath, timings_now() - start);
+}
+
+void timings_add_seconds(Timings *timings, TimingKind kind,
+                         const char *filepath, double seconds) {
+    if (!timings->enabled)
+        return;
+
+    if (timings->entries_used >= timings->entries_allocated) {
+        timings->entries_allocated =
+            timings->entries_allocated ? timings->entries_allocated * 2 : 64;
+        timings->entries =
+            realloc(timings->entries,
+                    timings->entries_allocated * sizeof(TimingEntry));
+        if (!timings->entries)
+            abort();
+    }
+
+    TimingEntry entry = {.kind = kind, .seconds = seconds};
+    if (filepath) {
+        entry.filepath = strdup(filepath);
+        if (!entry.filepath)
+            abort();
+    }
+    timings->entries[timings->entries_used++] = entry;
+    timings->recorded_seconds += seconds;
+}
+
+double timings_kind_total(Timings *timings, TimingKind kind) {
+    double total = 0;
+    for (size_t i = 0; i < timings->entries_used; i++) {
+        if (timings->entries[i].kind == kind)
+            total += timings->entries[i].seconds;
+    }
+    return total;
+}
+
+size_t timings_kind_count(Timings *timings, TimingKind kind) {
+    size_t count = 0;
+    for (size_t i = 0; i < timings->entries_used; i++)
+        count += timings->entries[i].kind == kind;
+    return count;
+}
+
+size_t timings_slowest(Timings *timings, TimingEntry **out, size_t count) {
+    size_t stored = 0;
+
+    // Insertion into a small sorted list, `count` is tiny
+    for (size_t i = 0; i < timings->entries_used; i++) {
+        TimingEntry *entry = timings->entries + i;
+        if (!entry->filepath)
+            continue;
+
+        size_t position = stored;
+        while (position > 0 && out[position - 1]->seconds < entry->seconds)
+            position--;
+        if (position >= count)
+            continue;
+
+        size_t last = stored < count ? stored : count - 1;
+        memmove(out + position + 1, out + position,
+                (last - position) * sizeof(TimingEntry *));
+        out[position] = entry;
+        if (stored < count)
+            stored++;
+    }
+
+    return stored;
+}
+
+void timings_print(Timings *timings, double total_seconds, FILE *file) {
+    fprintf(file, "Startup timings:\n");
+    for (int kind = 0; kind < TIMING_KIND_COUNT; kind++) {
+        size_t count = timings_kind_count(timings, kind);
+        if (!count)
+            continue;
+        fprintf(file, "  %-20s %10.3f ms", kind_names[kind],
+                timings_kind_total(timings, kind) * 1000.0);
+        if (kind >= TIMING_MESH_LOAD)
+            fprintf(file, "  (%zu files)", count);
+        fprintf(file, "\n");
+    }
+    fprintf(file, "  %-20s %10.3f ms\n", "other",
+            (total_seconds - timings->recorded_seconds) * 1000.0);
+    fprintf(file, "  %-20s %10.3f ms\n", "total", total_seconds * 1000.0);
+
+    TimingEntry *slowest[TIMINGS_SLOWEST_COUNT];
+    size_t slowest_count =
+        timings_slowest(timings, slowest, TIMINGS_SLOWEST_COUNT);
+    if (!slowest_count)
+        return;
+
+    fprintf(file, "Slowest assets:\n");
+    for (size_t i = 0; i < slowest_count; i++)
+        fprintf(file, "  %10.3f ms  %-16s %s\n", slowest[i]->seconds * 1000.0,
+                kind_names[slowest[i]->kind], slowest[i]->filepath);
+}
+
+void timings_free(Timings *timings) {
+    for (size_t i = 0; i < timings->entries_used; i++)
+        free(timings->entries[i].filepath);
+    free(timings->entries);
+    timings->entries = 0;
+    timings->entries_used = 0;
+    timings->entries_allocated = 0;
+}
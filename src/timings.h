@@ -0,0 +1,59 @@
+#ifndef _TIMINGS
+#define _TIMINGS
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Number of assets listed in the "slowest assets" part of the report
+#define TIMINGS_SLOWEST_COUNT 5
+
+typedef enum {
+    TIMING_ARGUMENTS,
+    TIMING_WINDOW,
+    TIMING_SHADER,
+    TIMING_DISCOVERY,
+    TIMING_TEXTURE_PROBE,
+    TIMING_MESH_LOAD,
+    TIMING_TEXTURE_DECODE,
+    TIMING_TEXTURE_UPLOAD,
+    TIMING_WATCH,
+    TIMING_KIND_COUNT,
+} TimingKind;
+
+// A single measured phase, `filepath` is 0 for phases not tied to an asset.
+typedef struct {
+    TimingKind kind;
+    double seconds;
+    char *filepath;
+} TimingEntry;
+
+// Startup phase timings for the -timings report. Nothing is recorded unless
+// `enabled` is set.
+typedef struct {
+    int enabled;
+    TimingEntry *entries;
+    size_t entries_allocated;
+    size_t entries_used;
+    // Sum of the seconds of all entries
+    double recorded_seconds;
+} Timings;
+
+// Monotonic time in seconds, usable before the window is created.
+double timings_now(void);
+// Records a phase that started at `start` (from timings_now) and ends now.
+// `filepath` is copied.
+void timings_add(Timings *timings, TimingKind kind, const char *filepath,
+                 double start);
+// Records a phase of known length.
+void timings_add_seconds(Timings *timings, TimingKind kind,
+                         const char *filepath, double seconds);
+double timings_kind_total(Timings *timings, TimingKind kind);
+size_t timings_kind_count(Timings *timings, TimingKind kind);
+// Stores pointers to the `count` slowest asset entries into `out`, slowest
+// first. Returns the number of entries stored.
+size_t timings_slowest(Timings *timings, TimingEntry **out, size_t count);
+// Prints totals per phase, `total_seconds` and the slowest assets.
+void timings_print(Timings *timings, double total_seconds, FILE *file);
+void timings_free(Timings *timings);
+
+#endif
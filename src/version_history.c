@@ -0,0 +1,348 @@
+#include "version_history.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Matches are at least this long, and the hash covers as many bytes
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 14
+#define LZ_MAX_OFFSET 65535
+// Lengths from 15 on continue in the bytes after the token
+#define LZ_LENGTH_EXTENDED 15
+
+// Vertex arrays stored of a mesh, the present ones follow this header in
+// this order
+enum {
+    MESH_VERTICES,
+    MESH_TEXCOORDS,
+    MESH_TEXCOORDS2,
+    MESH_NORMALS,
+    MESH_TANGENTS,
+    MESH_COLORS,
+    MESH_INDICES,
+    MESH_ARRAY_COUNT,
+};
+
+typedef struct {
+    int32_t vertex_count;
+    int32_t triangle_count;
+    uint32_t arrays;
+} MeshHeader;
+
+typedef struct {
+    void **data;
+    size_t size;
+} MeshArray;
+
+static inline void mesh_arrays(Mesh *mesh, MeshArray *arrays) {
+    size_t vertex_count = (size_t)mesh->vertexCount;
+    arrays[MESH_VERTICES] =
+        (MeshArray){(void **)&mesh->vertices, vertex_count * 3 * sizeof(float)};
+    arrays[MESH_TEXCOORDS] = (MeshArray){(void **)&mesh->texcoords,
+                                         vertex_count * 2 * sizeof(float)};
+    arrays[MESH_TEXCOORDS2] = (MeshArray){(void **)&mesh->texcoords2,
+                                          vertex_count * 2 * sizeof(float)};
+    arrays[MESH_NORMALS] =
+        (MeshArray){(void **)&mesh->normals, vertex_count * 3 * sizeof(float)};
+    arrays[MESH_TANGENTS] =
+        (MeshArray){(void **)&mesh->tangents, vertex_count * 4 * sizeof(float)};
+    arrays[MESH_COLORS] = (MeshArray){(void **)&mesh->colors, vertex_count * 4};
+    arrays[MESH_INDICES] =
+        (MeshArray){(void **)&mesh->indices,
+                    (size_t)mesh->triangleCount * 3 * sizeof(unsigned short)};
+}
+
+static inline void *grow(uint8_t **buffer, size_t *allocated, size_t size) {
+    if (size > *allocated) {
+        *buffer = realloc(*buffer, size);
+        if (!*buffer)
+            abort();
+        *allocated = size;
+    }
+    return *buffer;
+}
+
+static inline uint32_t read_u32(const uint8_t *in) {
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hash_sequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline uint8_t *write_length(uint8_t *out, size_t length) {
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+// Writes the token and literals of a sequence, the match is written after.
+static inline uint8_t *write_literals(uint8_t *out, const uint8_t *literals,
+                                      size_t count) {
+    *out++ = (uint8_t)((count < LZ_LENGTH_EXTENDED ? count
+                                                   : LZ_LENGTH_EXTENDED)
+                       << 4);
+    if (count >= LZ_LENGTH_EXTENDED)
+        out = write_length(out, count - LZ_LENGTH_EXTENDED);
+    memcpy(out, literals, count);
+    return out + count;
+}
+
+size_t version_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t version_compress(const uint8_t *in, size_t size, uint8_t *out) {
+    assert(size <= UINT32_MAX);
+    // Last position of each hashed sequence
+    uint32_t positions[1 << LZ_HASH_BITS] = {0};
+    uint8_t *start = out;
+    size_t anchor = 0;
+    size_t i = 0;
+
+    while (i + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = read_u32(in + i);
+        uint32_t *position = positions + hash_sequence(sequence);
+        size_t candidate = *position;
+        *position = (uint32_t)i;
+
+        if (candidate >= i || i - candidate > LZ_MAX_OFFSET ||
+            read_u32(in + candidate) != sequence) {
+            // Skips ahead faster the longer nothing matched
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+
+        size_t match = LZ_MIN_MATCH;
+        while (i + match < size && in[candidate + match] == in[i + match])
+            match++;
+
+        uint8_t *token = out;
+        out = write_literals(out, in + anchor, i - anchor);
+        size_t offset = i - candidate;
+        *out++ = (uint8_t)offset;
+        *out++ = (uint8_t)(offset >> 8);
+        size_t match_code = match - LZ_MIN_MATCH;
+        *token |= (uint8_t)(match_code < LZ_LENGTH_EXTENDED
+                                ? match_code
+                                : LZ_LENGTH_EXTENDED);
+        if (match_code >= LZ_LENGTH_EXTENDED)
+            out = write_length(out, match_code - LZ_LENGTH_EXTENDED);
+
+        i += match;
+        anchor = i;
+    }
+
+    // The last sequence has no match
+    out = write_literals(out, in + anchor, size - anchor);
+    return (size_t)(out - start);
+}
+
+// Reads the rest of a length starting with `length` in the token. Returns 0
+// if the input ends first.
+static inline const uint8_t *read_length(const uint8_t *in, const uint8_t *end,
+                                         size_t *length) {
+    if (*length < LZ_LENGTH_EXTENDED)
+        return in;
+    uint8_t byte;
+    do {
+        if (in >= end)
+            return 0;
+        byte = *in++;
+        *length += byte;
+    } while (byte == 255);
+    return in;
+}
+
+int version_decompress(const uint8_t *in, size_t size, uint8_t *out,
+                       size_t out_size) {
+    const uint8_t *in_end = in + size;
+    uint8_t *out_start = out;
+    uint8_t *out_end = out + out_size;
+
+    // Streams end with a sequence of literals only
+    while (in < in_end) {
+        uint8_t token = *in++;
+        size_t literals = token >> 4;
+        in = read_length(in, in_end, &literals);
+        if (!in || literals > (size_t)(in_end - in) ||
+            literals > (size_t)(out_end - out))
+            return 1;
+        memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == in_end)
+            return out != out_end;
+
+        if (in_end - in < 2)
+            return 1;
+        size_t offset = (size_t)in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t match = token & 0x0f;
+        in = read_length(in, in_end, &match);
+        match += LZ_MIN_MATCH;
+        if (!in || !offset || offset > (size_t)(out - out_start) ||
+            match > (size_t)(out_end - out))
+            return 1;
+
+        // Overlapping matches repeat the bytes just written, which are
+        // copied in chunks doubling in size
+        const uint8_t *from = out - offset;
+        uint8_t *match_end = out + match;
+        while (out < match_end) {
+            size_t chunk = (size_t)(out - from);
+            if (chunk > (size_t)(match_end - out))
+                chunk = (size_t)(match_end - out);
+            memcpy(out, from, chunk);
+            out += chunk;
+        }
+    }
+    return 1;
+}
+
+void version_history_init(VersionHistory *history, size_t capacity) {
+    *history = (VersionHistory){
+        .capacity =
+            capacity < VERSION_HISTORY_MAX ? capacity : VERSION_HISTORY_MAX,
+    };
+}
+
+void version_history_free(VersionHistory *history) {
+    for (size_t i = 0; i < VERSION_HISTORY_MAX; i++)
+        free(history->versions[i].data);
+    free(history->raw);
+    free(history->compressed);
+    *history = (VersionHistory){0};
+}
+
+int version_history_record(VersionHistory *history, const void *data,
+                           size_t size, int width, int height) {
+    if (!history->capacity)
+        return 1;
+
+    uint8_t *compressed =
+        grow(&history->compressed, &history->compressed_allocated,
+             version_compress_bound(size));
+    size_t compressed_size = version_compress(data, size, compressed);
+
+    // The slot of the oldest version, once the ring is full
+    AssetVersion *version = history->versions + history->next;
+    history->compressed_bytes -= version->size;
+    version->data = realloc(version->data, compressed_size ? compressed_size
+                                                           : 1);
+    if (!version->data)
+        abort();
+    memcpy(version->data, compressed, compressed_size);
+    version->size = compressed_size;
+    version->raw_size = size;
+    version->width = width;
+    version->height = height;
+    version->number = ++history->recorded;
+    history->compressed_bytes += compressed_size;
+
+    history->next = (history->next + 1) % history->capacity;
+    if (history->count < history->capacity)
+        history->count++;
+    history->shown = 0;
+    return 0;
+}
+
+int version_history_record_mesh(VersionHistory *history, const Mesh *mesh) {
+    Mesh arrays_of = *mesh;
+    MeshArray arrays[MESH_ARRAY_COUNT];
+    mesh_arrays(&arrays_of, arrays);
+
+    MeshHeader header = {
+        .vertex_count = mesh->vertexCount,
+        .triangle_count = mesh->triangleCount,
+    };
+    size_t size = sizeof(header);
+    for (int i = 0; i < MESH_ARRAY_COUNT; i++) {
+        if (!*arrays[i].data)
+            continue;
+        header.arrays |= 1u << i;
+        size += arrays[i].size;
+    }
+
+    uint8_t *raw = grow(&history->raw, &history->raw_allocated, size);
+    memcpy(raw, &header, sizeof(header));
+    size_t offset = sizeof(header);
+    for (int i = 0; i < MESH_ARRAY_COUNT; i++) {
+        if (!(header.arrays & 1u << i))
+            continue;
+        memcpy(raw + offset, *arrays[i].data, arrays[i].size);
+        offset += arrays[i].size;
+    }
+    return version_history_record(history, raw, size, 0, 0);
+}
+
+const AssetVersion *version_history_get(VersionHistory *history, size_t age) {
+    if (age >= history->count)
+        return 0;
+    size_t slot =
+        (history->next + history->capacity - 1 - age) % history->capacity;
+    return history->versions + slot;
+}
+
+int version_history_step(VersionHistory *history, int direction) {
+    if (direction > 0 && history->shown + 1 < history->count) {
+        history->shown++;
+        return 1;
+    }
+    if (direction < 0 && history->shown > 0) {
+        history->shown--;
+        return 1;
+    }
+    return 0;
+}
+
+int version_history_read(const AssetVersion *version, void *out) {
+    return version_decompress(version->data, version->size, out,
+                              version->raw_size);
+}
+
+Mesh version_history_read_mesh(const AssetVersion *version) {
+    Mesh mesh = {0};
+    if (version->raw_size < sizeof(MeshHeader))
+        return mesh;
+    uint8_t *raw = malloc(version->raw_size);
+    if (!raw)
+        abort();
+    if (version_history_read(version, raw)) {
+        free(raw);
+        return mesh;
+    }
+
+    MeshHeader header;
+    memcpy(&header, raw, sizeof(header));
+    mesh.vertexCount = header.vertex_count;
+    mesh.triangleCount = header.triangle_count;
+    MeshArray arrays[MESH_ARRAY_COUNT];
+    mesh_arrays(&mesh, arrays);
+
+    size_t offset = sizeof(header);
+    for (int i = 0; i < MESH_ARRAY_COUNT; i++) {
+        if (!(header.arrays & 1u << i))
+            continue;
+        if (arrays[i].size > version->raw_size - offset)
+            break;
+        *arrays[i].data = malloc(arrays[i].size ? arrays[i].size : 1);
+        if (!*arrays[i].data)
+            abort();
+        memcpy(*arrays[i].data, raw + offset, arrays[i].size);
+        offset += arrays[i].size;
+    }
+    free(raw);
+
+    if (offset != version->raw_size) {
+        for (int i = 0; i < MESH_ARRAY_COUNT; i++)
+            free(*arrays[i].data);
+        return (Mesh){0};
+    }
+    return mesh;
+}
@@ -0,0 +1,85 @@
+#ifndef _VERSION_HISTORY
+#define _VERSION_HISTORY
+
+// The last few versions of an asset as loaded, compressed in memory, so that
+// a re-export can be compared with the previous one without reading or
+// parsing any files.
+//
+// Versions are stored as the processed data: the vertex arrays of a mesh, or
+// the composited pixels of a texture. They are compressed with a byte
+// oriented LZ77 variant that is fast in both directions, and kept in a ring
+// where the oldest version makes room for the newest.
+
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define VERSION_HISTORY_MAX 32
+// Versions kept of each asset unless set with -history, none as recording
+// costs a compression of every load
+#define VERSION_HISTORY_DEFAULT 0
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t raw_size;
+    // Of pixels, 0 for meshes
+    int width;
+    int height;
+    // Counts the versions recorded, starting from 1
+    uint64_t number;
+} AssetVersion;
+
+typedef struct {
+    AssetVersion versions[VERSION_HISTORY_MAX];
+    size_t capacity;
+    size_t count;
+    // Slot of the next version
+    size_t next;
+    uint64_t recorded;
+    // Versions before the newest one of the version shown
+    size_t shown;
+    size_t compressed_bytes;
+    // Serialized meshes and compression output, reused between versions
+    uint8_t *raw;
+    size_t raw_allocated;
+    uint8_t *compressed;
+    size_t compressed_allocated;
+} VersionHistory;
+
+// Keeps up to `capacity` versions, at most VERSION_HISTORY_MAX.
+void version_history_init(VersionHistory *history, size_t capacity);
+void version_history_free(VersionHistory *history);
+
+// Records `size` bytes as the newest version and shows it. `width` and
+// `height` are kept along for pixels. Returns 0 on success.
+int version_history_record(VersionHistory *history, const void *data,
+                           size_t size, int width, int height);
+// Records the vertex arrays of `mesh` as the newest version and shows it.
+int version_history_record_mesh(VersionHistory *history, const Mesh *mesh);
+
+// The version `age` versions before the newest, 0 if there is none.
+const AssetVersion *version_history_get(VersionHistory *history, size_t age);
+// Shows the version one older (`direction` 1) or newer (-1) than the one
+// shown, if there is one. Returns 1 if the version shown changed.
+int version_history_step(VersionHistory *history, int direction);
+
+// Decompresses the `raw_size` bytes of `version` into `out`. Returns 0 on
+// success.
+int version_history_read(const AssetVersion *version, void *out);
+// Decompresses a version recorded with version_history_record_mesh into a
+// mesh with newly allocated arrays, not uploaded. The mesh is empty on
+// failure.
+Mesh version_history_read_mesh(const AssetVersion *version);
+
+// Compressed size of `size` bytes at most.
+size_t version_compress_bound(size_t size);
+// Compresses `size` bytes of `in` into `out`, of at least
+// version_compress_bound(size) bytes. Returns the compressed size.
+size_t version_compress(const uint8_t *in, size_t size, uint8_t *out);
+// Decompresses `size` bytes of `in`, which must result in exactly `out_size`
+// bytes. Returns 0 on success.
+int version_decompress(const uint8_t *in, size_t size, uint8_t *out,
+                       size_t out_size);
+
+#endif
@@ -0,0 +1,361 @@
+#include "voxel_mesh.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Position, texture coordinate and normal
+#define VERTEX_FLOATS 8
+#define QUAD_FLOATS (6 * VERTEX_FLOATS)
+
+typedef struct {
+    float x, y, z;
+} Vec3;
+
+typedef struct {
+    float u, v;
+} Vec2;
+
+// Placement of the sprite in model space
+typedef struct {
+    float scale;
+    float half_width;
+    float half_height;
+} Layout;
+
+static inline Vec3 add(Vec3 a, Vec3 b) {
+    return (Vec3){a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+static inline Vec2 add_uv(Vec2 a, Vec2 b) {
+    return (Vec2){a.u + b.u, a.v + b.v};
+}
+
+static inline float x_of(const Layout *layout, int column) {
+    return ((float)column - layout->half_width) * layout->scale;
+}
+
+// Rows go down the image and up in model space
+static inline float y_of(const Layout *layout, int row) {
+    return (layout->half_height - (float)row) * layout->scale;
+}
+
+static inline int is_solid(VoxelMesher *mesher, int x, int y) {
+    return mesher->solid[(size_t)y * (size_t)mesher->width + (size_t)x];
+}
+
+static inline void write_vertex(float *out, Vec3 position, Vec2 uv,
+                                Vec3 normal) {
+    out[0] = position.x;
+    out[1] = position.y;
+    out[2] = position.z;
+    out[3] = uv.u;
+    out[4] = uv.v;
+    out[5] = normal.x;
+    out[6] = normal.y;
+    out[7] = normal.z;
+}
+
+// Adds the quad spanned by `edge_u` and `edge_v` from `corner`, facing
+// `normal`. `uv` is the texture coordinate at `corner`, `uv_u` and `uv_v` its
+// change along the edges.
+static void emit_quad(VoxelBand *band, Vec3 corner, Vec3 edge_u, Vec3 edge_v,
+                      Vec3 normal, Vec2 uv, Vec2 uv_u, Vec2 uv_v) {
+    // Counter-clockwise when seen from the side the normal points to
+    Vec3 cross = {
+        edge_u.y * edge_v.z - edge_u.z * edge_v.y,
+        edge_u.z * edge_v.x - edge_u.x * edge_v.z,
+        edge_u.x * edge_v.y - edge_u.y * edge_v.x,
+    };
+    if (cross.x * normal.x + cross.y * normal.y + cross.z * normal.z < 0.0f) {
+        Vec3 edge = edge_u;
+        edge_u = edge_v;
+        edge_v = edge;
+        Vec2 uv_edge = uv_u;
+        uv_u = uv_v;
+        uv_v = uv_edge;
+    }
+
+    if (band->quad_count >= band->quads_allocated) {
+        band->quads_allocated =
+            band->quads_allocated ? band->quads_allocated * 2 : 64;
+        band->data = realloc(band->data, band->quads_allocated * QUAD_FLOATS *
+                                             sizeof(float));
+        if (!band->data)
+            abort();
+    }
+
+    Vec3 positions[4] = {corner, add(corner, edge_u),
+                         add(add(corner, edge_u), edge_v), add(corner, edge_v)};
+    Vec2 uvs[4] = {uv, add_uv(uv, uv_u), add_uv(add_uv(uv, uv_u), uv_v),
+                   add_uv(uv, uv_v)};
+    static const int order[6] = {0, 1, 2, 0, 2, 3};
+
+    float *out = band->data + band->quad_count++ * QUAD_FLOATS;
+    for (int i = 0; i < 6; i++)
+        write_vertex(out + i * VERTEX_FLOATS, positions[order[i]],
+                     uvs[order[i]], normal);
+}
+
+// Merges the front and back faces of rows `first` to `last` into rectangles.
+static void mesh_front_and_back(VoxelMesher *mesher, VoxelBand *band,
+                                const Layout *layout, int first, int last) {
+    int width = mesher->width;
+    float w = (float)mesher->width;
+    float h = (float)mesher->height;
+    float half_depth = layout->scale / 2.0f;
+    memset(mesher->merged, 0, (size_t)width * VOXEL_BAND_ROWS);
+
+#define MERGED(x, y) mesher->merged[(size_t)((y) - first) * width + (x)]
+
+    for (int y = first; y <= last; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!is_solid(mesher, x, y) || MERGED(x, y))
+                continue;
+
+            int x_end = x + 1;
+            while (x_end < width && is_solid(mesher, x_end, y) &&
+                   !MERGED(x_end, y))
+                x_end++;
+
+            int y_end = y + 1;
+            while (y_end <= last) {
+                int row_fits = 1;
+                for (int i = x; i < x_end && row_fits; i++)
+                    row_fits = is_solid(mesher, i, y_end) && !MERGED(i, y_end);
+                if (!row_fits)
+                    break;
+                y_end++;
+            }
+
+            for (int j = y; j < y_end; j++)
+                memset(&MERGED(x, j), 1, (size_t)(x_end - x));
+
+            Vec3 edge_u = {x_of(layout, x_end) - x_of(layout, x), 0, 0};
+            Vec3 edge_v = {0, y_of(layout, y) - y_of(layout, y_end), 0};
+            Vec2 uv = {(float)x / w, (float)y_end / h};
+            Vec2 uv_u = {(float)(x_end - x) / w, 0};
+            Vec2 uv_v = {0, -(float)(y_end - y) / h};
+
+            Vec3 front = {x_of(layout, x), y_of(layout, y_end), half_depth};
+            Vec3 back = {front.x, front.y, -half_depth};
+            emit_quad(band, front, edge_u, edge_v, (Vec3){0, 0, 1}, uv, uv_u,
+                      uv_v);
+            emit_quad(band, back, edge_u, edge_v, (Vec3){0, 0, -1}, uv, uv_u,
+                      uv_v);
+        }
+    }
+
+#undef MERGED
+}
+
+// Top and bottom faces, merged along each row. `side` is -1 for the top faces
+// and 1 for the bottom faces.
+static void mesh_row_edges(VoxelMesher *mesher, VoxelBand *band,
+                           const Layout *layout, int y, int side) {
+    float w = (float)mesher->width;
+    float h = (float)mesher->height;
+    float half_depth = layout->scale / 2.0f;
+    int neighbor = y + side;
+    int edge_row = side < 0 ? y : y + 1;
+
+    for (int x = 0; x < mesher->width;) {
+        int exposed = is_solid(mesher, x, y) &&
+                      (neighbor < 0 || neighbor >= mesher->height ||
+                       !is_solid(mesher, x, neighbor));
+        if (!exposed) {
+            x++;
+            continue;
+        }
+
+        int x_end = x + 1;
+        while (x_end < mesher->width && is_solid(mesher, x_end, y) &&
+               (neighbor < 0 || neighbor >= mesher->height ||
+                !is_solid(mesher, x_end, neighbor)))
+            x_end++;
+
+        Vec3 corner = {x_of(layout, x), y_of(layout, edge_row), -half_depth};
+        Vec3 edge_u = {x_of(layout, x_end) - x_of(layout, x), 0, 0};
+        Vec3 edge_v = {0, 0, layout->scale};
+        // Sampled along the middle of the row
+        Vec2 uv = {(float)x / w, ((float)y + 0.5f) / h};
+        Vec2 uv_u = {(float)(x_end - x) / w, 0};
+        emit_quad(band, corner, edge_u, edge_v, (Vec3){0, (float)-side, 0}, uv,
+                  uv_u, (Vec2){0, 0});
+        x = x_end;
+    }
+}
+
+// Left and right faces of column `x` in rows `first` to `last`, merged along
+// the column. `side` is -1 for the left faces and 1 for the right faces.
+static void mesh_column_edges(VoxelMesher *mesher, VoxelBand *band,
+                              const Layout *layout, int x, int side, int first,
+                              int last) {
+    float w = (float)mesher->width;
+    float h = (float)mesher->height;
+    float half_depth = layout->scale / 2.0f;
+    int neighbor = x + side;
+    int edge_column = side < 0 ? x : x + 1;
+
+    for (int y = first; y <= last;) {
+        int exposed = is_solid(mesher, x, y) &&
+                      (neighbor < 0 || neighbor >= mesher->width ||
+                       !is_solid(mesher, neighbor, y));
+        if (!exposed) {
+            y++;
+            continue;
+        }
+
+        int y_end = y + 1;
+        while (y_end <= last && is_solid(mesher, x, y_end) &&
+               (neighbor < 0 || neighbor >= mesher->width ||
+                !is_solid(mesher, neighbor, y_end)))
+            y_end++;
+
+        Vec3 corner = {x_of(layout, edge_column), y_of(layout, y_end),
+                       -half_depth};
+        Vec3 edge_u = {0, y_of(layout, y) - y_of(layout, y_end), 0};
+        Vec3 edge_v = {0, 0, layout->scale};
+        // Sampled along the middle of the column
+        Vec2 uv = {((float)x + 0.5f) / w, (float)y_end / h};
+        Vec2 uv_u = {0, -(float)(y_end - y) / h};
+        emit_quad(band, corner, edge_u, edge_v, (Vec3){(float)side, 0, 0}, uv,
+                  uv_u, (Vec2){0, 0});
+        y = y_end;
+    }
+}
+
+static void mesh_band(VoxelMesher *mesher, size_t band_index) {
+    VoxelBand *band = mesher->bands + band_index;
+    band->quad_count = 0;
+
+    int larger_side =
+        mesher->width > mesher->height ? mesher->width : mesher->height;
+    Layout layout = {
+        .scale = VOXEL_MESH_SIZE / (float)larger_side,
+        .half_width = (float)mesher->width / 2.0f,
+        .half_height = (float)mesher->height / 2.0f,
+    };
+
+    int first = (int)band_index * VOXEL_BAND_ROWS;
+    int last = first + VOXEL_BAND_ROWS - 1;
+    if (last >= mesher->height)
+        last = mesher->height - 1;
+
+    mesh_front_and_back(mesher, band, &layout, first, last);
+    for (int y = first; y <= last; y++) {
+        mesh_row_edges(mesher, band, &layout, y, -1);
+        mesh_row_edges(mesher, band, &layout, y, 1);
+    }
+    for (int x = 0; x < mesher->width; x++) {
+        mesh_column_edges(mesher, band, &layout, x, -1, first, last);
+        mesh_column_edges(mesher, band, &layout, x, 1, first, last);
+    }
+}
+
+void voxel_mesher_free(VoxelMesher *mesher) {
+    for (size_t i = 0; i < mesher->band_count; i++)
+        free(mesher->bands[i].data);
+    free(mesher->bands);
+    free(mesher->solid);
+    free(mesher->merged);
+    free(mesher->dirty);
+    *mesher = (VoxelMesher){0};
+}
+
+// Marks the band of `row` for re-meshing, if the row exists.
+static inline void mark_row_dirty(VoxelMesher *mesher, int row) {
+    if (row >= 0 && row < mesher->height)
+        mesher->dirty[row / VOXEL_BAND_ROWS] = 1;
+}
+
+void voxel_mesher_update(VoxelMesher *mesher, const uint8_t *pixels, int width,
+                         int height) {
+    assert(width > 0 && height > 0);
+    int fresh = 0;
+    if (mesher->width != width || mesher->height != height) {
+        voxel_mesher_free(mesher);
+        mesher->width = width;
+        mesher->height = height;
+        mesher->band_count =
+            (size_t)(height + VOXEL_BAND_ROWS - 1) / VOXEL_BAND_ROWS;
+        mesher->solid = calloc((size_t)width * (size_t)height, 1);
+        mesher->merged = malloc((size_t)width * VOXEL_BAND_ROWS);
+        mesher->dirty = calloc(mesher->band_count, 1);
+        mesher->bands = calloc(mesher->band_count, sizeof(VoxelBand));
+        if (!mesher->solid || !mesher->merged || !mesher->dirty ||
+            !mesher->bands)
+            abort();
+        fresh = 1;
+    }
+
+    for (int y = 0; y < height; y++) {
+        uint8_t *solid_row = mesher->solid + (size_t)y * (size_t)width;
+        const uint8_t *pixel_row = pixels + (size_t)y * (size_t)width * 4;
+        int changed = fresh;
+        for (int x = 0; x < width; x++) {
+            uint8_t solid = pixel_row[x * 4 + 3] >= VOXEL_ALPHA_THRESHOLD;
+            changed |= solid != solid_row[x];
+            solid_row[x] = solid;
+        }
+        // The top and bottom faces of the neighboring rows change with it
+        if (changed) {
+            mark_row_dirty(mesher, y - 1);
+            mark_row_dirty(mesher, y);
+            mark_row_dirty(mesher, y + 1);
+        }
+    }
+
+    mesher->bands_meshed = 0;
+    for (size_t i = 0; i < mesher->band_count; i++) {
+        if (!mesher->dirty[i])
+            continue;
+        mesh_band(mesher, i);
+        mesher->dirty[i] = 0;
+        mesher->bands_meshed++;
+    }
+}
+
+Mesh voxel_mesher_build(VoxelMesher *mesher) {
+    size_t quad_count = 0;
+    for (size_t i = 0; i < mesher->band_count; i++)
+        quad_count += mesher->bands[i].quad_count;
+    if (!quad_count)
+        return (Mesh){0};
+
+    size_t vertex_count = quad_count * 6;
+    Mesh mesh = {
+        .vertexCount = (int)vertex_count,
+        .triangleCount = (int)(quad_count * 2),
+        .vertices = malloc(vertex_count * 3 * sizeof(float)),
+        .texcoords = malloc(vertex_count * 2 * sizeof(float)),
+        .normals = malloc(vertex_count * 3 * sizeof(float)),
+    };
+    if (!mesh.vertices || !mesh.texcoords || !mesh.normals)
+        abort();
+
+    size_t vertex = 0;
+    for (size_t i = 0; i < mesher->band_count; i++) {
+        VoxelBand *band = mesher->bands + i;
+        for (size_t j = 0; j < band->quad_count * 6; j++, vertex++) {
+            const float *in = band->data + j * VERTEX_FLOATS;
+            memcpy(mesh.vertices + vertex * 3, in, 3 * sizeof(float));
+            memcpy(mesh.texcoords + vertex * 2, in + 3, 2 * sizeof(float));
+            memcpy(mesh.normals + vertex * 3, in + 5, 3 * sizeof(float));
+        }
+    }
+    return mesh;
+}
+
+size_t voxel_mesher_triangle_count(VoxelMesher *mesher) {
+    size_t quad_count = 0;
+    for (size_t i = 0; i < mesher->band_count; i++)
+        quad_count += mesher->bands[i].quad_count;
+    return quad_count * 2;
+}
+
+size_t voxel_mesher_naive_triangle_count(VoxelMesher *mesher) {
+    size_t solid_count = 0;
+    for (size_t i = 0; i < (size_t)mesher->width * (size_t)mesher->height; i++)
+        solid_count += mesher->solid[i];
+    return solid_count * 12;
+}
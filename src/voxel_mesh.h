@@ -0,0 +1,61 @@
+#ifndef _VOXEL_MESH
+#define _VOXEL_MESH
+
+// Extrudes a sprite into a voxel mesh: every opaque pixel becomes a column one
+// pixel deep. Coplanar faces are merged greedily into as few quads as
+// possible. The quads are textured with the sprite itself, so merging only
+// depends on which pixels are opaque, not on their colors.
+//
+// The sprite is meshed in bands of rows. Updating the mesher with an edited
+// sprite only re-meshes the bands whose opacity changed, plus the neighboring
+// bands whose faces border them.
+
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Rows per band, faces are not merged across bands
+#define VOXEL_BAND_ROWS 16
+// Pixels with at least this alpha are solid
+#define VOXEL_ALPHA_THRESHOLD 128
+// Width or height of the larger side of the extruded sprite
+#define VOXEL_MESH_SIZE 2.0f
+
+// Quads of one band, 6 vertices of position, texture coordinate and normal
+// each.
+typedef struct {
+    float *data;
+    size_t quad_count;
+    size_t quads_allocated;
+} VoxelBand;
+
+typedef struct {
+    int width;
+    int height;
+    // 1 for solid pixels
+    uint8_t *solid;
+    VoxelBand *bands;
+    size_t band_count;
+    // Scratch space of the meshing: faces already merged into a quad, and
+    // the bands to re-mesh
+    uint8_t *merged;
+    uint8_t *dirty;
+    // Bands re-meshed by the last voxel_mesher_update
+    size_t bands_meshed;
+} VoxelMesher;
+
+void voxel_mesher_free(VoxelMesher *mesher);
+
+// Meshes the RGBA8 `pixels`, only re-meshing the bands that changed since the
+// previous update. Starts over if the size changed.
+void voxel_mesher_update(VoxelMesher *mesher, const uint8_t *pixels, int width,
+                         int height);
+// Builds a mesh of the current quads, not yet uploaded. Returns an empty mesh
+// if there are none.
+Mesh voxel_mesher_build(VoxelMesher *mesher);
+
+size_t voxel_mesher_triangle_count(VoxelMesher *mesher);
+// Triangles of a mesh with a full cube per solid pixel.
+size_t voxel_mesher_naive_triangle_count(VoxelMesher *mesher);
+
+#endif
@@ -0,0 +1,107 @@
+#define _DEFAULT_SOURCE
+#define FIREWATCH_IMPLEMENTATION
+#include "firewatch.h"
+
+#include "alloc_track.h"
+#include "frame_stats.h"
+#include "path.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define WATCHED_FILEPATH "/tmp/bricklayer_test_alloc_track.txt"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_counts_allocations(void) {
+    TEST_ASSERT_TRUE(alloc_track_enabled());
+
+    AllocCount start = alloc_track_total();
+    void *pointer = malloc(100);
+    pointer = realloc(pointer, 200);
+    free(pointer);
+
+    AllocCount allocations = alloc_track_since(start);
+    TEST_ASSERT_EQUAL(2, allocations.count);
+    TEST_ASSERT_EQUAL(300, allocations.bytes);
+}
+
+void test_path_write_does_not_allocate(void) {
+    char texture_filepath[PATH_MAX];
+    AllocCount start = alloc_track_total();
+
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_FALSE(path_write_corresponding_texture_file(
+            texture_filepath, sizeof(texture_filepath),
+            "/path/to/somewhere/amodelname.obj"));
+
+    TEST_ASSERT_EQUAL(0, alloc_track_since(start).count);
+    TEST_ASSERT_EQUAL_STRING("/path/to/somewhere/amodelname.aseprite",
+                             texture_filepath);
+}
+
+void test_frame_stats_within_capacity_does_not_allocate(void) {
+    FrameStats stats = frame_stats_init(1000);
+    AllocCount start = alloc_track_total();
+
+    for (int i = 0; i < 1000; i++)
+        frame_stats_add(&stats, 0.016);
+
+    TEST_ASSERT_EQUAL(0, alloc_track_since(start).count);
+    frame_stats_free(&stats);
+}
+
+static volatile int reload_count = 0;
+
+static void count_reload(const char *filepath, uint64_t cookie) {
+    (void)filepath;
+    (void)cookie;
+    reload_count++;
+}
+
+static void touch_watched_file(void) {
+    FILE *file = fopen(WATCHED_FILEPATH, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("changed", file);
+    fclose(file);
+}
+
+// Changes the watched file and runs firewatch_check() like the main loop until
+// the change has been dispatched.
+static void reload_once(void) {
+    int expected = reload_count + 1;
+    touch_watched_file();
+
+    struct timespec delay = {.tv_nsec = 1000 * 1000};
+    for (int i = 0; i < 2000 && reload_count < expected; i++) {
+        firewatch_check();
+        nanosleep(&delay, 0);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(expected, reload_count);
+}
+
+void test_file_change_dispatch_does_not_allocate(void) {
+    touch_watched_file();
+    firewatch_new_file(WATCHED_FILEPATH, 0, &count_reload, 0);
+    reload_once();
+
+    AllocCount start = alloc_track_total();
+    for (int i = 0; i < 10; i++)
+        reload_once();
+    TEST_ASSERT_EQUAL(0, alloc_track_since(start).count);
+
+    remove(WATCHED_FILEPATH);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_counts_allocations);
+    RUN_TEST(test_path_write_does_not_allocate);
+    RUN_TEST(test_frame_stats_within_capacity_does_not_allocate);
+    RUN_TEST(test_file_change_dispatch_does_not_allocate);
+
+    return UNITY_END();
+}
@@ -0,0 +1,238 @@
+#include "ase_compose.h"
+#include "asset_gen.h"
+#include "cute_aseprite.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_ASEPRITE_FILEPATH "/tmp/bricklayer_test_ase_compose.aseprite"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Checks every frame composited with ase_compose_frame against the frames
+// composited by cute_aseprite itself.
+static void compare_with_cute_aseprite(AseGenOptions *options) {
+    uint8_t *file = 0;
+    size_t size = asset_gen_aseprite(options, &file);
+    TEST_ASSERT_NOT_EQUAL(0, size);
+
+    ase_t *reference = cute_aseprite_load_from_memory(file, (int)size, 0);
+    ase_t *ase = cute_aseprite_load_from_memory_ex(
+        file, (int)size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    TEST_ASSERT_NOT_NULL(reference);
+    TEST_ASSERT_NOT_NULL(ase);
+    TEST_ASSERT_NULL(ase->frames[0].pixels);
+
+    size_t row_size = (size_t)ase->w * 4;
+    uint8_t *pixels = malloc(row_size * (size_t)ase->h);
+    AseComposeTarget target = {
+        .pixels = pixels,
+        .stride = row_size,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+
+    for (int i = 0; i < ase->frame_count; i++) {
+        ase_compose_frame(ase, i, &target);
+        TEST_ASSERT_EQUAL_MEMORY(reference->frames[i].pixels, pixels,
+                                 row_size * (size_t)ase->h);
+    }
+
+    free(pixels);
+    cute_aseprite_free(ase);
+    cute_aseprite_free(reference);
+    free(file);
+}
+
+void test_rgba_layers_match(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 40;
+    options.height = 24;
+    options.layer_count = 4;
+    options.frame_count = 6;
+    options.hold = 3;
+    compare_with_cute_aseprite(&options);
+}
+
+void test_grayscale_matches(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.depth = 16;
+    options.layer_count = 3;
+    compare_with_cute_aseprite(&options);
+}
+
+void test_indexed_matches(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.depth = 8;
+    options.layer_count = 3;
+    options.frame_count = 4;
+    options.hold = 2;
+    compare_with_cute_aseprite(&options);
+}
+
+void test_blend_modes_match(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 37;
+    options.height = 9;
+    options.layer_count = 3;
+    for (int mode = 0; mode < ASE_BLEND_MODE_COUNT; mode++) {
+        options.blend_mode = mode;
+        options.depth = 32;
+        compare_with_cute_aseprite(&options);
+        options.depth = 8;
+        compare_with_cute_aseprite(&options);
+    }
+}
+
+void test_sub_rectangle_with_stride_and_bgra(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 16;
+    options.height = 8;
+    options.layer_count = 2;
+    uint8_t *file = 0;
+    size_t size = asset_gen_aseprite(&options, &file);
+
+    ase_t *reference = cute_aseprite_load_from_memory(file, (int)size, 0);
+    ase_t *ase = cute_aseprite_load_from_memory_ex(
+        file, (int)size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+
+    // The frame goes to (3, 2) of a 32 x 16 atlas filled with a canary value
+    enum { ATLAS_WIDTH = 32, ATLAS_HEIGHT = 16, X = 3, Y = 2 };
+    static uint8_t atlas[ATLAS_WIDTH * ATLAS_HEIGHT * 4];
+    memset(atlas, 0xab, sizeof(atlas));
+    AseComposeTarget target = {
+        .pixels = atlas + (Y * ATLAS_WIDTH + X) * 4,
+        .stride = ATLAS_WIDTH * 4,
+        .format = ASE_COMPOSE_BGRA8,
+    };
+    ase_compose_frame(ase, 0, &target);
+
+    for (int y = 0; y < ATLAS_HEIGHT; y++) {
+        for (int x = 0; x < ATLAS_WIDTH; x++) {
+            uint8_t *pixel = atlas + (y * ATLAS_WIDTH + x) * 4;
+            int inside = x >= X && x < X + ase->w && y >= Y && y < Y + ase->h;
+            if (!inside) {
+                TEST_ASSERT_EQUAL_HEX8(0xab, pixel[0]);
+                TEST_ASSERT_EQUAL_HEX8(0xab, pixel[3]);
+                continue;
+            }
+            ase_color_t expected =
+                reference->frames[0].pixels[(y - Y) * ase->w + (x - X)];
+            TEST_ASSERT_EQUAL_HEX8(expected.b, pixel[0]);
+            TEST_ASSERT_EQUAL_HEX8(expected.g, pixel[1]);
+            TEST_ASSERT_EQUAL_HEX8(expected.r, pixel[2]);
+            TEST_ASSERT_EQUAL_HEX8(expected.a, pixel[3]);
+        }
+    }
+
+    cute_aseprite_free(ase);
+    cute_aseprite_free(reference);
+    free(file);
+}
+
+// Composites the frame in regions of `region_size` pixels, the edge ones
+// smaller, and compares them with the frame composited by cute_aseprite.
+static void compare_regions(AseGenOptions *options, int region_size) {
+    uint8_t *file = 0;
+    size_t size = asset_gen_aseprite(options, &file);
+    ase_t *reference = cute_aseprite_load_from_memory(file, (int)size, 0);
+    ase_t *ase = cute_aseprite_load_from_memory_ex(
+        file, (int)size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    TEST_ASSERT_NOT_NULL(reference);
+    TEST_ASSERT_NOT_NULL(ase);
+
+    ase_color_t *region =
+        malloc((size_t)region_size * (size_t)region_size * 4);
+    AseComposeTarget target = {
+        .pixels = (uint8_t *)region,
+        .stride = (size_t)region_size * 4,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+    for (int y = 0; y < ase->h; y += region_size) {
+        for (int x = 0; x < ase->w; x += region_size) {
+            int w = ase->w - x < region_size ? ase->w - x : region_size;
+            int h = ase->h - y < region_size ? ase->h - y : region_size;
+            ase_compose_region(ase, 0, x, y, w, h, &target);
+            for (int row = 0; row < h; row++)
+                TEST_ASSERT_EQUAL_MEMORY(
+                    reference->frames[0].pixels + (y + row) * ase->w + x,
+                    region + row * region_size, (size_t)w * 4);
+        }
+    }
+
+    free(region);
+    cute_aseprite_free(ase);
+    cute_aseprite_free(reference);
+    free(file);
+}
+
+void test_regions_match_the_frame(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 45;
+    options.height = 29;
+    options.layer_count = 4;
+    compare_regions(&options, 8);
+    compare_regions(&options, 13);
+    options.depth = 16;
+    compare_regions(&options, 10);
+    options.depth = 8;
+    compare_regions(&options, 10);
+}
+
+void test_held_frames_share_pixels(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.layer_count = 3;
+    options.frame_count = 8;
+    options.hold = 4;
+    uint8_t *file = 0;
+    size_t size = asset_gen_aseprite(&options, &file);
+
+    ase_t *ase = cute_aseprite_load_from_memory(file, (int)size, 0);
+    TEST_ASSERT_NOT_NULL(ase);
+    for (int i = 0; i < ase->frame_count; i++) {
+        int held_from = i - i % options.hold;
+        TEST_ASSERT_EQUAL(held_from, ase->frames[i].shared_frame_index);
+        TEST_ASSERT_EQUAL_PTR(ase->frames[held_from].pixels,
+                              ase->frames[i].pixels);
+    }
+    TEST_ASSERT_NOT_EQUAL(ase->frames[0].pixels, ase->frames[4].pixels);
+
+    // Links are resolved to the cel with the pixels
+    ase_cel_t *linked = ase->frames[2].cels + 1;
+    TEST_ASSERT_TRUE(linked->is_linked);
+    TEST_ASSERT_EQUAL_PTR(ase->frames[0].cels + 1,
+                          ase_compose_resolve_cel(linked));
+
+    cute_aseprite_free(ase);
+    free(file);
+}
+
+void test_load_from_file(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    TEST_ASSERT_FALSE(
+        asset_gen_write_aseprite_file(TEST_ASEPRITE_FILEPATH, &options));
+
+    ase_t *ase = ase_compose_load(TEST_ASEPRITE_FILEPATH);
+    TEST_ASSERT_NOT_NULL(ase);
+    TEST_ASSERT_EQUAL(options.width, ase->w);
+    TEST_ASSERT_NULL(ase->frames[0].pixels);
+    cute_aseprite_free(ase);
+
+    TEST_ASSERT_NULL(ase_compose_load("/tmp/does/not/exist.aseprite"));
+    remove(TEST_ASEPRITE_FILEPATH);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_rgba_layers_match);
+    RUN_TEST(test_grayscale_matches);
+    RUN_TEST(test_indexed_matches);
+    RUN_TEST(test_blend_modes_match);
+    RUN_TEST(test_sub_rectangle_with_stride_and_bgra);
+    RUN_TEST(test_regions_match_the_frame);
+    RUN_TEST(test_held_frames_share_pixels);
+    RUN_TEST(test_load_from_file);
+
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include "ase_probe.h"
+#include "asset_gen.h"
+#include "cute_aseprite.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_ASEPRITE_FILEPATH "/tmp/bricklayer_test_ase_probe.aseprite"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Checks the probe of a generated file against a full decode.
+static void compare_with_cute_aseprite(AseGenOptions *options) {
+    uint8_t *file = 0;
+    size_t size = asset_gen_aseprite(options, &file);
+    TEST_ASSERT_NOT_EQUAL(0, size);
+
+    AseProbe probe;
+    TEST_ASSERT_EQUAL(0, ase_probe_memory(file, size, &probe));
+    ase_t *ase = cute_aseprite_load_from_memory(file, (int)size, 0);
+    TEST_ASSERT_NOT_NULL(ase);
+
+    TEST_ASSERT_EQUAL(ase->w, probe.width);
+    TEST_ASSERT_EQUAL(ase->h, probe.height);
+    TEST_ASSERT_EQUAL(options->depth, probe.depth);
+    TEST_ASSERT_EQUAL(ase->frame_count, probe.frame_count);
+    TEST_ASSERT_EQUAL(ase->layer_count, probe.layer_count);
+    TEST_ASSERT_EQUAL(ase->tag_count, probe.tag_count);
+
+    int cel_count = 0;
+    int linked_cel_count = 0;
+    size_t cel_bytes = 0;
+    for (int i = 0; i < ase->frame_count; i++) {
+        for (int j = 0; j < ase->frames[i].cel_count; j++) {
+            ase_cel_t *cel = ase->frames[i].cels + j;
+            cel_count++;
+            if (cel->is_linked)
+                linked_cel_count++;
+            else
+                cel_bytes += (size_t)cel->w * (size_t)cel->h *
+                             (size_t)(options->depth / 8);
+        }
+    }
+    TEST_ASSERT_EQUAL(cel_count, probe.cel_count);
+    TEST_ASSERT_EQUAL(linked_cel_count, probe.linked_cel_count);
+    TEST_ASSERT_EQUAL(cel_bytes, probe.cel_bytes);
+    TEST_ASSERT_EQUAL((size_t)ase->w * (size_t)ase->h * 4,
+                      ase_probe_frame_size(&probe));
+
+    cute_aseprite_free(ase);
+    free(file);
+}
+
+void test_matches_full_decode(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 40;
+    options.height = 24;
+    options.layer_count = 5;
+    options.frame_count = 6;
+    options.hold = 3;
+    compare_with_cute_aseprite(&options);
+
+    options.depth = 8;
+    options.compression = ASSET_GEN_COMPRESSION_NONE;
+    compare_with_cute_aseprite(&options);
+
+    options.depth = 16;
+    compare_with_cute_aseprite(&options);
+}
+
+void test_rejects_truncated_files(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.frame_count = 3;
+    uint8_t *file = 0;
+    size_t size = asset_gen_aseprite(&options, &file);
+
+    AseProbe probe;
+    for (size_t cut = 0; cut < size; cut += 97)
+        TEST_ASSERT_EQUAL(1, ase_probe_memory(file, cut, &probe));
+    TEST_ASSERT_EQUAL(0, ase_probe_memory(file, size, &probe));
+
+    // Broken magic number
+    file[4] = 0;
+    TEST_ASSERT_EQUAL(1, ase_probe_memory(file, size, &probe));
+    free(file);
+}
+
+void test_probe_file(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 32;
+    options.layer_count = 2;
+    TEST_ASSERT_FALSE(
+        asset_gen_write_aseprite_file(TEST_ASEPRITE_FILEPATH, &options));
+
+    AseProbe probe;
+    TEST_ASSERT_EQUAL(0, ase_probe_file(TEST_ASEPRITE_FILEPATH, &probe));
+    TEST_ASSERT_EQUAL(32, probe.width);
+    TEST_ASSERT_EQUAL(2, probe.layer_count);
+    remove(TEST_ASEPRITE_FILEPATH);
+
+    TEST_ASSERT_EQUAL(1, ase_probe_file("/tmp/does/not/exist.aseprite", &probe));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_matches_full_decode);
+    RUN_TEST(test_rejects_truncated_files);
+    RUN_TEST(test_probe_file);
+
+    return UNITY_END();
+}
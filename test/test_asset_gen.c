@@ -0,0 +1,155 @@
+#include "asset_gen.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static uint16_t read_u16(const uint8_t *data) {
+    return data[0] | (data[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *data) {
+    return read_u16(data) | ((uint32_t)read_u16(data + 2) << 16);
+}
+
+static void count_obj_lines(ObjGenOptions *options, size_t *vertices,
+                            size_t *faces) {
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL(0, asset_gen_write_obj(file, options));
+    rewind(file);
+
+    char line[256] = {0};
+    *vertices = *faces = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (!strncmp(line, "v ", 2))
+            (*vertices)++;
+        if (!strncmp(line, "f ", 2))
+            (*faces)++;
+    }
+    fclose(file);
+}
+
+void test_obj_triangle_counts(void) {
+    ObjGenOptions options = asset_gen_obj_defaults();
+    size_t vertices, faces;
+
+    options.triangle_count = 1001;
+    count_obj_lines(&options, &vertices, &faces);
+    TEST_ASSERT_EQUAL(1001, faces);
+    TEST_ASSERT_LESS_THAN(1001, vertices);
+
+    options.topology = ASSET_GEN_TOPOLOGY_SPHERE;
+    options.triangle_count = 500;
+    count_obj_lines(&options, &vertices, &faces);
+    TEST_ASSERT_EQUAL(500, faces);
+
+    options.topology = ASSET_GEN_TOPOLOGY_SOUP;
+    options.triangle_count = 10;
+    count_obj_lines(&options, &vertices, &faces);
+    TEST_ASSERT_EQUAL(10, faces);
+    TEST_ASSERT_EQUAL(30, vertices);
+}
+
+// Walks the frame and chunk structure of the file and counts cels of each
+// type.
+static void check_aseprite(AseGenOptions *options, int *raw_cels,
+                           int *linked_cels, int *compressed_cels) {
+    uint8_t *data = 0;
+    size_t size = asset_gen_aseprite(options, &data);
+    TEST_ASSERT_NOT_EQUAL(0, size);
+
+    TEST_ASSERT_EQUAL(size, read_u32(data));
+    TEST_ASSERT_EQUAL_HEX16(0xa5e0, read_u16(data + 4));
+    TEST_ASSERT_EQUAL(options->frame_count, read_u16(data + 6));
+    TEST_ASSERT_EQUAL(options->width, read_u16(data + 8));
+    TEST_ASSERT_EQUAL(options->height, read_u16(data + 10));
+    TEST_ASSERT_EQUAL(options->depth, read_u16(data + 12));
+
+    *raw_cels = *linked_cels = *compressed_cels = 0;
+    size_t offset = 128;
+    for (int frame = 0; frame < options->frame_count; frame++) {
+        uint32_t frame_size = read_u32(data + offset);
+        TEST_ASSERT_EQUAL_HEX16(0xf1fa, read_u16(data + offset + 4));
+        uint32_t chunk_count = read_u32(data + offset + 12);
+
+        size_t chunk = offset + 16;
+        for (uint32_t i = 0; i < chunk_count; i++) {
+            uint32_t chunk_size = read_u32(data + chunk);
+            if (read_u16(data + chunk + 4) == 0x2005) {
+                int cel_type = read_u16(data + chunk + 13);
+                *raw_cels += cel_type == 0;
+                *linked_cels += cel_type == 1;
+                *compressed_cels += cel_type == 2;
+            }
+            chunk += chunk_size;
+        }
+        TEST_ASSERT_EQUAL(offset + frame_size, chunk);
+        offset = chunk;
+    }
+    TEST_ASSERT_EQUAL(size, offset);
+    free(data);
+}
+
+void test_aseprite_structure(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 100;
+    options.height = 37;
+    options.layer_count = 3;
+    options.frame_count = 5;
+    options.hold = 2;
+    int raw, linked, compressed;
+
+    int depths[] = {32, 16, 8};
+    for (int i = 0; i < 3; i++) {
+        options.depth = depths[i];
+        check_aseprite(&options, &raw, &linked, &compressed);
+        TEST_ASSERT_EQUAL(0, raw);
+        TEST_ASSERT_EQUAL(6, linked);
+        TEST_ASSERT_EQUAL(9, compressed);
+    }
+
+    options.compression = ASSET_GEN_COMPRESSION_NONE;
+    options.hold = 1;
+    check_aseprite(&options, &raw, &linked, &compressed);
+    TEST_ASSERT_EQUAL(15, raw);
+    TEST_ASSERT_EQUAL(0, linked);
+}
+
+void test_aseprite_compresses(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = options.height = 256;
+    uint8_t *compressed = 0, *raw = 0;
+    size_t compressed_size = asset_gen_aseprite(&options, &compressed);
+    options.compression = ASSET_GEN_COMPRESSION_NONE;
+    size_t raw_size = asset_gen_aseprite(&options, &raw);
+
+    TEST_ASSERT_GREATER_THAN(256 * 256 * 4, raw_size);
+    TEST_ASSERT_LESS_THAN(raw_size / 4, compressed_size);
+    free(compressed);
+    free(raw);
+}
+
+void test_aseprite_invalid_options(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    uint8_t *data = 0;
+    options.depth = 24;
+    TEST_ASSERT_EQUAL(0, asset_gen_aseprite(&options, &data));
+    options.depth = 32;
+    options.layer_count = 65;
+    TEST_ASSERT_EQUAL(0, asset_gen_aseprite(&options, &data));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_obj_triangle_counts);
+    RUN_TEST(test_aseprite_structure);
+    RUN_TEST(test_aseprite_compresses);
+    RUN_TEST(test_aseprite_invalid_options);
+
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include "blend.h"
+#include "cute_aseprite.h"
+#include "unity.h"
+#include <string.h>
+
+// Odd so that every kernel also goes through its scalar tail
+#define ROW_LENGTH 4099
+
+ase_color_t src[ROW_LENGTH];
+ase_color_t dst[ROW_LENGTH];
+ase_color_t expected[ROW_LENGTH];
+ase_color_t result[ROW_LENGTH];
+uint32_t random_state = 1;
+
+static inline uint32_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static inline ase_color_t random_color(void) {
+    uint32_t value = next_random();
+    ase_color_t color = {(uint8_t)value, (uint8_t)(value >> 8),
+                         (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    // Plenty of the extremes, where the modes branch
+    switch (next_random() % 8) {
+    case 0:
+        color.a = 0;
+        break;
+    case 1:
+        color.a = 255;
+        break;
+    case 2:
+        color.r = 0;
+        color.g = 255;
+        break;
+    case 3:
+        color.b = 128;
+        break;
+    }
+    return color;
+}
+
+void setUp(void) {
+    for (int i = 0; i < ROW_LENGTH; i++) {
+        src[i] = random_color();
+        dst[i] = random_color();
+    }
+}
+
+void tearDown(void) {}
+
+static void check_kernel(BlendKernel kernel) {
+    if (!blend_kernel_supported(kernel))
+        TEST_IGNORE_MESSAGE("Not supported by this CPU");
+
+    const uint8_t opacities[] = {255, 128, 1, 0};
+    for (int mode = 0; mode < ASE_BLEND_MODE_COUNT; mode++) {
+        for (size_t o = 0; o < sizeof(opacities); o++) {
+            for (int i = 0; i < ROW_LENGTH; i++)
+                expected[i] = cute_aseprite_blend(
+                    src[i], dst[i], opacities[o], (ase_blend_mode_t)mode);
+
+            memcpy(result, dst, sizeof(result));
+            blend_row_kernel(kernel, (ase_blend_mode_t)mode, src, result,
+                             ROW_LENGTH, opacities[o]);
+
+            for (int i = 0; i < ROW_LENGTH; i++) {
+                uint32_t want, got;
+                memcpy(&want, expected + i, sizeof(want));
+                memcpy(&got, result + i, sizeof(got));
+                if (want != got) {
+                    char message[128];
+                    snprintf(message, sizeof(message),
+                             "%s, mode %d, opacity %d, pixel %d",
+                             blend_kernel_name(kernel), mode, opacities[o], i);
+                    TEST_ASSERT_EQUAL_HEX32_MESSAGE(want, got, message);
+                }
+            }
+        }
+    }
+}
+
+void test_scalar_matches_reference(void) {
+    check_kernel(BLEND_KERNEL_SCALAR);
+}
+
+void test_sse41_matches_reference(void) {
+    check_kernel(BLEND_KERNEL_SSE41);
+}
+
+void test_avx2_matches_reference(void) {
+    check_kernel(BLEND_KERNEL_AVX2);
+}
+
+void test_reference_modes(void) {
+    ase_color_t backdrop = {200, 100, 0, 255};
+    ase_color_t white = {255, 255, 255, 255};
+    ase_color_t black = {0, 0, 0, 255};
+
+    // Multiplying by white and screening with black keep the backdrop
+    ase_color_t color =
+        cute_aseprite_blend(white, backdrop, 255, ASE_BLEND_MODE_MULTIPLY);
+    TEST_ASSERT_EQUAL_MEMORY(&backdrop, &color, sizeof(color));
+    color = cute_aseprite_blend(black, backdrop, 255, ASE_BLEND_MODE_SCREEN);
+    TEST_ASSERT_EQUAL_MEMORY(&backdrop, &color, sizeof(color));
+
+    color = cute_aseprite_blend(white, backdrop, 255,
+                                ASE_BLEND_MODE_DIFFERENCE);
+    TEST_ASSERT_EQUAL(55, color.r);
+    TEST_ASSERT_EQUAL(155, color.g);
+    TEST_ASSERT_EQUAL(255, color.b);
+
+    color = cute_aseprite_blend(backdrop, backdrop, 255,
+                                ASE_BLEND_MODE_ADDITION);
+    TEST_ASSERT_EQUAL(255, color.r);
+    TEST_ASSERT_EQUAL(200, color.g);
+
+    // Over transparent pixels the source shows as is
+    ase_color_t transparent = {0};
+    color = cute_aseprite_blend(backdrop, transparent, 255,
+                                ASE_BLEND_MODE_MULTIPLY);
+    TEST_ASSERT_EQUAL_MEMORY(&backdrop, &color, sizeof(color));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_scalar_matches_reference);
+    RUN_TEST(test_sse41_matches_reference);
+    RUN_TEST(test_avx2_matches_reference);
+    RUN_TEST(test_reference_modes);
+
+    return UNITY_END();
+}
@@ -0,0 +1,200 @@
+#include "capture.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_CAPTURE_DIRECTORY "/tmp/bricklayer_test_capture"
+
+void setUp(void) {
+    mkdir(TEST_CAPTURE_DIRECTORY, 0755);
+}
+
+void tearDown(void) {}
+
+static uint32_t read_u32_big_endian(const uint8_t *data) {
+    return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 |
+           (uint32_t)data[2] << 8 | data[3];
+}
+
+// Straightforward decoder following the QOI specification. Returns the number
+// of pixels decoded into `out`.
+static size_t decode_qoi(const uint8_t *data, size_t size, uint8_t *out) {
+    TEST_ASSERT_EQUAL_MEMORY("qoif", data, 4);
+    size_t pixel_count =
+        (size_t)read_u32_big_endian(data + 4) * read_u32_big_endian(data + 8);
+    const uint8_t *end = data + size - 8;
+    data += 14;
+
+    uint8_t index[64][4] = {0};
+    uint8_t pixel[4] = {0, 0, 0, 255};
+    size_t decoded = 0;
+    while (decoded < pixel_count && data < end) {
+        uint8_t op = *data++;
+        int run = 1;
+        if (op == 0xfe) {
+            memcpy(pixel, data, 3);
+            data += 3;
+        } else if (op == 0xff) {
+            memcpy(pixel, data, 4);
+            data += 4;
+        } else if ((op & 0xc0) == 0x00) {
+            memcpy(pixel, index[op], 4);
+        } else if ((op & 0xc0) == 0x40) {
+            pixel[0] += ((op >> 4) & 3) - 2;
+            pixel[1] += ((op >> 2) & 3) - 2;
+            pixel[2] += (op & 3) - 2;
+        } else if ((op & 0xc0) == 0x80) {
+            int green = (op & 0x3f) - 32;
+            uint8_t second = *data++;
+            pixel[0] += green - 8 + (second >> 4);
+            pixel[1] += green;
+            pixel[2] += green - 8 + (second & 0x0f);
+        } else {
+            run = (op & 0x3f) + 1;
+        }
+        memcpy(index[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 +
+                      pixel[3] * 11) %
+                     64],
+               pixel, 4);
+        for (int i = 0; i < run; i++)
+            memcpy(out + 4 * decoded++, pixel, 4);
+    }
+
+    static const uint8_t end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    TEST_ASSERT_EQUAL_MEMORY(end_marker, end, 8);
+    return decoded;
+}
+
+// Runs, gradients, repeated colors and alpha changes, to hit every operation.
+static void fill_test_pixels(uint8_t *pixels, int width, int height) {
+    uint32_t state = 12345;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *pixel = pixels + ((size_t)y * width + x) * 4;
+            state = state * 1664525u + 1013904223u;
+            if (y % 4 == 0) {
+                memset(pixel, 0x80, 4);
+            } else if (y % 4 == 1) {
+                pixel[0] = (uint8_t)(x * 3);
+                pixel[1] = (uint8_t)(x * 3 + y);
+                pixel[2] = (uint8_t)(x * 2);
+                pixel[3] = 255;
+            } else if (y % 4 == 2) {
+                pixel[0] = (uint8_t)(state >> 8);
+                pixel[1] = (uint8_t)(state >> 16);
+                pixel[2] = (uint8_t)(state >> 24);
+                pixel[3] = (uint8_t)(x % 3 ? 255 : state);
+            } else {
+                pixel[0] = (uint8_t)((x % 3) * 40);
+                pixel[1] = 10;
+                pixel[2] = 200;
+                pixel[3] = 255;
+            }
+        }
+    }
+}
+
+void test_qoi_round_trip(void) {
+    int width = 97;
+    int height = 33;
+    size_t size = (size_t)width * height * 4;
+    uint8_t *pixels = malloc(size);
+    uint8_t *decoded = malloc(size);
+    uint8_t *encoded = malloc(capture_qoi_max_size(width, height));
+    fill_test_pixels(pixels, width, height);
+
+    size_t encoded_size = capture_encode_qoi(pixels, width, height, encoded);
+    TEST_ASSERT_LESS_OR_EQUAL(capture_qoi_max_size(width, height),
+                              encoded_size);
+    TEST_ASSERT_EQUAL(97, read_u32_big_endian(encoded + 4));
+    TEST_ASSERT_EQUAL(33, read_u32_big_endian(encoded + 8));
+    TEST_ASSERT_EQUAL((size_t)width * height,
+                      decode_qoi(encoded, encoded_size, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(pixels, decoded, size);
+
+    free(pixels);
+    free(decoded);
+    free(encoded);
+}
+
+void test_qoi_long_run(void) {
+    // More identical pixels than fit in one run operation
+    uint8_t pixels[200 * 4] = {0};
+    for (size_t i = 0; i < 200; i++)
+        pixels[i * 4 + 3] = 255;
+    uint8_t encoded[200 * 5 + 22];
+    size_t encoded_size = capture_encode_qoi(pixels, 200, 1, encoded);
+    // Four run operations between the header and the end marker
+    TEST_ASSERT_EQUAL(14 + 4 + 8, encoded_size);
+
+    uint8_t decoded[200 * 4];
+    TEST_ASSERT_EQUAL(200, decode_qoi(encoded, encoded_size, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(pixels, decoded, sizeof(pixels));
+}
+
+void test_workers_write_every_submitted_frame(void) {
+    int width = 16;
+    int height = 8;
+    Capture capture;
+    TEST_ASSERT_EQUAL(0, capture_init(&capture, TEST_CAPTURE_DIRECTORY,
+                                      CAPTURE_FORMAT_QOI, width, height, 2));
+
+    for (size_t i = 0; i < 40; i++) {
+        CaptureImage *image = capture_acquire(&capture);
+        // Never blocks, frames are dropped while the workers are busy
+        if (!image) {
+            capture.dropped_count++;
+            continue;
+        }
+        fill_test_pixels(image->pixels, width, height);
+        image->pixels[0] = (uint8_t)i;
+        image->frame_index = i;
+        capture_submit(&capture, image);
+    }
+    capture_finish(&capture, 0);
+
+    TEST_ASSERT_EQUAL(40, capture.written_count + capture.dropped_count);
+    TEST_ASSERT_GREATER_OR_EQUAL(CAPTURE_QUEUE_SIZE, capture.written_count);
+    TEST_ASSERT_EQUAL(0, capture.failed_count);
+
+    // The first frame cannot have been dropped
+    FILE *file = fopen(TEST_CAPTURE_DIRECTORY "/frame_000000.qoi", "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    uint8_t encoded[16 * 8 * 5 + 22];
+    size_t encoded_size = fread(encoded, 1, sizeof(encoded), file);
+    fclose(file);
+
+    uint8_t expected[16 * 8 * 4];
+    uint8_t decoded[16 * 8 * 4];
+    fill_test_pixels(expected, width, height);
+    expected[0] = 0;
+    TEST_ASSERT_EQUAL(16 * 8, decode_qoi(encoded, encoded_size, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(expected, decoded, sizeof(expected));
+
+    for (size_t i = 0; i < 40; i++) {
+        char filepath[256];
+        snprintf(filepath, sizeof(filepath), "%s/frame_%06zu.qoi",
+                 TEST_CAPTURE_DIRECTORY, i);
+        remove(filepath);
+    }
+    capture_free(&capture);
+}
+
+void test_missing_directory_fails(void) {
+    Capture capture;
+    TEST_ASSERT_EQUAL(1, capture_init(&capture, "/tmp/does/not/exist",
+                                      CAPTURE_FORMAT_QOI, 4, 4, 1));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_qoi_round_trip);
+    RUN_TEST(test_qoi_long_run);
+    RUN_TEST(test_workers_write_every_submitted_frame);
+    RUN_TEST(test_missing_directory_fails);
+
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+#define _DEFAULT_SOURCE
+#include "discovery.h"
+#include "unity.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_DIRECTORY "/tmp/bricklayer_test_discovery"
+// Enough for several workers
+#define MODEL_COUNT 100
+
+DiscoveryPatterns patterns;
+int found[MODEL_COUNT];
+char filepaths[MODEL_COUNT][64];
+const char *filepath_pointers[MODEL_COUNT];
+
+static void touch(const char *filepath) {
+    FILE *file = fopen(filepath, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fclose(file);
+}
+
+static void remove_files(void) {
+    char filepath[128];
+    const char *suffixes[] = {".obj", ".aseprite", ".ase", ".png"};
+    for (int i = 0; i < MODEL_COUNT; i++) {
+        for (int s = 0; s < 4; s++) {
+            snprintf(filepath, sizeof(filepath), TEST_DIRECTORY "/model%d%s",
+                     i, suffixes[s]);
+            remove(filepath);
+        }
+    }
+    rmdir(TEST_DIRECTORY "/dir.png");
+    rmdir(TEST_DIRECTORY);
+}
+
+void setUp(void) {
+    remove_files();
+    mkdir(TEST_DIRECTORY, 0755);
+    TEST_ASSERT_EQUAL(
+        0, discovery_parse_patterns(&patterns, DISCOVERY_DEFAULT_PATTERNS));
+    for (int i = 0; i < MODEL_COUNT; i++) {
+        snprintf(filepaths[i], sizeof(filepaths[i]),
+                 TEST_DIRECTORY "/model%d.obj", i);
+        filepath_pointers[i] = filepaths[i];
+    }
+}
+
+void tearDown(void) {
+    remove_files();
+}
+
+void test_patterns_are_parsed(void) {
+    TEST_ASSERT_EQUAL(3, patterns.pattern_count);
+    TEST_ASSERT_EQUAL_STRING(".aseprite", patterns.patterns[0]);
+    TEST_ASSERT_EQUAL_STRING(".ase", patterns.patterns[1]);
+    TEST_ASSERT_EQUAL_STRING(".png", patterns.patterns[2]);
+
+    TEST_ASSERT_EQUAL(0, discovery_parse_patterns(&patterns, ",_diffuse.png,"));
+    TEST_ASSERT_EQUAL(1, patterns.pattern_count);
+    TEST_ASSERT_EQUAL_STRING("_diffuse.png", patterns.patterns[0]);
+
+    TEST_ASSERT_NOT_EQUAL(0, discovery_parse_patterns(&patterns, ""));
+    TEST_ASSERT_NOT_EQUAL(0, discovery_parse_patterns(&patterns, "../a.png"));
+    TEST_ASSERT_NOT_EQUAL(
+        0, discovery_parse_patterns(&patterns, ".1,.2,.3,.4,.5,.6,.7,.8,.9"));
+}
+
+void test_first_pattern_found_wins(void) {
+    char filepath[128];
+    for (int i = 0; i < MODEL_COUNT; i++) {
+        // A third of each, and every tenth has none
+        if (i % 10 == 9)
+            continue;
+        const char *suffixes[] = {".aseprite", ".ase", ".png"};
+        const char *suffix = suffixes[i % 3];
+        snprintf(filepath, sizeof(filepath), TEST_DIRECTORY "/model%d%s", i,
+                 suffix);
+        touch(filepath);
+    }
+    // Preferred over the PNG
+    touch(TEST_DIRECTORY "/model2.aseprite");
+
+    size_t missing = discovery_find_textures(found, filepath_pointers,
+                                             MODEL_COUNT, &patterns, 4);
+    TEST_ASSERT_EQUAL(MODEL_COUNT / 10, missing);
+    for (int i = 0; i < MODEL_COUNT; i++) {
+        int expected = i % 10 == 9 ? DISCOVERY_MISSING : i % 3;
+        if (i == 2)
+            expected = 0;
+        TEST_ASSERT_EQUAL(expected, found[i]);
+    }
+
+    TEST_ASSERT_EQUAL(0, discovery_write_texture_file(
+                             filepath, sizeof(filepath), filepaths[5],
+                             &patterns, found[5]));
+    TEST_ASSERT_EQUAL_STRING(TEST_DIRECTORY "/model5.png", filepath);
+    TEST_ASSERT_NOT_EQUAL(0, discovery_write_texture_file(
+                                 filepath, sizeof(filepath), filepaths[9],
+                                 &patterns, found[9]));
+}
+
+void test_only_files_are_textures(void) {
+    mkdir(TEST_DIRECTORY "/dir.png", 0755);
+    const char *model = TEST_DIRECTORY "/dir.obj";
+    TEST_ASSERT_EQUAL(1, discovery_find_textures(found, &model, 1, &patterns,
+                                                 0));
+    TEST_ASSERT_EQUAL(DISCOVERY_MISSING, found[0]);
+}
+
+void test_sprites_are_their_own_texture(void) {
+    const char *models[] = {"/sprites/brick.aseprite", "no_extension"};
+    TEST_ASSERT_EQUAL(1, discovery_find_textures(found, models, 2, &patterns,
+                                                 0));
+    TEST_ASSERT_EQUAL(DISCOVERY_SELF, found[0]);
+    TEST_ASSERT_EQUAL(DISCOVERY_MISSING, found[1]);
+
+    char filepath[PATH_MAX];
+    TEST_ASSERT_EQUAL(0, discovery_write_texture_file(
+                             filepath, sizeof(filepath), models[0], &patterns,
+                             found[0]));
+    TEST_ASSERT_EQUAL_STRING("/sprites/brick.aseprite", filepath);
+
+    // Names without an extension get the pattern appended
+    TEST_ASSERT_EQUAL(0, discovery_write_texture_file(
+                             filepath, sizeof(filepath), "dir.d/model",
+                             &patterns, 2));
+    TEST_ASSERT_EQUAL_STRING("dir.d/model.png", filepath);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_patterns_are_parsed);
+    RUN_TEST(test_first_pattern_found_wins);
+    RUN_TEST(test_only_files_are_textures);
+    RUN_TEST(test_sprites_are_their_own_texture);
+
+    return UNITY_END();
+}
@@ -0,0 +1,219 @@
+#define _DEFAULT_SOURCE
+#include "disk_cache.h"
+#include "unity.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_CACHE_DIRECTORY "/tmp/bricklayer_test_disk_cache"
+#define TEST_SOURCE_FILEPATH "/tmp/bricklayer_test_disk_cache_source.txt"
+#define PAYLOAD_SIZE 1000
+// Of an entry with PAYLOAD_SIZE bytes, header included
+#define ENTRY_SIZE (PAYLOAD_SIZE + 64)
+
+DiskCache cache;
+uint8_t payload[PAYLOAD_SIZE];
+
+static void remove_directory(void) {
+    DIR *directory = opendir(TEST_CACHE_DIRECTORY);
+    if (!directory)
+        return;
+    struct dirent *dirent;
+    char filepath[512];
+    while ((dirent = readdir(directory))) {
+        if (dirent->d_name[0] == '.')
+            continue;
+        snprintf(filepath, sizeof(filepath), "%s/%s", TEST_CACHE_DIRECTORY,
+                 dirent->d_name);
+        remove(filepath);
+    }
+    closedir(directory);
+    rmdir(TEST_CACHE_DIRECTORY);
+}
+
+static size_t file_count(void) {
+    DIR *directory = opendir(TEST_CACHE_DIRECTORY);
+    TEST_ASSERT_NOT_NULL(directory);
+    size_t count = 0;
+    struct dirent *dirent;
+    while ((dirent = readdir(directory)))
+        count += dirent->d_name[0] != '.';
+    closedir(directory);
+    return count;
+}
+
+static void write_source(const char *contents) {
+    FILE *file = fopen(TEST_SOURCE_FILEPATH, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(contents, file);
+    fclose(file);
+}
+
+static DiskCacheKey fake_key(uint64_t source, uint64_t version) {
+    return (DiskCacheKey){.source = source, .version = version};
+}
+
+static int put_payload(DiskCacheKey key, uint8_t fill) {
+    memset(payload, fill, sizeof(payload));
+    struct iovec part = {payload, sizeof(payload)};
+    return disk_cache_put(&cache, key, &part, 1);
+}
+
+// 1 if the entry of `key` is there and holds `fill` bytes.
+static int has_payload(DiskCacheKey key, uint8_t fill) {
+    DiskCacheBlob blob;
+    if (disk_cache_get(&cache, key, &blob))
+        return 0;
+    int same = blob.size == PAYLOAD_SIZE;
+    for (size_t i = 0; same && i < blob.size; i++)
+        same = blob.data[i] == fill;
+    disk_cache_release(&blob);
+    return same;
+}
+
+void setUp(void) {
+    remove_directory();
+    TEST_ASSERT_EQUAL(
+        0, disk_cache_open(&cache, TEST_CACHE_DIRECTORY, 3 * ENTRY_SIZE));
+}
+
+void tearDown(void) {
+    disk_cache_close(&cache);
+    remove_directory();
+    remove(TEST_SOURCE_FILEPATH);
+}
+
+void test_entries_are_read_back(void) {
+    TEST_ASSERT_FALSE(has_payload(fake_key(1, 1), 0x11));
+    TEST_ASSERT_EQUAL(0, put_payload(fake_key(1, 1), 0x11));
+    TEST_ASSERT_TRUE(has_payload(fake_key(1, 1), 0x11));
+    TEST_ASSERT_FALSE(has_payload(fake_key(1, 2), 0x11));
+
+    // Still there for the next run
+    disk_cache_close(&cache);
+    TEST_ASSERT_EQUAL(
+        0, disk_cache_open(&cache, TEST_CACHE_DIRECTORY, 3 * ENTRY_SIZE));
+    TEST_ASSERT_TRUE(has_payload(fake_key(1, 1), 0x11));
+    // No temporary files are left behind
+    TEST_ASSERT_EQUAL(1, file_count());
+}
+
+void test_keys_follow_the_source(void) {
+    write_source("first");
+    DiskCacheKey first = disk_cache_key(DISK_CACHE_MESH, TEST_SOURCE_FILEPATH);
+    TEST_ASSERT_NOT_EQUAL(0, first.version);
+    DiskCacheKey other =
+        disk_cache_key(DISK_CACHE_PIXELS, TEST_SOURCE_FILEPATH);
+    TEST_ASSERT_NOT_EQUAL(first.source, other.source);
+
+    write_source("second version");
+    DiskCacheKey second =
+        disk_cache_key(DISK_CACHE_MESH, TEST_SOURCE_FILEPATH);
+    TEST_ASSERT_EQUAL(first.source, second.source);
+    TEST_ASSERT_NOT_EQUAL(first.version, second.version);
+
+    remove(TEST_SOURCE_FILEPATH);
+    DiskCacheKey missing =
+        disk_cache_key(DISK_CACHE_MESH, TEST_SOURCE_FILEPATH);
+    TEST_ASSERT_EQUAL(0, missing.version);
+    TEST_ASSERT_NOT_EQUAL(0, put_payload(missing, 0x22));
+}
+
+void test_least_recently_used_is_evicted(void) {
+    put_payload(fake_key(1, 1), 0x11);
+    put_payload(fake_key(2, 1), 0x22);
+    put_payload(fake_key(3, 1), 0x33);
+    TEST_ASSERT_TRUE(has_payload(fake_key(1, 1), 0x11));
+    put_payload(fake_key(4, 1), 0x44);
+    disk_cache_compact(&cache);
+
+    TEST_ASSERT_FALSE(has_payload(fake_key(2, 1), 0x22));
+    TEST_ASSERT_TRUE(has_payload(fake_key(1, 1), 0x11));
+    TEST_ASSERT_TRUE(has_payload(fake_key(3, 1), 0x33));
+    TEST_ASSERT_TRUE(has_payload(fake_key(4, 1), 0x44));
+    TEST_ASSERT_EQUAL(3, file_count());
+}
+
+void test_older_versions_are_swept(void) {
+    put_payload(fake_key(1, 1), 0x11);
+    put_payload(fake_key(1, 2), 0x12);
+    put_payload(fake_key(2, 1), 0x21);
+    disk_cache_compact(&cache);
+
+    TEST_ASSERT_FALSE(has_payload(fake_key(1, 1), 0x11));
+    TEST_ASSERT_TRUE(has_payload(fake_key(1, 2), 0x12));
+    TEST_ASSERT_TRUE(has_payload(fake_key(2, 1), 0x21));
+}
+
+void test_leftover_temporary_files_are_removed(void) {
+    const char *leftover =
+        TEST_CACHE_DIRECTORY "/0000000000000001-0000000000000001.cache.tmp.1.0";
+    const char *writing =
+        TEST_CACHE_DIRECTORY "/0000000000000001-0000000000000001.cache.tmp.1.1";
+    fclose(fopen(leftover, "w"));
+    fclose(fopen(writing, "w"));
+    struct timespec old[2] = {
+        {.tv_sec = time(0) - 2 * DISK_CACHE_STALE_SECONDS},
+        {.tv_sec = time(0) - 2 * DISK_CACHE_STALE_SECONDS},
+    };
+    TEST_ASSERT_EQUAL(0, utimensat(AT_FDCWD, leftover, old, 0));
+
+    disk_cache_compact(&cache);
+    TEST_ASSERT_NOT_EQUAL(0, access(leftover, F_OK));
+    TEST_ASSERT_EQUAL(0, access(writing, F_OK));
+}
+
+void test_damaged_entries_are_misses(void) {
+    put_payload(fake_key(5, 5), 0x55);
+    const char *filepath =
+        TEST_CACHE_DIRECTORY "/0000000000000005-0000000000000005.cache";
+    TEST_ASSERT_EQUAL(0, truncate(filepath, ENTRY_SIZE - 1));
+    TEST_ASSERT_FALSE(has_payload(fake_key(5, 5), 0x55));
+    TEST_ASSERT_NOT_EQUAL(0, access(filepath, F_OK));
+}
+
+void test_meshes_are_read_back(void) {
+    float vertices[] = {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0};
+    float normals[] = {0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1};
+    unsigned short indices[] = {0, 1, 2, 2, 1, 3};
+    Mesh mesh = {
+        .vertexCount = 4,
+        .triangleCount = 2,
+        .vertices = vertices,
+        .normals = normals,
+        .indices = indices,
+    };
+    TEST_ASSERT_EQUAL(0, disk_cache_put_mesh(&cache, fake_key(6, 1), &mesh));
+
+    Mesh read = {0};
+    TEST_ASSERT_EQUAL(0, disk_cache_get_mesh(&cache, fake_key(6, 1), &read));
+    TEST_ASSERT_EQUAL(4, read.vertexCount);
+    TEST_ASSERT_EQUAL(2, read.triangleCount);
+    TEST_ASSERT_EQUAL_MEMORY(vertices, read.vertices, sizeof(vertices));
+    TEST_ASSERT_EQUAL_MEMORY(normals, read.normals, sizeof(normals));
+    TEST_ASSERT_EQUAL_MEMORY(indices, read.indices, sizeof(indices));
+    TEST_ASSERT_NULL(read.texcoords);
+    TEST_ASSERT_NULL(read.colors);
+    free(read.vertices);
+    free(read.normals);
+    free(read.indices);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_entries_are_read_back);
+    RUN_TEST(test_keys_follow_the_source);
+    RUN_TEST(test_least_recently_used_is_evicted);
+    RUN_TEST(test_older_versions_are_swept);
+    RUN_TEST(test_leftover_temporary_files_are_removed);
+    RUN_TEST(test_damaged_entries_are_misses);
+    RUN_TEST(test_meshes_are_read_back);
+
+    return UNITY_END();
+}
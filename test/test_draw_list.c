@@ -0,0 +1,157 @@
+#include "draw_list.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Odd so that every kernel also goes through its scalar tail
+#define ENTRY_COUNT 1003
+
+DrawList list;
+uint32_t expected[ENTRY_COUNT];
+uint32_t random_state = 1;
+
+static inline float random_float(float min, float max) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return min + (max - min) * (float)(random_state >> 8) / (float)(1 << 24);
+}
+
+static PointCloudView view_from(float distance) {
+    Camera camera = {
+        .position = {0.0f, 0.0f, distance},
+        .target = {0.0f, 0.0f, 0.0f},
+        .up = {0.0f, 1.0f, 0.0f},
+        .fovy = 45.0f,
+    };
+    return point_cloud_view(camera, 800, 450);
+}
+
+static void set_box(size_t index, Vector3 center, float half_size) {
+    BoundingBox bounds = {
+        {center.x - half_size, center.y - half_size, center.z - half_size},
+        {center.x + half_size, center.y + half_size, center.z + half_size},
+    };
+    Mesh mesh = {.vertexCount = 3, .vaoId = (unsigned int)index + 1};
+    draw_list_set(&list, index, &mesh, 0, bounds, 0);
+}
+
+void setUp(void) {
+    draw_list_init(&list, ENTRY_COUNT);
+}
+
+void tearDown(void) {
+    draw_list_free(&list);
+}
+
+void test_boxes_outside_the_view_are_culled(void) {
+    PointCloudView view = view_from(10.0f);
+    set_box(0, (Vector3){0.0f, 0.0f, 0.0f}, 1.0f);
+    // Behind the camera
+    set_box(1, (Vector3){0.0f, 0.0f, 20.0f}, 1.0f);
+    // Beside and above the view
+    set_box(2, (Vector3){30.0f, 0.0f, 0.0f}, 1.0f);
+    set_box(3, (Vector3){0.0f, 30.0f, 0.0f}, 1.0f);
+    // Partly inside
+    set_box(4, (Vector3){9.0f, 0.0f, 0.0f}, 2.5f);
+    // Around the camera
+    set_box(5, (Vector3){0.0f, 0.0f, 10.0f}, 50.0f);
+    for (size_t i = 6; i < ENTRY_COUNT; i++)
+        set_box(i, (Vector3){0.0f, 0.0f, 100.0f}, 1.0f);
+
+    for (int kernel = 0; kernel < DRAW_LIST_KERNEL_COUNT; kernel++) {
+        if (!draw_list_kernel_supported(kernel))
+            continue;
+        TEST_ASSERT_EQUAL_MESSAGE(
+            3, draw_list_cull_kernel(kernel, &list, &view),
+            draw_list_kernel_name(kernel));
+        TEST_ASSERT_EQUAL(0, list.visible[0]);
+        TEST_ASSERT_EQUAL(4, list.visible[1]);
+        TEST_ASSERT_EQUAL(5, list.visible[2]);
+    }
+}
+
+void test_entries_without_a_mesh_are_culled(void) {
+    PointCloudView view = view_from(10.0f);
+    for (size_t i = 0; i < ENTRY_COUNT; i++)
+        set_box(i, (Vector3){0.0f, 0.0f, 0.0f}, 1.0f);
+    // Zero filled like a model that is not loaded yet, the origin is in view
+    for (size_t i = 0; i < ENTRY_COUNT; i += 2)
+        draw_list_set(&list, i, 0, 0, (BoundingBox){0}, 0);
+
+    for (int kernel = 0; kernel < DRAW_LIST_KERNEL_COUNT; kernel++) {
+        if (!draw_list_kernel_supported(kernel))
+            continue;
+        TEST_ASSERT_EQUAL_MESSAGE(ENTRY_COUNT / 2,
+                                  draw_list_cull_kernel(kernel, &list, &view),
+                                  draw_list_kernel_name(kernel));
+        for (size_t v = 0; v < list.visible_count; v++)
+            TEST_ASSERT_EQUAL(v * 2 + 1, list.visible[v]);
+    }
+}
+
+static void check_kernel(DrawListKernel kernel) {
+    if (!draw_list_kernel_supported(kernel))
+        TEST_IGNORE_MESSAGE("Not supported by this CPU");
+
+    for (size_t i = 0; i < ENTRY_COUNT; i++)
+        set_box(i,
+                (Vector3){random_float(-40.0f, 40.0f),
+                          random_float(-40.0f, 40.0f),
+                          random_float(-40.0f, 40.0f)},
+                random_float(0.0f, 3.0f));
+    PointCloudView view = view_from(20.0f);
+
+    size_t expected_count =
+        draw_list_cull_kernel(DRAW_LIST_KERNEL_SCALAR, &list, &view);
+    TEST_ASSERT_GREATER_THAN(0, expected_count);
+    TEST_ASSERT_LESS_THAN(ENTRY_COUNT, expected_count);
+    memcpy(expected, list.visible, expected_count * sizeof(uint32_t));
+
+    TEST_ASSERT_EQUAL(expected_count,
+                      draw_list_cull_kernel(kernel, &list, &view));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, list.visible, expected_count);
+}
+
+void test_sse41_matches_scalar(void) {
+    check_kernel(DRAW_LIST_KERNEL_SSE41);
+}
+
+void test_avx2_matches_scalar(void) {
+    check_kernel(DRAW_LIST_KERNEL_AVX2);
+}
+
+void test_entries_follow_the_mesh(void) {
+    unsigned short indices[6] = {0};
+    Mesh mesh = {.vertexCount = 4, .triangleCount = 2, .vaoId = 7};
+    BoundingBox bounds = {{-1.0f, -2.0f, -3.0f}, {1.0f, 2.0f, 3.0f}};
+
+    draw_list_set(&list, 2, &mesh, 9, bounds, DRAW_LIST_TILED);
+    TEST_ASSERT_EQUAL(7, list.vao_ids[2]);
+    TEST_ASSERT_EQUAL(4, list.element_counts[2]);
+    TEST_ASSERT_EQUAL(9, list.texture_ids[2]);
+    TEST_ASSERT_EQUAL(DRAW_LIST_TILED, list.flags[2]);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, list.min_y[2]);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, list.max_z[2]);
+
+    mesh.indices = indices;
+    draw_list_set(&list, 2, &mesh, 9, bounds, 0);
+    TEST_ASSERT_EQUAL(6, list.element_counts[2]);
+    TEST_ASSERT_EQUAL(DRAW_LIST_INDEXED, list.flags[2]);
+
+    draw_list_set(&list, 2, 0, 0, bounds, 0);
+    TEST_ASSERT_EQUAL(0, list.vao_ids[2]);
+    TEST_ASSERT_EQUAL(0, list.flags[2]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_boxes_outside_the_view_are_culled);
+    RUN_TEST(test_entries_without_a_mesh_are_culled);
+    RUN_TEST(test_sse41_matches_scalar);
+    RUN_TEST(test_avx2_matches_scalar);
+    RUN_TEST(test_entries_follow_the_mesh);
+
+    return UNITY_END();
+}
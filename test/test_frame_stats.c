@@ -0,0 +1,54 @@
+#include "frame_stats.h"
+#include "unity.h"
+
+FrameStats stats;
+
+void setUp(void) {
+    stats = frame_stats_init(0);
+}
+
+void tearDown(void) {
+    frame_stats_free(&stats);
+}
+
+void test_summary(void) {
+    for (int i = 1; i <= 100; i++)
+        frame_stats_add(&stats, i / 1000.0);
+
+    FrameStatsSummary summary = frame_stats_summarize(&stats);
+    TEST_ASSERT_EQUAL(100, summary.count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.001, summary.min);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.100, summary.max);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.0505, summary.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.050, summary.p50);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.095, summary.p95);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.099, summary.p99);
+    TEST_ASSERT_EQUAL(0, summary.hitches);
+}
+
+void test_hitches(void) {
+    for (int i = 0; i < 2000; i++)
+        frame_stats_add(&stats, 0.016);
+    frame_stats_add(&stats, 0.100);
+    frame_stats_add(&stats, 0.033);
+
+    FrameStatsSummary summary = frame_stats_summarize(&stats);
+    TEST_ASSERT_EQUAL(2002, summary.count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.016, summary.p50);
+    TEST_ASSERT_EQUAL(2, summary.hitches);
+}
+
+void test_empty(void) {
+    FrameStatsSummary summary = frame_stats_summarize(&stats);
+    TEST_ASSERT_EQUAL(0, summary.count);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_summary);
+    RUN_TEST(test_hitches);
+    RUN_TEST(test_empty);
+
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#include "asset_gen.h"
+#include "gl_loader.h"
+#include "raylib.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Needs a display. Runs headless with Mesa's software renderer under Xvfb:
+// LIBGL_ALWAYS_SOFTWARE=1 xvfb-run make test
+
+#define TEST_OBJ_FILEPATH "/tmp/bricklayer_test_gl_loader.obj"
+#define TEST_ASEPRITE_FILEPATH "/tmp/bricklayer_test_gl_loader.aseprite"
+
+static int has_gl = 0;
+
+void setUp(void) {
+    if (!has_gl)
+        TEST_IGNORE_MESSAGE("No display, skipping OpenGL tests");
+}
+
+void tearDown(void) {}
+
+// Polls the loader like the main loop does until a result is ready.
+static int wait_for_result(GlLoadResult *result) {
+    for (int i = 0; i < 5000; i++) {
+        if (gl_loader_poll(result))
+            return 1;
+        WaitTime(0.001);
+    }
+    return 0;
+}
+
+void test_texture_is_uploaded(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 96;
+    options.height = 48;
+    TEST_ASSERT_FALSE(
+        asset_gen_write_aseprite_file(TEST_ASEPRITE_FILEPATH, &options));
+
+    gl_loader_load_texture(TEST_ASEPRITE_FILEPATH, 3);
+
+    GlLoadResult result;
+    TEST_ASSERT_TRUE(wait_for_result(&result));
+    TEST_ASSERT_EQUAL(GL_LOAD_TEXTURE, result.kind);
+    TEST_ASSERT_EQUAL(3, result.model_index);
+    TEST_ASSERT_NOT_EQUAL(0, result.texture.id);
+    TEST_ASSERT_EQUAL(96, result.texture.width);
+    TEST_ASSERT_EQUAL(48, result.texture.height);
+
+    UnloadTexture(result.texture);
+    remove(TEST_ASEPRITE_FILEPATH);
+}
+
+void test_model_is_uploaded_in_order(void) {
+    ObjGenOptions options = asset_gen_obj_defaults();
+    options.triangle_count = 200;
+    TEST_ASSERT_FALSE(asset_gen_write_obj_file(TEST_OBJ_FILEPATH, &options));
+
+    gl_loader_load_model(TEST_OBJ_FILEPATH, 0);
+    gl_loader_load_model(TEST_OBJ_FILEPATH, 1);
+
+    for (uint64_t i = 0; i < 2; i++) {
+        GlLoadResult result;
+        TEST_ASSERT_TRUE(wait_for_result(&result));
+        TEST_ASSERT_EQUAL(GL_LOAD_MODEL, result.kind);
+        TEST_ASSERT_EQUAL(i, result.model_index);
+        TEST_ASSERT_EQUAL(1, result.model.meshCount);
+        TEST_ASSERT_EQUAL(200, result.model.meshes[0].triangleCount);
+        // Rebuilt for this context
+        TEST_ASSERT_NOT_EQUAL(0, result.model.meshes[0].vaoId);
+        UnloadModel(result.model);
+    }
+
+    remove(TEST_OBJ_FILEPATH);
+}
+
+int main(void) {
+    has_gl = getenv("DISPLAY") || getenv("WAYLAND_DISPLAY");
+    if (has_gl) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(64, 64, "test_gl_loader");
+        has_gl = IsWindowReady() && !gl_loader_start();
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_texture_is_uploaded);
+    RUN_TEST(test_model_is_uploaded_in_order);
+
+    int result = UNITY_END();
+    if (has_gl) {
+        gl_loader_stop();
+        CloseWindow();
+    }
+    return result;
+}
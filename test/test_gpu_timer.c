@@ -0,0 +1,167 @@
+#define _DEFAULT_SOURCE
+#include "gpu_timer.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_QUERY_COUNT 256
+
+// Queries of a GPU that finishes the commands of a frame `gpu_delay` frames
+// later, its clock advanced by the scopes of run_frame
+uint64_t query_times[FAKE_QUERY_COUNT];
+uint64_t query_ready_frame[FAKE_QUERY_COUNT];
+unsigned int next_query = 1;
+unsigned int live_queries = 0;
+uint64_t gpu_clock = 0;
+uint64_t frame = 0;
+uint64_t gpu_delay = 1;
+
+static void fake_create(unsigned int *ids, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        ids[i] = next_query++;
+    live_queries += (unsigned int)count;
+    TEST_ASSERT_LESS_THAN(FAKE_QUERY_COUNT, next_query);
+}
+
+static void fake_destroy(unsigned int *ids, size_t count) {
+    live_queries -= (unsigned int)count;
+}
+
+static void fake_timestamp(unsigned int id) {
+    query_times[id] = gpu_clock;
+    query_ready_frame[id] = frame + gpu_delay;
+}
+
+static int fake_result(unsigned int id, uint64_t *nanoseconds) {
+    if (frame < query_ready_frame[id])
+        return 0;
+    *nanoseconds = query_times[id];
+    return 1;
+}
+
+static const GpuTimerQueries fake_queries = {
+    .create = &fake_create,
+    .destroy = &fake_destroy,
+    .timestamp = &fake_timestamp,
+    .result = &fake_result,
+};
+
+GpuTimer timer;
+
+void setUp(void) {
+    memset(query_times, 0, sizeof(query_times));
+    memset(query_ready_frame, 0, sizeof(query_ready_frame));
+    next_query = 1;
+    gpu_clock = 1000000000;
+    frame = 0;
+    gpu_delay = 1;
+    gpu_timer_init(&timer, 3, &fake_queries);
+}
+
+void tearDown(void) {
+    gpu_timer_free(&timer);
+    TEST_ASSERT_EQUAL(0, live_queries);
+}
+
+// Times a frame where scope i takes `milliseconds[i]`, negative if not drawn
+static void run_frame(const double *milliseconds) {
+    gpu_timer_begin_frame(&timer);
+    for (size_t scope = 0; scope < 3; scope++) {
+        if (milliseconds[scope] < 0)
+            continue;
+        gpu_timer_begin(&timer, scope);
+        gpu_clock += (uint64_t)(milliseconds[scope] * 1e6);
+        gpu_timer_end(&timer, scope);
+    }
+    frame++;
+}
+
+void test_results_arrive_after_the_latency(void) {
+    double times[3] = {1, 2, 3};
+    for (int i = 0; i < GPU_TIMER_LATENCY; i++) {
+        run_frame(times);
+        TEST_ASSERT_EQUAL(0, timer.stats[0].samples);
+    }
+    run_frame(times);
+    TEST_ASSERT_EQUAL(1, timer.stats[0].samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, (float)timer.stats[1].last_ms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, (float)timer.stats[2].last_ms);
+    TEST_ASSERT_EQUAL(0, timer.dropped);
+}
+
+void test_statistics_accumulate(void) {
+    double times[][3] = {{1, 0.5, 2}, {3, 0.5, 2}, {2, 0.5, 2}};
+    for (int i = 0; i < 3; i++)
+        run_frame(times[i]);
+    double none[3] = {-1, -1, -1};
+    for (int i = 0; i < GPU_TIMER_LATENCY; i++)
+        run_frame(none);
+
+    GpuTimerStats *stats = timer.stats;
+    TEST_ASSERT_EQUAL(3, stats->samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 6.0f, (float)stats->total_ms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, (float)stats->min_ms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, (float)stats->max_ms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, (float)stats->last_ms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.28f, (float)stats->recent_ms);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, (float)timer.stats[1].recent_ms);
+}
+
+void test_late_results_are_dropped(void) {
+    gpu_delay = GPU_TIMER_LATENCY + 1;
+    double times[3] = {1, -1, 1};
+    for (int i = 0; i < GPU_TIMER_LATENCY + 2; i++)
+        run_frame(times);
+    TEST_ASSERT_EQUAL(0, timer.stats[0].samples);
+    TEST_ASSERT_EQUAL(4, timer.dropped);
+    TEST_ASSERT_EQUAL(0, timer.stats[1].samples);
+}
+
+void test_scopes_rank_by_recent_time(void) {
+    double times[3] = {1, 3, 2};
+    for (int i = 0; i < GPU_TIMER_LATENCY + 1; i++)
+        run_frame(times);
+    gpu_timer_rank(&timer);
+    TEST_ASSERT_EQUAL(1, timer.order[0]);
+    TEST_ASSERT_EQUAL(2, timer.order[1]);
+    TEST_ASSERT_EQUAL(0, timer.order[2]);
+
+    // The ranking follows when costs change
+    double changed[3] = {9, 3, 2};
+    for (int i = 0; i < 40; i++)
+        run_frame(changed);
+    gpu_timer_rank(&timer);
+    TEST_ASSERT_EQUAL(0, timer.order[0]);
+    TEST_ASSERT_EQUAL(1, timer.order[1]);
+}
+
+void test_print_lists_timed_scopes(void) {
+    double times[3] = {1, -1, 4};
+    for (int i = 0; i < GPU_TIMER_LATENCY + 2; i++)
+        run_frame(times);
+
+    char buffer[1024] = {0};
+    FILE *file = fmemopen(buffer, sizeof(buffer) - 1, "w");
+    const char *names[3] = {"grid", "wireframe", "model.obj"};
+    gpu_timer_print(&timer, names, file);
+    fclose(file);
+
+    char *model = strstr(buffer, "model.obj");
+    char *grid = strstr(buffer, "grid");
+    TEST_ASSERT_NOT_NULL(model);
+    TEST_ASSERT_NOT_NULL(grid);
+    TEST_ASSERT_TRUE(model < grid);
+    TEST_ASSERT_NULL(strstr(buffer, "wireframe"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_results_arrive_after_the_latency);
+    RUN_TEST(test_statistics_accumulate);
+    RUN_TEST(test_late_results_are_dropped);
+    RUN_TEST(test_scopes_rank_by_recent_time);
+    RUN_TEST(test_print_lists_timed_scopes);
+
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+#include "ase_compose.h"
+#include "asset_gen.h"
+#include "cute_aseprite.h"
+#include "layer_cache.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LAYER_COUNT 8
+
+uint8_t *file = 0;
+size_t file_size = 0;
+// Composited with ase_compose_frame for comparison
+ase_t *reference = 0;
+uint8_t *expected = 0;
+LayerCache cache;
+
+static ase_t *load(void) {
+    ase_t *ase = cute_aseprite_load_from_memory_ex(
+        file, (int)file_size, CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    TEST_ASSERT_NOT_NULL(ase);
+    return ase;
+}
+
+static void compare_with_reference(void) {
+    size_t row_size = (size_t)reference->w * 4;
+    AseComposeTarget target = {
+        .pixels = expected,
+        .stride = row_size,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+    ase_compose_frame(reference, 0, &target);
+    TEST_ASSERT_EQUAL_MEMORY(expected, layer_cache_pixels(&cache),
+                             row_size * (size_t)reference->h);
+}
+
+void setUp(void) {
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 48;
+    options.height = 32;
+    options.layer_count = LAYER_COUNT;
+    file_size = asset_gen_aseprite(&options, &file);
+    TEST_ASSERT_NOT_EQUAL(0, file_size);
+
+    reference = load();
+    expected = malloc((size_t)reference->w * (size_t)reference->h * 4);
+    TEST_ASSERT_EQUAL(0, layer_cache_init(&cache, load(), 0));
+}
+
+void tearDown(void) {
+    layer_cache_free(&cache);
+    cute_aseprite_free(reference);
+    free(expected);
+    free(file);
+}
+
+void test_composite_matches_frame(void) {
+    TEST_ASSERT_EQUAL(LAYER_COUNT, layer_cache_layer_count(&cache));
+    compare_with_reference();
+    TEST_ASSERT_EQUAL(LAYER_COUNT, cache.cels_composited);
+
+    // Nothing changed, nothing to composite
+    compare_with_reference();
+    TEST_ASSERT_EQUAL(0, cache.cels_composited);
+}
+
+void test_toggle_recomposites_layers_above(void) {
+    layer_cache_pixels(&cache);
+
+    layer_cache_set_visible(&cache, LAYER_COUNT - 3, 0);
+    reference->layers[LAYER_COUNT - 3].flags &= ~ASE_LAYER_FLAGS_VISIBLE;
+    compare_with_reference();
+    TEST_ASSERT_EQUAL(2, cache.cels_composited);
+
+    layer_cache_set_visible(&cache, LAYER_COUNT - 3, 1);
+    reference->layers[LAYER_COUNT - 3].flags |= ASE_LAYER_FLAGS_VISIBLE;
+    compare_with_reference();
+    TEST_ASSERT_EQUAL(3, cache.cels_composited);
+}
+
+void test_solo_layer(void) {
+    layer_cache_set_solo(&cache, 2);
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        if (i != 2)
+            reference->layers[i].flags &= ~ASE_LAYER_FLAGS_VISIBLE;
+    }
+    compare_with_reference();
+    TEST_ASSERT_EQUAL(1, cache.cels_composited);
+
+    // Back to the cached regular composite
+    layer_cache_set_solo(&cache, -1);
+    for (int i = 0; i < LAYER_COUNT; i++)
+        reference->layers[i].flags |= ASE_LAYER_FLAGS_VISIBLE;
+    compare_with_reference();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_composite_matches_frame);
+    RUN_TEST(test_toggle_recomposites_layers_above);
+    RUN_TEST(test_solo_layer);
+
+    return UNITY_END();
+}
@@ -0,0 +1,100 @@
+#include "lights.h"
+#include "raymath.h"
+#include "unity.h"
+
+LightSet set;
+
+void setUp(void) {
+    set = (LightSet){0};
+}
+
+void tearDown(void) {
+    light_set_free(&set);
+}
+
+static void add_point_light(Vector3 position, float radius) {
+    Light light = {
+        .type = LIGHT_POINT,
+        .enabled = true,
+        .position = position,
+        .color = {255, 128, 0, 255},
+        .attenuation = radius,
+    };
+    TEST_ASSERT_EQUAL(0, light_set_add(&set, light));
+}
+
+static BoundingBox unit_box_at(float x) {
+    return (BoundingBox){{x - 0.5f, -0.5f, -0.5f}, {x + 0.5f, 0.5f, 0.5f}};
+}
+
+void test_directional_lights_are_refused(void) {
+    Light light = {.type = LIGHT_DIRECTIONAL, .enabled = true};
+    TEST_ASSERT_EQUAL(1, light_set_add(&set, light));
+    TEST_ASSERT_EQUAL(0, set.light_count);
+}
+
+void test_converts_rlights_lights(void) {
+    add_point_light((Vector3){1, 2, 3}, 4.0f);
+    TEST_ASSERT_EQUAL(1, set.light_count);
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, set.lights[0].radius);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, set.lights[0].color.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.5f, set.lights[0].color.y);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, set.lights[0].intensity);
+}
+
+void test_each_draw_gets_the_lights_touching_it(void) {
+    BoundingBox boxes[3] = {unit_box_at(0), unit_box_at(10), unit_box_at(20)};
+    // Touches the first box only, both of the first two, none
+    add_point_light((Vector3){-1, 0, 0}, 1.0f);
+    add_point_light((Vector3){5, 0, 0}, 5.0f);
+    add_point_light((Vector3){100, 0, 0}, 1.0f);
+
+    light_set_cull(&set, boxes, 3, MatrixIdentity());
+    TEST_ASSERT_EQUAL(3, set.draw_count);
+    TEST_ASSERT_EQUAL(3, set.culled_used);
+
+    TEST_ASSERT_EQUAL(0, set.draws[0].offset);
+    TEST_ASSERT_EQUAL(2, set.draws[0].count);
+    TEST_ASSERT_EQUAL(2, set.draws[1].offset);
+    TEST_ASSERT_EQUAL(1, set.draws[1].count);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, set.culled[2].position.x);
+    TEST_ASSERT_EQUAL(0, set.draws[2].count);
+}
+
+void test_lights_are_moved_before_culling(void) {
+    BoundingBox box = unit_box_at(10);
+    add_point_light((Vector3){0, 0, 0}, 1.0f);
+
+    light_set_cull(&set, &box, 1, MatrixIdentity());
+    TEST_ASSERT_EQUAL(0, set.draws[0].count);
+
+    light_set_cull(&set, &box, 1, MatrixTranslate(10, 0, 0));
+    TEST_ASSERT_EQUAL(1, set.draws[0].count);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, set.culled[0].position.x);
+    // The placed lights stay where they were
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, set.lights[0].position.x);
+}
+
+void test_lights_per_draw_are_capped(void) {
+    BoundingBox boxes[2] = {unit_box_at(0), unit_box_at(1)};
+    for (size_t i = 0; i < LIGHTS_MAX_PER_DRAW + 10; i++)
+        add_point_light((Vector3){0.5f, 0, 0}, 2.0f);
+
+    light_set_cull(&set, boxes, 2, MatrixIdentity());
+    TEST_ASSERT_EQUAL(LIGHTS_MAX_PER_DRAW, set.draws[0].count);
+    TEST_ASSERT_EQUAL(LIGHTS_MAX_PER_DRAW, set.draws[1].offset);
+    TEST_ASSERT_EQUAL(LIGHTS_MAX_PER_DRAW, set.draws[1].count);
+    TEST_ASSERT_EQUAL(2 * LIGHTS_MAX_PER_DRAW, set.culled_used);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_directional_lights_are_refused);
+    RUN_TEST(test_converts_rlights_lights);
+    RUN_TEST(test_each_draw_gets_the_lights_touching_it);
+    RUN_TEST(test_lights_are_moved_before_culling);
+    RUN_TEST(test_lights_per_draw_are_capped);
+
+    return UNITY_END();
+}
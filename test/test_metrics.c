@@ -0,0 +1,160 @@
+#define _DEFAULT_SOURCE
+#include "metrics.h"
+#include "unity.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_METRICS_FILEPATH "/tmp/bricklayer_test_metrics.txt"
+#define COUNTING_THREADS 4
+#define COUNTS_PER_THREAD 100000
+
+char output[16384];
+
+void setUp(void) {
+    metrics_reset();
+    memset(output, 0, sizeof(output));
+}
+
+void tearDown(void) {
+    remove(TEST_METRICS_FILEPATH);
+}
+
+static void write_output(void) {
+    FILE *file = fmemopen(output, sizeof(output) - 1, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    metrics_write(file);
+    fclose(file);
+}
+
+// 1 if `line` is a whole line of the output
+static int has_line(const char *line) {
+    size_t length = strlen(line);
+    for (const char *found = strstr(output, line); found;
+         found = strstr(found + 1, line)) {
+        if ((found == output || found[-1] == '\n') && found[length] == '\n')
+            return 1;
+    }
+    return 0;
+}
+
+void test_counters_and_gauges_are_written(void) {
+    metrics_count(METRIC_MODEL_LOADS, 2);
+    metrics_count(METRIC_MODEL_LOADS, 1);
+    metrics_count(METRIC_TEXTURE_LOADS, 5);
+    metrics_count(METRIC_DECODE_NANOSECONDS, 1500000000);
+    metrics_store(METRIC_FIREWATCH_DROPPED, 7);
+    metrics_set(METRIC_TEXTURE_BYTES, 4096);
+    metrics_set(METRIC_FIREWATCH_QUEUE_DEPTH, 3);
+    metrics_set(METRIC_FIREWATCH_QUEUE_DEPTH, 1);
+    write_output();
+
+    TEST_ASSERT_TRUE(has_line("# TYPE bricklayer_asset_loads counter"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_asset_loads_total{kind=\"model\"} 3"));
+    TEST_ASSERT_TRUE(
+        has_line("bricklayer_asset_loads_total{kind=\"texture\"} 5"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_decode_seconds_total 1.500000000"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_firewatch_dropped_events_total 7"));
+    TEST_ASSERT_TRUE(
+        has_line("bricklayer_asset_memory_bytes{class=\"texture\"} 4096"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_firewatch_queue_depth 1"));
+    TEST_ASSERT_TRUE(has_line("# EOF"));
+}
+
+void test_families_are_written_once(void) {
+    write_output();
+    const char *header = "# TYPE bricklayer_cache_hits counter";
+    char *first = strstr(output, header);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_NULL(strstr(first + 1, header));
+    TEST_ASSERT_TRUE(has_line("# UNIT bricklayer_decode_bytes bytes"));
+
+    // The labelled metrics of a family follow its header
+    char *octree = strstr(output, "bricklayer_cache_hits_total{cache=\"octree\"}");
+    char *layers = strstr(output, "bricklayer_cache_hits_total{cache=\"layers\"}");
+    char *misses = strstr(output, "# TYPE bricklayer_cache_misses counter");
+    TEST_ASSERT_TRUE(first < octree && octree < layers && layers < misses);
+}
+
+void test_histograms_are_cumulative(void) {
+    metrics_observe(METRIC_FRAME_SECONDS, 0.001);
+    metrics_observe(METRIC_FRAME_SECONDS, 0.016);
+    metrics_observe(METRIC_FRAME_SECONDS, 0.016);
+    metrics_observe(METRIC_FRAME_SECONDS, 5.0);
+    metrics_observe(METRIC_TEXTURE_LOAD_SECONDS, 0.2);
+    write_output();
+
+    TEST_ASSERT_TRUE(has_line("bricklayer_frame_seconds_bucket{le=\"0.002\"} 1"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_frame_seconds_bucket{le=\"0.012\"} 1"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_frame_seconds_bucket{le=\"0.017\"} 3"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_frame_seconds_bucket{le=\"1\"} 3"));
+    TEST_ASSERT_TRUE(
+        has_line("bricklayer_frame_seconds_bucket{le=\"+Inf\"} 4"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_frame_seconds_count 4"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_frame_seconds_sum 5.033000000"));
+
+    TEST_ASSERT_TRUE(has_line("bricklayer_asset_load_seconds_bucket{kind="
+                              "\"texture\",le=\"0.25\"} 1"));
+    TEST_ASSERT_TRUE(has_line("bricklayer_asset_load_seconds_bucket{kind="
+                              "\"model\",le=\"+Inf\"} 0"));
+    TEST_ASSERT_TRUE(
+        has_line("bricklayer_asset_load_seconds_count{kind=\"texture\"} 1"));
+}
+
+static void *count_many(void *arg) {
+    (void)arg;
+    for (int i = 0; i < COUNTS_PER_THREAD; i++) {
+        metrics_count(METRIC_FIREWATCH_EVENTS, 1);
+        metrics_observe(METRIC_MODEL_LOAD_SECONDS, 0.003);
+    }
+    return 0;
+}
+
+void test_counting_from_threads_loses_nothing(void) {
+    pthread_t threads[COUNTING_THREADS];
+    for (int i = 0; i < COUNTING_THREADS; i++)
+        pthread_create(threads + i, 0, &count_many, 0);
+    for (int i = 0; i < COUNTING_THREADS; i++)
+        pthread_join(threads[i], 0);
+    write_output();
+
+    char line[128];
+    snprintf(line, sizeof(line), "bricklayer_firewatch_events_total %d",
+             COUNTING_THREADS * COUNTS_PER_THREAD);
+    TEST_ASSERT_TRUE(has_line(line));
+    snprintf(line, sizeof(line),
+             "bricklayer_asset_load_seconds_count{kind=\"model\"} %d",
+             COUNTING_THREADS * COUNTS_PER_THREAD);
+    TEST_ASSERT_TRUE(has_line(line));
+}
+
+void test_export_replaces_the_file(void) {
+    metrics_count(METRIC_LOAD_FAILURES, 1);
+    TEST_ASSERT_EQUAL(0, metrics_export_start(TEST_METRICS_FILEPATH, 60.0));
+    metrics_count(METRIC_LOAD_FAILURES, 1);
+    // Stopping writes the latest values
+    metrics_export_stop();
+
+    FILE *file = fopen(TEST_METRICS_FILEPATH, "r");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(output, 1, sizeof(output) - 1, file);
+    fclose(file);
+    TEST_ASSERT_GREATER_THAN(0, size);
+    TEST_ASSERT_TRUE(has_line("bricklayer_asset_load_failures_total 2"));
+    TEST_ASSERT_TRUE(has_line("# EOF"));
+
+    FILE *temporary = fopen(TEST_METRICS_FILEPATH ".tmp", "r");
+    TEST_ASSERT_NULL(temporary);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_counters_and_gauges_are_written);
+    RUN_TEST(test_families_are_written_once);
+    RUN_TEST(test_histograms_are_cumulative);
+    RUN_TEST(test_counting_from_threads_loses_nothing);
+    RUN_TEST(test_export_replaces_the_file);
+
+    return UNITY_END();
+}
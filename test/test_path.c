@@ -31,12 +31,41 @@ void test_get_corresponding_less_than_three_chars(void) {
     TEST_ASSERT_FALSE(actual_path);
 }
 
+void test_is_aseprite(void) {
+    TEST_ASSERT_TRUE(path_is_aseprite("/sprites/brick.aseprite"));
+    TEST_ASSERT_TRUE(path_is_aseprite(".aseprite"));
+    TEST_ASSERT_FALSE(path_is_aseprite("/models/brick.obj"));
+    TEST_ASSERT_FALSE(path_is_aseprite("aseprite"));
+
+    TEST_ASSERT_TRUE(path_is_aseprite_texture("/sprites/brick.aseprite"));
+    TEST_ASSERT_TRUE(path_is_aseprite_texture("/sprites/brick.ase"));
+    TEST_ASSERT_FALSE(path_is_aseprite_texture("/sprites/brick.png"));
+    TEST_ASSERT_FALSE(path_is_aseprite_texture("ase"));
+}
+
+void test_sprites_are_their_own_texture(void) {
+    char texture_path[64];
+    TEST_ASSERT_EQUAL(0, path_write_texture_file(texture_path,
+                                                 sizeof(texture_path),
+                                                 "/sprites/brick.aseprite"));
+    TEST_ASSERT_EQUAL_STRING("/sprites/brick.aseprite", texture_path);
+
+    TEST_ASSERT_EQUAL(0, path_write_texture_file(
+                             texture_path, sizeof(texture_path), "wall.obj"));
+    TEST_ASSERT_EQUAL_STRING("wall.aseprite", texture_path);
+
+    TEST_ASSERT_EQUAL(1, path_write_texture_file(texture_path, 8,
+                                                 "/sprites/brick.aseprite"));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
     RUN_TEST(test_get_corresponding_works_correctly);
     RUN_TEST(test_get_corresponding_less_than_three_chars);
     RUN_TEST(test_get_corresponding_only_three_chars);
+    RUN_TEST(test_is_aseprite);
+    RUN_TEST(test_sprites_are_their_own_texture);
 
     return UNITY_END();
 }
@@ -0,0 +1,227 @@
+#include "point_cloud.h"
+#include "unity.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SCAN_FILEPATH "/tmp/bricklayer_test_scan.obj"
+#define CACHE_FILEPATH SCAN_FILEPATH ".octree"
+#define SCAN_POINTS 50000
+
+PointCloud cloud;
+
+void setUp(void) {
+    cloud = (PointCloud){0};
+    unlink(CACHE_FILEPATH);
+}
+
+void tearDown(void) {
+    point_cloud_free(&cloud);
+    unlink(SCAN_FILEPATH);
+    unlink(CACHE_FILEPATH);
+}
+
+// Points on the surface of a unit sphere, with a few faces and normals mixed
+// in that are not points.
+static void write_scan(size_t point_count) {
+    FILE *file = fopen(SCAN_FILEPATH, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "# scan\no scan\n");
+    srand(1);
+    for (size_t i = 0; i < point_count; i++) {
+        float z = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+        float angle = (float)rand() / RAND_MAX * 6.2831853f;
+        float radius = sqrtf(1.0f - z * z);
+        if (i % 2)
+            fprintf(file, "v %f %f %f 1.0 0.5 0\n", radius * cosf(angle),
+                    radius * sinf(angle), z);
+        else
+            fprintf(file, "v %e %e %e\n", radius * cosf(angle),
+                    radius * sinf(angle), z);
+        if (i % 1000 == 0)
+            fprintf(file, "vn 0 1 0\nf 1 2 3\n");
+    }
+    fclose(file);
+}
+
+void test_parses_the_vertices_only(void) {
+    write_scan(1000);
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 3));
+    TEST_ASSERT_EQUAL(1, cloud.built);
+    TEST_ASSERT_EQUAL(1000, cloud.point_count);
+    // Too few points to split
+    TEST_ASSERT_EQUAL(1, cloud.node_count);
+    TEST_ASSERT_EQUAL(1000, cloud.nodes[0].count);
+
+    size_t colored = 0;
+    for (size_t i = 0; i < cloud.point_count; i++) {
+        const CloudPoint *point = cloud.points + i;
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f,
+                                 sqrtf(point->x * point->x +
+                                       point->y * point->y +
+                                       point->z * point->z));
+        if (point->r == 255) {
+            TEST_ASSERT_EQUAL(128, point->g);
+            TEST_ASSERT_EQUAL(0, point->b);
+            colored++;
+        }
+    }
+    TEST_ASSERT_EQUAL(500, colored);
+}
+
+void test_leaves_hold_their_points(void) {
+    write_scan(SCAN_POINTS);
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 4));
+    TEST_ASSERT_EQUAL(SCAN_POINTS, cloud.point_count);
+    TEST_ASSERT_GREATER_THAN(8, cloud.node_count);
+    TEST_ASSERT_EQUAL(SCAN_POINTS, cloud.nodes[0].total);
+
+    uint64_t leaf_points = 0;
+    for (size_t i = 0; i < cloud.node_count; i++) {
+        const CloudNode *node = cloud.nodes + i;
+        if (node->child_count) {
+            TEST_ASSERT_EQUAL(POINT_CLOUD_NODE_POINTS, node->count);
+            TEST_ASSERT_GREATER_OR_EQUAL(cloud.point_count, node->offset);
+            uint64_t children_total = 0;
+            for (uint32_t child = 0; child < node->child_count; child++)
+                children_total += cloud.nodes[node->first_child + child].total;
+            TEST_ASSERT_EQUAL(node->total, children_total);
+        } else {
+            TEST_ASSERT_LESS_OR_EQUAL(POINT_CLOUD_NODE_POINTS, node->count);
+            leaf_points += node->count;
+        }
+
+        // Subsamples included, every point is inside its node
+        for (uint32_t p = 0; p < node->count; p++) {
+            const CloudPoint *point = cloud.points + node->offset + p;
+            TEST_ASSERT_TRUE(point->x >= node->min[0] &&
+                             point->x <= node->min[0] + node->size);
+            TEST_ASSERT_TRUE(point->y >= node->min[1] &&
+                             point->y <= node->min[1] + node->size);
+            TEST_ASSERT_TRUE(point->z >= node->min[2] &&
+                             point->z <= node->min[2] + node->size);
+        }
+    }
+    TEST_ASSERT_EQUAL(SCAN_POINTS, leaf_points);
+
+    // The leaves partition the points
+    uint8_t *covered = calloc(SCAN_POINTS, 1);
+    for (size_t i = 0; i < cloud.node_count; i++) {
+        const CloudNode *node = cloud.nodes + i;
+        if (node->child_count)
+            continue;
+        TEST_ASSERT_LESS_OR_EQUAL(SCAN_POINTS, node->offset + node->count);
+        for (uint32_t p = 0; p < node->count; p++)
+            covered[node->offset + p]++;
+    }
+    for (size_t i = 0; i < SCAN_POINTS; i++)
+        TEST_ASSERT_EQUAL(1, covered[i]);
+    free(covered);
+}
+
+void test_cache_is_reused_until_the_scan_changes(void) {
+    write_scan(SCAN_POINTS);
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 2));
+    TEST_ASSERT_EQUAL(1, cloud.built);
+    size_t node_count = cloud.node_count;
+    point_cloud_free(&cloud);
+
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 2));
+    TEST_ASSERT_EQUAL(0, cloud.built);
+    TEST_ASSERT_EQUAL(node_count, cloud.node_count);
+    point_cloud_free(&cloud);
+
+    write_scan(2000);
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 2));
+    TEST_ASSERT_EQUAL(1, cloud.built);
+    TEST_ASSERT_EQUAL(2000, cloud.point_count);
+}
+
+void test_missing_or_empty_scans_fail(void) {
+    TEST_ASSERT_NOT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 1));
+    FILE *file = fopen(SCAN_FILEPATH, "w");
+    fprintf(file, "f 1 2 3\n");
+    fclose(file);
+    TEST_ASSERT_NOT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 1));
+    TEST_ASSERT_EQUAL(-1, access(CACHE_FILEPATH, F_OK));
+}
+
+static PointCloudView view_from(float distance) {
+    Camera camera = {
+        .position = {0.0f, 0.0f, distance},
+        .target = {0.0f, 0.0f, 0.0f},
+        .up = {0.0f, 1.0f, 0.0f},
+        .fovy = 45.0f,
+    };
+    return point_cloud_view(camera, 800, 450);
+}
+
+void test_selection_refines_up_close_within_the_budget(void) {
+    write_scan(SCAN_POINTS);
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 4));
+
+    // From afar the root alone is dense enough
+    PointCloudView view = view_from(5000.0f);
+    point_cloud_select(&cloud, &view, POINT_CLOUD_BUDGET);
+    TEST_ASSERT_EQUAL(1, cloud.cut_count);
+    TEST_ASSERT_EQUAL(0, cloud.cut[0]);
+
+    view = view_from(3.0f);
+    point_cloud_select(&cloud, &view, POINT_CLOUD_BUDGET);
+    TEST_ASSERT_GREATER_THAN(1, cloud.cut_count);
+    size_t unlimited_count = cloud.cut_count;
+
+    uint64_t budget = POINT_CLOUD_NODE_POINTS * 4;
+    point_cloud_select(&cloud, &view, budget);
+    TEST_ASSERT_LESS_OR_EQUAL(budget, cloud.cut_points);
+    TEST_ASSERT_LESS_THAN(unlimited_count, cloud.cut_count);
+
+    uint64_t points = 0;
+    for (size_t i = 0; i < cloud.cut_count; i++) {
+        const CloudNode *node = cloud.nodes + cloud.cut[i];
+        points += node->count < POINT_CLOUD_NODE_POINTS
+                      ? node->count
+                      : POINT_CLOUD_NODE_POINTS;
+    }
+    TEST_ASSERT_EQUAL(cloud.cut_points, points);
+}
+
+void test_selection_skips_nodes_outside_the_view(void) {
+    write_scan(SCAN_POINTS);
+    TEST_ASSERT_EQUAL(0, point_cloud_load(&cloud, SCAN_FILEPATH, 4));
+
+    // Looking away
+    Camera camera = {
+        .position = {0.0f, 0.0f, 3.0f},
+        .target = {0.0f, 0.0f, 6.0f},
+        .up = {0.0f, 1.0f, 0.0f},
+        .fovy = 45.0f,
+    };
+    PointCloudView view = point_cloud_view(camera, 800, 450);
+    point_cloud_select(&cloud, &view, POINT_CLOUD_BUDGET);
+    TEST_ASSERT_EQUAL(0, cloud.cut_count);
+
+    // From inside the sphere only the nodes in front are drawn
+    camera.position = (Vector3){0.0f, 0.0f, 0.0f};
+    camera.target = (Vector3){0.0f, 0.0f, -1.0f};
+    view = point_cloud_view(camera, 800, 450);
+    point_cloud_select(&cloud, &view, POINT_CLOUD_BUDGET);
+    TEST_ASSERT_GREATER_THAN(0, cloud.cut_count);
+    for (size_t i = 0; i < cloud.cut_count; i++)
+        TEST_ASSERT_TRUE(cloud.nodes[cloud.cut[i]].min[2] <= 0.0f);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parses_the_vertices_only);
+    RUN_TEST(test_leaves_hold_their_points);
+    RUN_TEST(test_cache_is_reused_until_the_scan_changes);
+    RUN_TEST(test_missing_or_empty_scans_fail);
+    RUN_TEST(test_selection_refines_up_close_within_the_budget);
+    RUN_TEST(test_selection_skips_nodes_outside_the_view);
+
+    return UNITY_END();
+}
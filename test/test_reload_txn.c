@@ -0,0 +1,103 @@
+#include "reload_txn.h"
+#include "unity.h"
+
+#define WINDOW 0.1
+
+ReloadTxns txns;
+double now = 0.0;
+
+static double fake_clock(void) {
+    return now;
+}
+
+void setUp(void) {
+    now = 10.0;
+    reload_txn_init(&txns, 4, WINDOW, &fake_clock);
+}
+
+void tearDown(void) {
+    reload_txn_free(&txns);
+}
+
+void test_nothing_is_ready_without_changes(void) {
+    size_t slot = 99;
+    uint32_t parts = 0;
+    TEST_ASSERT_EQUAL(0, reload_txn_next(&txns, &slot, &parts));
+    TEST_ASSERT_EQUAL(99, slot);
+}
+
+void test_changes_within_the_window_are_grouped(void) {
+    size_t slot = 0;
+    uint32_t parts = 0;
+    reload_txn_change(&txns, 2, RELOAD_PART_MODEL);
+    now += WINDOW / 2;
+    TEST_ASSERT_EQUAL(0, reload_txn_next(&txns, &slot, &parts));
+    reload_txn_change(&txns, 2, RELOAD_PART_TEXTURE);
+    now += WINDOW / 2;
+    // The window starts over with each change
+    TEST_ASSERT_EQUAL(0, reload_txn_next(&txns, &slot, &parts));
+
+    now += 2 * WINDOW;
+    TEST_ASSERT_EQUAL(1, reload_txn_next(&txns, &slot, &parts));
+    TEST_ASSERT_EQUAL(2, slot);
+    TEST_ASSERT_EQUAL(RELOAD_PART_MODEL | RELOAD_PART_TEXTURE, parts);
+    TEST_ASSERT_EQUAL(0, reload_txn_next(&txns, &slot, &parts));
+}
+
+void test_commit_waits_for_every_part(void) {
+    size_t slot = 0;
+    uint32_t parts = 0;
+    reload_txn_change(&txns, 1, RELOAD_PART_MODEL);
+    reload_txn_change(&txns, 1, RELOAD_PART_TEXTURE);
+    now += 2 * WINDOW;
+    TEST_ASSERT_EQUAL(1, reload_txn_next(&txns, &slot, &parts));
+
+    TEST_ASSERT_EQUAL(0, reload_txn_loaded(&txns, 1, RELOAD_PART_TEXTURE));
+    TEST_ASSERT_EQUAL(1, reload_txn_loaded(&txns, 1, RELOAD_PART_MODEL));
+    // Loads outside of a transaction commit right away
+    TEST_ASSERT_EQUAL(1, reload_txn_loaded(&txns, 3, RELOAD_PART_MODEL));
+}
+
+void test_changes_while_loading_start_the_next_transaction(void) {
+    size_t slot = 0;
+    uint32_t parts = 0;
+    reload_txn_change(&txns, 0, RELOAD_PART_MODEL);
+    now += 2 * WINDOW;
+    TEST_ASSERT_EQUAL(1, reload_txn_next(&txns, &slot, &parts));
+
+    reload_txn_change(&txns, 0, RELOAD_PART_TEXTURE);
+    now += 2 * WINDOW;
+    TEST_ASSERT_EQUAL(0, reload_txn_next(&txns, &slot, &parts));
+
+    TEST_ASSERT_EQUAL(1, reload_txn_loaded(&txns, 0, RELOAD_PART_MODEL));
+    TEST_ASSERT_EQUAL(1, reload_txn_next(&txns, &slot, &parts));
+    TEST_ASSERT_EQUAL(0, slot);
+    TEST_ASSERT_EQUAL(RELOAD_PART_TEXTURE, parts);
+}
+
+void test_constant_changes_do_not_starve(void) {
+    size_t slot = 0;
+    uint32_t parts = 0;
+    reload_txn_change(&txns, 3, RELOAD_PART_TEXTURE);
+    for (int i = 0; i < 9; i++) {
+        now += WINDOW / 2;
+        reload_txn_change(&txns, 3, RELOAD_PART_TEXTURE);
+        TEST_ASSERT_EQUAL(0, reload_txn_next(&txns, &slot, &parts));
+    }
+    now += RELOAD_TXN_MAX_WAIT;
+    reload_txn_change(&txns, 3, RELOAD_PART_TEXTURE);
+    TEST_ASSERT_EQUAL(1, reload_txn_next(&txns, &slot, &parts));
+    TEST_ASSERT_EQUAL(3, slot);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_nothing_is_ready_without_changes);
+    RUN_TEST(test_changes_within_the_window_are_grouped);
+    RUN_TEST(test_commit_waits_for_every_part);
+    RUN_TEST(test_changes_while_loading_start_the_next_transaction);
+    RUN_TEST(test_constant_changes_do_not_starve);
+
+    return UNITY_END();
+}
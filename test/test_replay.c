@@ -0,0 +1,84 @@
+#include "replay.h"
+#include "unity.h"
+#include <stdio.h>
+
+const char *filepath = "/tmp/bricklayer_test_replay.txt";
+ReplayLog log_;
+
+void setUp(void) {}
+
+void tearDown(void) {
+    replay_log_free(&log_);
+    remove(filepath);
+}
+
+void test_roundtrip(void) {
+    ReplayRecorder recorder = {0};
+    TEST_ASSERT_EQUAL(0, replay_recorder_open(&recorder, filepath, 0, 1));
+    replay_record_model(&recorder, "/path/to/model with spaces.obj");
+
+    ReplayFrame frame1 = {
+        .time = 1.0 / 3.0,
+        .flags = REPLAY_MOUSE_MIDDLE_DOWN | REPLAY_KEY_GRID,
+        .mouse_delta = {0.1f, -7.25f},
+        .wheel = 1.0f,
+        .camera_position = {0.1f, 1.0f / 3.0f, 3.0f},
+        .camera_up = {0.0f, 1.0f, 0.0f},
+    };
+    replay_record_frame(&recorder, &frame1);
+    replay_record_file_event(&recorder, 0.75, REPLAY_EVENT_TEXTURE, 3,
+                             "/path/to/model with spaces.aseprite");
+    ReplayFrame frame2 = {.time = 0.8};
+    replay_record_frame(&recorder, &frame2);
+    replay_recorder_close(&recorder);
+
+    TEST_ASSERT_EQUAL(0, replay_log_load(&log_, filepath));
+    TEST_ASSERT_EQUAL(0, log_.grid_enabled);
+    TEST_ASSERT_EQUAL(1, log_.wireframe_enabled);
+    TEST_ASSERT_EQUAL(1, log_.model_count);
+    TEST_ASSERT_EQUAL_STRING("/path/to/model with spaces.obj",
+                             log_.model_filepaths[0]);
+
+    TEST_ASSERT_EQUAL(2, log_.frame_count);
+    ReplayFrame *read = log_.frames;
+    TEST_ASSERT_EQUAL(0, read->frame);
+    TEST_ASSERT_TRUE(read->time == frame1.time);
+    TEST_ASSERT_EQUAL(frame1.flags, read->flags);
+    TEST_ASSERT_TRUE(read->mouse_delta.y == frame1.mouse_delta.y);
+    TEST_ASSERT_TRUE(read->camera_position.y == frame1.camera_position.y);
+    TEST_ASSERT_EQUAL(1, log_.frames[1].frame);
+
+    TEST_ASSERT_EQUAL(1, log_.event_count);
+    TEST_ASSERT_EQUAL(1, log_.events[0].frame);
+    TEST_ASSERT_EQUAL(REPLAY_EVENT_TEXTURE, log_.events[0].kind);
+    TEST_ASSERT_EQUAL(3, log_.events[0].cookie);
+    TEST_ASSERT_EQUAL_STRING("/path/to/model with spaces.aseprite",
+                             log_.events[0].filepath);
+}
+
+void test_rejects_other_files(void) {
+    FILE *file = fopen(filepath, "w");
+    fputs("v 1.0 2.0 3.0\n", file);
+    fclose(file);
+
+    TEST_ASSERT_NOT_EQUAL(0, replay_log_load(&log_, filepath));
+}
+
+void test_rejects_malformed_frames(void) {
+    FILE *file = fopen(filepath, "w");
+    fputs("bricklayer-replay 1\nf 0 0x0p+0 1\n", file);
+    fclose(file);
+
+    TEST_ASSERT_NOT_EQUAL(0, replay_log_load(&log_, filepath));
+    TEST_ASSERT_EQUAL(0, log_.frame_count);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_roundtrip);
+    RUN_TEST(test_rejects_other_files);
+    RUN_TEST(test_rejects_malformed_frames);
+
+    return UNITY_END();
+}
@@ -0,0 +1,94 @@
+#include "scene_snapshot.h"
+#include "unity.h"
+#include <pthread.h>
+
+#define PUBLISH_COUNT 100000
+
+SceneSnapshotBuffer buffer;
+
+void setUp(void) {
+    SceneSnapshot initial = {.grid_enabled = 1};
+    scene_snapshot_init(&buffer, &initial);
+}
+
+void tearDown(void) {
+    scene_snapshot_free(&buffer);
+}
+
+void test_initial_snapshot(void) {
+    SceneSnapshot snapshot;
+    scene_snapshot_read(&buffer, &snapshot);
+    TEST_ASSERT_EQUAL(0, snapshot.sequence);
+    TEST_ASSERT_EQUAL(1, snapshot.grid_enabled);
+}
+
+void test_back_buffer_not_visible_before_publish(void) {
+    scene_snapshot_back(&buffer)->wireframe_enabled = 1;
+
+    SceneSnapshot snapshot;
+    scene_snapshot_read(&buffer, &snapshot);
+    TEST_ASSERT_EQUAL(0, snapshot.wireframe_enabled);
+
+    scene_snapshot_publish(&buffer);
+    scene_snapshot_read(&buffer, &snapshot);
+    TEST_ASSERT_EQUAL(1, snapshot.wireframe_enabled);
+    TEST_ASSERT_EQUAL(1, snapshot.sequence);
+}
+
+void test_back_buffer_starts_from_last_published(void) {
+    scene_snapshot_back(&buffer)->camera.fovy = 45.0f;
+    scene_snapshot_publish(&buffer);
+    scene_snapshot_back(&buffer)->wireframe_enabled = 1;
+    scene_snapshot_publish(&buffer);
+
+    SceneSnapshot snapshot;
+    scene_snapshot_read(&buffer, &snapshot);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 45.0f, snapshot.camera.fovy);
+    TEST_ASSERT_EQUAL(1, snapshot.wireframe_enabled);
+    TEST_ASSERT_EQUAL(2, snapshot.sequence);
+}
+
+static void *publish_sequence(void *arg) {
+    (void)arg;
+    for (int i = 1; i <= PUBLISH_COUNT; i++) {
+        SceneSnapshot *back = scene_snapshot_back(&buffer);
+        back->camera.position.x = (float)i;
+        back->camera.position.y = (float)-i;
+        back->wireframe_enabled = i;
+        scene_snapshot_publish(&buffer);
+    }
+    return 0;
+}
+
+void test_reads_are_never_torn(void) {
+    pthread_t writer;
+    TEST_ASSERT_EQUAL(0, pthread_create(&writer, 0, &publish_sequence, 0));
+
+    uint64_t last_sequence = 0;
+    SceneSnapshot snapshot = {0};
+    while (snapshot.sequence < PUBLISH_COUNT) {
+        scene_snapshot_read(&buffer, &snapshot);
+        TEST_ASSERT_TRUE(snapshot.sequence >= last_sequence);
+        if (!snapshot.sequence)
+            continue;
+        TEST_ASSERT_EQUAL((int)snapshot.sequence, snapshot.wireframe_enabled);
+        TEST_ASSERT_EQUAL_FLOAT((float)snapshot.sequence,
+                                snapshot.camera.position.x);
+        TEST_ASSERT_EQUAL_FLOAT(-(float)snapshot.sequence,
+                                snapshot.camera.position.y);
+        last_sequence = snapshot.sequence;
+    }
+
+    pthread_join(writer, 0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_initial_snapshot);
+    RUN_TEST(test_back_buffer_not_visible_before_publish);
+    RUN_TEST(test_back_buffer_starts_from_last_published);
+    RUN_TEST(test_reads_are_never_torn);
+
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include "staging_ring.h"
+#include "unity.h"
+#include <stdint.h>
+
+// Fences are pointers to flags set by the test, the GPU is not involved
+static int fake_fence_signaled(void *fence, int wait) {
+    int *signaled = fence;
+    if (wait)
+        *signaled = 1;
+    return *signaled;
+}
+
+StagingRing ring;
+
+void setUp(void) {
+    staging_ring_init_client(&ring, 1024);
+    ring.fence_signaled = &fake_fence_signaled;
+}
+
+void tearDown(void) {
+    staging_ring_free(&ring);
+}
+
+static size_t offset_of(void *pointer) {
+    return (size_t)((uint8_t *)pointer - ring.memory);
+}
+
+void test_reservations_are_aligned_and_sequential(void) {
+    int fences[2] = {0};
+    void *first = staging_ring_reserve(&ring, 100);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_EQUAL(0, offset_of(first));
+    staging_ring_commit(&ring, fences);
+
+    void *second = staging_ring_reserve(&ring, 100);
+    TEST_ASSERT_EQUAL(STAGING_RING_ALIGNMENT * 2, offset_of(second));
+    staging_ring_commit(&ring, fences + 1);
+    TEST_ASSERT_EQUAL(2, ring.region_count);
+}
+
+void test_too_large_is_refused(void) {
+    TEST_ASSERT_NULL(staging_ring_reserve(&ring, 1025));
+    TEST_ASSERT_NOT_NULL(staging_ring_reserve(&ring, 1024));
+}
+
+void test_signalled_regions_are_reused(void) {
+    int fences[3] = {0};
+    staging_ring_reserve(&ring, 512);
+    staging_ring_commit(&ring, fences);
+    staging_ring_reserve(&ring, 256);
+    staging_ring_commit(&ring, fences + 1);
+
+    // The first region is done, the next reservation wraps into it without
+    // waiting for the second one
+    fences[0] = 1;
+    void *wrapped = staging_ring_reserve(&ring, 384);
+    TEST_ASSERT_EQUAL(0, offset_of(wrapped));
+    TEST_ASSERT_EQUAL(0, fences[1]);
+    staging_ring_commit(&ring, fences + 2);
+    TEST_ASSERT_EQUAL(2, ring.region_count);
+}
+
+void test_full_ring_waits_for_oldest(void) {
+    int fences[3] = {0};
+    staging_ring_reserve(&ring, 512);
+    staging_ring_commit(&ring, fences);
+    staging_ring_reserve(&ring, 512);
+    staging_ring_commit(&ring, fences + 1);
+
+    void *pointer = staging_ring_reserve(&ring, 256);
+    TEST_ASSERT_EQUAL(0, offset_of(pointer));
+    // Only the oldest region had to be waited for
+    TEST_ASSERT_EQUAL(1, fences[0]);
+    TEST_ASSERT_EQUAL(0, fences[1]);
+    staging_ring_commit(&ring, fences + 2);
+}
+
+void test_unfenced_regions_are_free_immediately(void) {
+    for (int i = 0; i < STAGING_RING_MAX_REGIONS * 2; i++) {
+        void *pointer = staging_ring_reserve(&ring, 1000);
+        TEST_ASSERT_EQUAL(0, offset_of(pointer));
+        staging_ring_commit(&ring, 0);
+    }
+}
+
+void test_region_limit(void) {
+    int fences[STAGING_RING_MAX_REGIONS + 1] = {0};
+    staging_ring_free(&ring);
+    staging_ring_init_client(&ring,
+                             STAGING_RING_ALIGNMENT * STAGING_RING_MAX_REGIONS * 2);
+    ring.fence_signaled = &fake_fence_signaled;
+
+    for (int i = 0; i <= STAGING_RING_MAX_REGIONS; i++) {
+        TEST_ASSERT_NOT_NULL(staging_ring_reserve(&ring, 1));
+        staging_ring_commit(&ring, fences + i);
+    }
+    // Room was left in the ring but the region list was full
+    TEST_ASSERT_EQUAL(1, fences[0]);
+    TEST_ASSERT_EQUAL(STAGING_RING_MAX_REGIONS, ring.region_count);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_reservations_are_aligned_and_sequential);
+    RUN_TEST(test_too_large_is_refused);
+    RUN_TEST(test_signalled_regions_are_reused);
+    RUN_TEST(test_full_ring_waits_for_oldest);
+    RUN_TEST(test_unfenced_regions_are_free_immediately);
+    RUN_TEST(test_region_limit);
+
+    return UNITY_END();
+}
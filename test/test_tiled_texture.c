@@ -0,0 +1,139 @@
+#include "ase_compose.h"
+#include "asset_gen.h"
+#include "tiled_texture.h"
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Small enough to tile the generated sprites
+#define MAX_SIZE 16
+
+TiledTexture texture;
+uint8_t *file = 0;
+ase_t *ase = 0;
+
+void setUp(void) {
+    tiled_texture_init(&texture);
+    AseGenOptions options = asset_gen_aseprite_defaults();
+    options.width = 40;
+    options.height = 24;
+    options.layer_count = 3;
+    size_t size = asset_gen_aseprite(&options, &file);
+    ase = cute_aseprite_load_from_memory_ex(file, (int)size,
+                                            CUTE_ASEPRITE_NO_COMPOSITE, 0);
+    TEST_ASSERT_NOT_NULL(ase);
+}
+
+void tearDown(void) {
+    tiled_texture_free(&texture);
+    cute_aseprite_free(ase);
+    free(file);
+    file = 0;
+}
+
+// Clears the changed tiles like tiled_texture_upload does.
+static void fake_upload(void) {
+    size_t count =
+        (size_t)texture.composed.columns * (size_t)texture.composed.rows;
+    memset(texture.dirty, 0, count);
+    texture.dirty_count = 0;
+}
+
+void test_tiles_cover_the_canvas(void) {
+    TEST_ASSERT_FALSE(tiled_texture_needed(4096, 4096, 4096));
+    TEST_ASSERT_TRUE(tiled_texture_needed(4097, 100, 4096));
+
+    TilePlan plan = tiled_texture_plan(20000, 5000, 16384);
+    TEST_ASSERT_EQUAL(TILED_TEXTURE_TILE_SIZE, plan.tile_size);
+    TEST_ASSERT_EQUAL(10, plan.columns);
+    TEST_ASSERT_EQUAL(3, plan.rows);
+
+    // Never larger than the limit
+    plan = tiled_texture_plan(3000, 1000, 1024);
+    TEST_ASSERT_EQUAL(1024, plan.tile_size);
+    TEST_ASSERT_EQUAL(3, plan.columns);
+    TEST_ASSERT_EQUAL(1, plan.rows);
+}
+
+void test_tiles_match_the_frame(void) {
+    TEST_ASSERT_EQUAL(6, tiled_texture_compose(&texture, ase, MAX_SIZE, 4));
+    TEST_ASSERT_EQUAL(3, texture.composed.columns);
+    TEST_ASSERT_EQUAL(2, texture.composed.rows);
+
+    uint8_t *frame = malloc((size_t)ase->w * (size_t)ase->h * 4);
+    AseComposeTarget target = {
+        .pixels = frame,
+        .stride = (size_t)ase->w * 4,
+        .format = ASE_COMPOSE_RGBA8,
+    };
+    ase_compose_frame(ase, 0, &target);
+
+    for (int y = 0; y < ase->h; y++) {
+        for (int x = 0; x < ase->w; x++) {
+            size_t tile = (size_t)(y / MAX_SIZE) * 3 + (size_t)(x / MAX_SIZE);
+            uint8_t *pixel = texture.pixels + tile * MAX_SIZE * MAX_SIZE * 4 +
+                             ((y % MAX_SIZE) * MAX_SIZE + x % MAX_SIZE) * 4;
+            TEST_ASSERT_EQUAL_MEMORY(frame + (y * ase->w + x) * 4, pixel, 4);
+        }
+    }
+    free(frame);
+}
+
+void test_only_changed_tiles_are_uploaded(void) {
+    tiled_texture_compose(&texture, ase, MAX_SIZE, 2);
+    fake_upload();
+    TEST_ASSERT_EQUAL(0, tiled_texture_compose(&texture, ase, MAX_SIZE, 2));
+
+    // A pixel of the last tile, on the top layer
+    ase_cel_t *cel = ase->frames[0].cels + ase->frames[0].cel_count - 1;
+    int x = ase->w - 1 - cel->x;
+    int y = ase->h - 1 - cel->y;
+    TEST_ASSERT_TRUE(x < cel->w && y < cel->h);
+    ase_color_t *pixel = (ase_color_t *)cel->pixels + y * cel->w + x;
+    *pixel = (ase_color_t){pixel->r ^ 0xff, 0x12, 0x34, 0xff};
+
+    TEST_ASSERT_EQUAL(1, tiled_texture_compose(&texture, ase, MAX_SIZE, 2));
+    TEST_ASSERT_EQUAL(1, texture.dirty[5]);
+    TEST_ASSERT_EQUAL(0, texture.dirty[4]);
+}
+
+void test_only_tiles_of_changed_cels_are_composited(void) {
+    tiled_texture_compose(&texture, ase, MAX_SIZE, 2);
+    TEST_ASSERT_EQUAL(6, texture.tiles_composited);
+    fake_upload();
+    // Kept for the next reload
+    TEST_ASSERT_NOT_NULL(texture.pixels);
+    tiled_texture_compose(&texture, ase, MAX_SIZE, 2);
+    TEST_ASSERT_EQUAL(0, texture.tiles_composited);
+
+    // Only the tiles under the top layer's cel
+    ase_cel_t *cel = ase->frames[0].cels + ase->frames[0].cel_count - 1;
+    size_t covered = 0;
+    for (int y = 0; y < ase->h; y += MAX_SIZE)
+        for (int x = 0; x < ase->w; x += MAX_SIZE)
+            covered += cel->x < x + MAX_SIZE && cel->x + cel->w > x &&
+                       cel->y < y + MAX_SIZE && cel->y + cel->h > y;
+    cel->opacity *= 0.5f;
+    tiled_texture_compose(&texture, ase, MAX_SIZE, 2);
+    TEST_ASSERT_EQUAL(covered, texture.tiles_composited);
+}
+
+void test_new_size_changes_every_tile(void) {
+    tiled_texture_compose(&texture, ase, MAX_SIZE, 0);
+    fake_upload();
+    // Same canvas, in larger tiles
+    TEST_ASSERT_EQUAL(2, tiled_texture_compose(&texture, ase, 2 * MAX_SIZE, 0));
+    TEST_ASSERT_EQUAL(2 * MAX_SIZE, texture.composed.tile_size);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_tiles_cover_the_canvas);
+    RUN_TEST(test_tiles_match_the_frame);
+    RUN_TEST(test_only_changed_tiles_are_uploaded);
+    RUN_TEST(test_only_tiles_of_changed_cels_are_composited);
+    RUN_TEST(test_new_size_changes_every_tile);
+
+    return UNITY_END();
+}
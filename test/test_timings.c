@@ -0,0 +1,71 @@
+#include "timings.h"
+#include "unity.h"
+#include <string.h>
+
+Timings timings;
+
+void setUp(void) {
+    timings = (Timings){.enabled = 1};
+}
+
+void tearDown(void) {
+    timings_free(&timings);
+}
+
+void test_disabled_records_nothing(void) {
+    timings.enabled = 0;
+    timings_add_seconds(&timings, TIMING_MESH_LOAD, "a.obj", 1.0);
+    TEST_ASSERT_EQUAL(0, timings.entries_used);
+}
+
+void test_kind_totals(void) {
+    timings_add_seconds(&timings, TIMING_WINDOW, 0, 0.5);
+    timings_add_seconds(&timings, TIMING_MESH_LOAD, "a.obj", 1.0);
+    timings_add_seconds(&timings, TIMING_MESH_LOAD, "b.obj", 2.0);
+    timings_add_seconds(&timings, TIMING_TEXTURE_DECODE, "a.aseprite", 0.25);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 3.0,
+                             timings_kind_total(&timings, TIMING_MESH_LOAD));
+    TEST_ASSERT_EQUAL(2, timings_kind_count(&timings, TIMING_MESH_LOAD));
+    TEST_ASSERT_EQUAL(0, timings_kind_count(&timings, TIMING_SHADER));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 3.75, timings.recorded_seconds);
+}
+
+void test_slowest_assets(void) {
+    const double seconds[] = {0.3, 0.9, 0.1, 0.5, 0.7, 0.2, 0.8};
+    char filepath[16];
+    for (int i = 0; i < 7; i++) {
+        snprintf(filepath, sizeof(filepath), "%d.obj", i);
+        timings_add_seconds(&timings, TIMING_MESH_LOAD, filepath, seconds[i]);
+    }
+    // Phases without an asset are never listed
+    timings_add_seconds(&timings, TIMING_WINDOW, 0, 10.0);
+
+    TimingEntry *slowest[3];
+    TEST_ASSERT_EQUAL(3, timings_slowest(&timings, slowest, 3));
+    TEST_ASSERT_EQUAL_STRING("1.obj", slowest[0]->filepath);
+    TEST_ASSERT_EQUAL_STRING("6.obj", slowest[1]->filepath);
+    TEST_ASSERT_EQUAL_STRING("4.obj", slowest[2]->filepath);
+}
+
+void test_slowest_fewer_than_requested(void) {
+    timings_add_seconds(&timings, TIMING_TEXTURE_UPLOAD, "a.aseprite", 0.1);
+    timings_add_seconds(&timings, TIMING_TEXTURE_DECODE, "a.aseprite", 0.4);
+
+    TimingEntry *slowest[TIMINGS_SLOWEST_COUNT];
+    TEST_ASSERT_EQUAL(
+        2, timings_slowest(&timings, slowest, TIMINGS_SLOWEST_COUNT));
+    TEST_ASSERT_EQUAL(TIMING_TEXTURE_DECODE, slowest[0]->kind);
+    TEST_ASSERT_EQUAL(TIMING_TEXTURE_UPLOAD, slowest[1]->kind);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_disabled_records_nothing);
+    RUN_TEST(test_kind_totals);
+    RUN_TEST(test_slowest_assets);
+    RUN_TEST(test_slowest_fewer_than_requested);
+
+    return UNITY_END();
+}
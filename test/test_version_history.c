@@ -0,0 +1,183 @@
+#include "unity.h"
+#include "version_history.h"
+#include <stdlib.h>
+#include <string.h>
+
+VersionHistory history;
+
+void setUp(void) {
+    version_history_init(&history, 3);
+}
+
+void tearDown(void) {
+    version_history_free(&history);
+}
+
+static void assert_round_trip(const uint8_t *data, size_t size) {
+    uint8_t *compressed = malloc(version_compress_bound(size));
+    uint8_t *decompressed = malloc(size + 1);
+    size_t compressed_size = version_compress(data, size, compressed);
+    TEST_ASSERT_LESS_OR_EQUAL(version_compress_bound(size), compressed_size);
+    TEST_ASSERT_EQUAL(
+        0, version_decompress(compressed, compressed_size, decompressed, size));
+    if (size)
+        TEST_ASSERT_EQUAL_MEMORY(data, decompressed, size);
+    free(compressed);
+    free(decompressed);
+}
+
+// Sprite-like pixels: runs of a few colors
+static uint8_t *make_pixels(size_t size, uint8_t seed) {
+    uint8_t *pixels = malloc(size);
+    for (size_t i = 0; i < size; i += 4) {
+        uint8_t color = (uint8_t)((i / 64 + seed) % 5 * 40);
+        pixels[i] = color;
+        pixels[i + 1] = (uint8_t)(color + seed);
+        pixels[i + 2] = 0x80;
+        if (i + 3 < size)
+            pixels[i + 3] = 0xff;
+    }
+    return pixels;
+}
+
+void test_compression_round_trips(void) {
+    assert_round_trip((const uint8_t *)"", 0);
+    assert_round_trip((const uint8_t *)"abc", 3);
+    assert_round_trip((const uint8_t *)"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+                      38);
+
+    uint8_t *noise = malloc(100000);
+    srand(3);
+    for (size_t i = 0; i < 100000; i++)
+        noise[i] = (uint8_t)rand();
+    assert_round_trip(noise, 100000);
+    free(noise);
+
+    uint8_t *pixels = make_pixels(256 * 256 * 4 + 3, 1);
+    assert_round_trip(pixels, 256 * 256 * 4 + 3);
+    free(pixels);
+}
+
+void test_pixels_compress_well(void) {
+    size_t size = 256 * 256 * 4;
+    uint8_t *pixels = make_pixels(size, 1);
+    TEST_ASSERT_EQUAL(0, version_history_record(&history, pixels, size, 256,
+                                                256));
+    const AssetVersion *version = version_history_get(&history, 0);
+    TEST_ASSERT_LESS_THAN(size / 6, version->size);
+    TEST_ASSERT_EQUAL(version->size, history.compressed_bytes);
+    TEST_ASSERT_EQUAL(256, version->width);
+    free(pixels);
+}
+
+void test_corrupt_input_is_refused(void) {
+    size_t size = 4096;
+    uint8_t *pixels = make_pixels(size, 2);
+    uint8_t *compressed = malloc(version_compress_bound(size));
+    uint8_t *out = malloc(size);
+    size_t compressed_size = version_compress(pixels, size, compressed);
+
+    // Cut short, or expected to be longer
+    TEST_ASSERT_NOT_EQUAL(
+        0, version_decompress(compressed, compressed_size - 1, out, size));
+    TEST_ASSERT_NOT_EQUAL(
+        0, version_decompress(compressed, compressed_size, out, size - 1));
+    // A match before the start
+    uint8_t bad[] = {0x10, 'a', 0x10, 0x00};
+    TEST_ASSERT_NOT_EQUAL(0, version_decompress(bad, sizeof(bad), out, 100));
+
+    free(pixels);
+    free(compressed);
+    free(out);
+}
+
+void test_oldest_versions_make_room(void) {
+    size_t size = 1024;
+    for (uint8_t i = 0; i < 5; i++) {
+        uint8_t *pixels = make_pixels(size, i);
+        TEST_ASSERT_EQUAL(0,
+                          version_history_record(&history, pixels, size, 16, 16));
+        free(pixels);
+    }
+    TEST_ASSERT_EQUAL(3, history.count);
+    TEST_ASSERT_NULL(version_history_get(&history, 3));
+
+    uint8_t *out = malloc(size);
+    size_t compressed_bytes = 0;
+    for (size_t age = 0; age < 3; age++) {
+        const AssetVersion *version = version_history_get(&history, age);
+        TEST_ASSERT_EQUAL(5 - age, version->number);
+        TEST_ASSERT_EQUAL(0, version_history_read(version, out));
+        uint8_t *expected = make_pixels(size, (uint8_t)(4 - age));
+        TEST_ASSERT_EQUAL_MEMORY(expected, out, size);
+        free(expected);
+        compressed_bytes += version->size;
+    }
+    TEST_ASSERT_EQUAL(compressed_bytes, history.compressed_bytes);
+    free(out);
+}
+
+void test_stepping_stays_within_the_versions(void) {
+    uint8_t data[16] = {0};
+    TEST_ASSERT_EQUAL(0, version_history_step(&history, 1));
+    version_history_record(&history, data, sizeof(data), 0, 0);
+    version_history_record(&history, data, sizeof(data), 0, 0);
+
+    TEST_ASSERT_EQUAL(0, version_history_step(&history, -1));
+    TEST_ASSERT_EQUAL(1, version_history_step(&history, 1));
+    TEST_ASSERT_EQUAL(1, history.shown);
+    TEST_ASSERT_EQUAL(0, version_history_step(&history, 1));
+    TEST_ASSERT_EQUAL(1, version_history_step(&history, -1));
+
+    // A new version is shown right away
+    version_history_step(&history, 1);
+    version_history_record(&history, data, sizeof(data), 0, 0);
+    TEST_ASSERT_EQUAL(0, history.shown);
+
+    // Nothing is kept without capacity
+    VersionHistory disabled;
+    version_history_init(&disabled, 0);
+    TEST_ASSERT_NOT_EQUAL(
+        0, version_history_record(&disabled, data, sizeof(data), 0, 0));
+    TEST_ASSERT_NULL(version_history_get(&disabled, 0));
+    version_history_free(&disabled);
+}
+
+void test_meshes_round_trip(void) {
+    float vertices[9] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    float texcoords[6] = {0, 0, 1, 0, 0, 1};
+    unsigned short indices[3] = {0, 1, 2};
+    Mesh mesh = {
+        .vertexCount = 3,
+        .triangleCount = 1,
+        .vertices = vertices,
+        .texcoords = texcoords,
+        .indices = indices,
+    };
+    TEST_ASSERT_EQUAL(0, version_history_record_mesh(&history, &mesh));
+
+    Mesh read = version_history_read_mesh(version_history_get(&history, 0));
+    TEST_ASSERT_EQUAL(3, read.vertexCount);
+    TEST_ASSERT_EQUAL(1, read.triangleCount);
+    TEST_ASSERT_EQUAL_MEMORY(vertices, read.vertices, sizeof(vertices));
+    TEST_ASSERT_EQUAL_MEMORY(texcoords, read.texcoords, sizeof(texcoords));
+    TEST_ASSERT_EQUAL_MEMORY(indices, read.indices, sizeof(indices));
+    TEST_ASSERT_NULL(read.normals);
+    TEST_ASSERT_NULL(read.colors);
+    free(read.vertices);
+    free(read.texcoords);
+    free(read.indices);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_compression_round_trips);
+    RUN_TEST(test_pixels_compress_well);
+    RUN_TEST(test_corrupt_input_is_refused);
+    RUN_TEST(test_oldest_versions_make_room);
+    RUN_TEST(test_stepping_stays_within_the_versions);
+    RUN_TEST(test_meshes_round_trip);
+
+    return UNITY_END();
+}
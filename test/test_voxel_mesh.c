@@ -0,0 +1,177 @@
+#include "unity.h"
+#include "voxel_mesh.h"
+#include <stdlib.h>
+#include <string.h>
+
+VoxelMesher mesher;
+
+void setUp(void) {
+    mesher = (VoxelMesher){0};
+}
+
+void tearDown(void) {
+    voxel_mesher_free(&mesher);
+}
+
+static uint8_t *make_pixels(int width, int height, uint8_t alpha) {
+    uint8_t *pixels = malloc((size_t)width * height * 4);
+    TEST_ASSERT_NOT_NULL(pixels);
+    for (int i = 0; i < width * height; i++) {
+        pixels[i * 4 + 0] = (uint8_t)i;
+        pixels[i * 4 + 1] = (uint8_t)(i * 7);
+        pixels[i * 4 + 2] = 100;
+        pixels[i * 4 + 3] = alpha;
+    }
+    return pixels;
+}
+
+static void set_alpha(uint8_t *pixels, int width, int x, int y,
+                      uint8_t alpha) {
+    pixels[((size_t)y * width + x) * 4 + 3] = alpha;
+}
+
+static void free_mesh(Mesh mesh) {
+    free(mesh.vertices);
+    free(mesh.texcoords);
+    free(mesh.normals);
+}
+
+// Every triangle winds counter-clockwise around its normal.
+static void assert_winding(Mesh mesh) {
+    for (int i = 0; i < mesh.triangleCount; i++) {
+        float *a = mesh.vertices + i * 9;
+        float *b = a + 3;
+        float *c = a + 6;
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float cross[3] = {ab[1] * ac[2] - ab[2] * ac[1],
+                          ab[2] * ac[0] - ab[0] * ac[2],
+                          ab[0] * ac[1] - ab[1] * ac[0]};
+        float *normal = mesh.normals + i * 9;
+        TEST_ASSERT_GREATER_THAN_FLOAT(
+            0.0f, cross[0] * normal[0] + cross[1] * normal[1] +
+                      cross[2] * normal[2]);
+    }
+}
+
+void test_single_pixel_is_a_cube(void) {
+    uint8_t pixel[4] = {255, 0, 0, 255};
+    voxel_mesher_update(&mesher, pixel, 1, 1);
+    TEST_ASSERT_EQUAL(12, voxel_mesher_triangle_count(&mesher));
+    TEST_ASSERT_EQUAL(12, voxel_mesher_naive_triangle_count(&mesher));
+
+    Mesh mesh = voxel_mesher_build(&mesher);
+    TEST_ASSERT_EQUAL(36, mesh.vertexCount);
+    assert_winding(mesh);
+    // The cube fills the whole mesh size
+    for (int i = 0; i < mesh.vertexCount * 3; i++)
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, VOXEL_MESH_SIZE / 2.0f,
+                                 mesh.vertices[i] < 0 ? -mesh.vertices[i]
+                                                      : mesh.vertices[i]);
+    free_mesh(mesh);
+}
+
+void test_solid_sprite_merges_into_few_quads(void) {
+    uint8_t *pixels = make_pixels(32, 32, 255);
+    voxel_mesher_update(&mesher, pixels, 32, 32);
+
+    // Two bands of rows: front, back, left and right per band, one top and
+    // one bottom
+    TEST_ASSERT_EQUAL(10 * 2, voxel_mesher_triangle_count(&mesher));
+    TEST_ASSERT_EQUAL(32 * 32 * 12,
+                      voxel_mesher_naive_triangle_count(&mesher));
+
+    Mesh mesh = voxel_mesher_build(&mesher);
+    assert_winding(mesh);
+    free_mesh(mesh);
+    free(pixels);
+}
+
+void test_transparent_pixels_are_skipped(void) {
+    uint8_t *pixels = make_pixels(8, 8, 0);
+    voxel_mesher_update(&mesher, pixels, 8, 8);
+    TEST_ASSERT_EQUAL(0, voxel_mesher_triangle_count(&mesher));
+    Mesh mesh = voxel_mesher_build(&mesher);
+    TEST_ASSERT_EQUAL(0, mesh.vertexCount);
+    TEST_ASSERT_NULL(mesh.vertices);
+
+    // A hole in a solid sprite adds the four faces around it
+    free(pixels);
+    pixels = make_pixels(3, 3, 255);
+    set_alpha(pixels, 3, 1, 1, 0);
+    voxel_mesher_update(&mesher, pixels, 3, 3);
+    mesh = voxel_mesher_build(&mesher);
+    assert_winding(mesh);
+    free_mesh(mesh);
+    free(pixels);
+}
+
+void test_only_changed_bands_are_remeshed(void) {
+    int size = VOXEL_BAND_ROWS * 4;
+    uint8_t *pixels = make_pixels(size, size, 255);
+    voxel_mesher_update(&mesher, pixels, size, size);
+    TEST_ASSERT_EQUAL(4, mesher.bands_meshed);
+
+    // Colors are in the texture, the mesh stays the same
+    pixels[0] = 1;
+    voxel_mesher_update(&mesher, pixels, size, size);
+    TEST_ASSERT_EQUAL(0, mesher.bands_meshed);
+
+    // Inside a band
+    set_alpha(pixels, size, 5, VOXEL_BAND_ROWS + 5, 0);
+    voxel_mesher_update(&mesher, pixels, size, size);
+    TEST_ASSERT_EQUAL(1, mesher.bands_meshed);
+
+    // On the first row of a band, the band above has faces bordering it
+    set_alpha(pixels, size, 5, VOXEL_BAND_ROWS * 2, 0);
+    voxel_mesher_update(&mesher, pixels, size, size);
+    TEST_ASSERT_EQUAL(2, mesher.bands_meshed);
+
+    free(pixels);
+}
+
+void test_incremental_update_matches_fresh_mesh(void) {
+    int width = 40;
+    int height = VOXEL_BAND_ROWS * 3 + 5;
+    uint8_t *pixels = make_pixels(width, height, 255);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            if ((x * 7 + y * 3) % 11 == 0)
+                set_alpha(pixels, width, x, y, 0);
+    voxel_mesher_update(&mesher, pixels, width, height);
+
+    for (int x = 10; x < 30; x++)
+        set_alpha(pixels, width, x, VOXEL_BAND_ROWS - 1, 0);
+    voxel_mesher_update(&mesher, pixels, width, height);
+    Mesh incremental = voxel_mesher_build(&mesher);
+
+    VoxelMesher fresh = {0};
+    voxel_mesher_update(&fresh, pixels, width, height);
+    Mesh expected = voxel_mesher_build(&fresh);
+
+    TEST_ASSERT_EQUAL(expected.vertexCount, incremental.vertexCount);
+    TEST_ASSERT_EQUAL_MEMORY(expected.vertices, incremental.vertices,
+                             (size_t)expected.vertexCount * 3 * sizeof(float));
+    TEST_ASSERT_EQUAL_MEMORY(expected.texcoords, incremental.texcoords,
+                             (size_t)expected.vertexCount * 2 * sizeof(float));
+    assert_winding(incremental);
+    TEST_ASSERT_LESS_THAN(voxel_mesher_naive_triangle_count(&fresh) / 4,
+                          voxel_mesher_triangle_count(&fresh));
+
+    free_mesh(incremental);
+    free_mesh(expected);
+    voxel_mesher_free(&fresh);
+    free(pixels);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_single_pixel_is_a_cube);
+    RUN_TEST(test_solid_sprite_merges_into_few_quads);
+    RUN_TEST(test_transparent_pixels_are_skipped);
+    RUN_TEST(test_only_changed_bands_are_remeshed);
+    RUN_TEST(test_incremental_update_matches_fresh_mesh);
+
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+#include "asset_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Command-line front end for asset_gen, see usage() below.
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  assetgen obj <file.obj> [-triangles N] "
+            "[-topology grid|sphere|soup]\n"
+            "           [-no-texcoords] [-no-normals] [-seed N]\n"
+            "  assetgen aseprite <file.aseprite> [-size WxH] "
+            "[-depth 32|16|8] [-layers N]\n"
+            "           [-frames N] [-hold N] [-blend N] "
+            "[-compression zlib|none] [-seed N]\n"
+            "  assetgen pairs <directory> [-count N] "
+            "[any obj and aseprite option]\n"
+            "  assetgen storm [-count N] [-interval MS] [-rename] "
+            "<files...>\n");
+}
+
+// Parses the options shared by the obj, aseprite and pairs commands. Returns
+// the number of arguments consumed, 0 if `argv[0]` is not one of them.
+static int parse_generator_option(int argc, char **argv,
+                                  ObjGenOptions *obj_options,
+                                  AseGenOptions *ase_options) {
+    if (!strcmp(argv[0], "-no-texcoords")) {
+        obj_options->with_texcoords = 0;
+        return 1;
+    }
+    if (!strcmp(argv[0], "-no-normals")) {
+        obj_options->with_normals = 0;
+        return 1;
+    }
+    if (argc < 2)
+        return 0;
+
+    if (!strcmp(argv[0], "-triangles")) {
+        obj_options->triangle_count = strtoull(argv[1], 0, 10);
+    } else if (!strcmp(argv[0], "-topology")) {
+        if (!strcmp(argv[1], "grid"))
+            obj_options->topology = ASSET_GEN_TOPOLOGY_GRID;
+        else if (!strcmp(argv[1], "sphere"))
+            obj_options->topology = ASSET_GEN_TOPOLOGY_SPHERE;
+        else if (!strcmp(argv[1], "soup"))
+            obj_options->topology = ASSET_GEN_TOPOLOGY_SOUP;
+        else
+            return 0;
+    } else if (!strcmp(argv[0], "-seed")) {
+        obj_options->seed = (uint32_t)strtoul(argv[1], 0, 10);
+        ase_options->seed = obj_options->seed;
+    } else if (!strcmp(argv[0], "-size")) {
+        if (sscanf(argv[1], "%dx%d", &ase_options->width,
+                   &ase_options->height) != 2)
+            return 0;
+    } else if (!strcmp(argv[0], "-depth")) {
+        ase_options->depth = atoi(argv[1]);
+    } else if (!strcmp(argv[0], "-layers")) {
+        ase_options->layer_count = atoi(argv[1]);
+    } else if (!strcmp(argv[0], "-frames")) {
+        ase_options->frame_count = atoi(argv[1]);
+    } else if (!strcmp(argv[0], "-hold")) {
+        ase_options->hold = atoi(argv[1]);
+    } else if (!strcmp(argv[0], "-blend")) {
+        ase_options->blend_mode = atoi(argv[1]);
+    } else if (!strcmp(argv[0], "-compression")) {
+        if (!strcmp(argv[1], "zlib"))
+            ase_options->compression = ASSET_GEN_COMPRESSION_ZLIB;
+        else if (!strcmp(argv[1], "none"))
+            ase_options->compression = ASSET_GEN_COMPRESSION_NONE;
+        else
+            return 0;
+    } else {
+        return 0;
+    }
+
+    return 2;
+}
+
+static int generate_pairs(const char *directory, int count,
+                          const ObjGenOptions *obj_options,
+                          const AseGenOptions *ase_options) {
+    char filepath[4096] = {0};
+    for (int i = 0; i < count; i++) {
+        ObjGenOptions obj = *obj_options;
+        AseGenOptions ase = *ase_options;
+        obj.seed += (uint32_t)i;
+        ase.seed += (uint32_t)i;
+
+        snprintf(filepath, sizeof(filepath), "%s/model_%05d.obj", directory, i);
+        if (asset_gen_write_obj_file(filepath, &obj)) {
+            fprintf(stderr, "ERROR: could not write %s\n", filepath);
+            return 1;
+        }
+
+        snprintf(filepath, sizeof(filepath), "%s/model_%05d.aseprite",
+                 directory, i);
+        if (asset_gen_write_aseprite_file(filepath, &ase)) {
+            fprintf(stderr, "ERROR: could not write %s\n", filepath);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    const char *command = argv[1];
+    ObjGenOptions obj_options = asset_gen_obj_defaults();
+    AseGenOptions ase_options = asset_gen_aseprite_defaults();
+
+    if (!strcmp(command, "storm")) {
+        StormOptions storm_options = {.count = 10,
+                                      .interval_milliseconds = 100};
+        int i = 2;
+        for (; i < argc && *argv[i] == '-'; i++) {
+            if (!strcmp(argv[i], "-rename"))
+                storm_options.use_rename = 1;
+            else if (!strcmp(argv[i], "-count") && i + 1 < argc)
+                storm_options.count = atoi(argv[++i]);
+            else if (!strcmp(argv[i], "-interval") && i + 1 < argc)
+                storm_options.interval_milliseconds = atoi(argv[++i]);
+            else {
+                usage();
+                return 1;
+            }
+        }
+        if (i >= argc) {
+            usage();
+            return 1;
+        }
+        return asset_gen_rewrite_storm((const char **)argv + i,
+                                       (size_t)(argc - i), &storm_options);
+    }
+
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    const char *target = argv[2];
+    int pair_count = 1;
+    for (int i = 3; i < argc;) {
+        if (!strcmp(command, "pairs") && !strcmp(argv[i], "-count") &&
+            i + 1 < argc) {
+            pair_count = atoi(argv[i + 1]);
+            i += 2;
+            continue;
+        }
+
+        int consumed = parse_generator_option(argc - i, argv + i, &obj_options,
+                                              &ase_options);
+        if (!consumed) {
+            fprintf(stderr, "Unsupported option \"%s\"\n", argv[i]);
+            usage();
+            return 1;
+        }
+        i += consumed;
+    }
+
+    if (!strcmp(command, "obj"))
+        return asset_gen_write_obj_file(target, &obj_options);
+    if (!strcmp(command, "aseprite"))
+        return asset_gen_write_aseprite_file(target, &ase_options);
+    if (!strcmp(command, "pairs"))
+        return generate_pairs(target, pair_count, &obj_options, &ase_options);
+
+    usage();
+    return 1;
+}